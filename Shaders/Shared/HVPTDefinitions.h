@@ -3,9 +3,61 @@
 
 #ifdef __cplusplus
 #include "HLSLTypeAliases.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/Float16.h"
 
 namespace UE::HLSL
 {
+
+// C++ equivalents of the intrinsics used by the packing helpers below, so that the CPU can reproduce the encodings exactly
+#define HVPT_SHARED_INLINE inline
+
+inline uint HVPT_AsUint(float Value)
+{
+	uint Bits;
+	FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+	return Bits;
+}
+
+inline float HVPT_AsFloat(uint Bits)
+{
+	float Value;
+	FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+inline uint HVPT_F32ToF16(float Value)
+{
+	return FFloat16(Value).Encoded;
+}
+
+inline float HVPT_F16ToF32(uint Bits)
+{
+	FFloat16 Half;
+	Half.Encoded = static_cast<uint16>(Bits & 0xFFFF);
+	return Half.GetFloat();
+}
+
+inline float HVPT_Saturate(float Value)
+{
+	return Value > 0.0f ? (Value < 1.0f ? Value : 1.0f) : 0.0f;
+}
+
+inline uint HVPT_MinUint(uint A, uint B)
+{
+	return A < B ? A : B;
+}
+
+#else
+
+#define HVPT_SHARED_INLINE
+#define HVPT_AsUint asuint
+#define HVPT_AsFloat asfloat
+#define HVPT_F32ToF16 f32tof16
+#define HVPT_F16ToF32 f16tof32
+#define HVPT_Saturate saturate
+#define HVPT_MinUint min
+
 #endif
 
 
@@ -85,6 +137,99 @@ struct FHVPT_Reservoir
 };
 
 
+// Reservoir stored in 20 bytes instead of 28, used in place of FHVPT_Reservoir in every reservoir buffer with r.HVPT.ReSTIR.CompactReservoirs
+// Weights vary by many orders of magnitude and half floats overflow for bright lights, so RunningSum and P_y keep the full exponent
+// range of a float with 15 bits of mantissa. M is a half float, which is exact for every integer count below 2048
+struct FHVPT_CompactReservoir
+{
+	uint2 PackedData;			// Same as FHVPT_Reservoir::PackedData
+
+	// PackedWeights.x:
+	//		Top 24 bits:	RunningSum
+	//		Bottom 8 bits:	Top 8 bits of P_y
+	// PackedWeights.y:
+	//		Top 16 bits:	Bottom 16 bits of P_y
+	//		Bottom 16 bits:	M as 16-bit float
+	uint2 PackedWeights;
+
+	// Light sample as unorm16 pairs, x in the top 16 bits
+	uint PackedLightSample;
+};
+
+// Largest error of the encodings used by FHVPT_CompactReservoir, checked by HVPT::Private::ValidateCompactReservoirRoundTrip in the HVPT.ReservoirFormat.CompactRoundTrip test
+#define HVPT_COMPACT_RESERVOIR_WEIGHT_MAX_RELATIVE_ERROR	(1.0f / 65536.0f)
+#define HVPT_COMPACT_RESERVOIR_M_MAX_RELATIVE_ERROR			(1.0f / 2048.0f)
+#define HVPT_COMPACT_RESERVOIR_LIGHT_SAMPLE_MAX_ERROR		(1.0f / 131072.0f)
+
+// Rounds to the nearest float with 15 bits of mantissa, and returns its top 24 bits
+HVPT_SHARED_INLINE uint HVPT_PackReservoirWeight(float Weight)
+{
+	return (HVPT_AsUint(Weight) + 0x80u) >> 8;
+}
+
+HVPT_SHARED_INLINE float HVPT_UnpackReservoirWeight(uint PackedWeight)
+{
+	return HVPT_AsFloat(PackedWeight << 8);
+}
+
+HVPT_SHARED_INLINE uint2 HVPT_PackReservoirWeights(float RunningSum, float M, float P_y)
+{
+	uint PackedRunningSum = HVPT_PackReservoirWeight(RunningSum);
+	uint PackedP_y = HVPT_PackReservoirWeight(P_y);
+	return uint2((PackedRunningSum << 8) | (PackedP_y >> 16), (PackedP_y << 16) | (HVPT_F32ToF16(M) & 0xFFFFu));
+}
+
+HVPT_SHARED_INLINE float HVPT_UnpackReservoirRunningSum(uint2 PackedWeights)
+{
+	return HVPT_UnpackReservoirWeight(PackedWeights[0] >> 8);
+}
+
+HVPT_SHARED_INLINE float HVPT_UnpackReservoirP_y(uint2 PackedWeights)
+{
+	return HVPT_UnpackReservoirWeight(((PackedWeights[0] & 0xFFu) << 16) | (PackedWeights[1] >> 16));
+}
+
+HVPT_SHARED_INLINE float HVPT_UnpackReservoirM(uint2 PackedWeights)
+{
+	return HVPT_F16ToF32(PackedWeights[1] & 0xFFFFu);
+}
+
+// Light samples are random numbers in [0, 1). Each is quantized to one of 65536 equal intervals and decoded to its centre
+HVPT_SHARED_INLINE uint HVPT_PackReservoirLightSampleComponent(float Value)
+{
+	return HVPT_MinUint(uint(HVPT_Saturate(Value) * 65536.0f), 65535u);
+}
+
+HVPT_SHARED_INLINE float HVPT_UnpackReservoirLightSampleComponent(uint PackedValue)
+{
+	return (float(PackedValue & 0xFFFFu) + 0.5f) / 65536.0f;
+}
+
+HVPT_SHARED_INLINE FHVPT_CompactReservoir HVPT_PackCompactReservoir(FHVPT_Reservoir Reservoir)
+{
+	FHVPT_CompactReservoir CompactReservoir;
+	CompactReservoir.PackedData = Reservoir.PackedData;
+	CompactReservoir.PackedWeights = HVPT_PackReservoirWeights(Reservoir.RunningSum, Reservoir.M, Reservoir.P_y);
+	CompactReservoir.PackedLightSample = (HVPT_PackReservoirLightSampleComponent(Reservoir.LightSample[0]) << 16)
+		| HVPT_PackReservoirLightSampleComponent(Reservoir.LightSample[1]);
+	return CompactReservoir;
+}
+
+HVPT_SHARED_INLINE FHVPT_Reservoir HVPT_UnpackCompactReservoir(FHVPT_CompactReservoir CompactReservoir)
+{
+	FHVPT_Reservoir Reservoir;
+	Reservoir.RunningSum = HVPT_UnpackReservoirRunningSum(CompactReservoir.PackedWeights);
+	Reservoir.M = HVPT_UnpackReservoirM(CompactReservoir.PackedWeights);
+	Reservoir.P_y = HVPT_UnpackReservoirP_y(CompactReservoir.PackedWeights);
+	Reservoir.PackedData = CompactReservoir.PackedData;
+	Reservoir.LightSample = float2(
+		HVPT_UnpackReservoirLightSampleComponent(CompactReservoir.PackedLightSample >> 16),
+		HVPT_UnpackReservoirLightSampleComponent(CompactReservoir.PackedLightSample)
+	);
+	return Reservoir;
+}
+
+
 // (omega, z) tuples describing subsequent bounces after the first scattering event
 struct FHVPT_Bounce
 {
@@ -97,6 +242,10 @@ struct FHVPT_Bounce
 
 // TODO: A further optimization would be quantizing the directions and sorting the rays so similar directions are executed by nearby threads
 // TODO: Can do an indirection table where entries have their sort key in top 8(?) bits and index in bottom 24
+
+// Deferred surface bounces are sorted by candidate index, then by the direction quantized into the bottom bits of the sort key
+#define HVPT_SURFACE_BOUNCE_DIRECTION_KEY_BITS 12
+
 struct FHVPT_DeferredSurfaceBounce
 {
 	// Packed data:
@@ -134,6 +283,79 @@ struct FHVPT_DeferredSurfaceBounce
 #define HVPT_SPATIAL_REUSE_NEIGHBOUR_TERMINATOR 0
 
 
+// Adaptive candidate generation
+
+// Reservoirs are bucketed by how noisy they are expected to be. Bucket i generates r.HVPT.ReSTIR.NumInitialCandidates >> (COUNT - 1 - i) candidates (at least 1)
+#define HVPT_CANDIDATE_BUCKET_COUNT 3
+
+
+// Voxel grids
+
+// Maximum number of levels in the ortho grid majorant pyramid, including the top-level grid resolution itself
+#define HVPT_MAX_MAJORANT_MIP_COUNT 8
+
+// Bottom-level bricks come in one size class for each power of two resolution a cell can have: 1, 2 and 4 voxels across
+// The resolution of a cell is stored in 3 bits of its top-level data, so 4 is the largest power of two it can hold
+#define HVPT_BRICK_SIZE_CLASS_COUNT 3
+#define HVPT_MAX_BRICK_RESOLUTION 4
+
+// Layout of the brick free list, see AllocateBrick in VoxelGridBuildUtils.ush
+#define HVPT_BRICK_FREE_LIST_COUNTS			0	// Number of free bricks of each size class
+#define HVPT_BRICK_FREE_LIST_OFFSETS		3	// Element at which the stack of free bricks of each size class starts
+#define HVPT_BRICK_FREE_LIST_HEADER_SIZE	6
+
+// Cells are ranked by the resolution they ask for before rounding, in this many steps of equal log2 width
+// When the pool cannot hold every brick of a build, the lowest ranks are lowered in resolution first
+#define HVPT_BRICK_PRIORITY_BUCKET_COUNT 32
+
+// Layout of the brick degradation stats, see HVPT_PlanBrickDegradationCS
+#define HVPT_BRICK_DEGRADATION_STATS_DEMAND			0	// Slabs of the largest class the build asked for before any cell was lowered
+#define HVPT_BRICK_DEGRADATION_STATS_LEVEL			1	// Most resolution halvings applied to any cell
+#define HVPT_BRICK_DEGRADATION_STATS_CELLS			2	// Number of cells lowered in resolution
+#define HVPT_BRICK_DEGRADATION_STATS_MISSING		3	// Slabs still missing at the highest level allowed
+#define HVPT_BRICK_DEGRADATION_STATS_SIZE			4
+
+// Edge length in voxels of the sub-bricks that bottom-level grids are split into for sub-brick majorants
+#define HVPT_SUB_BRICK_SIZE 4
+
+// Number of equal ranges of view depth that the frustum grid distributes its depth slices over, see FrustumUtils.ush
+// Must be a power of two and a multiple of 4
+#define HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT 32
+
+// Encodings of bottom-level voxel channels, see GetGridDataFormat in VoxelGridBuildUtils.ush
+#define HVPT_GRID_DATA_FORMAT_FLOAT16		0	// Three half floats, 8 bytes per voxel
+#define HVPT_GRID_DATA_FORMAT_RGB9E5		1	// Three 9-bit mantissas with a shared 5-bit exponent, 4 bytes per voxel. Unsigned only
+#define HVPT_GRID_DATA_FORMAT_RGBE8			2	// Three 8-bit mantissas with a shared 8-bit exponent, 4 bytes per voxel. Unsigned only
+#define HVPT_GRID_DATA_FORMAT_MONOCHROME16	3	// One half float, 2 bytes per voxel. Only used for extinction when every volume has grey extinction
+#define HVPT_GRID_DATA_FORMAT_COUNT			4
+
+// Channels of the bottom-level grid. The format of each channel occupies 4 bits of the packed grid data formats
+#define HVPT_GRID_DATA_CHANNEL_EXTINCTION	0
+#define HVPT_GRID_DATA_CHANNEL_EMISSION		1
+#define HVPT_GRID_DATA_CHANNEL_SCATTERING	2
+#define HVPT_GRID_DATA_CHANNEL_VELOCITY		3
+#define HVPT_GRID_DATA_CHANNEL_COUNT		4
+
+// Layout of the counters written by HVPT_CollectOrthoGridStatsCS, see VoxelGridStats.h
+#define HVPT_ORTHO_GRID_STATS_ALLOCATED_CELL_COUNT	0
+#define HVPT_ORTHO_GRID_STATS_USED_VOXEL_COUNT		1
+#define HVPT_ORTHO_GRID_STATS_CELLS_BY_RESOLUTION	2	// One count for each power of two resolution a cell can have: 1, 2 and 4
+#define HVPT_ORTHO_GRID_STATS_RESOLUTION_COUNT		3
+#define HVPT_ORTHO_GRID_STATS_VOLUME_VOXEL_COUNTS	5	// One count for each volume
+#define HVPT_ORTHO_GRID_STATS_MAX_VOLUMES			256
+
+// Volumes whose sparse volume texture is traced directly instead of being rasterized into bricks, see FHVPTOrthoGridDirectVolume
+// Each volume has a slot holding its transform, and instances of the same texture share one of the texture slots bound in the
+// ortho grid uniform buffer
+#define HVPT_MAX_DIRECT_VOLUMES 32
+#define HVPT_MAX_DIRECT_VOLUME_TEXTURES 4
+
+// Volumes shown by several instances with the same material and texture frame, rasterized once into bricks in their own local space
+// Each instance has a slot holding its world to local transform and the shared local grid it looks up, see FHVPTOrthoGridInstancedVolume
+#define HVPT_MAX_INSTANCED_VOLUMES 4096
+#define HVPT_MAX_INSTANCED_ASSET_GRID_RESOLUTION 64
+
+
 // Debug tools
 
 // Flags and view modes are packed together into a single uint
@@ -152,6 +374,16 @@ struct FHVPT_DeferredSurfaceBounce
 #define HVPT_DEBUG_VIEW_MODE_FIREFLY_DETECTION			0x05		// Visualize when sum in reservoirs is very high to detect fireflies
 #define HVPT_DEBUG_VIEW_MODE_REPROJECTION				0x06		// Visualizes difference between pixel position and reprojected pixel position
 #define HVPT_DEBUG_VIEW_MODE_MULTI_PASS_OVERALLOCATION	0x07		// Visualizes when multi-pass indirection buffer has been overallocated
+#define HVPT_DEBUG_VIEW_MODE_COLLISIONS					0x08		// Null (red) and real (green) collisions per path, 1.0 = HVPT_DEBUG_COLLISION_SCALE collisions
+
+#define HVPT_DEBUG_COLLISION_SCALE						64.0f
+
+// Layout of the counters behind the collision stats, see FHVPTCollisionStatsReadback
+// Collision totals are 64-bit, split into a low and a high word, as a frame can exceed 2^32 collisions
+#define HVPT_COLLISION_STATS_PATH_COUNT					0
+#define HVPT_COLLISION_STATS_NULL_COUNT					1		// Low and high word
+#define HVPT_COLLISION_STATS_REAL_COUNT					3		// Low and high word
+#define HVPT_COLLISION_STATS_SIZE						5
 
 #define HVPT_DEBUG_VIEW_MODE_CUSTOM						0xFF		// Used for temporary debug visualization
 
@@ -160,6 +392,7 @@ struct FHVPT_DeferredSurfaceBounce
 }
 
 using FHVPT_Reservoir = UE::HLSL::FHVPT_Reservoir;
+using FHVPT_CompactReservoir = UE::HLSL::FHVPT_CompactReservoir;
 using FHVPT_Bounce = UE::HLSL::FHVPT_Bounce;
 using FHVPT_DeferredSurfaceBounce = UE::HLSL::FHVPT_DeferredSurfaceBounce;
 
@@ -2,9 +2,11 @@
 
 #include "HVPT.h"
 
+#include "HVPTDefinitions.h"
 #include "HeterogeneousVolumeExSceneProxy.h"
 #include "PrimitiveSceneProxy.h"
 #include "RenderUtils.h"
+#include "RenderingThread.h"
 #include "SceneRendering.h"
 #include "ShaderCore.h"
 #include "HAL/IConsoleManager.h"
@@ -192,6 +194,23 @@ static TAutoConsoleVariable<bool> CVarHVPTVoxelGridRebuildEveryFrame(
 	ECVF_RenderThreadSafe
 );
 
+static TAutoConsoleVariable<bool> CVarHVPTGridBuildAsyncCompute(
+	TEXT("r.HVPT.GridBuild.AsyncCompute"),
+	true,
+	TEXT("Build the voxel grids on the async compute queue, overlapping with the base pass. ")
+	TEXT("Only used on platforms with efficient async compute (Default = true)."),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTGridBuildOneFrameLatency(
+	TEXT("r.HVPT.GridBuild.OneFrameLatency"),
+	false,
+	TEXT("Render with the voxel grids built in the previous frame, while this frame's grids are built into a second set of buffers. ")
+	TEXT("Takes the grid build off the critical path, at the cost of volumes lagging a frame behind and the memory of a second brick pool. ")
+	TEXT("The ortho grid is fully rebuilt every time in this mode (Default = false)."),
+	ECVF_RenderThreadSafe
+);
+
 static TAutoConsoleVariable<bool> CVarHVPTVoxelGridJitter(
 	TEXT("r.HVPT.Jitter"),
 	true,
@@ -216,7 +235,7 @@ static TAutoConsoleVariable<float> CVarHVPTMinimumVoxelSizeOutsideFrustum(
 static TAutoConsoleVariable<int32> CVarHVPTBottomLevelGridResolution(
 	TEXT("r.HVPT.BottomLevelGridResolution"),
 	4,
-	TEXT("Determines intra-tile bottom-level grid resolution (Default = 4)"),
+	TEXT("Determines intra-tile bottom-level grid resolution, rounded down to a power of two no larger than 4 (Default = 4)"),
 	ECVF_RenderThreadSafe
 );
 
@@ -234,6 +253,45 @@ static TAutoConsoleVariable<float> CVarHVPTShadingRateOutsideFrustum(
 	ECVF_RenderThreadSafe
 );
 
+static TAutoConsoleVariable<int32> CVarHVPTGridDataFormatExtinction(
+	TEXT("r.HVPT.GridDataFormat.Extinction"),
+	HVPT_GRID_DATA_FORMAT_FLOAT16,
+	TEXT("Encoding of bottom-level extinction voxels.\n")
+	TEXT("0: RGB half floats, 8 bytes per voxel (default).\n")
+	TEXT("1: RGB9E5 shared exponent, 4 bytes per voxel.\n")
+	TEXT("2: RGBE8 8-bit channels with a shared exponent, 4 bytes per voxel."),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTGridDataFormatEmission(
+	TEXT("r.HVPT.GridDataFormat.Emission"),
+	HVPT_GRID_DATA_FORMAT_FLOAT16,
+	TEXT("Encoding of bottom-level emission voxels. See r.HVPT.GridDataFormat.Extinction for formats (Default = 0)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTGridDataFormatScattering(
+	TEXT("r.HVPT.GridDataFormat.Scattering"),
+	HVPT_GRID_DATA_FORMAT_FLOAT16,
+	TEXT("Encoding of bottom-level scattering voxels. See r.HVPT.GridDataFormat.Extinction for formats (Default = 0)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTMonochromeExtinction(
+	TEXT("r.HVPT.MonochromeExtinction"),
+	true,
+	TEXT("Store a single channel of extinction and track it with scalar math when every volume is marked as having grey extinction (Default = true)."),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTInterleavedShadingData(
+	TEXT("r.HVPT.InterleavedShadingData"),
+	false,
+	TEXT("Keep an extra copy of extinction, scattering and emission interleaved per voxel, so that shading a collision fetches one element instead of three. ")
+	TEXT("Costs the memory of the copy, which is taken from the bottom-level memory budget (Default = false)."),
+	ECVF_RenderThreadSafe
+);
+
 
 static TAutoConsoleVariable<int32> CVarHVPTFogCompositingMode(
 	TEXT("r.HVPT.FogCompositingMode"),
@@ -281,10 +339,51 @@ static TAutoConsoleVariable<int32> CVarHVPTFrustumGridDepthSliceCount(
 	ECVF_RenderThreadSafe
 );
 
+static TAutoConsoleVariable<bool> CVarHVPTFrustumGridAdaptiveDepthSlices(
+	TEXT("r.HVPT.FrustumGrid.AdaptiveDepthSlices"),
+	true,
+	TEXT("Concentrate depth slices on the depth ranges that volumes occupy, instead of spreading them evenly between the near and far planes (Default = true)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<float> CVarHVPTFrustumGridEmptyDepthSliceWeight(
+	TEXT("r.HVPT.FrustumGrid.EmptyDepthSliceWeight"),
+	0.05f,
+	TEXT("With r.HVPT.FrustumGrid.AdaptiveDepthSlices, density of depth slices in depth ranges no volume occupies, relative to occupied ranges (Default = 0.05)\n")
+	TEXT("Clamped to [0.01, 1]"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTFrustumGridRebuildInterval(
+	TEXT("r.HVPT.FrustumGrid.RebuildInterval"),
+	1,
+	TEXT("Rebuild the frustum grid every N frames, rendering from the previous grid in between (Default = 1)\n")
+	TEXT("Lookups into the previous grid go through the view it was built with, so they stay in the right place as the camera moves.\n")
+	TEXT("Volumes moving or coming into view lag behind by up to N - 1 frames. Camera cuts always rebuild."),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<float> CVarHVPTFrustumGridRebuildBudget(
+	TEXT("r.HVPT.FrustumGrid.RebuildBudgetMs"),
+	0.0f,
+	TEXT("GPU time per frame the frustum grid rebuild may take on average, in milliseconds (Default = 0.0)\n")
+	TEXT("The rebuild interval is stretched beyond r.HVPT.FrustumGrid.RebuildInterval until the measured cost of a rebuild fits.\n")
+	TEXT("The cost can only be measured when the grid is not built on async compute. <= 0: no budget"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTFrustumGridMaxRebuildInterval(
+	TEXT("r.HVPT.FrustumGrid.MaxRebuildInterval"),
+	8,
+	TEXT("Upper limit on the interval r.HVPT.FrustumGrid.RebuildBudgetMs can stretch rebuilds to (Default = 8)"),
+	ECVF_RenderThreadSafe
+);
+
 static TAutoConsoleVariable<int32> CVarHVPTFrustumGridMaxMemory(
 	TEXT("r.HVPT.FrustumGrid.MaxBottomLevelMemoryMegabytes"),
-	128,
-	TEXT("Maximum allowed size of bottom level grid in megabytes (Default = 128)"),
+	576,
+	TEXT("Maximum allowed size of bottom level grid in megabytes, across all voxel channels in their selected formats and the brick free list. ")
+	TEXT("The default fits as many voxels as 128 MB did when only one half float channel was counted (Default = 576)"),
 	ECVF_RenderThreadSafe
 );
 
@@ -298,8 +397,149 @@ static TAutoConsoleVariable<bool> CVarHVPTOrthoGrid(
 
 static TAutoConsoleVariable<int32> CVarHVPTOrthoGridMaxMemory(
 	TEXT("r.HVPT.OrthoGrid.MaxBottomLevelMemoryMegabytes"),
+	576,
+	TEXT("Maximum allowed size of bottom level grid in megabytes, across all voxel channels in their selected formats and the brick free list. ")
+	TEXT("The default fits as many voxels as 128 MB did when only one half float channel was counted (Default = 576)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTOrthoGridMaxDegradationLevel(
+	TEXT("r.HVPT.OrthoGrid.MaxDegradationLevel"),
+	2,
+	TEXT("Number of times the resolution of an ortho grid cell may be halved when the bricks a build needs do not fit in r.HVPT.OrthoGrid.MaxBottomLevelMemoryMegabytes. ")
+	TEXT("Cells asking for the lowest resolution, being far away, small on screen or of low LOD importance, are lowered first, within the same build. ")
+	TEXT("0 leaves cells that do not fit empty instead (Default = 2)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridIncrementalRebuild(
+	TEXT("r.HVPT.OrthoGrid.IncrementalRebuild"),
+	true,
+	TEXT("Only re-rasterize the parts of the ortho grid touched by volumes that have moved or changed since the last build (Default = true)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTOrthoGridFullRebuildInterval(
+	TEXT("r.HVPT.OrthoGrid.FullRebuildInterval"),
+	120,
+	TEXT("When incremental rebuilds are enabled, force a full rebuild after this many frames to refresh voxel sizes, streamed data and reclaim unused bricks. 0 = never (Default = 120)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTOrthoGridMajorantMipCount(
+	TEXT("r.HVPT.OrthoGrid.MajorantMipCount"),
+	5,
+	TEXT("Number of levels in the majorant pyramid used to skip empty space while tracking. 1 = step through every top-level cell (Default = 5)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<float> CVarHVPTOrthoGridMajorantLeapThreshold(
+	TEXT("r.HVPT.OrthoGrid.MajorantLeapThreshold"),
+	0.0f,
+	TEXT("Coarse majorant pyramid cells with a majorant at or below this extinction are tracked through in a single step instead of descending to finer cells.\n")
+	TEXT("Higher values take fewer steps through thin media at the cost of more null collisions. 0 = only skip empty space (Default = 0.0)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridSubBrickMajorants(
+	TEXT("r.HVPT.OrthoGrid.SubBrickMajorants"),
+	true,
+	TEXT("Store a majorant for every 4x4x4 sub-brick of each bottom-level grid, and track through occupied top-level cells one sub-brick at a time.\n")
+	TEXT("Reduces null collisions in cells that contain a few dense voxels, at the cost of more DDA steps (Default = true)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridTrilinearFiltering(
+	TEXT("r.HVPT.OrthoGrid.TrilinearFiltering"),
+	false,
+	TEXT("Sample the ortho grid with trilinear filtering instead of taking the nearest voxel, blending across cell boundaries with the neighbouring bricks.\n")
+	TEXT("Coarser voxel sizes then look smooth rather than blocky, at the cost of up to eight voxel loads per sample and looser majorants (Default = false)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<FString> CVarHVPTOrthoGridBakedGrid(
+	TEXT("r.HVPT.OrthoGrid.BakedGrid"),
+	TEXT(""),
+	TEXT("Path of an ortho grid written by r.HVPT.OrthoGrid.Bake. If set, the file is memory mapped and uploaded in place of building the ortho grid.\n")
+	TEXT("Only suitable for scenes where the volumes do not move or animate. The frustum grid is still built every frame (Default = empty)"),
+	ECVF_RenderThreadSafe
+);
+
+// Filename of the pending bake, only accessed on the render thread
+static FString GHVPTOrthoGridBakeRequest;
+
+static FAutoConsoleCommand CmdHVPTOrthoGridBake(
+	TEXT("r.HVPT.OrthoGrid.Bake"),
+	TEXT("Writes the next ortho grid to be rendered to the file given as the argument, to be loaded with r.HVPT.OrthoGrid.BakedGrid."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() != 1)
+		{
+			UE_LOG(LogHVPT, Warning, TEXT("Usage: r.HVPT.OrthoGrid.Bake <Filename>"));
+			return;
+		}
+
+		ENQUEUE_RENDER_COMMAND(HVPTRequestOrthoGridBake)([Filename = Args[0]](FRHICommandListImmediate&)
+		{
+			GHVPTOrthoGridBakeRequest = Filename;
+		});
+	})
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridStats(
+	TEXT("r.HVPT.OrthoGrid.Stats"),
+	false,
+	TEXT("Reads back the occupancy of the ortho grid and its brick pool every few frames, and publishes it to 'stat HVPT' and the CSV profiler (Default = false)"),
+	ECVF_RenderThreadSafe
+);
+
+// Set by r.HVPT.OrthoGrid.DumpStats, only accessed on the render thread
+static bool GHVPTOrthoGridDumpStatsRequest = false;
+
+static FAutoConsoleCommand CmdHVPTOrthoGridDumpStats(
+	TEXT("r.HVPT.OrthoGrid.DumpStats"),
+	TEXT("Logs the occupancy of the ortho grid, its brick pool and the bricks used by each volume, once the next readback completes."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		ENQUEUE_RENDER_COMMAND(HVPTRequestOrthoGridDumpStats)([](FRHICommandListImmediate&)
+		{
+			GHVPTOrthoGridDumpStatsRequest = true;
+		});
+	})
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridDirectVolumes(
+	TEXT("r.HVPT.OrthoGrid.DirectVolumes"),
+	true,
+	TEXT("Volumes that ask to sample their sparse volume texture directly are traced from the texture instead of being rasterized into bricks, ")
+	TEXT("as long as they share no ortho grid cells with other volumes. Up to HVPT_MAX_DIRECT_VOLUMES volumes are sampled directly, ")
+	TEXT("using at most HVPT_MAX_DIRECT_VOLUME_TEXTURES distinct texture frames between them, so instances of the same texture are cheap (Default = true)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridInstancedVolumes(
+	TEXT("r.HVPT.OrthoGrid.InstancedVolumes"),
+	true,
+	TEXT("Volumes showing the same material and sparse volume texture frame in two or more places are rasterized once into bricks in their own local space, ")
+	TEXT("and every instance looks them up through its world to local transform, so their bricks and build time do not grow with the instance count. ")
+	TEXT("Only applies to instances that share no ortho grid cells with other volumes, up to HVPT_MAX_INSTANCED_VOLUMES instances (Default = true)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<bool> CVarHVPTOrthoGridBrickCache(
+	TEXT("r.HVPT.OrthoGrid.BrickCache"),
+	true,
+	TEXT("Keeps the rasterized bricks of animated volumes, keyed by their sparse volume texture frame and their placement in the ortho grid. ")
+	TEXT("When a looping animation returns to a frame, or another instance shows the same frame, the bricks are copied instead of rasterizing the material again. ")
+	TEXT("Instances showing the same frame in the same build are rasterized once, and the others are copied from it afterwards (Default = true)"),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTOrthoGridBrickCacheMaxMemory(
+	TEXT("r.HVPT.OrthoGrid.BrickCache.MaxMemoryMegabytes"),
 	128,
-	TEXT("Maximum allowed size of bottom level grid in megabytes (Default = 128)"),
+	TEXT("Size of the ortho grid brick cache in megabytes, across all voxel channels in their selected formats. ")
+	TEXT("The least recently used frames are evicted when it is full (Default = 128)"),
 	ECVF_RenderThreadSafe
 );
 
@@ -491,6 +731,16 @@ namespace HVPT
 		return CVarHVPTVoxelGridJitter.GetValueOnRenderThread();
 	}
 
+	bool UseAsyncComputeForGridBuild()
+	{
+		return CVarHVPTGridBuildAsyncCompute.GetValueOnRenderThread() && GSupportsEfficientAsyncCompute;
+	}
+
+	bool UseOneFrameLatencyForGridBuild()
+	{
+		return CVarHVPTGridBuildOneFrameLatency.GetValueOnRenderThread();
+	}
+
 	float GetMinimumVoxelSizeInsideFrustum()
 	{
 		return FMath::Max(CVarHVPTMinimumVoxelSizeInsideFrustum.GetValueOnRenderThread(), 0.01f);
@@ -503,7 +753,8 @@ namespace HVPT
 
 	int32 GetBottomLevelGridResolution()
 	{
-		return FMath::Max(CVarHVPTBottomLevelGridResolution.GetValueOnRenderThread(), 1);
+		// Bricks are allocated from a size class for each power of two resolution up to HVPT_MAX_BRICK_RESOLUTION
+		return 1 << FMath::FloorLog2(FMath::Clamp(CVarHVPTBottomLevelGridResolution.GetValueOnRenderThread(), 1, HVPT_MAX_BRICK_RESOLUTION));
 	}
 
 	float GetInsideFrustumShadingRate()
@@ -516,6 +767,31 @@ namespace HVPT
 		return FMath::Max(CVarHVPTShadingRateOutsideFrustum.GetValueOnRenderThread(), 0.1f);
 	}
 
+	int32 GetGridDataFormatForExtinction()
+	{
+		return FMath::Clamp(CVarHVPTGridDataFormatExtinction.GetValueOnRenderThread(), 0, HVPT_GRID_DATA_FORMAT_RGBE8);
+	}
+
+	int32 GetGridDataFormatForEmission()
+	{
+		return FMath::Clamp(CVarHVPTGridDataFormatEmission.GetValueOnRenderThread(), 0, HVPT_GRID_DATA_FORMAT_RGBE8);
+	}
+
+	int32 GetGridDataFormatForScattering()
+	{
+		return FMath::Clamp(CVarHVPTGridDataFormatScattering.GetValueOnRenderThread(), 0, HVPT_GRID_DATA_FORMAT_RGBE8);
+	}
+
+	bool UseMonochromeExtinction()
+	{
+		return CVarHVPTMonochromeExtinction.GetValueOnRenderThread();
+	}
+
+	bool UseInterleavedShadingData()
+	{
+		return CVarHVPTInterleavedShadingData.GetValueOnRenderThread();
+	}
+
 
 	EFogCompositionMode GetFogCompositingMode()
 	{
@@ -554,6 +830,31 @@ namespace HVPT
 		return FMath::Max(CVarHVPTFrustumGridMaxMemory.GetValueOnRenderThread(), 1);
 	}
 
+	bool UseAdaptiveDepthSlicesForFrustumGrid()
+	{
+		return CVarHVPTFrustumGridAdaptiveDepthSlices.GetValueOnRenderThread();
+	}
+
+	float GetEmptyDepthSliceWeightForFrustumGrid()
+	{
+		return FMath::Clamp(CVarHVPTFrustumGridEmptyDepthSliceWeight.GetValueOnRenderThread(), 0.01f, 1.0f);
+	}
+
+	int32 GetRebuildIntervalForFrustumGrid()
+	{
+		return FMath::Max(CVarHVPTFrustumGridRebuildInterval.GetValueOnRenderThread(), 1);
+	}
+
+	float GetRebuildBudgetMillisecondsForFrustumGrid()
+	{
+		return CVarHVPTFrustumGridRebuildBudget.GetValueOnRenderThread();
+	}
+
+	int32 GetMaxRebuildIntervalForFrustumGrid()
+	{
+		return FMath::Max(CVarHVPTFrustumGridMaxRebuildInterval.GetValueOnRenderThread(), GetRebuildIntervalForFrustumGrid());
+	}
+
 
 	bool EnableOrthoGrid()
 	{
@@ -565,6 +866,92 @@ namespace HVPT
 		return FMath::Max(CVarHVPTOrthoGridMaxMemory.GetValueOnRenderThread(), 1);
 	}
 
+	int32 GetMaxDegradationLevelForOrthoGrid()
+	{
+		return FMath::Max(CVarHVPTOrthoGridMaxDegradationLevel.GetValueOnRenderThread(), 0);
+	}
+
+	bool EnableIncrementalRebuildForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridIncrementalRebuild.GetValueOnRenderThread();
+	}
+
+	int32 GetFullRebuildIntervalForOrthoGrid()
+	{
+		return FMath::Max(CVarHVPTOrthoGridFullRebuildInterval.GetValueOnRenderThread(), 0);
+	}
+
+	int32 GetMajorantMipCountForOrthoGrid()
+	{
+		return FMath::Clamp(CVarHVPTOrthoGridMajorantMipCount.GetValueOnRenderThread(), 1, HVPT_MAX_MAJORANT_MIP_COUNT);
+	}
+
+	float GetMajorantLeapThresholdForOrthoGrid()
+	{
+		return FMath::Max(CVarHVPTOrthoGridMajorantLeapThreshold.GetValueOnRenderThread(), 0.0f);
+	}
+
+	bool UseSubBrickMajorantsForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridSubBrickMajorants.GetValueOnRenderThread();
+	}
+
+	bool UseTrilinearFilteringForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridTrilinearFiltering.GetValueOnRenderThread();
+	}
+
+	FString GetBakedGridForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridBakedGrid.GetValueOnRenderThread();
+	}
+
+	bool ConsumeBakeRequestForOrthoGrid(FString& OutFilename)
+	{
+		check(IsInRenderingThread());
+		if (GHVPTOrthoGridBakeRequest.IsEmpty())
+		{
+			return false;
+		}
+
+		OutFilename = MoveTemp(GHVPTOrthoGridBakeRequest);
+		GHVPTOrthoGridBakeRequest.Reset();
+		return true;
+	}
+
+	bool EnableStatsForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridStats.GetValueOnRenderThread();
+	}
+
+	bool ConsumeDumpStatsRequestForOrthoGrid()
+	{
+		check(IsInRenderingThread());
+		const bool bRequested = GHVPTOrthoGridDumpStatsRequest;
+		GHVPTOrthoGridDumpStatsRequest = false;
+		return bRequested;
+	}
+
+	bool EnableDirectVolumesForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridDirectVolumes.GetValueOnRenderThread();
+	}
+
+	bool EnableInstancedVolumesForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridInstancedVolumes.GetValueOnRenderThread();
+	}
+
+	bool EnableBrickCacheForOrthoGrid()
+	{
+		return CVarHVPTOrthoGridBrickCache.GetValueOnRenderThread();
+	}
+
+	int32 GetBrickCacheMemoryInMegabytesForOrthoGrid()
+	{
+		return FMath::Max(CVarHVPTOrthoGridBrickCacheMaxMemory.GetValueOnRenderThread(), 1);
+	}
+
 
 	bool GetFreezeTemporalSeed()
 	{
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "RenderGraphFwd.h"
+#include "Rendering/VoxelGrid.h"
+#include "Rendering/BakedVoxelGrid.h"
+#include "Rendering/VoxelGridStats.h"
+
+class FSceneViewFamily;
+
+
+// Collection of all resources that are shared by every view rendering a scene, across all view families
+struct FHVPTSceneState
+{
+	// The ortho grid covers the whole scene in world space, so it is built at most once per frame by the first view family to
+	// render the scene. Other families register the extracted cache instead.
+	uint32 OrthoGridBuildFrameNumber = MAX_uint32;
+
+	// RDG resources are only valid within the graph of the view family that created them
+	TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> OrthoGridUniformBuffer = nullptr;
+	const FSceneViewFamily* OrthoGridUniformBufferViewFamily = nullptr;
+	uint32 OrthoGridUniformBufferFrameNumber = MAX_uint32;
+
+	// Finest voxel size required by views that did not take part in a build, so that the next build also accounts for them
+	uint32 VoxelSizeFrameNumber = MAX_uint32;
+	float CurrentFrameMinimumVoxelSize = UE_MAX_FLT;
+	float PreviousFrameMinimumVoxelSize = UE_MAX_FLT;
+
+	// Cached resources used between frames
+
+	FHVPTOrthoGridParameterCache OrthoGridParameterCache;
+	FHVPTBrickPool OrthoGridBrickPool;
+	// Pool the ortho grid is not being rendered from, only allocated with r.HVPT.GridBuild.OneFrameLatency
+	FHVPTBrickPool OrthoGridBackBrickPool;
+	// Shared by both pools, as they always have the same capacity
+	FHVPTOrthoGridAllocationState OrthoGridAllocationState;
+	// Bricks of animated volumes kept between builds, see r.HVPT.OrthoGrid.BrickCache
+	FHVPTBrickCache OrthoGridBrickCache;
+
+	// Baked grid that replaces the ortho grid build, see r.HVPT.OrthoGrid.BakedGrid
+	FString BakedOrthoGridFilename;
+	bool bUseBakedOrthoGrid = false;
+
+	FHVPTOrthoGridBake OrthoGridBake;
+
+	// See r.HVPT.OrthoGrid.Stats
+	FHVPTOrthoGridStatsReadback OrthoGridStatsReadback;
+};
@@ -1,6 +1,7 @@
 #include "HVPTViewExtension.h"
 
 #include "HVPT.h"
+#include "HVPTSceneState.h"
 #include "HVPTViewState.h"
 
 #include "Rendering/VoxelGrid.h"
@@ -11,6 +12,9 @@
 #define LOCTEXT_NAMESPACE "HVPTModule"
 
 DECLARE_GPU_STAT_NAMED(HVPTStat, TEXT("HVPT"));
+// The radiance pass is timed under the shading data layout it read, so that both layouts of r.HVPT.InterleavedShadingData can be compared
+DECLARE_GPU_STAT_NAMED(HVPTRadiancePerChannelStat, TEXT("HVPT Radiance (Per-Channel Shading Data)"));
+DECLARE_GPU_STAT_NAMED(HVPTRadianceInterleavedStat, TEXT("HVPT Radiance (Interleaved Shading Data)"));
 
 
 namespace HVPT {
@@ -104,6 +108,42 @@ void FHVPTViewExtension::PreRenderView_RenderThread(FRDGBuilder& GraphBuilder, F
 
 }
 
+void FHVPTViewExtension::PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	RenderingViewFamily = &InViewFamily;
+}
+
+void FHVPTViewExtension::PreRenderBasePass_RenderThread(FRDGBuilder& GraphBuilder, bool bDepthBufferIsPopulated)
+{
+#if RHI_RAYTRACING
+	// Views are only initialized after PreRenderView_RenderThread, so their heterogeneous volume mesh batches are not known before this point
+	if (!RenderingViewFamily || RenderingViewFamily->EngineShowFlags.PathTracing)
+		return;
+	auto Scene = (RenderingViewFamily->Scene) ? RenderingViewFamily->Scene->GetRenderScene() : nullptr;
+	if (!Scene)
+		return;
+
+	for (const FSceneView* View : RenderingViewFamily->Views)
+	{
+		if (!View->bIsViewInfo)
+			continue;
+		const FViewInfo& ViewInfo = static_cast<const FViewInfo&>(*View);
+		if (ViewInfo.bIsReflectionCapture || !HVPT::ShouldRenderHVPTForView(ViewInfo))
+			continue;
+
+		auto ViewState = GetOrCreateViewStateForView(ViewInfo);
+		if (!ViewState)
+			continue;
+
+		RDG_EVENT_SCOPE_STAT(GraphBuilder, HVPTStat, "HVPT");
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HVPTStat);
+
+		// Nothing reads the grids until the prepass in PrePostProcessPass_RenderThread
+		BuildVoxelGrids(GraphBuilder, ViewInfo, Scene, *ViewState);
+	}
+#endif
+}
+
 void FHVPTViewExtension::PostRenderBasePassDeferred_RenderThread(
 	FRDGBuilder& GraphBuilder, FSceneView& InView, const FRenderTargetBindingSlots& RenderTargets, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTextureParameters
 )
@@ -165,29 +205,12 @@ void FHVPTViewExtension::PrePostProcessPass_RenderThread(FRDGBuilder& GraphBuild
 		ViewState->TemporalAccumulationTexture_Lo = GraphBuilder.RegisterExternalTexture(ViewState->TemporalAccumulationRT_Lo);
 	}
 
-	// Build voxel grid if required
+	// The voxel grids are normally built by PreRenderBasePass_RenderThread, and are first read by the prepass
+	// Renderers that skip that hook build them here instead, without any overlap
+	if (!ViewState->bVoxelGridsBuilt)
 	{
-		TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> OrthoGridUniformBuffer = HVPT::GetOrthoVoxelGridUniformBuffer(GraphBuilder, *ViewState);
-		TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters> FrustumGridUniformBuffer = HVPT::GetFrustumVoxelGridUniformBuffer(GraphBuilder, *ViewState);
-
-		bool bIsGridEmpty = !(OrthoGridUniformBuffer && FrustumGridUniformBuffer);
-		if (!bIsGridEmpty)
-		{
-			auto& Parameters = OrthoGridUniformBuffer->GetParameters();
-			bIsGridEmpty = Parameters->TopLevelGridWorldBoundsMin == Parameters->TopLevelGridWorldBoundsMax;
-		}
-
-		if (HVPT::GetRebuildEveryFrame() || bIsGridEmpty)
-		{
-			FHVPT_VoxelGridBuildOptions BuildOptions;
-			BuildOptions.bJitter = HVPT::GetShouldJitter() && !HVPT::GetFreezeTemporalSeed();
-
-			HVPT::BuildOrthoVoxelGrid(GraphBuilder, Scene, ViewInfo, BuildOptions, OrthoGridUniformBuffer);
-			HVPT::BuildFrustumVoxelGrid(GraphBuilder, Scene, ViewInfo, BuildOptions, FrustumGridUniformBuffer);
-
-			ViewState->OrthoGridUniformBuffer = OrthoGridUniformBuffer;
-			ViewState->FrustumGridUniformBuffer = FrustumGridUniformBuffer;
-		}
+		UE_LOG(LogHVPT, Verbose, TEXT("Voxel grids were not built before the base pass, building them before the prepass"));
+		BuildVoxelGrids(GraphBuilder, ViewInfo, Scene, *ViewState);
 	}
 
 	// Create depth buffer copy
@@ -231,7 +254,7 @@ void FHVPTViewExtension::PrePostProcessPass_RenderThread(FRDGBuilder& GraphBuild
 		AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(ViewState->RadianceTexture), FLinearColor::Black);
 
 		// Perform radiance pass
-		if (!HVPT::GetDisableRadiance())
+		auto RenderRadiance = [&]()
 		{
 			if (HVPT::UseReSTIR())
 			{
@@ -253,6 +276,20 @@ void FHVPTViewExtension::PrePostProcessPass_RenderThread(FRDGBuilder& GraphBuild
 					*ViewState
 				);
 			}
+		};
+
+		if (!HVPT::GetDisableRadiance())
+		{
+			if (HVPT::UseInterleavedShadingData())
+			{
+				RDG_GPU_STAT_SCOPE(GraphBuilder, HVPTRadianceInterleavedStat);
+				RenderRadiance();
+			}
+			else
+			{
+				RDG_GPU_STAT_SCOPE(GraphBuilder, HVPTRadiancePerChannelStat);
+				RenderRadiance();
+			}
 		}
 	}
 
@@ -351,11 +388,7 @@ void FHVPTViewExtension::PostRenderView_RenderThread(FRDGBuilder& GraphBuilder,
 	}
 
 	// Extract resources used between frames
-	if (ViewState->OrthoGridUniformBuffer && ViewState->FrustumGridUniformBuffer)
-	{
-		HVPT::ExtractOrthoVoxelGridUniformBuffer(GraphBuilder, ViewState->OrthoGridUniformBuffer, ViewState->OrthoGridParameterCache);
-		HVPT::ExtractFrustumVoxelGridUniformBuffer(GraphBuilder, ViewState->FrustumGridUniformBuffer, ViewState->FrustumGridParameterCache);
-	}
+	// The voxel grids are extracted as soon as they are built, see BuildVoxelGrids
 	if (ViewState->FeatureTexture)
 		GraphBuilder.QueueTextureExtraction(ViewState->FeatureTexture, &ViewState->FeatureRT);
 	else
@@ -385,11 +418,17 @@ void FHVPTViewExtension::PostRenderView_RenderThread(FRDGBuilder& GraphBuilder,
 	ViewState->DepthBufferCopy = nullptr;
 	ViewState->FrustumGridUniformBuffer = nullptr;
 	ViewState->OrthoGridUniformBuffer = nullptr;
+	ViewState->bVoxelGridsBuilt = false;
 	ViewState->DebugTexture = nullptr;
 
 #endif
 }
 
+void FHVPTViewExtension::PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	RenderingViewFamily = nullptr;
+}
+
 bool FHVPTViewExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
 {
 #if RHI_RAYTRACING
@@ -414,15 +453,186 @@ FHVPTViewState* FHVPTViewExtension::GetOrCreateViewStateForView(const FViewInfo&
 	return nullptr;
 }
 
+FHVPTSceneState& FHVPTViewExtension::GetOrCreateSceneState(const FScene& Scene)
+{
+	if (TUniquePtr<FHVPTSceneState>* SceneState = SceneStates.Find(&Scene))
+	{
+		return **SceneState;
+	}
+
+	return *SceneStates.Add(&Scene, MakeUnique<FHVPTSceneState>());
+}
+
+void FHVPTViewExtension::BuildVoxelGrids(FRDGBuilder& GraphBuilder, const FViewInfo& ViewInfo, const FScene* Scene, FHVPTViewState& ViewState)
+{
+	FHVPT_VoxelGridBuildOptions BuildOptions;
+	BuildOptions.bJitter = HVPT::GetShouldJitter() && !HVPT::GetFreezeTemporalSeed();
+	BuildOptions.ComputePassFlags = HVPT::UseAsyncComputeForGridBuild() ? ERDGPassFlags::AsyncCompute : ERDGPassFlags::Compute;
+
+	// With one frame of latency, the grids built last frame are rendered from while this frame's grids are built into the other brick pool
+	// The pools are swapped before each build, and the new grid takes over once it is extracted at the end of the frame
+	const bool bOneFrameLatency = HVPT::UseOneFrameLatencyForGridBuild();
+
+	FHVPTSceneState& SceneState = GetOrCreateSceneState(*Scene);
+	const uint32 FrameNumber = ViewInfo.Family->FrameNumber;
+
+	// Every view reports the voxel size it needs, so that the next build accounts for views of families that render after it
+	if (SceneState.VoxelSizeFrameNumber != FrameNumber)
+	{
+		SceneState.VoxelSizeFrameNumber = FrameNumber;
+		SceneState.PreviousFrameMinimumVoxelSize = SceneState.CurrentFrameMinimumVoxelSize;
+		SceneState.CurrentFrameMinimumVoxelSize = UE_MAX_FLT;
+	}
+	SceneState.CurrentFrameMinimumVoxelSize = FMath::Min(SceneState.CurrentFrameMinimumVoxelSize, HVPT::CalcOrthoGridMinimumVoxelSize(ViewInfo, BuildOptions));
+
+	TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> OrthoGridUniformBuffer = HVPT::GetOrthoVoxelGridUniformBuffer(GraphBuilder, ViewInfo, SceneState);
+	TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters> FrustumGridUniformBuffer = HVPT::GetFrustumVoxelGridUniformBuffer(GraphBuilder, ViewState);
+
+	// Switching to or from a baked grid replaces the whole ortho grid
+	const FString BakedOrthoGridFilename = HVPT::GetBakedGridForOrthoGrid();
+	if (SceneState.BakedOrthoGridFilename != BakedOrthoGridFilename && SceneState.OrthoGridBuildFrameNumber != FrameNumber)
+	{
+		SceneState.BakedOrthoGridFilename = BakedOrthoGridFilename;
+		SceneState.bUseBakedOrthoGrid = !BakedOrthoGridFilename.IsEmpty()
+			&& HVPT::LoadBakedOrthoVoxelGrid(GraphBuilder, Scene, ViewInfo, BakedOrthoGridFilename, OrthoGridUniformBuffer);
+
+		// The cached volume records do not describe the grid anymore, so the next build must not be incremental
+		SceneState.OrthoGridParameterCache.VolumeRecords.Reset();
+		SceneState.OrthoGridParameterCache.DirectVolumes.Reset();
+		SceneState.OrthoGridParameterCache.BuildSettingsHash = 0;
+
+		if (SceneState.bUseBakedOrthoGrid)
+		{
+			HVPT::ExtractOrthoVoxelGridUniformBuffer(GraphBuilder, OrthoGridUniformBuffer, SceneState.OrthoGridParameterCache);
+
+			SceneState.OrthoGridBuildFrameNumber = FrameNumber;
+			SceneState.OrthoGridUniformBuffer = OrthoGridUniformBuffer;
+			SceneState.OrthoGridUniformBufferViewFamily = ViewInfo.Family;
+			SceneState.OrthoGridUniformBufferFrameNumber = FrameNumber;
+		}
+		else
+		{
+			OrthoGridUniformBuffer = nullptr;
+		}
+	}
+
+	bool bIsGridEmpty = !(OrthoGridUniformBuffer && FrustumGridUniformBuffer);
+	if (!bIsGridEmpty)
+	{
+		auto& Parameters = OrthoGridUniformBuffer->GetParameters();
+		bIsGridEmpty = Parameters->TopLevelGridWorldBoundsMin == Parameters->TopLevelGridWorldBoundsMax;
+	}
+
+	if (HVPT::GetRebuildEveryFrame() || bIsGridEmpty)
+	{
+		// The ortho grid is shared by every view of the scene, so it is only built once per frame however many views render it
+		if (SceneState.OrthoGridBuildFrameNumber != FrameNumber && !SceneState.bUseBakedOrthoGrid)
+		{
+			TArray<const FViewInfo*, TInlineAllocator<4>> BuildViews;
+			for (const FSceneView* FamilyView : ViewInfo.Family->Views)
+			{
+				if (FamilyView->bIsViewInfo && HVPT::ShouldRenderHVPTForView(static_cast<const FViewInfo&>(*FamilyView)))
+				{
+					BuildViews.Add(static_cast<const FViewInfo*>(FamilyView));
+				}
+			}
+
+			// Without a previous grid to render from, the new grid has to be used straight away
+			FHVPT_VoxelGridBuildOptions OrthoGridBuildOptions = BuildOptions;
+			OrthoGridBuildOptions.bBuildIntoBackBuffers = bOneFrameLatency && OrthoGridUniformBuffer != nullptr;
+			if (OrthoGridBuildOptions.bBuildIntoBackBuffers)
+			{
+				Swap(SceneState.OrthoGridBrickPool, SceneState.OrthoGridBackBrickPool);
+			}
+			else if (!bOneFrameLatency)
+			{
+				SceneState.OrthoGridBackBrickPool = FHVPTBrickPool();
+			}
+
+			TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> BuiltOrthoGridUniformBuffer;
+			HVPT::BuildOrthoVoxelGrid(GraphBuilder, Scene, BuildViews, OrthoGridBuildOptions, SceneState, BuiltOrthoGridUniformBuffer);
+			HVPT::ExtractOrthoVoxelGridUniformBuffer(GraphBuilder, BuiltOrthoGridUniformBuffer, SceneState.OrthoGridParameterCache);
+			SceneState.OrthoGridBuildFrameNumber = FrameNumber;
+
+			// Other views of this family keep sharing the previous grid when the new one is deferred to the next frame
+			if (!OrthoGridBuildOptions.bBuildIntoBackBuffers)
+			{
+				OrthoGridUniformBuffer = BuiltOrthoGridUniformBuffer;
+				SceneState.OrthoGridUniformBuffer = OrthoGridUniformBuffer;
+				SceneState.OrthoGridUniformBufferViewFamily = ViewInfo.Family;
+				SceneState.OrthoGridUniformBufferFrameNumber = FrameNumber;
+			}
+		}
+
+		// Between rebuilds the view keeps rendering from the cached frustum grid
+		if (HVPT::ShouldRebuildFrustumVoxelGrid(ViewInfo, FrustumGridUniformBuffer != nullptr, ViewState.FrustumGridRebuildState))
+		{
+			FHVPT_VoxelGridBuildOptions FrustumGridBuildOptions = BuildOptions;
+			FrustumGridBuildOptions.bBuildIntoBackBuffers = bOneFrameLatency && FrustumGridUniformBuffer != nullptr;
+			if (FrustumGridBuildOptions.bBuildIntoBackBuffers)
+			{
+				Swap(ViewState.FrustumGridBrickPool, ViewState.FrustumGridBackBrickPool);
+			}
+			else if (!bOneFrameLatency)
+			{
+				ViewState.FrustumGridBackBrickPool = FHVPTBrickPool();
+			}
+
+			HVPT::BeginFrustumVoxelGridRebuildTiming(GraphBuilder, FrustumGridBuildOptions, ViewState.FrustumGridRebuildState);
+
+			TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters> BuiltFrustumGridUniformBuffer;
+			HVPT::BuildFrustumVoxelGrid(GraphBuilder, Scene, ViewInfo, FrustumGridBuildOptions, ViewState.FrustumGridBrickPool, BuiltFrustumGridUniformBuffer);
+			HVPT::ExtractFrustumVoxelGridUniformBuffer(GraphBuilder, BuiltFrustumGridUniformBuffer, ViewState.FrustumGridParameterCache);
+
+			HVPT::EndFrustumVoxelGridRebuildTiming(GraphBuilder, ViewState.FrustumGridRebuildState);
+
+			if (!FrustumGridBuildOptions.bBuildIntoBackBuffers)
+			{
+				FrustumGridUniformBuffer = BuiltFrustumGridUniformBuffer;
+			}
+		}
+	}
+
+	ViewState.OrthoGridUniformBuffer = OrthoGridUniformBuffer;
+	ViewState.FrustumGridUniformBuffer = FrustumGridUniformBuffer;
+	ViewState.bVoxelGridsBuilt = true;
+
+	FString BakeFilename;
+	if (OrthoGridUniformBuffer && HVPT::ConsumeBakeRequestForOrthoGrid(BakeFilename))
+	{
+		HVPT::BakeOrthoVoxelGrid(GraphBuilder, OrthoGridUniformBuffer, BakeFilename, SceneState.OrthoGridBake);
+	}
+	HVPT::UpdateOrthoVoxelGridBake(SceneState.OrthoGridBake);
+
+	FHVPTOrthoGridStatsReadback& StatsReadback = SceneState.OrthoGridStatsReadback;
+	StatsReadback.bDumpWhenReady |= HVPT::ConsumeDumpStatsRequestForOrthoGrid();
+	if (OrthoGridUniformBuffer && (HVPT::EnableStatsForOrthoGrid() || StatsReadback.bDumpWhenReady))
+	{
+		HVPT::QueueOrthoVoxelGridStatsReadback(
+			GraphBuilder,
+			Scene,
+			OrthoGridUniformBuffer,
+			SceneState.bUseBakedOrthoGrid ? FHVPTBrickPool() : SceneState.OrthoGridBrickPool,
+			SceneState.OrthoGridParameterCache.VolumeRecords,
+			StatsReadback
+		);
+	}
+	HVPT::UpdateOrthoVoxelGridStats(StatsReadback);
+}
+
 
 void HVPT::DrawDebugOverlay(
 	FRDGBuilder& GraphBuilder,
 	const FViewInfo& ViewInfo,
 	FHVPTViewState& State)
 {
+	const bool bHasCollisionStats = State.CollisionStatsReadback.bHasStats;
+	const float NullCollisionsPerPath = State.CollisionStatsReadback.NullCollisionsPerPath;
+	const float RealCollisionsPerPath = State.CollisionStatsReadback.RealCollisionsPerPath;
+
 	FScreenPassRenderTarget Output(State.DebugTexture, ViewInfo.ViewRect, ERenderTargetLoadAction::ELoad);
 	AddDrawCanvasPass(GraphBuilder, RDG_EVENT_NAME("HVPTDebugOverlay"), ViewInfo, Output,
-		[&ViewInfo](FCanvas& Canvas)
+		[&ViewInfo, bHasCollisionStats, NullCollisionsPerPath, RealCollisionsPerPath](FCanvas& Canvas)
 		{
 			float X = 20;
 			float Y = 20;
@@ -450,6 +660,7 @@ void HVPT::DrawDebugOverlay(
 				TEXT("Fireflies"),
 				TEXT("Reprojection"),
 				TEXT("Multi-Pass SR Overalloc"),
+				TEXT("Collisions (Null/Real)"),
 			};
 
 			{
@@ -522,7 +733,20 @@ void HVPT::DrawDebugOverlay(
 				bool bEnabled = HVPT::GetSpatialReuseEnabled() && HVPT::GetMultiPassSpatialReuseEnabled();
 				Line = FString::Printf(TEXT("Multi-Pass Spatial Reuse=%s"), bEnabled ? TEXT("True") : TEXT("False"));
 				Canvas.DrawShadowedString(X, Y += YStep, *Line, GetStatsFont(), bEnabled ? FLinearColor::Green : FLinearColor::Red);
-			}
+			} break;
+			case HVPT_DEBUG_VIEW_MODE_COLLISIONS:
+			{
+				if (!bHasCollisionStats)
+				{
+					Line = FString::Printf(TEXT("Waiting for collision readback"));
+					Canvas.DrawShadowedString(X, Y += YStep, *Line, GetStatsFont(), FLinearColor::Gray);
+					break;
+				}
+				Line = FString::Printf(TEXT("Null Collisions Per Path=%.2f"), NullCollisionsPerPath);
+				Canvas.DrawShadowedString(X, Y += YStep, *Line, GetStatsFont(), FLinearColor::Red);
+				Line = FString::Printf(TEXT("Real Collisions Per Path=%.2f"), RealCollisionsPerPath);
+				Canvas.DrawShadowedString(X, Y += YStep, *Line, GetStatsFont(), FLinearColor::Green);
+			} break;
 			default:
 				break;
 			}
@@ -2,8 +2,10 @@
 
 #include "SceneViewExtension.h"
 
+class FScene;
 class FSceneViewState;
 struct FHVPTViewState;
+struct FHVPTSceneState;
 
 class FSceneTextureParameters;
 
@@ -18,8 +20,11 @@ public:
 	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
 	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
 
+	virtual void PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
 	virtual void PreRenderView_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView) override;
 
+	virtual void PreRenderBasePass_RenderThread(FRDGBuilder& GraphBuilder, bool bDepthBufferIsPopulated) override;
+
 	virtual void PostRenderBasePassDeferred_RenderThread(
 		FRDGBuilder& GraphBuilder, FSceneView& InView, const FRenderTargetBindingSlots& RenderTargets, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTextures
 	) override;
@@ -29,12 +34,18 @@ public:
 	) override;
 
 	virtual void PostRenderView_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView) override;
+	virtual void PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
 	//~ End ISceneViewExtension interface
 
 protected:
 	virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
 
 	FHVPTViewState* GetOrCreateViewStateForView(const FViewInfo& ViewInfo);
+	FHVPTSceneState& GetOrCreateSceneState(const FScene& Scene);
+
+	// Builds the ortho and frustum grids used by the view
+	// Called once views are initialized and before the base pass, so that on the async compute queue the build overlaps with the base pass
+	void BuildVoxelGrids(FRDGBuilder& GraphBuilder, const FViewInfo& ViewInfo, const FScene* Scene, FHVPTViewState& ViewState);
 
 private:
 
@@ -47,6 +58,12 @@ private:
 	FDelegateHandle AnyRTPassEnabledDelegateHandle;
 
 	TMap<FSceneViewState*, TUniquePtr<FHVPTViewState>> ViewStates;
+
+	// Family being rendered, as PreRenderBasePass_RenderThread is not given its views. Only accessed on the render thread
+	const FSceneViewFamily* RenderingViewFamily = nullptr;
+
+	// Resources shared by all views of a scene, such as the ortho grid
+	TMap<const FScene*, TUniquePtr<FHVPTSceneState>> SceneStates;
 };
 
 
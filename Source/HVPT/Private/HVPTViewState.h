@@ -2,6 +2,7 @@
 
 #include "RenderGraphFwd.h"
 #include "Rendering/VoxelGrid.h"
+#include "Rendering/VoxelGridStats.h"
 
 
 // Collection of all resources required by a view to render Heterogeneous Volumes with the path tracing pipeline
@@ -19,9 +20,12 @@ struct FHVPTViewState
 
 	TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> OrthoGridUniformBuffer = nullptr;
 	TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters> FrustumGridUniformBuffer = nullptr;
+	bool bVoxelGridsBuilt = false;
 
 	FRDGTextureRef DebugTexture = nullptr; // General purpose texture for debug visualization
 	uint32 DebugFlags = 0;
+	// Averages of the collisions shown by HVPT_DEBUG_VIEW_MODE_COLLISIONS, see stat HVPT
+	FHVPTCollisionStatsReadback CollisionStatsReadback;
 
 	// Cached resources used between frames
 
@@ -30,9 +34,15 @@ struct FHVPTViewState
 
 	TRefCountPtr<FRDGPooledBuffer> ReSTIRReservoirCache = nullptr;
 	TRefCountPtr<FRDGPooledBuffer> ReSTIRExtraBounceCache = nullptr;
+	// Luminance moments of each reservoir, for r.HVPT.ReSTIR.AdaptiveCandidates
+	TRefCountPtr<FRDGPooledBuffer> ReSTIRLuminanceMomentsCache = nullptr;
 
-	FHVPTOrthoGridParameterCache OrthoGridParameterCache;
+	// The ortho grid cache is shared between views, see FHVPTSceneState
 	FHVPTFrustumGridParameterCache FrustumGridParameterCache;
+	FHVPTBrickPool FrustumGridBrickPool;
+	// Pool the frustum grid is not being rendered from, only allocated with r.HVPT.GridBuild.OneFrameLatency
+	FHVPTBrickPool FrustumGridBackBrickPool;
+	FHVPTFrustumGridRebuildState FrustumGridRebuildState;
 
 	uint32 AccumulatedSampleCount = 0;
 
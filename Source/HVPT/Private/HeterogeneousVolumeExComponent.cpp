@@ -9,6 +9,9 @@
 #include "Materials/Material.h"
 #include "Materials/MaterialInterface.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "Engine/Font.h"
+#include "VT/RuntimeVirtualTexture.h"
+#include "Hash/xxhash.h"
 
 #include "Engine/World.h"
 #include "StaticMeshResources.h"
@@ -81,7 +84,22 @@ UHeterogeneousVolumeExComponent::UHeterogeneousVolumeExComponent(const FObjectIn
 	StreamingMipBias = 0.0f;
 	bIssueBlockingRequests = false;
 	bPivotAtCentroid = false;
+	bMonochromeExtinction = false;
+	MinBrickResolution = 1;
+	MaxBrickResolution = 0;
+	LODDistanceBias = 0.0f;
+	LODImportance = 1.0f;
+	bSampleSparseVolumeTextureDirectly = false;
+	DirectExtinctionScale = 1.0f;
+	DirectMaxDensity = 1.0f;
+	DirectAlbedo = FLinearColor::White;
+	DirectEmissionScale = 0.0f;
 	PreviousSVT = nullptr;
+	PreviousSVTFrame = nullptr;
+	DataRevision = 0;
+	ContentRevision = 0;
+	FrameCacheKeyMaterialInstance = nullptr;
+	bFrameCacheKeyParametersDirty = true;
 }
 
 void UHeterogeneousVolumeExComponent::SetStreamingMipBias(int32 NewValue)
@@ -94,6 +112,22 @@ void UHeterogeneousVolumeExComponent::SetStreamingMipBias(int32 NewValue)
 	}
 }
 
+void UHeterogeneousVolumeExComponent::SetLODPolicy(int32 NewMinBrickResolution, int32 NewMaxBrickResolution, float NewLODDistanceBias, float NewLODImportance)
+{
+	if (AreDynamicDataChangesAllowed()
+		&& (MinBrickResolution != NewMinBrickResolution
+			|| MaxBrickResolution != NewMaxBrickResolution
+			|| LODDistanceBias != NewLODDistanceBias
+			|| LODImportance != NewLODImportance))
+	{
+		MinBrickResolution = NewMinBrickResolution;
+		MaxBrickResolution = NewMaxBrickResolution;
+		LODDistanceBias = NewLODDistanceBias;
+		LODImportance = NewLODImportance;
+		MarkRenderStateDirty();
+	}
+}
+
 void UHeterogeneousVolumeExComponent::SetVolumeResolution(FIntVector NewValue)
 {
 	if (AreDynamicDataChangesAllowed()
@@ -174,6 +208,75 @@ void UHeterogeneousVolumeExComponent::Play()
 	}
 }
 
+void UHeterogeneousVolumeExComponent::MarkVolumeDataDirty()
+{
+	DataRevision++;
+	ContentRevision++;
+	bFrameCacheKeyParametersDirty = true;
+	MarkRenderDynamicDataDirty();
+}
+
+namespace
+{
+
+template<typename ValueType>
+void UpdateParameterHash(FXxHash64Builder& Builder, const FMaterialParameterInfo& ParameterInfo, const ValueType& Value)
+{
+	const uint32 ParameterInfoHash = GetTypeHash(ParameterInfo);
+	Builder.Update(&ParameterInfoHash, sizeof(ParameterInfoHash));
+	Builder.Update(&Value, sizeof(Value));
+}
+
+template<typename ParameterValueType, typename GetValueType>
+void UpdateParameterHash(FXxHash64Builder& Builder, const TArray<ParameterValueType>& Parameters, FName SkippedParameterName, GetValueType GetValue)
+{
+	const int32 ParameterCount = Parameters.Num();
+	Builder.Update(&ParameterCount, sizeof(ParameterCount));
+	for (const ParameterValueType& Parameter : Parameters)
+	{
+		if (Parameter.ParameterInfo.Name != SkippedParameterName)
+		{
+			UpdateParameterHash(Builder, Parameter.ParameterInfo, GetValue(Parameter));
+		}
+	}
+}
+
+}
+
+void UHeterogeneousVolumeExComponent::CalcFrameCacheKeyParameters(FName SVTParameterName, FHeterogeneousVolumeExFrameKey& FrameKey) const
+{
+	// The MID belongs to this component only, so it is identified by its base material and the parameters set along the chain of
+	// instances, to let other instances of the same material share the frame. The frame itself is set as a parameter on the MID,
+	// and is part of the key already
+	FXxHash64Builder Builder;
+	for (const UMaterialInstance* MaterialInstance = MaterialInstanceDynamic; MaterialInstance; MaterialInstance = Cast<UMaterialInstance>(MaterialInstance->Parent))
+	{
+		UpdateParameterHash(Builder, MaterialInstance->ScalarParameterValues, NAME_None, [](const FScalarParameterValue& Parameter) { return Parameter.ParameterValue; });
+		UpdateParameterHash(Builder, MaterialInstance->VectorParameterValues, NAME_None, [](const FVectorParameterValue& Parameter) { return Parameter.ParameterValue; });
+		UpdateParameterHash(Builder, MaterialInstance->DoubleVectorParameterValues, NAME_None, [](const FDoubleVectorParameterValue& Parameter) { return Parameter.ParameterValue; });
+		UpdateParameterHash(Builder, MaterialInstance->TextureParameterValues, NAME_None, [](const FTextureParameterValue& Parameter) { return Parameter.ParameterValue.Get(); });
+		UpdateParameterHash(Builder, MaterialInstance->RuntimeVirtualTextureParameterValues, NAME_None, [](const FRuntimeVirtualTextureParameterValue& Parameter) { return Parameter.ParameterValue.Get(); });
+		UpdateParameterHash(Builder, MaterialInstance->SparseVolumeTextureParameterValues, SVTParameterName, [](const FSparseVolumeTextureParameterValue& Parameter) { return Parameter.ParameterValue.Get(); });
+		UpdateParameterHash(Builder, MaterialInstance->FontParameterValues, NAME_None, [](const FFontParameterValue& Parameter) { return HashCombine(GetTypeHash(Parameter.FontValue.Get()), GetTypeHash(Parameter.FontPage)); });
+
+		// Static switches select a different shader rather than different uniforms, but still change what is rasterized
+		const FStaticParameterSet& StaticParameters = MaterialInstance->GetStaticParameters();
+		UpdateParameterHash(Builder, StaticParameters.StaticSwitchParameters, NAME_None, [](const FStaticSwitchParameter& Parameter) { return HashCombine(GetTypeHash(Parameter.Value), GetTypeHash(Parameter.bOverride)); });
+	}
+
+	FrameKey.Material = FObjectKey(MaterialInstanceDynamic->GetMaterial());
+	FrameKey.ParameterHash = Builder.Finalize().Hash;
+}
+
+const UE::SVT::FTextureRenderResources* UHeterogeneousVolumeExComponent::GetDirectSparseVolumeTexture() const
+{
+	if (bSampleSparseVolumeTextureDirectly && PreviousSVTFrame)
+	{
+		return PreviousSVTFrame->GetTextureRenderResources();
+	}
+	return nullptr;
+}
+
 FPrimitiveSceneProxy* UHeterogeneousVolumeExComponent::CreateSceneProxy()
 {
 	return new FHeterogeneousVolumeExSceneProxy(this);
@@ -493,6 +596,27 @@ void UHeterogeneousVolumeExComponent::TickComponent(float DeltaTime, ELevelTick
 			const bool bHasValidFrameRate = bPlaying != 0;
 			const float MipLevel = SparseVolumeTexture_GetOptimalStreamingMipLevel(SparseVolumeTexture, Bounds, StreamingMipBias);
 			USparseVolumeTextureFrame* SparseVolumeTextureFrame = USparseVolumeTextureFrame::GetFrameAndIssueStreamingRequest(SparseVolumeTexture, GetTypeHash(this), FrameRate, Frame, MipLevel, bIsBlocking, bHasValidFrameRate);
+			if (SparseVolumeTextureFrame != PreviousSVTFrame)
+			{
+				// The volume contents change with the frame even when the proxy doesn't need to be recreated
+				PreviousSVTFrame = SparseVolumeTextureFrame;
+				DataRevision++;
+				MarkRenderDynamicDataDirty();
+			}
+
+			// Hashing the parameters walks every parameter of the material instances, so it is only redone when they may have changed
+			FHeterogeneousVolumeExFrameKey NewFrameCacheKey = FrameCacheKey;
+			if (bFrameCacheKeyParametersDirty || FrameCacheKeyMaterialInstance != MaterialInstanceDynamic)
+			{
+				CalcFrameCacheKeyParameters(SVTParameterName, NewFrameCacheKey);
+				FrameCacheKeyMaterialInstance = MaterialInstanceDynamic;
+				bFrameCacheKeyParametersDirty = false;
+			}
+			NewFrameCacheKey.SparseVolumeTextureFrame = FObjectKey(SparseVolumeTextureFrame);
+			NewFrameCacheKey.MipLevel = FMath::FloorToInt32(MipLevel);
+			NewFrameCacheKey.ContentRevision = ContentRevision;
+			SetFrameCacheKey(NewFrameCacheKey);
+
 			if (SparseVolumeTextureFrame)
 			{
 				FIntVector PerFrameVolumeResolution = SparseVolumeTextureFrame->GetVolumeResolution();
@@ -512,6 +636,41 @@ void UHeterogeneousVolumeExComponent::TickComponent(float DeltaTime, ELevelTick
 
 			MaterialInstanceDynamic->SetSparseVolumeTextureParameterValue(SVTParameterName, SparseVolumeTextureFrame);
 		}
+		else
+		{
+			SetFrameCacheKey(FHeterogeneousVolumeExFrameKey());
+		}
+	}
+}
+
+void UHeterogeneousVolumeExComponent::SetFrameCacheKey(const FHeterogeneousVolumeExFrameKey& NewFrameCacheKey)
+{
+	// The ortho grid may have to restore the bricks of another frame even if the data revision has not changed, e.g. for a new mip level
+	if (NewFrameCacheKey != FrameCacheKey)
+	{
+		FrameCacheKey = NewFrameCacheKey;
+		MarkRenderDynamicDataDirty();
+	}
+}
+
+void UHeterogeneousVolumeExComponent::SendRenderDynamicData_Concurrent()
+{
+	Super::SendRenderDynamicData_Concurrent();
+
+	if (SceneProxy)
+	{
+		FHeterogeneousVolumeExSceneProxy* HeterogeneousVolumeExSceneProxy = static_cast<FHeterogeneousVolumeExSceneProxy*>(SceneProxy);
+		const uint32 NewDataRevision = DataRevision;
+		const FHeterogeneousVolumeExFrameKey NewFrameCacheKey = FrameCacheKey;
+		// The frame that is sampled directly changes along with the data revision
+		const UE::SVT::FTextureRenderResources* NewDirectSparseVolumeTexture = GetDirectSparseVolumeTexture();
+		ENQUEUE_RENDER_COMMAND(FHeterogeneousVolumeExUpdateDataRevision)(
+			[HeterogeneousVolumeExSceneProxy, NewDataRevision, NewFrameCacheKey, NewDirectSparseVolumeTexture](FRHICommandListImmediate& RHICmdList)
+			{
+				HeterogeneousVolumeExSceneProxy->SetDataRevision_RenderThread(NewDataRevision, NewFrameCacheKey);
+				HeterogeneousVolumeExSceneProxy->SetDirectSparseVolumeTexture_RenderThread(NewDirectSparseVolumeTexture);
+			}
+		);
 	}
 }
 
@@ -52,8 +52,22 @@ FHeterogeneousVolumeExSceneProxy::FHeterogeneousVolumeExSceneProxy(UHeterogeneou
 	HeterogeneousVolumeData.MipBias = InComponent->StreamingMipBias;
 	HeterogeneousVolumeData.bPivotAtCentroid = InComponent->bPivotAtCentroid;
 	HeterogeneousVolumeData.bHoldout = InComponent->bHoldout;
+	HeterogeneousVolumeData.bMonochromeExtinction = InComponent->bMonochromeExtinction;
+
+	HeterogeneousVolumeData.MinBrickResolution = InComponent->MinBrickResolution;
+	HeterogeneousVolumeData.MaxBrickResolution = InComponent->MaxBrickResolution;
+	HeterogeneousVolumeData.LODDistanceBias = InComponent->LODDistanceBias;
+	HeterogeneousVolumeData.LODImportance = InComponent->LODImportance;
+
+	HeterogeneousVolumeData.DirectSparseVolumeTexture = InComponent->GetDirectSparseVolumeTexture();
+	HeterogeneousVolumeData.DirectExtinctionScale = InComponent->DirectExtinctionScale;
+	HeterogeneousVolumeData.DirectMaxDensity = InComponent->DirectMaxDensity;
+	HeterogeneousVolumeData.DirectAlbedo = InComponent->DirectAlbedo;
+	HeterogeneousVolumeData.DirectEmissionScale = InComponent->DirectEmissionScale;
 
 	HeterogeneousVolumeData.bIsPlayingAnimation = InComponent->bPlaying;
+	HeterogeneousVolumeData.DataRevision = InComponent->GetDataRevision();
+	HeterogeneousVolumeData.FrameCacheKey = InComponent->GetFrameCacheKey();
 
 	// Initialize vertex buffer data for a quad
 	StaticMeshVertexBuffers.PositionVertexBuffer.Init(4);
@@ -105,6 +119,19 @@ FHeterogeneousVolumeExSceneProxy::~FHeterogeneousVolumeExSceneProxy()
 	StaticMeshVertexBuffers.ColorVertexBuffer.ReleaseResource();
 }
 
+void FHeterogeneousVolumeExSceneProxy::SetDataRevision_RenderThread(uint32 NewDataRevision, const FHeterogeneousVolumeExFrameKey& NewFrameCacheKey)
+{
+	check(IsInRenderingThread());
+	HeterogeneousVolumeData.DataRevision = NewDataRevision;
+	HeterogeneousVolumeData.FrameCacheKey = NewFrameCacheKey;
+}
+
+void FHeterogeneousVolumeExSceneProxy::SetDirectSparseVolumeTexture_RenderThread(const UE::SVT::FTextureRenderResources* NewDirectSparseVolumeTexture)
+{
+	check(IsInRenderingThread());
+	HeterogeneousVolumeData.DirectSparseVolumeTexture = NewDirectSparseVolumeTexture;
+}
+
 SIZE_T FHeterogeneousVolumeExSceneProxy::GetStaticTypeHash()
 {
 	return reinterpret_cast<size_t>(&GHeterogeneousVolumeExSceneProxy_UniquePointer);
@@ -35,6 +35,10 @@ public:
 	virtual uint32 GetMemoryFootprint(void) const override { return sizeof(*this) + GetAllocatedSize(); }
 	//~ End FPrimitiveSceneProxy Interface.
 
+	// Called on the render thread when the component's volume data changes without recreating the proxy
+	void SetDataRevision_RenderThread(uint32 NewDataRevision, const FHeterogeneousVolumeExFrameKey& NewFrameCacheKey);
+	void SetDirectSparseVolumeTexture_RenderThread(const UE::SVT::FTextureRenderResources* NewDirectSparseVolumeTexture);
+
 	// This is a bit of an ugly hack to be able to identify when a FPrimitiveSceneProxy is a FHeterogeneousVolumeExSceneProxy
 	static SIZE_T GetStaticTypeHash();
 
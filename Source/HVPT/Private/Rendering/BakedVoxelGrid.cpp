@@ -0,0 +1,520 @@
+#include "BakedVoxelGrid.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "SceneRendering.h"
+#include "SystemTextures.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+#include "VoxelGrid.h"
+#include "GridDataFormat.h"
+#include "MajorantPyramid.h"
+#include "VoxelGridStats.h"
+
+
+namespace
+{
+
+constexpr uint32 BakedOrthoGridMagic = 0x42505648; // "HVPB"
+constexpr uint32 BakedOrthoGridVersion = 2;
+
+// Sections are aligned so that they can be viewed as arrays straight from a memory mapped file
+constexpr int64 BakedOrthoGridSectionAlignment = 16;
+
+enum EBakedOrthoGridSection
+{
+	Section_TopLevelGrid = 0,
+	Section_FirstChannel,
+	Section_Majorants = Section_FirstChannel + HVPT_GRID_DATA_CHANNEL_COUNT,
+	Section_SubBrickMajorants,
+	Section_Count
+};
+
+struct FBakedOrthoGridSection
+{
+	uint64 Offset;
+	uint64 Size;
+};
+
+struct FBakedOrthoGridHeader
+{
+	uint32 Magic;
+	uint32 Version;
+
+	float TopLevelGridWorldBoundsMin[3];
+	float TopLevelGridWorldBoundsMax[3];
+	int32 TopLevelGridResolution[3];
+
+	uint32 GridDataFormats;
+	int32 VoxelsPerBrick;
+	int32 BrickCount;
+
+	int32 MajorantMipCount;
+	int32 SubBricksPerBrick;
+
+	FBakedOrthoGridSection Sections[Section_Count];
+};
+
+// Matches the encoding of FHVPT_TopLevelGridData in VoxelGridBuildUtils.ush
+constexpr uint32 EmptyVoxelIndex = 0x1FFFFFFF;
+
+uint32 GetBottomLevelIndex(uint32 TopLevelGridData)
+{
+	return TopLevelGridData >> 3;
+}
+
+uint32 SetBottomLevelIndex(uint32 TopLevelGridData, uint32 BottomLevelIndex)
+{
+	return (BottomLevelIndex << 3) | (TopLevelGridData & 0x7);
+}
+
+// Cells of directly sampled and instanced volumes hold the slot of the volume in place of a brick, just below EmptyVoxelIndex
+constexpr uint32 FirstVolumeSlotIndex = EmptyVoxelIndex - HVPT_MAX_DIRECT_VOLUMES - HVPT_MAX_INSTANCED_VOLUMES;
+
+bool IsBottomLevelAllocated(uint32 TopLevelGridData)
+{
+	return GetBottomLevelIndex(TopLevelGridData) < FirstVolumeSlotIndex;
+}
+
+int64 CalcTopLevelCellCount(const FIntVector& TopLevelGridResolution)
+{
+	return static_cast<int64>(TopLevelGridResolution.X) * TopLevelGridResolution.Y * TopLevelGridResolution.Z;
+}
+
+}
+
+
+int32 HVPT::Private::CalcBakedChannelDataSize(uint32 GridDataFormats, int32 Channel, int32 VoxelsPerBrick, int32 BrickCount)
+{
+	return CalcGridDataBufferSize(GetGridDataFormat(GridDataFormats, Channel), VoxelsPerBrick * BrickCount) * sizeof(FHVPT_GridData);
+}
+
+void HVPT::Private::SerializeBakedOrthoGrid(const FHVPTBakedOrthoGrid& Grid, TArray<uint8>& OutBytes)
+{
+	check(Grid.TopLevelGrid.Num() == CalcTopLevelCellCount(Grid.TopLevelGridResolution));
+	check(Grid.VoxelsPerBrick > 0);
+	check(Grid.SubBrickMajorants.Num() == static_cast<int64>(CalcMajorantMipSize(Grid.TopLevelGridResolution)) * Grid.SubBricksPerBrick);
+
+	// Give the slabs new indices in the order of the cells that use them, so that the unused slabs of the pool are left behind.
+	// Smaller bricks share a slab, so they keep their offset within it
+	TArray<uint32> TopLevelGrid(Grid.TopLevelGrid);
+	TArray<int32> SourceBricks;
+	TMap<int32, int32> BakedBrickIndices;
+	for (uint32& TopLevelGridData : TopLevelGrid)
+	{
+		if (IsBottomLevelAllocated(TopLevelGridData))
+		{
+			const uint32 BottomLevelIndex = GetBottomLevelIndex(TopLevelGridData);
+			const int32 SourceBrickIndex = BottomLevelIndex / Grid.VoxelsPerBrick;
+
+			int32* BakedBrickIndex = BakedBrickIndices.Find(SourceBrickIndex);
+			if (!BakedBrickIndex)
+			{
+				BakedBrickIndex = &BakedBrickIndices.Add(SourceBrickIndex, SourceBricks.Add(SourceBrickIndex));
+			}
+			TopLevelGridData = SetBottomLevelIndex(TopLevelGridData, *BakedBrickIndex * Grid.VoxelsPerBrick + BottomLevelIndex % Grid.VoxelsPerBrick);
+		}
+		else
+		{
+			// The volumes the slots refer to are not part of the bake
+			TopLevelGridData = SetBottomLevelIndex(TopLevelGridData, EmptyVoxelIndex);
+		}
+	}
+	const int32 BrickCount = SourceBricks.Num();
+
+	FBakedOrthoGridHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = BakedOrthoGridMagic;
+	Header.Version = BakedOrthoGridVersion;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Header.TopLevelGridWorldBoundsMin[Axis] = Grid.TopLevelGridWorldBoundsMin[Axis];
+		Header.TopLevelGridWorldBoundsMax[Axis] = Grid.TopLevelGridWorldBoundsMax[Axis];
+		Header.TopLevelGridResolution[Axis] = Grid.TopLevelGridResolution[Axis];
+	}
+	Header.GridDataFormats = Grid.GridDataFormats;
+	Header.VoxelsPerBrick = Grid.VoxelsPerBrick;
+	Header.BrickCount = BrickCount;
+	Header.MajorantMipCount = Grid.MajorantMipCount;
+	Header.SubBricksPerBrick = Grid.SubBricksPerBrick;
+
+	Header.Sections[Section_TopLevelGrid].Size = TopLevelGrid.Num() * sizeof(uint32);
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		Header.Sections[Section_FirstChannel + Channel].Size = CalcBakedChannelDataSize(Grid.GridDataFormats, Channel, Grid.VoxelsPerBrick, BrickCount);
+	}
+	Header.Sections[Section_Majorants].Size = Grid.Majorants.Num() * sizeof(uint32);
+	Header.Sections[Section_SubBrickMajorants].Size = Grid.SubBrickMajorants.Num() * sizeof(uint32);
+
+	uint64 Offset = Align(sizeof(FBakedOrthoGridHeader), BakedOrthoGridSectionAlignment);
+	for (FBakedOrthoGridSection& Section : Header.Sections)
+	{
+		Section.Offset = Offset;
+		Offset = Align(Offset + Section.Size, BakedOrthoGridSectionAlignment);
+	}
+
+	OutBytes.SetNumZeroed(Offset);
+	FMemory::Memcpy(OutBytes.GetData(), &Header, sizeof(Header));
+
+	auto GetSectionData = [&OutBytes, &Header](int32 Section)
+	{
+		return OutBytes.GetData() + Header.Sections[Section].Offset;
+	};
+
+	FMemory::Memcpy(GetSectionData(Section_TopLevelGrid), TopLevelGrid.GetData(), Header.Sections[Section_TopLevelGrid].Size);
+
+	// The voxels of every format are tightly packed, so a brick is a contiguous run of bytes in its channel
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		const int64 BrickSize = static_cast<int64>(Grid.VoxelsPerBrick) * CalcGridDataBytesPerVoxel(GetGridDataFormat(Grid.GridDataFormats, Channel));
+		uint8* ChannelData = GetSectionData(Section_FirstChannel + Channel);
+
+		for (int32 BakedBrickIndex = 0; BakedBrickIndex < BrickCount; ++BakedBrickIndex)
+		{
+			const int64 SourceOffset = SourceBricks[BakedBrickIndex] * BrickSize;
+			check(SourceOffset + BrickSize <= Grid.ChannelData[Channel].Num());
+			FMemory::Memcpy(ChannelData + BakedBrickIndex * BrickSize, Grid.ChannelData[Channel].GetData() + SourceOffset, BrickSize);
+		}
+	}
+
+	// Sub-brick majorants are indexed by top-level cell rather than by brick, so they do not move with the bricks
+	FMemory::Memcpy(GetSectionData(Section_Majorants), Grid.Majorants.GetData(), Header.Sections[Section_Majorants].Size);
+	FMemory::Memcpy(GetSectionData(Section_SubBrickMajorants), Grid.SubBrickMajorants.GetData(), Header.Sections[Section_SubBrickMajorants].Size);
+}
+
+bool HVPT::Private::ParseBakedOrthoGrid(TConstArrayView<uint8> Bytes, FHVPTBakedOrthoGrid& OutGrid)
+{
+	if (Bytes.Num() < sizeof(FBakedOrthoGridHeader) || !IsAligned(Bytes.GetData(), BakedOrthoGridSectionAlignment))
+	{
+		return false;
+	}
+
+	FBakedOrthoGridHeader Header;
+	FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+	if (Header.Magic != BakedOrthoGridMagic || Header.Version != BakedOrthoGridVersion)
+	{
+		return false;
+	}
+
+	const FIntVector TopLevelGridResolution(Header.TopLevelGridResolution[0], Header.TopLevelGridResolution[1], Header.TopLevelGridResolution[2]);
+	if (TopLevelGridResolution.GetMin() <= 0 || Header.VoxelsPerBrick <= 0 || Header.BrickCount < 0 || Header.MajorantMipCount <= 0 || Header.MajorantMipCount > HVPT_MAX_MAJORANT_MIP_COUNT || Header.SubBricksPerBrick < 0)
+	{
+		return false;
+	}
+
+	// Every section must be in bounds, and exactly as large as the header says the grid needs
+	uint64 ExpectedSizes[Section_Count];
+	ExpectedSizes[Section_TopLevelGrid] = CalcTopLevelCellCount(TopLevelGridResolution) * sizeof(uint32);
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		ExpectedSizes[Section_FirstChannel + Channel] = CalcBakedChannelDataSize(Header.GridDataFormats, Channel, Header.VoxelsPerBrick, Header.BrickCount);
+	}
+	ExpectedSizes[Section_Majorants] = CalcMajorantMipOffset(TopLevelGridResolution, Header.MajorantMipCount) * sizeof(uint32);
+	ExpectedSizes[Section_SubBrickMajorants] = static_cast<uint64>(CalcMajorantMipSize(TopLevelGridResolution)) * Header.SubBricksPerBrick * sizeof(uint32);
+
+	for (int32 Section = 0; Section < Section_Count; ++Section)
+	{
+		const FBakedOrthoGridSection& SectionHeader = Header.Sections[Section];
+		if (SectionHeader.Size != ExpectedSizes[Section]
+			|| SectionHeader.Offset % BakedOrthoGridSectionAlignment != 0
+			|| SectionHeader.Offset > static_cast<uint64>(Bytes.Num())
+			|| SectionHeader.Size > static_cast<uint64>(Bytes.Num()) - SectionHeader.Offset)
+		{
+			return false;
+		}
+	}
+
+	auto GetSectionView = [&Bytes, &Header](int32 Section)
+	{
+		return Bytes.Slice(Header.Sections[Section].Offset, Header.Sections[Section].Size);
+	};
+	auto GetSectionViewAsUints = [&GetSectionView](int32 Section)
+	{
+		const TConstArrayView<uint8> View = GetSectionView(Section);
+		return TConstArrayView<uint32>(reinterpret_cast<const uint32*>(View.GetData()), View.Num() / sizeof(uint32));
+	};
+
+	OutGrid.TopLevelGridWorldBoundsMin = FVector3f(Header.TopLevelGridWorldBoundsMin[0], Header.TopLevelGridWorldBoundsMin[1], Header.TopLevelGridWorldBoundsMin[2]);
+	OutGrid.TopLevelGridWorldBoundsMax = FVector3f(Header.TopLevelGridWorldBoundsMax[0], Header.TopLevelGridWorldBoundsMax[1], Header.TopLevelGridWorldBoundsMax[2]);
+	OutGrid.TopLevelGridResolution = TopLevelGridResolution;
+	OutGrid.GridDataFormats = Header.GridDataFormats;
+	OutGrid.VoxelsPerBrick = Header.VoxelsPerBrick;
+	OutGrid.BrickCount = Header.BrickCount;
+	OutGrid.MajorantMipCount = Header.MajorantMipCount;
+	OutGrid.SubBricksPerBrick = Header.SubBricksPerBrick;
+
+	OutGrid.TopLevelGrid = GetSectionViewAsUints(Section_TopLevelGrid);
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		OutGrid.ChannelData[Channel] = GetSectionView(Section_FirstChannel + Channel);
+	}
+	OutGrid.Majorants = GetSectionViewAsUints(Section_Majorants);
+	OutGrid.SubBrickMajorants = GetSectionViewAsUints(Section_SubBrickMajorants);
+
+	// A corrupt index or resolution would let the shaders read outside of the brick pool
+	const uint64 BottomLevelVoxelCount = static_cast<uint64>(Header.BrickCount) * Header.VoxelsPerBrick;
+	for (uint32 TopLevelGridData : OutGrid.TopLevelGrid)
+	{
+		const uint32 VoxelResolution = TopLevelGridData & 0x7;
+		if (IsBottomLevelAllocated(TopLevelGridData)
+			&& (VoxelResolution > HVPT_MAX_BRICK_RESOLUTION || static_cast<uint64>(GetBottomLevelIndex(TopLevelGridData)) + VoxelResolution * VoxelResolution * VoxelResolution > BottomLevelVoxelCount))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+void HVPT::BakeOrthoVoxelGrid(
+	FRDGBuilder& GraphBuilder, const TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer, const FString& Filename, FHVPTOrthoGridBake& Bake
+)
+{
+	const TRDGParameterStruct<FHVPTOrthoGridUniformBufferParameters>& Parameters = OrthoGridUniformBuffer->GetParameters();
+	if (!Parameters->bUseOrthoGrid || Parameters->TopLevelGridWorldBoundsMin == Parameters->TopLevelGridWorldBoundsMax)
+	{
+		UE_LOG(LogHVPT, Warning, TEXT("Cannot bake the ortho grid to '%s', as the grid is empty"), *Filename);
+		return;
+	}
+
+	// Directly sampled volumes have no bricks, and their textures are not part of the bake
+	if (Parameters->NumDirectVolumes > 0)
+	{
+		UE_LOG(LogHVPT, Warning, TEXT("%d volume(s) are sampled directly and will be empty in '%s'. Disable r.HVPT.OrthoGrid.DirectVolumes before baking to include them."),
+			Parameters->NumDirectVolumes, *Filename);
+	}
+
+	// Nor are the local grids of instanced volumes, as only the top-level grid refers to bricks in the bake
+	if (Parameters->NumInstancedVolumes > 0)
+	{
+		UE_LOG(LogHVPT, Warning, TEXT("%d instanced volume(s) share local grids and will be empty in '%s'. Disable r.HVPT.OrthoGrid.InstancedVolumes before baking to include them."),
+			Parameters->NumInstancedVolumes, *Filename);
+	}
+
+	Bake = FHVPTOrthoGridBake();
+	Bake.Filename = Filename;
+
+	FHVPTBakedOrthoGrid& Grid = Bake.Grid;
+	Grid.TopLevelGridWorldBoundsMin = Parameters->TopLevelGridWorldBoundsMin;
+	Grid.TopLevelGridWorldBoundsMax = Parameters->TopLevelGridWorldBoundsMax;
+	Grid.TopLevelGridResolution = Parameters->TopLevelGridResolution;
+	Grid.GridDataFormats = Parameters->GridDataFormats;
+	Grid.VoxelsPerBrick = Parameters->VoxelsPerBrick;
+	Grid.MajorantMipCount = Parameters->MajorantMipCount;
+	Grid.SubBricksPerBrick = Parameters->bUseSubBrickMajorants ? Parameters->SubBricksPerBrick : 0;
+
+	FRDGBufferRef Buffers[] = {
+		Parameters->TopLevelGridBuffer->GetParent(),
+		Parameters->ExtinctionGridBuffer->GetParent(),
+		Parameters->EmissionGridBuffer->GetParent(),
+		Parameters->ScatteringGridBuffer->GetParent(),
+		Parameters->VelocityGridBuffer->GetParent(),
+		Parameters->MajorantGridBuffer->GetParent(),
+		Parameters->SubBrickMajorantGridBuffer->GetParent(),
+	};
+	static_assert(UE_ARRAY_COUNT(Buffers) == Section_Count);
+
+	for (FRDGBufferRef Buffer : Buffers)
+	{
+		const uint32 NumBytes = Buffer->Desc.GetSize();
+		FRHIGPUBufferReadback* Readback = Bake.Readbacks.Emplace_GetRef(MakeUnique<FRHIGPUBufferReadback>(TEXT("HVPT.OrthoGridBakeReadback"))).Get();
+		Bake.ReadbackSizes.Add(NumBytes);
+
+		AddEnqueueCopyPass(GraphBuilder, Readback, Buffer, NumBytes);
+	}
+
+	// The whole pool is read back, and the slabs that are in use are picked out when the grid is serialized
+	const int32 ExtinctionBrickSize = Grid.VoxelsPerBrick * CalcGridDataBytesPerVoxel(GetGridDataFormat(Grid.GridDataFormats, HVPT_GRID_DATA_CHANNEL_EXTINCTION));
+	Grid.BrickCount = Bake.ReadbackSizes[Section_FirstChannel + HVPT_GRID_DATA_CHANNEL_EXTINCTION] / ExtinctionBrickSize;
+}
+
+void HVPT::UpdateOrthoVoxelGridBake(FHVPTOrthoGridBake& Bake)
+{
+	if (!Bake.IsPending())
+	{
+		return;
+	}
+
+	for (const TUniquePtr<FRHIGPUBufferReadback>& Readback : Bake.Readbacks)
+	{
+		if (!Readback->IsReady())
+		{
+			return;
+		}
+	}
+
+	TArray<const uint8*, TInlineAllocator<Section_Count>> Data;
+	for (int32 Section = 0; Section < Section_Count; ++Section)
+	{
+		Data.Add(static_cast<const uint8*>(Bake.Readbacks[Section]->Lock(Bake.ReadbackSizes[Section])));
+	}
+
+	auto GetDataAsUints = [&Data, &Bake](int32 Section, int64 Num)
+	{
+		check(Num * sizeof(uint32) <= Bake.ReadbackSizes[Section]);
+		return TConstArrayView<uint32>(reinterpret_cast<const uint32*>(Data[Section]), Num);
+	};
+
+	FHVPTBakedOrthoGrid& Grid = Bake.Grid;
+	Grid.TopLevelGrid = GetDataAsUints(Section_TopLevelGrid, CalcTopLevelCellCount(Grid.TopLevelGridResolution));
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		Grid.ChannelData[Channel] = TConstArrayView<uint8>(Data[Section_FirstChannel + Channel], Bake.ReadbackSizes[Section_FirstChannel + Channel]);
+	}
+	Grid.Majorants = GetDataAsUints(Section_Majorants, HVPT::Private::CalcMajorantMipOffset(Grid.TopLevelGridResolution, Grid.MajorantMipCount));
+	Grid.SubBrickMajorants = GetDataAsUints(Section_SubBrickMajorants, static_cast<int64>(HVPT::Private::CalcMajorantMipSize(Grid.TopLevelGridResolution)) * Grid.SubBricksPerBrick);
+
+	TArray<uint8> Bytes;
+	HVPT::Private::SerializeBakedOrthoGrid(Grid, Bytes);
+
+	for (const TUniquePtr<FRHIGPUBufferReadback>& Readback : Bake.Readbacks)
+	{
+		Readback->Unlock();
+	}
+
+	if (FFileHelper::SaveArrayToFile(Bytes, *Bake.Filename))
+	{
+		UE_LOG(LogHVPT, Log, TEXT("Baked the ortho grid to '%s' (%.1f MB)"), *Bake.Filename, Bytes.Num() / (1024.0f * 1024.0f));
+	}
+	else
+	{
+		UE_LOG(LogHVPT, Warning, TEXT("Failed to write the baked ortho grid to '%s'"), *Bake.Filename);
+	}
+
+	Bake = FHVPTOrthoGridBake();
+}
+
+bool HVPT::LoadBakedOrthoVoxelGrid(
+	FRDGBuilder& GraphBuilder, const FScene* Scene, const FViewInfo& View, const FString& Filename, TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer
+)
+{
+	// The mapping is owned by the graph, so that the uploads can read straight from the file without a copy
+	struct FMappedBakedOrthoGrid
+	{
+		TUniquePtr<IMappedFileHandle> Handle;
+		TUniquePtr<IMappedFileRegion> Region;
+	};
+	FMappedBakedOrthoGrid& Mapping = *GraphBuilder.AllocObject<FMappedBakedOrthoGrid>();
+
+	Mapping.Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (Mapping.Handle)
+	{
+		Mapping.Region.Reset(Mapping.Handle->MapRegion());
+	}
+
+	FHVPTBakedOrthoGrid Grid;
+	if (!Mapping.Region || !HVPT::Private::ParseBakedOrthoGrid(TConstArrayView<uint8>(Mapping.Region->GetMappedPtr(), Mapping.Region->GetMappedSize()), Grid))
+	{
+		UE_LOG(LogHVPT, Warning, TEXT("'%s' is not a baked ortho grid, building the ortho grid instead"), *Filename);
+		return false;
+	}
+
+	// Tracking shaders that only support grey extinction cannot read a grid with coloured extinction
+	if (HVPT::Private::ShouldUseMonochromeExtinction(View) && !HVPT::Private::HasMonochromeExtinction(Grid.GridDataFormats))
+	{
+		UE_LOG(LogHVPT, Warning, TEXT("'%s' was baked with coloured extinction, which cannot be rendered while r.HVPT.MonochromeExtinction is enabled"), *Filename);
+		return false;
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "HVPT: Ortho Grid Load");
+
+	auto CreateAndUploadBuffer = [&GraphBuilder](uint32 BytesPerElement, TConstArrayView<uint8> Data, const TCHAR* Name)
+	{
+		FRDGBufferRef Buffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(BytesPerElement, FMath::Max<uint32>(Data.Num() / BytesPerElement, 1)),
+			Name
+		);
+		if (!Data.IsEmpty())
+		{
+			GraphBuilder.QueueBufferUpload(Buffer, Data.GetData(), Data.Num(), ERDGInitialDataFlags::NoCopy);
+		}
+		return Buffer;
+	};
+	auto AsBytes = [](TConstArrayView<uint32> Data)
+	{
+		return TConstArrayView<uint8>(reinterpret_cast<const uint8*>(Data.GetData()), Data.Num() * sizeof(uint32));
+	};
+
+	FRDGBufferRef TopLevelGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_TopLevelGridData), AsBytes(Grid.TopLevelGrid), TEXT("HVPT.TopLevelGridBuffer"));
+	FRDGBufferRef ExtinctionGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_GridData), Grid.ChannelData[HVPT_GRID_DATA_CHANNEL_EXTINCTION], TEXT("HVPT.BakedOrthoGrid.ExtinctionGridBuffer"));
+	FRDGBufferRef EmissionGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_GridData), Grid.ChannelData[HVPT_GRID_DATA_CHANNEL_EMISSION], TEXT("HVPT.BakedOrthoGrid.EmissionGridBuffer"));
+	FRDGBufferRef ScatteringGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_GridData), Grid.ChannelData[HVPT_GRID_DATA_CHANNEL_SCATTERING], TEXT("HVPT.BakedOrthoGrid.ScatteringGridBuffer"));
+	FRDGBufferRef VelocityGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_GridData), Grid.ChannelData[HVPT_GRID_DATA_CHANNEL_VELOCITY], TEXT("HVPT.BakedOrthoGrid.VelocityGridBuffer"));
+	FRDGBufferRef MajorantGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_MajorantGridData), AsBytes(Grid.Majorants), TEXT("HVPT.MajorantVoxelGridBuffer"));
+	FRDGBufferRef SubBrickMajorantGridBuffer = CreateAndUploadBuffer(sizeof(FHVPT_MajorantGridData), AsBytes(Grid.SubBrickMajorants), TEXT("HVPT.SubBrickMajorantGridBuffer"));
+
+	// The interleaved copy is not baked, as it can be rebuilt from the channels in a single pass
+	const bool bInterleavedShadingData = HVPT::UseInterleavedShadingData() && Grid.BrickCount > 0;
+	FRDGBufferRef ShadingGridBuffer = GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_ShadingGridData));
+	if (bInterleavedShadingData)
+	{
+		ShadingGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_ShadingGridData), Grid.BrickCount * Grid.VoxelsPerBrick),
+			TEXT("HVPT.BakedOrthoGrid.ShadingGridBuffer")
+		);
+
+		FRDGBufferRef RasterTileBuffer;
+		FRDGBufferRef RasterTileAllocatorBuffer;
+		HVPT::Private::GenerateRasterTiles(
+			GraphBuilder,
+			Scene,
+			Grid.TopLevelGridResolution,
+			TopLevelGridBuffer,
+			RasterTileBuffer,
+			RasterTileAllocatorBuffer,
+			ERDGPassFlags::Compute
+		);
+
+		HVPT::Private::InterleaveShadingGridData(
+			GraphBuilder,
+			Scene,
+			RasterTileBuffer,
+			RasterTileAllocatorBuffer,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			Grid.GridDataFormats,
+			ShadingGridBuffer,
+			ERDGPassFlags::Compute
+		);
+	}
+	HVPT::SetShadingDataMemoryStats(true, Grid.BrickCount * Grid.VoxelsPerBrick, Grid.GridDataFormats, bInterleavedShadingData);
+
+	FHVPTOrthoGridUniformBufferParameters* OrthoGridUniformBufferParameters = GraphBuilder.AllocParameters<FHVPTOrthoGridUniformBufferParameters>();
+	{
+		OrthoGridUniformBufferParameters->TopLevelGridWorldBoundsMin = Grid.TopLevelGridWorldBoundsMin;
+		OrthoGridUniformBufferParameters->TopLevelGridWorldBoundsMax = Grid.TopLevelGridWorldBoundsMax;
+		OrthoGridUniformBufferParameters->TopLevelGridResolution = Grid.TopLevelGridResolution;
+
+		OrthoGridUniformBufferParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(TopLevelGridBuffer);
+		OrthoGridUniformBufferParameters->ExtinctionGridBuffer = GraphBuilder.CreateSRV(ExtinctionGridBuffer);
+		OrthoGridUniformBufferParameters->EmissionGridBuffer = GraphBuilder.CreateSRV(EmissionGridBuffer);
+		OrthoGridUniformBufferParameters->ScatteringGridBuffer = GraphBuilder.CreateSRV(ScatteringGridBuffer);
+		OrthoGridUniformBufferParameters->VelocityGridBuffer = GraphBuilder.CreateSRV(VelocityGridBuffer);
+		OrthoGridUniformBufferParameters->GridDataFormats = Grid.GridDataFormats;
+		OrthoGridUniformBufferParameters->ShadingGridBuffer = GraphBuilder.CreateSRV(ShadingGridBuffer);
+		OrthoGridUniformBufferParameters->bUseInterleavedShadingData = bInterleavedShadingData;
+
+		OrthoGridUniformBufferParameters->bUseOrthoGrid = HVPT::EnableOrthoGrid();
+		OrthoGridUniformBufferParameters->MajorantGridBuffer = GraphBuilder.CreateSRV(MajorantGridBuffer);
+		HVPT::Private::SetMajorantPyramidParameters(*OrthoGridUniformBufferParameters, Grid.TopLevelGridResolution, Grid.MajorantMipCount);
+		HVPT::Private::SetDirectVolumeParameters(*OrthoGridUniformBufferParameters, {});
+		HVPT::Private::SetInstancedVolumeParameters(GraphBuilder, *OrthoGridUniformBufferParameters, 0, nullptr, nullptr);
+
+		OrthoGridUniformBufferParameters->SubBrickMajorantGridBuffer = GraphBuilder.CreateSRV(SubBrickMajorantGridBuffer);
+		OrthoGridUniformBufferParameters->bUseSubBrickMajorants = Grid.SubBricksPerBrick > 0;
+		// The file does not record whether its majorants bound filtered samples, so baked grids are always sampled unfiltered
+		OrthoGridUniformBufferParameters->bUseTrilinearFiltering = false;
+		OrthoGridUniformBufferParameters->VoxelsPerBrick = Grid.VoxelsPerBrick;
+		OrthoGridUniformBufferParameters->SubBricksPerBrick = FMath::Max(Grid.SubBricksPerBrick, 1);
+	}
+	OrthoGridUniformBuffer = GraphBuilder.CreateUniformBuffer(OrthoGridUniformBufferParameters);
+
+	UE_LOG(LogHVPT, Log, TEXT("Loaded baked ortho grid '%s' (%d bricks)"), *Filename, Grid.BrickCount);
+	return true;
+}
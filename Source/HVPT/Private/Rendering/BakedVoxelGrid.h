@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphFwd.h"
+#include "HVPTDefinitions.h"
+
+class FScene;
+class FViewInfo;
+class FRHIGPUBufferReadback;
+
+struct FHVPTSceneState;
+struct FHVPTOrthoGridUniformBufferParameters;
+
+
+// An ortho grid in the layout used on the GPU
+// Used both for a grid read back from the GPU, where slabs can be anywhere in the pool, and for a baked grid, where the slabs are compacted
+// Holds views only, so a baked grid can be used straight from a memory mapped file
+struct FHVPTBakedOrthoGrid
+{
+	FVector3f TopLevelGridWorldBoundsMin = FVector3f::ZeroVector;
+	FVector3f TopLevelGridWorldBoundsMax = FVector3f::ZeroVector;
+	FIntVector TopLevelGridResolution = FIntVector::ZeroValue;
+
+	uint32 GridDataFormats = 0;
+	int32 VoxelsPerBrick = 0; // Voxels in each slab of the pool, which holds one brick of the largest size or several smaller ones
+	int32 BrickCount = 0; // Number of slabs
+
+	int32 MajorantMipCount = 0;
+	int32 SubBricksPerBrick = 0; // 0 if the grid has no sub-brick majorants
+
+	// FHVPT_TopLevelGridData of every top-level cell
+	TConstArrayView<uint32> TopLevelGrid;
+
+	// Contents of the FHVPT_GridData buffer of each channel, BrickCount slabs long
+	TConstArrayView<uint8> ChannelData[HVPT_GRID_DATA_CHANNEL_COUNT];
+
+	// FHVPT_MajorantGridData of every level of the majorant pyramid
+	TConstArrayView<uint32> Majorants;
+
+	// FHVPT_MajorantGridData of the SubBricksPerBrick sub-bricks of each top-level cell
+	TConstArrayView<uint32> SubBrickMajorants;
+};
+
+
+// Readbacks of an ortho grid that is being baked to a file
+// The grid is written out once every readback has completed, which takes a few frames
+struct FHVPTOrthoGridBake
+{
+	FString Filename;
+
+	// Layout of the grid, the views are filled in when the readbacks are locked
+	FHVPTBakedOrthoGrid Grid;
+
+	// Top-level grid, each channel, majorants and sub-brick majorants, in that order
+	TArray<TUniquePtr<FRHIGPUBufferReadback>> Readbacks;
+	TArray<uint32> ReadbackSizes;
+
+	bool IsPending() const { return !Readbacks.IsEmpty(); }
+};
+
+
+namespace HVPT
+{
+
+// Queues readbacks of OrthoGridUniformBuffer to be written to Filename by UpdateOrthoVoxelGridBake
+// Any bake that is still pending is abandoned
+void BakeOrthoVoxelGrid(
+	FRDGBuilder& GraphBuilder,
+	const TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer,
+	const FString& Filename,
+	FHVPTOrthoGridBake& Bake
+);
+
+// Writes out the pending bake once all of its readbacks have completed
+void UpdateOrthoVoxelGridBake(FHVPTOrthoGridBake& Bake);
+
+// Uploads the baked grid in Filename in place of building the ortho grid
+// Returns false, leaving OrthoGridUniformBuffer untouched, if the file is missing, invalid, or cannot be rendered by View
+bool LoadBakedOrthoVoxelGrid(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FViewInfo& View,
+	const FString& Filename,
+	TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer
+);
+
+}
+
+
+namespace HVPT::Private
+{
+
+// Writes Grid to OutBytes in the baked format.
+// Only slabs referenced by the top-level grid are kept. They are moved to the start of the pool, in the order of the cells that use them
+void SerializeBakedOrthoGrid(const FHVPTBakedOrthoGrid& Grid, TArray<uint8>& OutBytes);
+
+// Points OutGrid into Bytes, which must outlive it. Returns false if Bytes is not a valid baked grid of the current version
+bool ParseBakedOrthoGrid(TConstArrayView<uint8> Bytes, FHVPTBakedOrthoGrid& OutGrid);
+
+// Number of bytes of the FHVPT_GridData buffer holding BrickCount slabs of a channel
+int32 CalcBakedChannelDataSize(uint32 GridDataFormats, int32 Channel, int32 VoxelsPerBrick, int32 BrickCount);
+
+}
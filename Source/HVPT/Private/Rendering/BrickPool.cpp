@@ -0,0 +1,1401 @@
+#include "BrickPool.h"
+
+#include "VoxelGrid.h"
+#include "GridDataFormat.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "SystemTextures.h"
+#include "ScenePrivate.h"
+
+
+class FHVPT_InitializeBrickFreeListCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_InitializeBrickFreeListCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_InitializeBrickFreeListCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(int, BrickCapacity)
+		SHADER_PARAMETER(int, BrickFreeListThreadCount)
+		SHADER_PARAMETER(int, SlabVoxelCount)
+		SHADER_PARAMETER(int, MaxBrickSizeClass)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_InitializeBrickFreeListCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_InitializeBrickFreeListCS", SF_Compute);
+
+
+class FHVPT_CountBrickDemandCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_CountBrickDemandCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_CountBrickDemandCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(int, MaxBrickSizeClass)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWRasterTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, CellPriorityBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickDemandBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWPriorityDemandBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_CountBrickDemandCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_CountBrickDemandCS", SF_Compute);
+
+
+class FHVPT_PlanBrickDegradationCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_PlanBrickDegradationCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_PlanBrickDegradationCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(int, SlabVoxelCount)
+		SHADER_PARAMETER(int, MaxBrickSizeClass)
+		SHADER_PARAMETER(int, MaxDegradationLevel)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickDemandBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWPriorityDemandBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickDegradationBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickDegradationStatsBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_PlanBrickDegradationCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_PlanBrickDegradationCS", SF_Compute);
+
+
+class FHVPT_ApplyBrickDegradationCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_ApplyBrickDegradationCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_ApplyBrickDegradationCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWRasterTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, CellPriorityBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BrickDegradationBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickDegradationStatsBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_ApplyBrickDegradationCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_ApplyBrickDegradationCS", SF_Compute);
+
+
+class FHVPT_ReserveBrickSizeClassesCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_ReserveBrickSizeClassesCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_ReserveBrickSizeClassesCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(int, BrickCapacity)
+		SHADER_PARAMETER(int, SlabVoxelCount)
+		SHADER_PARAMETER(int, MaxBrickSizeClass)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BrickDemandBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickSplitBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickSplitIndirectArgsBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_ReserveBrickSizeClassesCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_ReserveBrickSizeClassesCS", SF_Compute);
+
+
+class FHVPT_SplitBrickSlabsCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_SplitBrickSlabsCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_SplitBrickSlabsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(int, BrickCapacity)
+		SHADER_PARAMETER(int, SlabVoxelCount)
+		SHADER_PARAMETER(int, MaxBrickSizeClass)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BrickSplitBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_SplitBrickSlabsCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_SplitBrickSlabsCS", SF_Compute);
+
+
+class FHVPT_MarkLiveBricksCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_MarkLiveBricksCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_MarkLiveBricksCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(int, SlabVoxelCount)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWSlabOccupancyBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_MarkLiveBricksCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_MarkLiveBricksCS", SF_Compute);
+
+
+class FHVPT_ReclaimBrickSlabsCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_ReclaimBrickSlabsCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_ReclaimBrickSlabsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(int, BrickCapacity)
+		SHADER_PARAMETER(int, BrickFreeListThreadCount)
+		SHADER_PARAMETER(int, SlabVoxelCount)
+		SHADER_PARAMETER(int, MaxBrickSizeClass)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, SlabOccupancyBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_ReclaimBrickSlabsCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_ReclaimBrickSlabsCS", SF_Compute);
+
+
+class FHVPT_DeferBrickCacheCellsCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_DeferBrickCacheCellsCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_DeferBrickCacheCellsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(FIntVector, CacheCellMin)
+		SHADER_PARAMETER(FIntVector, CacheCellCount)
+		SHADER_PARAMETER(FIntVector, CacheSourceCellMin)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWRasterTopLevelGridBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_DeferBrickCacheCellsCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_DeferBrickCacheCellsCS", SF_Compute);
+
+
+class FHVPT_RestoreBrickCacheCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_RestoreBrickCacheCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_RestoreBrickCacheCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(FIntVector, CacheCellMin)
+		SHADER_PARAMETER(FIntVector, CacheCellCount)
+		SHADER_PARAMETER(int, CacheFirstSlot)
+		SHADER_PARAMETER(int, bCacheDeferredRestore)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, CacheCellBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, CacheExtinctionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, CacheEmissionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, CacheScatteringGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, CacheVelocityGridBuffer)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWRasterTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWExtinctionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWEmissionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWScatteringGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWVelocityGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_ShadingGridData>, RWShadingGridBuffer)
+		SHADER_PARAMETER(int, bInterleavedShadingData)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickOverflowCountBuffer)
+		SHADER_PARAMETER(int, VoxelsPerBrick)
+		SHADER_PARAMETER(uint32, GridDataFormats)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_RestoreBrickCacheCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_RestoreBrickCacheCS", SF_Compute);
+
+
+class FHVPT_CaptureBrickCacheCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_CaptureBrickCacheCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_CaptureBrickCacheCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(FIntVector, CacheCellMin)
+		SHADER_PARAMETER(FIntVector, CacheCellCount)
+		SHADER_PARAMETER(int, CacheFirstSlot)
+		SHADER_PARAMETER(int, bCacheNewEntry)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ExtinctionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, EmissionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ScatteringGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, VelocityGridBuffer)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWCacheCellBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWCacheExtinctionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWCacheEmissionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWCacheScatteringGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWCacheVelocityGridBuffer)
+
+		SHADER_PARAMETER(int, VoxelsPerBrick)
+		SHADER_PARAMETER(uint32, GridDataFormats)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_CaptureBrickCacheCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_CaptureBrickCacheCS", SF_Compute);
+
+
+// Brick indices must fit in the top-level cell encoding, below the indices reserved for directly sampled and instanced volumes
+static const int64 MaxAddressableVoxelCount = 0x1FFFFFFF - HVPT_MAX_DIRECT_VOLUMES - HVPT_MAX_INSTANCED_VOLUMES;
+
+// Size class of the bricks that fill a whole slab of VoxelsPerBrick voxels
+static int32 CalcMaxBrickSizeClass(int32 VoxelsPerBrick)
+{
+	return FMath::FloorLog2(VoxelsPerBrick) / 3;
+}
+
+
+void FHVPTBrickPoolAllocator::Initialize(int32 InBrickCapacity, int32 InVoxelsPerBrick)
+{
+	check(InBrickCapacity >= 0 && InVoxelsPerBrick > 0);
+
+	BrickCapacity = InBrickCapacity;
+	VoxelsPerBrick = InVoxelsPerBrick;
+	MaxSizeClass = CalcMaxBrickSizeClass(VoxelsPerBrick);
+	checkf((1 << (3 * MaxSizeClass)) == VoxelsPerBrick && MaxSizeClass < HVPT_BRICK_SIZE_CLASS_COUNT,
+		TEXT("%d voxels is not the size of a brick of a supported resolution"), VoxelsPerBrick);
+
+	// Matches HVPT_InitializeBrickFreeListCS
+	for (int32 SizeClass = 0; SizeClass < HVPT_BRICK_SIZE_CLASS_COUNT; ++SizeClass)
+	{
+		FreeLists[SizeClass].Reset();
+	}
+	FreeLists[MaxSizeClass].SetNumUninitialized(BrickCapacity);
+	for (int32 BrickIndex = 0; BrickIndex < BrickCapacity; ++BrickIndex)
+	{
+		FreeLists[MaxSizeClass][BrickIndex] = (BrickCapacity - 1 - BrickIndex) * VoxelsPerBrick;
+	}
+
+	AllocatedBricks.Reset();
+	OverflowBrickCount = 0;
+}
+
+void FHVPTBrickPoolAllocator::Reserve(TConstArrayView<int32> DemandByClass)
+{
+	check(DemandByClass.Num() > MaxSizeClass);
+
+	// Matches HVPT_ReserveBrickSizeClassesCS followed by HVPT_SplitBrickSlabsCS
+	TArray<uint32>& SlabFreeList = FreeLists[MaxSizeClass];
+	int32 MaxClassCount = SlabFreeList.Num();
+	int32 SpareSlabCount = MaxClassCount - FMath::Min(DemandByClass[MaxSizeClass], MaxClassCount);
+
+	for (int32 SizeClass = 0; SizeClass < MaxSizeClass; ++SizeClass)
+	{
+		const int32 BricksPerSlab = GetBricksPerSlab(SizeClass);
+		const int32 MissingBrickCount = FMath::Max(DemandByClass[SizeClass] - FreeLists[SizeClass].Num(), 0);
+		const int32 SlabCount = FMath::Min(FMath::DivideAndRoundUp(MissingBrickCount, BricksPerSlab), SpareSlabCount);
+
+		MaxClassCount -= SlabCount;
+		SpareSlabCount -= SlabCount;
+		for (int32 BrickIndex = 0; BrickIndex < SlabCount * BricksPerSlab; ++BrickIndex)
+		{
+			const uint32 SlabBottomLevelIndex = SlabFreeList[MaxClassCount + BrickIndex / BricksPerSlab];
+			FreeLists[SizeClass].Push(SlabBottomLevelIndex + (BrickIndex % BricksPerSlab) * (1 << (3 * SizeClass)));
+		}
+	}
+
+	SlabFreeList.SetNum(MaxClassCount, EAllowShrinking::No);
+}
+
+int32 FHVPTBrickPoolAllocator::CalcRequiredSlabCount(TConstArrayView<int32> DemandByClass) const
+{
+	check(DemandByClass.Num() > MaxSizeClass);
+
+	int32 SlabCount = DemandByClass[MaxSizeClass];
+	for (int32 SizeClass = 0; SizeClass < MaxSizeClass; ++SizeClass)
+	{
+		const int32 MissingBrickCount = FMath::Max(DemandByClass[SizeClass] - FreeLists[SizeClass].Num(), 0);
+		SlabCount += FMath::DivideAndRoundUp(MissingBrickCount, GetBricksPerSlab(SizeClass));
+	}
+	return SlabCount;
+}
+
+int32 FHVPTBrickPoolAllocator::Allocate(int32 Resolution)
+{
+	TArray<uint32>& FreeList = FreeLists[GetSizeClass(Resolution)];
+	if (FreeList.IsEmpty())
+	{
+		OverflowBrickCount++;
+		return INDEX_NONE;
+	}
+
+	const uint32 BottomLevelIndex = FreeList.Pop(EAllowShrinking::No);
+	check(!AllocatedBricks.Contains(BottomLevelIndex));
+	AllocatedBricks.Add(BottomLevelIndex, Resolution);
+
+	return BottomLevelIndex;
+}
+
+void FHVPTBrickPoolAllocator::Free(int32 BottomLevelIndex, int32 Resolution)
+{
+	check(BottomLevelIndex >= 0 && BottomLevelIndex % (Resolution * Resolution * Resolution) == 0);
+
+	const int32* AllocatedResolution = AllocatedBricks.Find(BottomLevelIndex);
+	checkf(AllocatedResolution && *AllocatedResolution == Resolution, TEXT("Brick %d was freed at resolution %d but is not allocated at it"), BottomLevelIndex, Resolution);
+	AllocatedBricks.Remove(BottomLevelIndex);
+
+	FreeLists[GetSizeClass(Resolution)].Push(BottomLevelIndex);
+}
+
+void FHVPTBrickPoolAllocator::Reclaim()
+{
+	// Matches HVPT_MarkLiveBricksCS
+	TArray<uint64> LiveBricks;
+	TArray<int32> SlabSizeClasses;
+	LiveBricks.SetNumZeroed(BrickCapacity);
+	SlabSizeClasses.Init(INDEX_NONE, BrickCapacity);
+	for (const TPair<uint32, int32>& Brick : AllocatedBricks)
+	{
+		const int32 SizeClass = GetSizeClass(Brick.Value);
+		const int32 Slab = Brick.Key / VoxelsPerBrick;
+		LiveBricks[Slab] |= uint64(1) << ((Brick.Key % VoxelsPerBrick) >> (3 * SizeClass));
+		SlabSizeClasses[Slab] = SizeClass;
+	}
+
+	// Matches HVPT_ReclaimBrickSlabsCS. Slabs are visited in reverse so that, like after Initialize, the start of the pool is handed out first
+	for (int32 SizeClass = 0; SizeClass < HVPT_BRICK_SIZE_CLASS_COUNT; ++SizeClass)
+	{
+		FreeLists[SizeClass].Reset();
+	}
+	for (int32 Slab = BrickCapacity - 1; Slab >= 0; --Slab)
+	{
+		const uint32 SlabBottomLevelIndex = Slab * VoxelsPerBrick;
+		if (LiveBricks[Slab] == 0)
+		{
+			FreeLists[MaxSizeClass].Push(SlabBottomLevelIndex);
+			continue;
+		}
+
+		const int32 SizeClass = SlabSizeClasses[Slab];
+		for (int32 BrickInSlab = GetBricksPerSlab(SizeClass) - 1; BrickInSlab >= 0; --BrickInSlab)
+		{
+			if ((LiveBricks[Slab] & (uint64(1) << BrickInSlab)) == 0)
+			{
+				FreeLists[SizeClass].Push(SlabBottomLevelIndex + BrickInSlab * (1 << (3 * SizeClass)));
+			}
+		}
+	}
+}
+
+int64 FHVPTBrickPoolAllocator::GetFreeVoxelCount() const
+{
+	int64 FreeVoxelCount = 0;
+	for (int32 SizeClass = 0; SizeClass < HVPT_BRICK_SIZE_CLASS_COUNT; ++SizeClass)
+	{
+		FreeVoxelCount += static_cast<int64>(FreeLists[SizeClass].Num()) << (3 * SizeClass);
+	}
+	return FreeVoxelCount;
+}
+
+int64 FHVPTBrickPoolAllocator::GetAllocatedVoxelCount() const
+{
+	int64 AllocatedVoxelCount = 0;
+	for (const TPair<uint32, int32>& Brick : AllocatedBricks)
+	{
+		AllocatedVoxelCount += Brick.Value * Brick.Value * Brick.Value;
+	}
+	return AllocatedVoxelCount;
+}
+
+float FHVPTBrickPoolAllocator::CalcFragmentation() const
+{
+	const int64 FreeVoxelCount = GetFreeVoxelCount();
+	if (FreeVoxelCount == 0)
+	{
+		return 0.0f;
+	}
+
+	const int64 FreeSlabVoxelCount = static_cast<int64>(FreeLists[MaxSizeClass].Num()) * VoxelsPerBrick;
+	return 1.0f - static_cast<float>(FreeSlabVoxelCount) / static_cast<float>(FreeVoxelCount);
+}
+
+
+void FHVPTBrickCacheAllocator::Initialize(int32 InSlotCapacity)
+{
+	check(InSlotCapacity >= 0);
+
+	Entries.Reset();
+	SlotCapacity = InSlotCapacity;
+	BuildIndex = 0;
+}
+
+int32 FHVPTBrickCacheAllocator::Find(const FHVPTBrickCacheKey& Key, bool& bOutCreatedThisBuild)
+{
+	bOutCreatedThisBuild = false;
+
+	FEntry* Entry = Entries.FindByPredicate([&Key](const FEntry& Entry) { return Entry.Key == Key; });
+	if (!Entry)
+	{
+		return INDEX_NONE;
+	}
+
+	Entry->LastUsedBuildIndex = BuildIndex;
+	bOutCreatedThisBuild = Entry->CreatedBuildIndex == BuildIndex;
+	return Entry->FirstSlot;
+}
+
+int32 FHVPTBrickCacheAllocator::Allocate(const FHVPTBrickCacheKey& Key)
+{
+	const int32 SlotCount = Key.GetSlotCount();
+	check(SlotCount > 0);
+	if (SlotCount > SlotCapacity)
+	{
+		return INDEX_NONE;
+	}
+
+	while (true)
+	{
+		// First gap between entries that is large enough
+		int32 GapStart = 0;
+		int32 InsertIndex = 0;
+		for (; InsertIndex <= Entries.Num(); ++InsertIndex)
+		{
+			const int32 GapEnd = InsertIndex < Entries.Num() ? Entries[InsertIndex].FirstSlot : SlotCapacity;
+			if (GapEnd - GapStart >= SlotCount)
+			{
+				break;
+			}
+			if (InsertIndex < Entries.Num())
+			{
+				GapStart = Entries[InsertIndex].FirstSlot + Entries[InsertIndex].SlotCount;
+			}
+		}
+
+		if (InsertIndex <= Entries.Num())
+		{
+			FEntry Entry;
+			Entry.Key = Key;
+			Entry.FirstSlot = GapStart;
+			Entry.SlotCount = SlotCount;
+			Entry.CreatedBuildIndex = BuildIndex;
+			Entry.LastUsedBuildIndex = BuildIndex;
+			Entries.Insert(Entry, InsertIndex);
+			return GapStart;
+		}
+
+		// Evict the least recently used entry and try again
+		int32 EvictIndex = INDEX_NONE;
+		for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+		{
+			if (Entries[EntryIndex].LastUsedBuildIndex != BuildIndex
+				&& (EvictIndex == INDEX_NONE || Entries[EntryIndex].LastUsedBuildIndex < Entries[EvictIndex].LastUsedBuildIndex))
+			{
+				EvictIndex = EntryIndex;
+			}
+		}
+
+		if (EvictIndex == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		Entries.RemoveAt(EvictIndex, 1, EAllowShrinking::No);
+	}
+}
+
+int32 FHVPTBrickCacheAllocator::GetUsedSlotCount() const
+{
+	int32 UsedSlotCount = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		UsedSlotCount += Entry.SlotCount;
+	}
+	return UsedSlotCount;
+}
+
+
+int32 HVPT::Private::CalcBrickCapacity(int32 MaxMemoryInMegabytes, int32 VoxelsPerBrick, uint32 GridDataFormats, bool bInterleavedShadingData)
+{
+	int64 BytesPerVoxel = CalcGridDataBytesPerVoxelForAllChannels(GridDataFormats);
+	if (bInterleavedShadingData)
+	{
+		BytesPerVoxel += sizeof(FHVPT_ShadingGridData);
+	}
+
+	// Each slab needs a free list element for every brick of each size class it could be split into
+	const int64 BytesPerSlab = BytesPerVoxel * VoxelsPerBrick + (CalcBrickFreeListSize(1, VoxelsPerBrick) - HVPT_BRICK_FREE_LIST_HEADER_SIZE) * sizeof(uint32);
+	const int64 MaxSlabCount = static_cast<int64>(MaxMemoryInMegabytes * 1e6) / BytesPerSlab;
+
+	return static_cast<int32>(FMath::Max<int64>(FMath::Min(MaxSlabCount, MaxAddressableVoxelCount / VoxelsPerBrick), 1));
+}
+
+int32 HVPT::Private::CalcBrickCacheSlotCapacity(int32 MaxMemoryInMegabytes, int32 VoxelsPerBrick, uint32 GridDataFormats)
+{
+	const int64 BytesPerSlot = CalcGridDataBytesPerVoxelForAllChannels(GridDataFormats) * VoxelsPerBrick + sizeof(FHVPT_TopLevelGridData);
+	const int64 MaxSlotCount = static_cast<int64>(MaxMemoryInMegabytes * 1e6) / BytesPerSlot;
+	return static_cast<int32>(FMath::Max<int64>(FMath::Min(MaxSlotCount, MaxAddressableVoxelCount / VoxelsPerBrick), 1));
+}
+
+int32 HVPT::Private::CalcBrickFreeListSize(int32 BrickCapacity, int32 VoxelsPerBrick)
+{
+	int32 FreeListSize = HVPT_BRICK_FREE_LIST_HEADER_SIZE;
+	for (int32 BricksPerSlab = VoxelsPerBrick; BricksPerSlab > 0; BricksPerSlab >>= 3)
+	{
+		FreeListSize += BrickCapacity * BricksPerSlab;
+	}
+	return FreeListSize;
+}
+
+FRDGBufferRef HVPT::Private::CreateBrickOverflowCountBuffer(FRDGBuilder& GraphBuilder, ERDGPassFlags ComputePassFlags)
+{
+	FRDGBufferRef BrickOverflowCountBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 1),
+		TEXT("HVPT.BrickPool.BrickOverflowCountBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(BrickOverflowCountBuffer, PF_R32_UINT), 0, ComputePassFlags);
+
+	return BrickOverflowCountBuffer;
+}
+
+void HVPT::Private::SetupBrickPool(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FHVPTBrickPool& BrickPool,
+	int32 BrickCapacity,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	bool bInterleavedShadingData,
+	bool bResetFreeList,
+	FRDGBufferRef& ExtinctionGridBuffer,
+	FRDGBufferRef& EmissionGridBuffer,
+	FRDGBufferRef& ScatteringGridBuffer,
+	FRDGBufferRef& VelocityGridBuffer,
+	FRDGBufferRef& ShadingGridBuffer,
+	FRDGBufferRef& BrickFreeListBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	const bool bRecreatePool = !BrickPool.IsValid() || BrickPool.BrickCapacity != BrickCapacity || BrickPool.VoxelsPerBrick != VoxelsPerBrick
+		|| BrickPool.GridDataFormats != GridDataFormats || BrickPool.bInterleavedShadingData != bInterleavedShadingData;
+	if (bRecreatePool)
+	{
+		const int32 BottomLevelVoxelCount = BrickCapacity * VoxelsPerBrick;
+		auto CalcBufferSize = [BottomLevelVoxelCount, GridDataFormats](int32 Channel)
+		{
+			return CalcGridDataBufferSize(GetGridDataFormat(GridDataFormats, Channel), BottomLevelVoxelCount);
+		};
+
+		ExtinctionGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_EXTINCTION)),
+			TEXT("HVPT.BrickPool.ExtinctionGridBuffer")
+		);
+		EmissionGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_EMISSION)),
+			TEXT("HVPT.BrickPool.EmissionGridBuffer")
+		);
+		ScatteringGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_SCATTERING)),
+			TEXT("HVPT.BrickPool.ScatteringGridBuffer")
+		);
+		VelocityGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_VELOCITY)),
+			TEXT("HVPT.BrickPool.VelocityGridBuffer")
+		);
+		BrickFreeListBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), CalcBrickFreeListSize(BrickCapacity, VoxelsPerBrick)),
+			TEXT("HVPT.BrickPool.BrickFreeListBuffer")
+		);
+
+		BrickPool.ShadingGridBuffer = nullptr;
+		if (bInterleavedShadingData)
+		{
+			ShadingGridBuffer = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_ShadingGridData), BottomLevelVoxelCount),
+				TEXT("HVPT.BrickPool.ShadingGridBuffer")
+			);
+			BrickPool.ShadingGridBuffer = GraphBuilder.ConvertToExternalBuffer(ShadingGridBuffer);
+		}
+
+		BrickPool.ExtinctionGridBuffer = GraphBuilder.ConvertToExternalBuffer(ExtinctionGridBuffer);
+		BrickPool.EmissionGridBuffer = GraphBuilder.ConvertToExternalBuffer(EmissionGridBuffer);
+		BrickPool.ScatteringGridBuffer = GraphBuilder.ConvertToExternalBuffer(ScatteringGridBuffer);
+		BrickPool.VelocityGridBuffer = GraphBuilder.ConvertToExternalBuffer(VelocityGridBuffer);
+		BrickPool.BrickFreeListBuffer = GraphBuilder.ConvertToExternalBuffer(BrickFreeListBuffer);
+
+		BrickPool.BrickCapacity = BrickCapacity;
+		BrickPool.VoxelsPerBrick = VoxelsPerBrick;
+		BrickPool.GridDataFormats = GridDataFormats;
+		BrickPool.bInterleavedShadingData = bInterleavedShadingData;
+	}
+	else
+	{
+		ExtinctionGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickPool.ExtinctionGridBuffer);
+		EmissionGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickPool.EmissionGridBuffer);
+		ScatteringGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickPool.ScatteringGridBuffer);
+		VelocityGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickPool.VelocityGridBuffer);
+		BrickFreeListBuffer = GraphBuilder.RegisterExternalBuffer(BrickPool.BrickFreeListBuffer);
+
+		if (bInterleavedShadingData)
+		{
+			ShadingGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickPool.ShadingGridBuffer);
+		}
+	}
+
+	if (!bInterleavedShadingData)
+	{
+		ShadingGridBuffer = GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_ShadingGridData));
+	}
+
+	// Only the free list needs resetting - bricks are overwritten when they are allocated, so the pool contents never need clearing
+	if (bRecreatePool || bResetFreeList)
+	{
+		const int32 ThreadGroupSize = FHVPT_InitializeBrickFreeListCS::GetThreadGroupSize1D();
+		const FIntVector GroupCount(FMath::Min(FMath::DivideAndRoundUp(BrickCapacity, ThreadGroupSize), GRHIMaxDispatchThreadGroupsPerDimension.X), 1, 1);
+
+		FHVPT_InitializeBrickFreeListCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_InitializeBrickFreeListCS::FParameters>();
+		{
+			PassParameters->BrickCapacity = BrickCapacity;
+			PassParameters->BrickFreeListThreadCount = GroupCount.X * ThreadGroupSize;
+			PassParameters->SlabVoxelCount = VoxelsPerBrick;
+			PassParameters->MaxBrickSizeClass = CalcMaxBrickSizeClass(VoxelsPerBrick);
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+		}
+
+		const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+		TShaderRef<FHVPT_InitializeBrickFreeListCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_InitializeBrickFreeListCS>();
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("InitializeBrickFreeList"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			GroupCount
+		);
+	}
+}
+
+void HVPT::Private::ReserveBricks(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef RasterTopLevelGridBuffer,
+	FRDGBufferRef CellPriorityBuffer,
+	int32 MaxDegradationLevel,
+	int32 BrickCapacity,
+	int32 VoxelsPerBrick,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef& BrickDegradationStatsBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	RDG_EVENT_SCOPE(GraphBuilder, "ReserveBricks");
+
+	// With a single size class there is nothing to split or lower, but the demand is still counted for the stats
+	const int32 MaxBrickSizeClass = CalcMaxBrickSizeClass(VoxelsPerBrick);
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+
+	FRDGBufferRef BrickDemandBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), HVPT_BRICK_SIZE_CLASS_COUNT),
+		TEXT("HVPT.BrickPool.BrickDemandBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(BrickDemandBuffer, PF_R32_UINT), 0, ComputePassFlags);
+
+	FRDGBufferRef PriorityDemandBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), HVPT_BRICK_PRIORITY_BUCKET_COUNT * HVPT_BRICK_SIZE_CLASS_COUNT),
+		TEXT("HVPT.BrickPool.PriorityDemandBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(PriorityDemandBuffer, PF_R32_UINT), 0, ComputePassFlags);
+
+	{
+		FHVPT_CountBrickDemandCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_CountBrickDemandCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->MaxBrickSizeClass = MaxBrickSizeClass;
+			PassParameters->RWRasterTopLevelGridBuffer = GraphBuilder.CreateUAV(RasterTopLevelGridBuffer);
+			PassParameters->CellPriorityBuffer = GraphBuilder.CreateSRV(CellPriorityBuffer, PF_R32_UINT);
+			PassParameters->RWBrickDemandBuffer = GraphBuilder.CreateUAV(BrickDemandBuffer, PF_R32_UINT);
+			PassParameters->RWPriorityDemandBuffer = GraphBuilder.CreateUAV(PriorityDemandBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_CountBrickDemandCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_CountBrickDemandCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("CountBrickDemand"),
+			ComputePassFlags,
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(TopLevelGridResolution, FHVPT_CountBrickDemandCS::GetThreadGroupSize3D())
+		);
+	}
+
+	// Lowers the resolution of the lowest priority cells until their demand fits in the pool, see HVPT_PlanBrickDegradationCS
+	BrickDegradationStatsBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), HVPT_BRICK_DEGRADATION_STATS_SIZE),
+		TEXT("HVPT.BrickPool.BrickDegradationStatsBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(BrickDegradationStatsBuffer, PF_R32_UINT), 0, ComputePassFlags);
+
+	FRDGBufferRef BrickDegradationBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), HVPT_BRICK_PRIORITY_BUCKET_COUNT),
+		TEXT("HVPT.BrickPool.BrickDegradationBuffer")
+	);
+
+	{
+		FHVPT_PlanBrickDegradationCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_PlanBrickDegradationCS::FParameters>();
+		{
+			PassParameters->SlabVoxelCount = VoxelsPerBrick;
+			PassParameters->MaxBrickSizeClass = MaxBrickSizeClass;
+			PassParameters->MaxDegradationLevel = FMath::Clamp(MaxDegradationLevel, 0, MaxBrickSizeClass);
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+			PassParameters->RWBrickDemandBuffer = GraphBuilder.CreateUAV(BrickDemandBuffer, PF_R32_UINT);
+			PassParameters->RWPriorityDemandBuffer = GraphBuilder.CreateUAV(PriorityDemandBuffer, PF_R32_UINT);
+			PassParameters->RWBrickDegradationBuffer = GraphBuilder.CreateUAV(BrickDegradationBuffer, PF_R32_UINT);
+			PassParameters->RWBrickDegradationStatsBuffer = GraphBuilder.CreateUAV(BrickDegradationStatsBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_PlanBrickDegradationCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_PlanBrickDegradationCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("PlanBrickDegradation"),
+			ComputePassFlags,
+			ComputeShader,
+			PassParameters,
+			FIntVector(1, 1, 1)
+		);
+	}
+
+	{
+		FHVPT_ApplyBrickDegradationCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_ApplyBrickDegradationCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			// Both views may be of the same buffer when every cell of the grid is rastered
+			PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+			PassParameters->RWRasterTopLevelGridBuffer = GraphBuilder.CreateUAV(RasterTopLevelGridBuffer);
+			PassParameters->CellPriorityBuffer = GraphBuilder.CreateSRV(CellPriorityBuffer, PF_R32_UINT);
+			PassParameters->BrickDegradationBuffer = GraphBuilder.CreateSRV(BrickDegradationBuffer, PF_R32_UINT);
+			PassParameters->RWBrickDegradationStatsBuffer = GraphBuilder.CreateUAV(BrickDegradationStatsBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_ApplyBrickDegradationCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_ApplyBrickDegradationCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("ApplyBrickDegradation"),
+			ComputePassFlags,
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(TopLevelGridResolution, FHVPT_ApplyBrickDegradationCS::GetThreadGroupSize3D())
+		);
+	}
+
+	FRDGBufferRef BrickSplitBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 3 * HVPT_BRICK_SIZE_CLASS_COUNT),
+		TEXT("HVPT.BrickPool.BrickSplitBuffer")
+	);
+	FRDGBufferRef BrickSplitIndirectArgsBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(1),
+		TEXT("HVPT.BrickPool.BrickSplitIndirectArgs")
+	);
+
+	{
+		FHVPT_ReserveBrickSizeClassesCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_ReserveBrickSizeClassesCS::FParameters>();
+		{
+			PassParameters->BrickCapacity = BrickCapacity;
+			PassParameters->SlabVoxelCount = VoxelsPerBrick;
+			PassParameters->MaxBrickSizeClass = MaxBrickSizeClass;
+			PassParameters->BrickDemandBuffer = GraphBuilder.CreateSRV(BrickDemandBuffer, PF_R32_UINT);
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+			PassParameters->RWBrickSplitBuffer = GraphBuilder.CreateUAV(BrickSplitBuffer, PF_R32_UINT);
+			PassParameters->RWBrickSplitIndirectArgsBuffer = GraphBuilder.CreateUAV(BrickSplitIndirectArgsBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_ReserveBrickSizeClassesCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_ReserveBrickSizeClassesCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("ReserveBrickSizeClasses"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			FIntVector(1, 1, 1)
+		);
+	}
+
+	{
+		FHVPT_SplitBrickSlabsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_SplitBrickSlabsCS::FParameters>();
+		{
+			PassParameters->BrickCapacity = BrickCapacity;
+			PassParameters->SlabVoxelCount = VoxelsPerBrick;
+			PassParameters->MaxBrickSizeClass = MaxBrickSizeClass;
+			PassParameters->BrickSplitBuffer = GraphBuilder.CreateSRV(BrickSplitBuffer, PF_R32_UINT);
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+			PassParameters->IndirectArgs = BrickSplitIndirectArgsBuffer;
+		}
+
+		TShaderRef<FHVPT_SplitBrickSlabsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_SplitBrickSlabsCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("SplitBrickSlabs"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			BrickSplitIndirectArgsBuffer,
+			0
+		);
+	}
+}
+
+void HVPT::Private::ReclaimBricks(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	FRDGBufferRef TopLevelGridBuffer,
+	int32 BrickCapacity,
+	int32 VoxelsPerBrick,
+	FRDGBufferRef BrickFreeListBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	RDG_EVENT_SCOPE(GraphBuilder, "ReclaimBricks");
+
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+
+	// Two words of live brick bits and the size class plus one of each slab
+	FRDGBufferRef SlabOccupancyBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 3 * BrickCapacity),
+		TEXT("HVPT.BrickPool.SlabOccupancyBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(SlabOccupancyBuffer, PF_R32_UINT), 0, ComputePassFlags);
+
+	{
+		FHVPT_MarkLiveBricksCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_MarkLiveBricksCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->SlabVoxelCount = VoxelsPerBrick;
+			PassParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(TopLevelGridBuffer);
+			PassParameters->RWSlabOccupancyBuffer = GraphBuilder.CreateUAV(SlabOccupancyBuffer, PF_R32_UINT);
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_MarkLiveBricksCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_MarkLiveBricksCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("MarkLiveBricks"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(TopLevelGridResolution, FHVPT_MarkLiveBricksCS::GetThreadGroupSize3D())
+		);
+	}
+
+	{
+		const int32 ThreadGroupSize = FHVPT_ReclaimBrickSlabsCS::GetThreadGroupSize1D();
+		const FIntVector GroupCount(FMath::Min(FMath::DivideAndRoundUp(BrickCapacity, ThreadGroupSize), GRHIMaxDispatchThreadGroupsPerDimension.X), 1, 1);
+
+		FHVPT_ReclaimBrickSlabsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_ReclaimBrickSlabsCS::FParameters>();
+		{
+			PassParameters->BrickCapacity = BrickCapacity;
+			PassParameters->BrickFreeListThreadCount = GroupCount.X * ThreadGroupSize;
+			PassParameters->SlabVoxelCount = VoxelsPerBrick;
+			PassParameters->MaxBrickSizeClass = CalcMaxBrickSizeClass(VoxelsPerBrick);
+			PassParameters->SlabOccupancyBuffer = GraphBuilder.CreateSRV(SlabOccupancyBuffer, PF_R32_UINT);
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_ReclaimBrickSlabsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_ReclaimBrickSlabsCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("ReclaimBrickSlabs"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			GroupCount
+		);
+	}
+}
+
+void HVPT::Private::SetupBrickCache(
+	FRDGBuilder& GraphBuilder,
+	FHVPTBrickCache& BrickCache,
+	int32 SlotCapacity,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	uint32 BuildSettingsHash,
+	FRDGBufferRef& CellBuffer,
+	FRDGBufferRef& ExtinctionGridBuffer,
+	FRDGBufferRef& EmissionGridBuffer,
+	FRDGBufferRef& ScatteringGridBuffer,
+	FRDGBufferRef& VelocityGridBuffer
+)
+{
+	const bool bRecreateCache = !BrickCache.IsValid() || BrickCache.Allocator.GetSlotCapacity() != SlotCapacity || BrickCache.VoxelsPerBrick != VoxelsPerBrick
+		|| BrickCache.GridDataFormats != GridDataFormats || BrickCache.BuildSettingsHash != BuildSettingsHash;
+	if (bRecreateCache)
+	{
+		// Slots are always written by a capture before they are restored from, so the new buffers are not cleared
+		const int32 CacheVoxelCount = SlotCapacity * VoxelsPerBrick;
+		auto CalcBufferSize = [CacheVoxelCount, GridDataFormats](int32 Channel)
+		{
+			return CalcGridDataBufferSize(GetGridDataFormat(GridDataFormats, Channel), CacheVoxelCount);
+		};
+
+		CellBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_TopLevelGridData), SlotCapacity),
+			TEXT("HVPT.BrickCache.CellBuffer")
+		);
+		ExtinctionGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_EXTINCTION)),
+			TEXT("HVPT.BrickCache.ExtinctionGridBuffer")
+		);
+		EmissionGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_EMISSION)),
+			TEXT("HVPT.BrickCache.EmissionGridBuffer")
+		);
+		ScatteringGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_SCATTERING)),
+			TEXT("HVPT.BrickCache.ScatteringGridBuffer")
+		);
+		VelocityGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), CalcBufferSize(HVPT_GRID_DATA_CHANNEL_VELOCITY)),
+			TEXT("HVPT.BrickCache.VelocityGridBuffer")
+		);
+
+		BrickCache.CellBuffer = GraphBuilder.ConvertToExternalBuffer(CellBuffer);
+		BrickCache.ExtinctionGridBuffer = GraphBuilder.ConvertToExternalBuffer(ExtinctionGridBuffer);
+		BrickCache.EmissionGridBuffer = GraphBuilder.ConvertToExternalBuffer(EmissionGridBuffer);
+		BrickCache.ScatteringGridBuffer = GraphBuilder.ConvertToExternalBuffer(ScatteringGridBuffer);
+		BrickCache.VelocityGridBuffer = GraphBuilder.ConvertToExternalBuffer(VelocityGridBuffer);
+
+		BrickCache.VoxelsPerBrick = VoxelsPerBrick;
+		BrickCache.GridDataFormats = GridDataFormats;
+		BrickCache.BuildSettingsHash = BuildSettingsHash;
+		BrickCache.Allocator.Initialize(SlotCapacity);
+	}
+	else
+	{
+		CellBuffer = GraphBuilder.RegisterExternalBuffer(BrickCache.CellBuffer);
+		ExtinctionGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickCache.ExtinctionGridBuffer);
+		EmissionGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickCache.EmissionGridBuffer);
+		ScatteringGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickCache.ScatteringGridBuffer);
+		VelocityGridBuffer = GraphBuilder.RegisterExternalBuffer(BrickCache.VelocityGridBuffer);
+	}
+}
+
+void HVPT::Private::AssignBrickCacheSlots(FHVPTBrickCacheAllocator& Allocator, TArray<FHVPTBrickCacheVolume>& Volumes)
+{
+	Allocator.BeginBuild();
+
+	for (int32 VolumeIndex = 0; VolumeIndex < Volumes.Num();)
+	{
+		FHVPTBrickCacheVolume& Volume = Volumes[VolumeIndex];
+
+		bool bCreatedThisBuild;
+		Volume.FirstSlot = Allocator.Find(Volume.Key, bCreatedThisBuild);
+		if (Volume.FirstSlot != INDEX_NONE)
+		{
+			// Another instance showing the same frame has already claimed a new entry this build, which is only filled after rasterization
+			if (bCreatedThisBuild)
+			{
+				const FHVPTBrickCacheVolume* SourceVolume = Volumes.FindByPredicate([&Volume](const FHVPTBrickCacheVolume& OtherVolume)
+					{
+						return OtherVolume.bNewEntry && OtherVolume.FirstSlot == Volume.FirstSlot;
+					});
+				check(SourceVolume);
+
+				Volume.bRestore = false;
+				Volume.bCapture = false;
+				Volume.bNewEntry = false;
+				Volume.bDeferredRestore = true;
+				Volume.SourceCellMin = SourceVolume->CellMin;
+				++VolumeIndex;
+				continue;
+			}
+
+			// Cells that could not be restored are captured again, e.g. after the level of detail of the volume has changed
+			Volume.bRestore = true;
+			Volume.bCapture = true;
+			Volume.bNewEntry = false;
+			Volume.bDeferredRestore = false;
+		}
+		else
+		{
+			Volume.FirstSlot = Allocator.Allocate(Volume.Key);
+			if (Volume.FirstSlot == INDEX_NONE)
+			{
+				Volumes.RemoveAtSwap(VolumeIndex, 1, EAllowShrinking::No);
+				continue;
+			}
+
+			Volume.bRestore = false;
+			Volume.bCapture = true;
+			Volume.bNewEntry = true;
+			Volume.bDeferredRestore = false;
+		}
+
+		++VolumeIndex;
+	}
+}
+
+void HVPT::Private::DeferBrickCacheVolumes(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	TConstArrayView<FHVPTBrickCacheVolume> Volumes,
+	FRDGBufferRef RasterTopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+	TShaderRef<FHVPT_DeferBrickCacheCellsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_DeferBrickCacheCellsCS>();
+
+	for (const FHVPTBrickCacheVolume& Volume : Volumes)
+	{
+		if (!Volume.bDeferredRestore)
+		{
+			continue;
+		}
+
+		const FIntVector CellCount = Volume.CellMax - Volume.CellMin + FIntVector(1);
+
+		FHVPT_DeferBrickCacheCellsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_DeferBrickCacheCellsCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->CacheCellMin = Volume.CellMin;
+			PassParameters->CacheCellCount = CellCount;
+			PassParameters->CacheSourceCellMin = Volume.SourceCellMin;
+			PassParameters->RWRasterTopLevelGridBuffer = GraphBuilder.CreateUAV(RasterTopLevelGridBuffer);
+		}
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("DeferBrickCache"),
+			ComputePassFlags,
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(CellCount, FHVPT_DeferBrickCacheCellsCS::GetThreadGroupSize3D())
+		);
+	}
+}
+
+void HVPT::Private::RestoreBrickCacheVolumes(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	TConstArrayView<FHVPTBrickCacheVolume> Volumes,
+	bool bDeferred,
+	FRDGBufferRef CacheCellBuffer,
+	FRDGBufferRef CacheExtinctionGridBuffer,
+	FRDGBufferRef CacheEmissionGridBuffer,
+	FRDGBufferRef CacheScatteringGridBuffer,
+	FRDGBufferRef CacheVelocityGridBuffer,
+	FRDGBufferRef RasterTopLevelGridBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef ShadingGridBuffer,
+	bool bInterleavedShadingData,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+	TShaderRef<FHVPT_RestoreBrickCacheCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_RestoreBrickCacheCS>();
+
+	// The shading buffer of a pool without interleaved data is a system buffer, which can't be bound for writing
+	if (!bInterleavedShadingData)
+	{
+		ShadingGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_ShadingGridData), 1),
+			TEXT("HVPT.BrickCache.DummyShadingGridBuffer")
+		);
+	}
+
+	for (const FHVPTBrickCacheVolume& Volume : Volumes)
+	{
+		if (bDeferred ? !Volume.bDeferredRestore : !Volume.bRestore)
+		{
+			continue;
+		}
+
+		const FIntVector CellCount = Volume.CellMax - Volume.CellMin + FIntVector(1);
+
+		FHVPT_RestoreBrickCacheCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_RestoreBrickCacheCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->CacheCellMin = Volume.CellMin;
+			PassParameters->CacheCellCount = CellCount;
+			PassParameters->CacheFirstSlot = Volume.FirstSlot;
+			PassParameters->bCacheDeferredRestore = bDeferred;
+
+			PassParameters->CacheCellBuffer = GraphBuilder.CreateSRV(CacheCellBuffer);
+			PassParameters->CacheExtinctionGridBuffer = GraphBuilder.CreateSRV(CacheExtinctionGridBuffer);
+			PassParameters->CacheEmissionGridBuffer = GraphBuilder.CreateSRV(CacheEmissionGridBuffer);
+			PassParameters->CacheScatteringGridBuffer = GraphBuilder.CreateSRV(CacheScatteringGridBuffer);
+			PassParameters->CacheVelocityGridBuffer = GraphBuilder.CreateSRV(CacheVelocityGridBuffer);
+
+			PassParameters->RWRasterTopLevelGridBuffer = GraphBuilder.CreateUAV(RasterTopLevelGridBuffer);
+			PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+			PassParameters->RWExtinctionGridBuffer = GraphBuilder.CreateUAV(ExtinctionGridBuffer);
+			PassParameters->RWEmissionGridBuffer = GraphBuilder.CreateUAV(EmissionGridBuffer);
+			PassParameters->RWScatteringGridBuffer = GraphBuilder.CreateUAV(ScatteringGridBuffer);
+			PassParameters->RWVelocityGridBuffer = GraphBuilder.CreateUAV(VelocityGridBuffer);
+			PassParameters->RWShadingGridBuffer = GraphBuilder.CreateUAV(ShadingGridBuffer);
+			PassParameters->bInterleavedShadingData = bInterleavedShadingData;
+
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+			PassParameters->RWBrickOverflowCountBuffer = GraphBuilder.CreateUAV(BrickOverflowCountBuffer, PF_R32_UINT);
+			PassParameters->VoxelsPerBrick = VoxelsPerBrick;
+			PassParameters->GridDataFormats = GridDataFormats;
+		}
+
+		// One group per cell, with a thread per voxel of the brick
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("RestoreBrickCache"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			CellCount
+		);
+	}
+}
+
+void HVPT::Private::CaptureBrickCacheVolumes(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	TConstArrayView<FHVPTBrickCacheVolume> Volumes,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef CacheCellBuffer,
+	FRDGBufferRef CacheExtinctionGridBuffer,
+	FRDGBufferRef CacheEmissionGridBuffer,
+	FRDGBufferRef CacheScatteringGridBuffer,
+	FRDGBufferRef CacheVelocityGridBuffer,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+	TShaderRef<FHVPT_CaptureBrickCacheCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_CaptureBrickCacheCS>();
+
+	for (const FHVPTBrickCacheVolume& Volume : Volumes)
+	{
+		if (!Volume.bCapture)
+		{
+			continue;
+		}
+
+		const FIntVector CellCount = Volume.CellMax - Volume.CellMin + FIntVector(1);
+
+		FHVPT_CaptureBrickCacheCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_CaptureBrickCacheCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->CacheCellMin = Volume.CellMin;
+			PassParameters->CacheCellCount = CellCount;
+			PassParameters->CacheFirstSlot = Volume.FirstSlot;
+			PassParameters->bCacheNewEntry = Volume.bNewEntry;
+
+			PassParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(TopLevelGridBuffer);
+			PassParameters->ExtinctionGridBuffer = GraphBuilder.CreateSRV(ExtinctionGridBuffer);
+			PassParameters->EmissionGridBuffer = GraphBuilder.CreateSRV(EmissionGridBuffer);
+			PassParameters->ScatteringGridBuffer = GraphBuilder.CreateSRV(ScatteringGridBuffer);
+			PassParameters->VelocityGridBuffer = GraphBuilder.CreateSRV(VelocityGridBuffer);
+
+			PassParameters->RWCacheCellBuffer = GraphBuilder.CreateUAV(CacheCellBuffer);
+			PassParameters->RWCacheExtinctionGridBuffer = GraphBuilder.CreateUAV(CacheExtinctionGridBuffer);
+			PassParameters->RWCacheEmissionGridBuffer = GraphBuilder.CreateUAV(CacheEmissionGridBuffer);
+			PassParameters->RWCacheScatteringGridBuffer = GraphBuilder.CreateUAV(CacheScatteringGridBuffer);
+			PassParameters->RWCacheVelocityGridBuffer = GraphBuilder.CreateUAV(CacheVelocityGridBuffer);
+
+			PassParameters->VoxelsPerBrick = VoxelsPerBrick;
+			PassParameters->GridDataFormats = GridDataFormats;
+		}
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("CaptureBrickCache"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			CellCount
+		);
+	}
+}
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "RenderGraphResources.h"
+#include "HVPTDefinitions.h"
+#include "HeterogeneousVolumeExInterface.h"
+
+class FScene;
+
+
+// Persistent pool of bottom-level bricks that a voxel grid sub-allocates from
+// The pool is made of BrickCapacity slabs of VoxelsPerBrick voxels, each holding either one brick of the largest resolution
+// or several bricks of one smaller resolution, see AllocateBrick in VoxelGridBuildUtils.ush
+// Lives in the scene or view state so that rebuilding a grid does not recreate the bottom-level buffers
+struct FHVPTBrickPool
+{
+	TRefCountPtr<FRDGPooledBuffer> ExtinctionGridBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> EmissionGridBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> ScatteringGridBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> VelocityGridBuffer = nullptr;
+
+	// Interleaved copy of extinction, scattering and emission, only allocated if bInterleavedShadingData is set
+	TRefCountPtr<FRDGPooledBuffer> ShadingGridBuffer = nullptr;
+
+	// Number of free bricks and stack offset of each size class, followed by a stack of free bottom-level indices for each class
+	TRefCountPtr<FRDGPooledBuffer> BrickFreeListBuffer = nullptr;
+
+	int32 BrickCapacity = 0;
+	int32 VoxelsPerBrick = 0;
+	uint32 GridDataFormats = 0;
+	bool bInterleavedShadingData = false;
+
+	bool IsValid() const { return BrickFreeListBuffer.IsValid() && BrickCapacity > 0; }
+};
+
+
+// CPU mirror of the GPU brick free list
+// Reserves and hands out bricks in the same order as HVPT_ReserveBrickSizeClassesCS, HVPT_SplitBrickSlabsCS and AllocateBrick,
+// so that the behaviour of the pool can be reproduced without a GPU. Reclaim rebuilds the same free bricks as HVPT_ReclaimBrickSlabsCS,
+// although the GPU pushes them in no particular order
+class FHVPTBrickPoolAllocator
+{
+public:
+	// VoxelsPerBrick is the size of a slab, and must be the cube of a power of two resolution no larger than HVPT_MAX_BRICK_RESOLUTION
+	void Initialize(int32 InBrickCapacity, int32 InVoxelsPerBrick);
+
+	// Splits slabs of the largest class for the smaller classes that do not have enough free bricks for DemandByClass
+	// Must be called before the bricks are allocated, as Allocate never splits slabs itself
+	void Reserve(TConstArrayView<int32> DemandByClass);
+	// Slabs of the largest class needed to give every cell counted in DemandByClass a brick, after the free bricks of the smaller classes
+	// Matches CalcRequiredSlabCount in VoxelGridBuild.usf
+	int32 CalcRequiredSlabCount(TConstArrayView<int32> DemandByClass) const;
+
+	// Returns the index of the first voxel in the allocated brick, or INDEX_NONE if its size class is exhausted
+	int32 Allocate(int32 Resolution);
+	void Free(int32 BottomLevelIndex, int32 Resolution);
+
+	// Rebuilds the free lists from the bricks still allocated, returning every slab without live bricks to the largest class
+	void Reclaim();
+
+	int32 GetBrickCapacity() const { return BrickCapacity; }
+	int32 GetVoxelsPerBrick() const { return VoxelsPerBrick; }
+	int32 GetMaxSizeClass() const { return MaxSizeClass; }
+	int32 GetFreeBrickCount(int32 SizeClass) const { return FreeLists[SizeClass].Num(); }
+	int32 GetAllocatedBrickCount() const { return AllocatedBricks.Num(); }
+	int64 GetFreeVoxelCount() const;
+	int64 GetAllocatedVoxelCount() const;
+	// Number of calls to Allocate that found the pool exhausted, as counted by BrickOverflowCountBuffer on the GPU
+	int32 GetOverflowBrickCount() const { return OverflowBrickCount; }
+
+	// Fraction of the free voxels that are not in a whole free slab, and so can only be used by bricks of the class their slab was split into
+	// Reclaim brings this back down to the free voxels of partially used slabs
+	float CalcFragmentation() const;
+
+	static int32 GetSizeClass(int32 Resolution) { return FMath::FloorLog2(Resolution); }
+
+private:
+	int32 GetBricksPerSlab(int32 SizeClass) const { return VoxelsPerBrick >> (3 * SizeClass); }
+
+	TArray<uint32> FreeLists[HVPT_BRICK_SIZE_CLASS_COUNT];
+	// Resolution of each allocated brick, by bottom-level index
+	TMap<uint32, int32> AllocatedBricks;
+
+	int32 BrickCapacity = 0;
+	int32 VoxelsPerBrick = 0;
+	int32 MaxSizeClass = 0;
+	int32 OverflowBrickCount = 0;
+};
+
+
+// Identifies the bricks of an entry of the brick cache: the frame of the volume, and its placement relative to the top-level cells
+// Every field is compared on lookup, so two volumes only share an entry if they rasterize to the same bricks
+struct FHVPTBrickCacheKey
+{
+	FHeterogeneousVolumeExFrameKey Frame;
+
+	// Origin of the volume within its top-level cell, in 1/1024ths of a cell, as instances are rarely placed exactly the same
+	FIntVector QuantizedOffsetInCell = FIntVector::ZeroValue;
+	FVector TopLevelVoxelSize = FVector::ZeroVector;
+	// Scaled axes of the instance to world transform
+	FVector InstanceAxisX = FVector::ZeroVector;
+	FVector InstanceAxisY = FVector::ZeroVector;
+	FVector InstanceAxisZ = FVector::ZeroVector;
+
+	// Inclusive box of top-level cells the entry covers, relative to the cell of the origin, as it can be clipped by the edge of the grid
+	FIntVector CellMin = FIntVector::ZeroValue;
+	FIntVector CellMax = FIntVector::ZeroValue;
+
+	int32 GetSlotCount() const
+	{
+		const FIntVector CellCount = CellMax - CellMin + FIntVector(1);
+		return CellCount.X * CellCount.Y * CellCount.Z;
+	}
+
+	bool operator==(const FHVPTBrickCacheKey& Other) const
+	{
+		return Frame == Other.Frame
+			&& QuantizedOffsetInCell == Other.QuantizedOffsetInCell
+			&& TopLevelVoxelSize == Other.TopLevelVoxelSize
+			&& InstanceAxisX == Other.InstanceAxisX
+			&& InstanceAxisY == Other.InstanceAxisY
+			&& InstanceAxisZ == Other.InstanceAxisZ
+			&& CellMin == Other.CellMin
+			&& CellMax == Other.CellMax;
+	}
+};
+
+// CPU bookkeeping of the brick cache, see FHVPTBrickCache
+// Entries are contiguous ranges of slots, and the least recently used entries are evicted to make room for new ones
+class FHVPTBrickCacheAllocator
+{
+public:
+	void Initialize(int32 InSlotCapacity);
+
+	// Entries used by the current build are never evicted
+	void BeginBuild() { BuildIndex++; }
+
+	// Returns the first slot of the entry, or INDEX_NONE if there is none. bOutCreatedThisBuild is set if the entry has not been filled yet
+	int32 Find(const FHVPTBrickCacheKey& Key, bool& bOutCreatedThisBuild);
+	// Returns the first slot of a new entry with one slot per cell of the key, or INDEX_NONE if it does not fit even after evicting
+	// every entry not used by the current build
+	int32 Allocate(const FHVPTBrickCacheKey& Key);
+
+	int32 GetSlotCapacity() const { return SlotCapacity; }
+	int32 GetEntryCount() const { return Entries.Num(); }
+	int32 GetUsedSlotCount() const;
+
+private:
+	struct FEntry
+	{
+		FHVPTBrickCacheKey Key;
+		int32 FirstSlot = 0;
+		int32 SlotCount = 0;
+		uint32 CreatedBuildIndex = 0;
+		uint32 LastUsedBuildIndex = 0;
+	};
+
+	// Sorted by FirstSlot
+	TArray<FEntry> Entries;
+
+	int32 SlotCapacity = 0;
+	uint32 BuildIndex = 0;
+};
+
+// Bricks rasterized for animated volumes, kept so that a frame that is shown again can be copied into the ortho grid instead of rasterized
+// Each entry holds one slot per top-level cell in the box of cells around a volume, and each slot holds one brick in the layout of the pool
+// Lives in the scene state next to the pool, and is dropped whenever the layout of the pool bricks changes
+struct FHVPTBrickCache
+{
+	// Cell of each slot, with the index of the brick in the cache buffers instead of the pool
+	TRefCountPtr<FRDGPooledBuffer> CellBuffer = nullptr;
+
+	TRefCountPtr<FRDGPooledBuffer> ExtinctionGridBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> EmissionGridBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> ScatteringGridBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> VelocityGridBuffer = nullptr;
+
+	int32 VoxelsPerBrick = 0;
+	uint32 GridDataFormats = 0;
+	// Rasterization settings the bricks were built with
+	uint32 BuildSettingsHash = 0;
+
+	FHVPTBrickCacheAllocator Allocator;
+
+	bool IsValid() const { return CellBuffer.IsValid() && Allocator.GetSlotCapacity() > 0; }
+};
+
+// A volume whose bricks are restored from or kept in the brick cache during a build
+struct FHVPTBrickCacheVolume
+{
+	FHVPTBrickCacheKey Key;
+
+	// Inclusive box of top-level cells the entry covers, in the grid
+	FIntVector CellMin = FIntVector::ZeroValue;
+	FIntVector CellMax = FIntVector::ZeroValue;
+
+	// Set by AssignBrickCacheSlots
+	int32 FirstSlot = INDEX_NONE;
+	// Cells are copied from the entry before rasterization
+	bool bRestore = false;
+	// Rasterized cells are copied into the entry afterwards. A new entry has all of its cells written
+	bool bCapture = false;
+	bool bNewEntry = false;
+	// Another instance creates the entry this build, so cells are restored from it once it has been captured, instead of being rasterized
+	bool bDeferredRestore = false;
+	// First cell of the instance creating the entry, in the grid
+	FIntVector SourceCellMin = FIntVector::ZeroValue;
+
+	int32 GetSlotCount() const { return Key.GetSlotCount(); }
+};
+
+
+namespace HVPT::Private
+{
+
+// GridDataFormats determines the bytes per voxel of every channel, see GridDataFormat.h
+// The interleaved shading data is counted against the same budget, as it duplicates the shading channels, and so is the free list
+int32 CalcBrickCapacity(int32 MaxMemoryInMegabytes, int32 VoxelsPerBrick, uint32 GridDataFormats, bool bInterleavedShadingData);
+
+// Number of slots of VoxelsPerBrick voxels that fit in the brick cache budget
+int32 CalcBrickCacheSlotCapacity(int32 MaxMemoryInMegabytes, int32 VoxelsPerBrick, uint32 GridDataFormats);
+
+// Number of elements in the free list of a pool, which has room for every brick of each size class the slabs could be split into
+int32 CalcBrickFreeListSize(int32 BrickCapacity, int32 VoxelsPerBrick);
+
+// Creates a counter of the bricks AllocateBrick could not hand out because the pool was exhausted, cleared to zero
+FRDGBufferRef CreateBrickOverflowCountBuffer(FRDGBuilder& GraphBuilder, ERDGPassFlags ComputePassFlags);
+
+// Registers the pool buffers with the graph, recreating them if the layout of the pool has changed
+// The free list is refilled with every brick in the pool if bResetFreeList is set or if the pool was recreated
+// ShadingGridBuffer is a dummy buffer if bInterleavedShadingData is not set
+void SetupBrickPool(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FHVPTBrickPool& BrickPool,
+	int32 BrickCapacity,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	bool bInterleavedShadingData,
+	bool bResetFreeList,
+	FRDGBufferRef& ExtinctionGridBuffer,
+	FRDGBufferRef& EmissionGridBuffer,
+	FRDGBufferRef& ScatteringGridBuffer,
+	FRDGBufferRef& VelocityGridBuffer,
+	FRDGBufferRef& ShadingGridBuffer,
+	FRDGBufferRef& BrickFreeListBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Splits slabs of the largest size class for the smaller classes, so that every cell marked in RasterTopLevelGridBuffer without a brick
+// can be allocated one of its own resolution. Must run after the last FreeBrick and before the first AllocateBrick of a build
+// When the pool cannot hold them all, the cells with the lowest CellPriorityBuffer rank are first halved in resolution, up to
+// MaxDegradationLevel times, in both grids. BrickDegradationStatsBuffer is laid out as HVPT_BRICK_DEGRADATION_STATS_*
+void ReserveBricks(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef RasterTopLevelGridBuffer,
+	FRDGBufferRef CellPriorityBuffer,
+	int32 MaxDegradationLevel,
+	int32 BrickCapacity,
+	int32 VoxelsPerBrick,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef& BrickDegradationStatsBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Rebuilds the free list from the bricks TopLevelGridBuffer still references, so that slabs whose bricks have all been freed can be
+// used by any size class again. Only needed when the free list is kept between builds
+void ReclaimBricks(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	FRDGBufferRef TopLevelGridBuffer,
+	int32 BrickCapacity,
+	int32 VoxelsPerBrick,
+	FRDGBufferRef BrickFreeListBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Registers the cache buffers with the graph, recreating them and dropping every entry if the layout of the pool bricks,
+// the rasterization settings or the capacity have changed
+void SetupBrickCache(
+	FRDGBuilder& GraphBuilder,
+	FHVPTBrickCache& BrickCache,
+	int32 SlotCapacity,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	uint32 BuildSettingsHash,
+	FRDGBufferRef& CellBuffer,
+	FRDGBufferRef& ExtinctionGridBuffer,
+	FRDGBufferRef& EmissionGridBuffer,
+	FRDGBufferRef& ScatteringGridBuffer,
+	FRDGBufferRef& VelocityGridBuffer
+);
+
+// Finds or allocates the entry of each volume, and decides whether it is restored, captured or neither
+// Volumes that do not fit in the cache are removed
+void AssignBrickCacheSlots(FHVPTBrickCacheAllocator& Allocator, TArray<FHVPTBrickCacheVolume>& Volumes);
+
+// Unmarks the cells of deferred volumes in RasterTopLevelGridBuffer that will be restored from the instance creating their entry
+void DeferBrickCacheVolumes(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	TConstArrayView<FHVPTBrickCacheVolume> Volumes,
+	FRDGBufferRef RasterTopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Copies cached bricks into cells that are about to be rasterized at the same resolution they were cached at, and unmarks them in
+// RasterTopLevelGridBuffer so that they are not rasterized. Bricks are allocated from the pool, so this must not run in the same pass as a FreeBrick
+// With bDeferred, restores the cells unmarked by DeferBrickCacheVolumes instead, which must run after CaptureBrickCacheVolumes
+void RestoreBrickCacheVolumes(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	TConstArrayView<FHVPTBrickCacheVolume> Volumes,
+	bool bDeferred,
+	FRDGBufferRef CacheCellBuffer,
+	FRDGBufferRef CacheExtinctionGridBuffer,
+	FRDGBufferRef CacheEmissionGridBuffer,
+	FRDGBufferRef CacheScatteringGridBuffer,
+	FRDGBufferRef CacheVelocityGridBuffer,
+	FRDGBufferRef RasterTopLevelGridBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef ShadingGridBuffer,
+	bool bInterleavedShadingData,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Copies the cells of each volume into its entry once it has been rasterized
+void CaptureBrickCacheVolumes(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	TConstArrayView<FHVPTBrickCacheVolume> Volumes,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef CacheCellBuffer,
+	FRDGBufferRef CacheExtinctionGridBuffer,
+	FRDGBufferRef CacheEmissionGridBuffer,
+	FRDGBufferRef CacheScatteringGridBuffer,
+	FRDGBufferRef CacheVelocityGridBuffer,
+	int32 VoxelsPerBrick,
+	uint32 GridDataFormats,
+	ERDGPassFlags ComputePassFlags
+);
+
+}
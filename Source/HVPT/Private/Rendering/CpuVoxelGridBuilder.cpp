@@ -0,0 +1,922 @@
+#include "CpuVoxelGridBuilder.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+#include "HVPT.h"
+#include "GridDataFormat.h"
+#include "MajorantPyramid.h"
+#include "VoxelGridStats.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("CPU Ortho Grid Voxel Size"), STAT_HVPTCpuOrthoGridCalculateVoxelSize, STATGROUP_HVPT);
+DECLARE_CYCLE_STAT(TEXT("CPU Ortho Grid Allocate"), STAT_HVPTCpuOrthoGridAllocateBottomLevelGrid, STATGROUP_HVPT);
+DECLARE_CYCLE_STAT(TEXT("CPU Ortho Grid Rasterize"), STAT_HVPTCpuOrthoGridRasterize, STATGROUP_HVPT);
+DECLARE_CYCLE_STAT(TEXT("CPU Ortho Grid Majorants"), STAT_HVPTCpuOrthoGridBuildMajorants, STATGROUP_HVPT);
+
+
+namespace
+{
+
+// Matches the encoding of FHVPT_TopLevelGridData in VoxelGridBuildUtils.ush
+constexpr uint32 EmptyVoxelIndex = 0x1FFFFFFF;
+
+// Value the top-level grid is cleared to before voxel sizes are calculated, see CalculateVoxelSize in VoxelGridBuilder.cpp
+constexpr uint32 ClearedTopLevelGridData = 0xFFFFFFF8;
+
+// Rasterization runs one THREADGROUP_SIZE_3D^3 group per top-level cell, with one thread per bottom-level voxel
+constexpr int32 RasterGroupSize = 4;
+constexpr int32 RasterGroupThreadCount = RasterGroupSize * RasterGroupSize * RasterGroupSize;
+
+// GetZeroThreshold in RasterizeBottomLevel.usf
+constexpr float RasterZeroThreshold = 1.0e-6f;
+
+// Cells whose samples are held in memory at once while rasterizing a volume
+constexpr int32 RasterBatchSize = 1024;
+
+uint32 MortonEncode3(const FIntVector& Voxel)
+{
+	return FMath::MortonCode3(Voxel.X) | (FMath::MortonCode3(Voxel.Y) << 1) | (FMath::MortonCode3(Voxel.Z) << 2);
+}
+
+FIntVector MortonDecode3(uint32 Morton)
+{
+	return FIntVector(FMath::ReverseMortonCode3(Morton), FMath::ReverseMortonCode3(Morton >> 1), FMath::ReverseMortonCode3(Morton >> 2));
+}
+
+uint32 GetBottomLevelIndex(uint32 TopLevelGridData)
+{
+	return TopLevelGridData >> 3;
+}
+
+int32 GetBottomLevelVoxelResolution(uint32 TopLevelGridData)
+{
+	return TopLevelGridData & 0x7;
+}
+
+uint32 PackTopLevelGridData(uint32 BottomLevelIndex, int32 BottomLevelVoxelResolution)
+{
+	return (BottomLevelIndex << 3) | (BottomLevelVoxelResolution & 0x7);
+}
+
+bool IsBottomLevelAllocated(uint32 TopLevelGridData)
+{
+	return GetBottomLevelIndex(TopLevelGridData) != EmptyVoxelIndex;
+}
+
+bool IsBottomLevelEmpty(uint32 TopLevelGridData)
+{
+	return GetBottomLevelVoxelResolution(TopLevelGridData) == 0;
+}
+
+// Before the bottom-level grid is allocated, each cell temporarily holds its voxel size
+float GetVoxelSize(uint32 TopLevelGridData)
+{
+	float VoxelSize;
+	FMemory::Memcpy(&VoxelSize, &TopLevelGridData, sizeof(VoxelSize));
+	return VoxelSize;
+}
+
+uint32 SetVoxelSize(float VoxelSize)
+{
+	uint32 TopLevelGridData;
+	FMemory::Memcpy(&TopLevelGridData, &VoxelSize, sizeof(TopLevelGridData));
+	return TopLevelGridData;
+}
+
+uint32 PackMajorantData(float Majorant, float Mean)
+{
+	return FFloat16(Majorant).Encoded | (static_cast<uint32>(FFloat16(Mean).Encoded) << 16);
+}
+
+float GetMajorant(uint32 MajorantGridData)
+{
+	FFloat16 Majorant;
+	Majorant.Encoded = static_cast<uint16>(MajorantGridData);
+	return Majorant.GetFloat();
+}
+
+float GetMean(uint32 MajorantGridData)
+{
+	FFloat16 Mean;
+	Mean.Encoded = static_cast<uint16>(MajorantGridData >> 16);
+	return Mean.GetFloat();
+}
+
+// Luminance in Common.ush
+float Luminance(const FVector3f& Color)
+{
+	return Color.X * 0.3f + Color.Y * 0.59f + Color.Z * 0.11f;
+}
+
+bool BoxesIntersect(const FBox3f& A, const FBox3f& B)
+{
+	return !(A.Min.X > B.Max.X || A.Min.Y > B.Max.Y || A.Min.Z > B.Max.Z || B.Min.X > A.Max.X || B.Min.Y > A.Max.Y || B.Min.Z > A.Max.Z);
+}
+
+bool BoxContainsPoint(const FBox3f& Box, const FVector3f& Point)
+{
+	return Point.X >= Box.Min.X && Point.Y >= Box.Min.Y && Point.Z >= Box.Min.Z
+		&& Point.X <= Box.Max.X && Point.Y <= Box.Max.Y && Point.Z <= Box.Max.Z;
+}
+
+// FHVPTVolumeLODPolicy limits, followed by the clamp in HVPT_TopLevelGridCalculateVoxelSizeCS
+float ClampVoxelSizeToBrickResolution(float VoxelSize, const FBox3f& CellBounds, const FHVPTCpuVolume& Volume, int32 BottomLevelGridResolution)
+{
+	int32 MaxBrickResolution = BottomLevelGridResolution;
+	if (Volume.MaxBrickResolution > 0)
+	{
+		MaxBrickResolution = 1 << FMath::FloorLog2(FMath::Clamp(Volume.MaxBrickResolution, 1, BottomLevelGridResolution));
+	}
+	const int32 MinBrickResolution = FMath::Min(static_cast<int32>(FMath::RoundUpToPowerOfTwo(FMath::Clamp(Volume.MinBrickResolution, 1, MaxBrickResolution))), MaxBrickResolution);
+
+	const float CellSize = (CellBounds.Max - CellBounds.Min).GetMax();
+	return FMath::Clamp(VoxelSize, CellSize / (MaxBrickResolution * 0.99f), CellSize / (MinBrickResolution * 0.99f));
+}
+
+EParallelForFlags GetParallelForFlags(const FHVPTCpuOrthoGridBuildSettings& Settings)
+{
+	return Settings.bMultithreaded ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+}
+
+}
+
+
+void FHVPTCpuOrthoGridBuilder::Build(const FHVPTCpuOrthoGridBuildSettings& InSettings, TConstArrayView<FHVPTCpuVolume> Volumes)
+{
+	Settings = InSettings;
+	Settings.BottomLevelGridResolution = FMath::Clamp(Settings.BottomLevelGridResolution, 1, RasterGroupSize);
+	Timings = FTimings();
+
+	const FIntVector& Resolution = Settings.TopLevelGridResolution;
+	const int64 CellCount = static_cast<int64>(Resolution.X) * Resolution.Y * Resolution.Z;
+	checkf(HVPT::Private::CalcMajorantMipSize(Resolution) == CellCount,
+		TEXT("Top-level grid resolution %s cannot be addressed with morton codes, see r.HVPT.ForceCubicTopLevelGrid"), *Resolution.ToString());
+
+	VoxelsPerBrick = FMath::Cube(Settings.BottomLevelGridResolution);
+	SubBricksPerBrick = FMath::Cube(FMath::DivideAndRoundUp(Settings.BottomLevelGridResolution, HVPT_SUB_BRICK_SIZE));
+	MajorantMipCount = HVPT::Private::CalcMajorantMipCount(Resolution, Settings.MaxMajorantMipCount);
+
+	BrickAllocator.Initialize(Settings.BrickCapacity, VoxelsPerBrick);
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		const int32 ChannelDataSize = HVPT::Private::CalcBakedChannelDataSize(Settings.GridDataFormats, Channel, VoxelsPerBrick, Settings.BrickCapacity);
+		ChannelData[Channel].Reset();
+		ChannelData[Channel].SetNumZeroed(ChannelDataSize);
+	}
+
+	// Each step is timed for GetTimings and also shows up in stat HVPT
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HVPTCpuOrthoGridCalculateVoxelSize);
+		const double StartTime = FPlatformTime::Seconds();
+		CalculateVoxelSize(Volumes);
+		Timings.CalculateVoxelSizeSeconds = FPlatformTime::Seconds() - StartTime;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HVPTCpuOrthoGridAllocateBottomLevelGrid);
+		const double StartTime = FPlatformTime::Seconds();
+		AllocateBottomLevelGrid();
+		Timings.AllocateBottomLevelGridSeconds = FPlatformTime::Seconds() - StartTime;
+	}
+
+	// Volumes are rasterized one after another, as they are on the GPU, so that overlapping volumes accumulate in the same order
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HVPTCpuOrthoGridRasterize);
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FHVPTCpuVolume& Volume : Volumes)
+		{
+			RasterizeVolume(Volume);
+		}
+		Timings.RasterizeSeconds = FPlatformTime::Seconds() - StartTime;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HVPTCpuOrthoGridBuildMajorants);
+		const double StartTime = FPlatformTime::Seconds();
+		BuildMajorants();
+		Timings.BuildMajorantsSeconds = FPlatformTime::Seconds() - StartTime;
+	}
+}
+
+FBox FHVPTCpuOrthoGridBuilder::CalcCellWorldBounds(const FIntVector& Cell) const
+{
+	// Calculated in single precision, as CalcVoxelBounds does
+	const FVector3f WorldBoundsMin(Settings.TopLevelGridWorldBounds.Min);
+	const FVector3f WorldBoundsExtent = FVector3f(Settings.TopLevelGridWorldBounds.Max) - WorldBoundsMin;
+	const FVector3f GridResolution(Settings.TopLevelGridResolution);
+
+	const FVector3f CellMin = WorldBoundsMin + WorldBoundsExtent * (FVector3f(Cell) / GridResolution);
+	const FVector3f CellMax = WorldBoundsMin + WorldBoundsExtent * ((FVector3f(Cell) + 1.0f) / GridResolution);
+	return FBox(FVector(CellMin), FVector(CellMax));
+}
+
+bool FHVPTCpuOrthoGridBuilder::GetBottomLevelVoxel(const FVector3f& TopLevelVoxelPos, uint32& OutBottomLevelVoxelIndex) const
+{
+	OutBottomLevelVoxelIndex = EmptyVoxelIndex;
+
+	const FVector3f GridResolution(Settings.TopLevelGridResolution);
+	if (TopLevelVoxelPos.GetMin() < 0.0f || TopLevelVoxelPos.X > GridResolution.X || TopLevelVoxelPos.Y > GridResolution.Y || TopLevelVoxelPos.Z > GridResolution.Z)
+	{
+		return false;
+	}
+
+	const FIntVector Cell(
+		FMath::Min(static_cast<int32>(TopLevelVoxelPos.X), Settings.TopLevelGridResolution.X - 1),
+		FMath::Min(static_cast<int32>(TopLevelVoxelPos.Y), Settings.TopLevelGridResolution.Y - 1),
+		FMath::Min(static_cast<int32>(TopLevelVoxelPos.Z), Settings.TopLevelGridResolution.Z - 1)
+	);
+	const uint32 TopLevelGridData = TopLevelGrid[MortonEncode3(Cell)];
+	if (!IsBottomLevelAllocated(TopLevelGridData))
+	{
+		return false;
+	}
+
+	const int32 VoxelResolution = GetBottomLevelVoxelResolution(TopLevelGridData);
+	const FVector3f BottomLevelVoxelPos = (TopLevelVoxelPos - FVector3f(Cell)) * static_cast<float>(VoxelResolution);
+	const FIntVector Voxel(
+		FMath::Clamp(static_cast<int32>(BottomLevelVoxelPos.X), 0, VoxelResolution - 1),
+		FMath::Clamp(static_cast<int32>(BottomLevelVoxelPos.Y), 0, VoxelResolution - 1),
+		FMath::Clamp(static_cast<int32>(BottomLevelVoxelPos.Z), 0, VoxelResolution - 1)
+	);
+	OutBottomLevelVoxelIndex = GetBottomLevelIndex(TopLevelGridData) + MortonEncode3(Voxel);
+	return true;
+}
+
+float FHVPTCpuOrthoGridBuilder::CalcApronMajorant(const FIntVector& Cell, int32 VoxelResolution) const
+{
+	float ApronMajorant = 0.0f;
+	for (int32 Z = -1; Z <= VoxelResolution; ++Z)
+	for (int32 Y = -1; Y <= VoxelResolution; ++Y)
+	for (int32 X = -1; X <= VoxelResolution; ++X)
+	{
+		const FIntVector ApronVoxel(X, Y, Z);
+		if (ApronVoxel.GetMin() >= 0 && ApronVoxel.GetMax() < VoxelResolution)
+		{
+			continue;
+		}
+
+		uint32 NeighbourBottomLevelIndex;
+		const FVector3f TopLevelVoxelPos = FVector3f(Cell) + (FVector3f(ApronVoxel) + 0.5f) / static_cast<float>(VoxelResolution);
+		if (GetBottomLevelVoxel(TopLevelVoxelPos, NeighbourBottomLevelIndex))
+		{
+			ApronMajorant = FMath::Max(ApronMajorant, LoadVoxel(HVPT_GRID_DATA_CHANNEL_EXTINCTION, NeighbourBottomLevelIndex).GetMax());
+		}
+	}
+	return ApronMajorant;
+}
+
+void FHVPTCpuOrthoGridBuilder::CalculateVoxelSize(TConstArrayView<FHVPTCpuVolume> Volumes)
+{
+	TopLevelGrid.Init(ClearedTopLevelGridData, HVPT::Private::CalcMajorantMipSize(Settings.TopLevelGridResolution));
+
+	// HVPT_TopLevelGridCalculateVoxelSizeCS, for a view that does not use the projected pixel size
+	// Each cell takes the finest voxel size of the volumes that touch it
+	for (const FHVPTCpuVolume& Volume : Volumes)
+	{
+		const FBox3f VolumeBounds(Volume.WorldBounds);
+		const float VolumeVoxelSize = FMath::Max(Volume.MinimumVoxelSize, Settings.MinimumVoxelSize);
+
+		ParallelFor(TopLevelGrid.Num(), [this, &Volume, &VolumeBounds, VolumeVoxelSize](int32 LinearIndex)
+		{
+			const FBox3f CellBounds(CalcCellWorldBounds(MortonDecode3(LinearIndex)));
+			if (!BoxesIntersect(CellBounds, VolumeBounds))
+			{
+				return;
+			}
+
+			float VoxelSize = ClampVoxelSizeToBrickResolution(VolumeVoxelSize, CellBounds, Volume, Settings.BottomLevelGridResolution);
+			if (IsBottomLevelAllocated(TopLevelGrid[LinearIndex]))
+			{
+				VoxelSize = FMath::Min(VoxelSize, GetVoxelSize(TopLevelGrid[LinearIndex]));
+			}
+			TopLevelGrid[LinearIndex] = SetVoxelSize(VoxelSize);
+		}, GetParallelForFlags(Settings));
+	}
+}
+
+void FHVPTCpuOrthoGridBuilder::AllocateBottomLevelGrid()
+{
+	// HVPT_AllocateBottomLevelGridCS
+	// Cells are only given a resolution here. Bricks are allocated during rasterization, once a cell is known to have contents
+	CellPriorities.Reset();
+	CellPriorities.SetNumZeroed(TopLevelGrid.Num());
+	const float PriorityScale = HVPT_BRICK_PRIORITY_BUCKET_COUNT / (FMath::Log2(static_cast<float>(Settings.BottomLevelGridResolution)) + 1.0f);
+
+	ParallelFor(TopLevelGrid.Num(), [this, PriorityScale](int32 LinearIndex)
+	{
+		const uint32 TopLevelGridData = TopLevelGrid[LinearIndex];
+		if (!IsBottomLevelAllocated(TopLevelGridData))
+		{
+			return;
+		}
+
+		const float VoxelSize = GetVoxelSize(TopLevelGridData);
+		const FBox3f CellBounds(CalcCellWorldBounds(MortonDecode3(LinearIndex)));
+		const FVector3f CellExtent = CellBounds.Max - CellBounds.Min;
+
+		int32 VoxelResolution = 0;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const uint32 AxisResolution = FMath::RoundUpToPowerOfTwo(FMath::Max(FMath::CeilToInt32(CellExtent[Axis] / VoxelSize), 1));
+			VoxelResolution = FMath::Max(VoxelResolution, FMath::Clamp(static_cast<int32>(AxisResolution), 1, Settings.BottomLevelGridResolution));
+		}
+
+		const float RequestedResolution = CellExtent.GetMax() / VoxelSize;
+		const int32 Priority = static_cast<int32>(FMath::Log2(FMath::Max(RequestedResolution, 1.0f)) * PriorityScale);
+		CellPriorities[LinearIndex] = static_cast<uint8>(FMath::Clamp(Priority, 0, HVPT_BRICK_PRIORITY_BUCKET_COUNT - 1));
+
+		TopLevelGrid[LinearIndex] = PackTopLevelGridData(EmptyVoxelIndex, VoxelResolution);
+	}, GetParallelForFlags(Settings));
+
+	// HVPT_CountBrickDemandCS, so that every cell can be given a brick of its own resolution
+	int32 DemandByClass[HVPT_BRICK_SIZE_CLASS_COUNT] = {};
+	TArray<int32> PriorityDemand;
+	PriorityDemand.SetNumZeroed(HVPT_BRICK_PRIORITY_BUCKET_COUNT * HVPT_BRICK_SIZE_CLASS_COUNT);
+	for (int32 LinearIndex = 0; LinearIndex < TopLevelGrid.Num(); ++LinearIndex)
+	{
+		const uint32 TopLevelGridData = TopLevelGrid[LinearIndex];
+		if (!IsBottomLevelEmpty(TopLevelGridData) && !IsBottomLevelAllocated(TopLevelGridData))
+		{
+			const int32 SizeClass = FHVPTBrickPoolAllocator::GetSizeClass(GetBottomLevelVoxelResolution(TopLevelGridData));
+			DemandByClass[SizeClass]++;
+			PriorityDemand[CellPriorities[LinearIndex] * HVPT_BRICK_SIZE_CLASS_COUNT + SizeClass]++;
+		}
+	}
+
+	int32 BucketLevels[HVPT_BRICK_PRIORITY_BUCKET_COUNT];
+	PlanBrickDegradation(DemandByClass, PriorityDemand, BucketLevels);
+
+	// HVPT_ApplyBrickDegradationCS
+	for (int32 LinearIndex = 0; LinearIndex < TopLevelGrid.Num(); ++LinearIndex)
+	{
+		uint32& TopLevelGridData = TopLevelGrid[LinearIndex];
+		if (IsBottomLevelEmpty(TopLevelGridData) || IsBottomLevelAllocated(TopLevelGridData))
+		{
+			continue;
+		}
+
+		const int32 VoxelResolution = GetBottomLevelVoxelResolution(TopLevelGridData);
+		const int32 DegradedVoxelResolution = FMath::Max(VoxelResolution >> BucketLevels[CellPriorities[LinearIndex]], 1);
+		if (DegradedVoxelResolution < VoxelResolution)
+		{
+			TopLevelGridData = PackTopLevelGridData(EmptyVoxelIndex, DegradedVoxelResolution);
+			DegradationStats.DegradedCellCount++;
+		}
+	}
+
+	// ReserveBricks with the demand left after lowering
+	BrickAllocator.Reserve(DemandByClass);
+}
+
+void FHVPTCpuOrthoGridBuilder::PlanBrickDegradation(TArrayView<int32> DemandByClass, TArrayView<int32> PriorityDemand, TArrayView<int32> OutBucketLevels)
+{
+	// HVPT_PlanBrickDegradationCS
+	const int32 MaxSizeClass = BrickAllocator.GetMaxSizeClass();
+	const int32 MaxDegradationLevel = FMath::Clamp(Settings.MaxDegradationLevel, 0, MaxSizeClass);
+	const int32 AvailableSlabCount = BrickAllocator.GetFreeBrickCount(MaxSizeClass);
+
+	int32 RequiredSlabCount = BrickAllocator.CalcRequiredSlabCount(DemandByClass);
+	DegradationStats = FDegradationStats();
+	DegradationStats.DemandSlabCount = RequiredSlabCount;
+
+	for (int32& BucketLevel : OutBucketLevels)
+	{
+		BucketLevel = 0;
+	}
+
+	// Each level moves the lowest buckets down one size class in turn, and only moves on to the next level once every bucket has had it
+	for (int32 Level = 1; Level <= MaxDegradationLevel && RequiredSlabCount > AvailableSlabCount; ++Level)
+	{
+		for (int32 Bucket = 0; Bucket < HVPT_BRICK_PRIORITY_BUCKET_COUNT && RequiredSlabCount > AvailableSlabCount; ++Bucket)
+		{
+			// Classes are visited from the smallest up, so each cell moves down exactly once
+			int32 MovedCount = 0;
+			for (int32 SizeClass = 1; SizeClass <= MaxSizeClass; ++SizeClass)
+			{
+				const int32 Count = PriorityDemand[Bucket * HVPT_BRICK_SIZE_CLASS_COUNT + SizeClass];
+				PriorityDemand[Bucket * HVPT_BRICK_SIZE_CLASS_COUNT + SizeClass - 1] += Count;
+				PriorityDemand[Bucket * HVPT_BRICK_SIZE_CLASS_COUNT + SizeClass] = 0;
+				DemandByClass[SizeClass - 1] += Count;
+				DemandByClass[SizeClass] -= Count;
+				MovedCount += Count;
+			}
+
+			if (MovedCount > 0)
+			{
+				OutBucketLevels[Bucket] = Level;
+				DegradationStats.Level = Level;
+				RequiredSlabCount = BrickAllocator.CalcRequiredSlabCount(DemandByClass);
+			}
+		}
+	}
+
+	DegradationStats.MissingSlabCount = FMath::Max(RequiredSlabCount - AvailableSlabCount, 0);
+}
+
+void FHVPTCpuOrthoGridBuilder::RasterizeVolume(const FHVPTCpuVolume& Volume)
+{
+	const FBox3f VolumeBounds(Volume.WorldBounds);
+
+	// Raster tiles are only generated for cells with a resolution. Cells the volume does not touch would sum to zero and be skipped
+	TArray<int32> RasterCells;
+	for (int32 LinearIndex = 0; LinearIndex < TopLevelGrid.Num(); ++LinearIndex)
+	{
+		if (!IsBottomLevelEmpty(TopLevelGrid[LinearIndex]) && BoxesIntersect(FBox3f(CalcCellWorldBounds(MortonDecode3(LinearIndex))), VolumeBounds))
+		{
+			RasterCells.Add(LinearIndex);
+		}
+	}
+
+	struct FRasterCell
+	{
+		bool bHasContents = false;
+		bool bWasAlreadyAllocated = false;
+	};
+	TArray<FHVPTCpuVolumeSample> Samples;
+	TArray<FRasterCell> RasterCellStates;
+
+	for (int32 BatchStart = 0; BatchStart < RasterCells.Num(); BatchStart += RasterBatchSize)
+	{
+		const int32 BatchCount = FMath::Min(RasterBatchSize, RasterCells.Num() - BatchStart);
+		Samples.Reset();
+		Samples.SetNum(BatchCount * RasterGroupThreadCount);
+		RasterCellStates.Reset();
+		RasterCellStates.SetNum(BatchCount);
+
+		// Evaluate every thread of the group, with samples stored in the morton order of the threads as in group shared memory
+		ParallelFor(BatchCount, [&](int32 BatchIndex)
+		{
+			const int32 LinearIndex = RasterCells[BatchStart + BatchIndex];
+			const int32 VoxelResolution = GetBottomLevelVoxelResolution(TopLevelGrid[LinearIndex]);
+
+			const FBox3f CellBounds(CalcCellWorldBounds(MortonDecode3(LinearIndex)));
+			const FVector3f CellExtent = CellBounds.Max - CellBounds.Min;
+
+			float ExtinctionSum = 0.0f;
+			for (int32 LinearThreadIndex = 0; LinearThreadIndex < RasterGroupThreadCount; ++LinearThreadIndex)
+			{
+				const FIntVector GroupThreadId = MortonDecode3(LinearThreadIndex);
+				if (GroupThreadId.GetMax() >= VoxelResolution)
+				{
+					continue;
+				}
+
+				const FVector3f UVW = (FVector3f(GroupThreadId) + 0.5f) / static_cast<float>(VoxelResolution);
+				const FVector3f WorldPosition = UVW * CellExtent + CellBounds.Min;
+				if (BoxContainsPoint(VolumeBounds, WorldPosition))
+				{
+					FHVPTCpuVolumeSample& Sample = Samples[BatchIndex * RasterGroupThreadCount + LinearThreadIndex];
+					Sample = Volume.Sample(WorldPosition);
+					ExtinctionSum += Luminance(Sample.Extinction);
+				}
+			}
+
+			RasterCellStates[BatchIndex].bHasContents = ExtinctionSum > RasterZeroThreshold;
+		}, GetParallelForFlags(Settings));
+
+		// Bricks are handed out in cell order, so that the result is the same however the cells were evaluated
+		for (int32 BatchIndex = 0; BatchIndex < BatchCount; ++BatchIndex)
+		{
+			FRasterCell& RasterCell = RasterCellStates[BatchIndex];
+			uint32& TopLevelGridData = TopLevelGrid[RasterCells[BatchStart + BatchIndex]];
+
+			RasterCell.bWasAlreadyAllocated = IsBottomLevelAllocated(TopLevelGridData);
+			if (!RasterCell.bHasContents || RasterCell.bWasAlreadyAllocated)
+			{
+				continue;
+			}
+
+			const int32 BottomLevelIndex = BrickAllocator.Allocate(GetBottomLevelVoxelResolution(TopLevelGridData));
+			TopLevelGridData = (BottomLevelIndex == INDEX_NONE)
+				? PackTopLevelGridData(EmptyVoxelIndex, 0) // Pool is exhausted, so the cell is left empty
+				: PackTopLevelGridData(BottomLevelIndex, GetBottomLevelVoxelResolution(TopLevelGridData));
+		}
+
+		// HVPT_AccumulatePropertiesInBottomLevelGrid
+		ParallelFor(BatchCount, [&](int32 BatchIndex)
+		{
+			const FRasterCell& RasterCell = RasterCellStates[BatchIndex];
+			const uint32 TopLevelGridData = TopLevelGrid[RasterCells[BatchStart + BatchIndex]];
+			if (!RasterCell.bHasContents || !IsBottomLevelAllocated(TopLevelGridData))
+			{
+				return;
+			}
+
+			const int32 AllocatedVoxelCount = FMath::Cube(GetBottomLevelVoxelResolution(TopLevelGridData));
+			for (int32 LinearThreadIndex = 0; LinearThreadIndex < AllocatedVoxelCount; ++LinearThreadIndex)
+			{
+				const FHVPTCpuVolumeSample& Sample = Samples[BatchIndex * RasterGroupThreadCount + LinearThreadIndex];
+				const uint32 VoxelIndex = GetBottomLevelIndex(TopLevelGridData) + LinearThreadIndex;
+
+				FVector3f Values[HVPT_GRID_DATA_CHANNEL_COUNT];
+				Values[HVPT_GRID_DATA_CHANNEL_EXTINCTION] = Sample.Extinction;
+				Values[HVPT_GRID_DATA_CHANNEL_EMISSION] = Sample.Emission;
+				Values[HVPT_GRID_DATA_CHANNEL_SCATTERING] = Sample.Albedo * Sample.Extinction;
+				Values[HVPT_GRID_DATA_CHANNEL_VELOCITY] = Sample.Velocity;
+
+				for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+				{
+					if (RasterCell.bWasAlreadyAllocated)
+					{
+						Values[Channel] += LoadVoxel(Channel, VoxelIndex);
+					}
+					StoreVoxel(Channel, VoxelIndex, Values[Channel]);
+				}
+			}
+		}, GetParallelForFlags(Settings));
+	}
+}
+
+void FHVPTCpuOrthoGridBuilder::BuildMajorants()
+{
+	const FIntVector& Resolution = Settings.TopLevelGridResolution;
+
+	Majorants.Reset();
+	Majorants.SetNumZeroed(HVPT::Private::CalcMajorantMipOffset(Resolution, MajorantMipCount));
+	SubBrickMajorants.Reset();
+	SubBrickMajorants.SetNumZeroed(Settings.bBuildSubBrickMajorants ? HVPT::Private::CalcMajorantMipSize(Resolution) * SubBricksPerBrick : 1);
+
+	// HVPT_BuildMajorantVoxelGridCS
+	ParallelFor(TopLevelGrid.Num(), [this](int32 LinearIndex)
+	{
+		float Majorant = 0.0f;
+		float Mean = 0.0f;
+		uint32 VoxelsContributingToMajorant = 0;
+
+		const uint32 TopLevelGridData = TopLevelGrid[LinearIndex];
+		if (IsBottomLevelAllocated(TopLevelGridData))
+		{
+			const int32 VoxelResolution = GetBottomLevelVoxelResolution(TopLevelGridData);
+			const uint32 FirstBottomLevelIndex = GetBottomLevelIndex(TopLevelGridData);
+
+			const int32 FilterApron = Settings.bTrilinearFiltering ? 1 : 0;
+			const float ApronMajorant = Settings.bTrilinearFiltering ? CalcApronMajorant(MortonDecode3(LinearIndex), VoxelResolution) : 0.0f;
+
+			const int32 SubBrickResolution = FMath::DivideAndRoundUp(VoxelResolution, HVPT_SUB_BRICK_SIZE);
+			const uint32 FirstSubBrickIndex = LinearIndex * SubBricksPerBrick;
+
+			for (int32 SubBrickZ = 0; SubBrickZ < SubBrickResolution; ++SubBrickZ)
+			for (int32 SubBrickY = 0; SubBrickY < SubBrickResolution; ++SubBrickY)
+			for (int32 SubBrickX = 0; SubBrickX < SubBrickResolution; ++SubBrickX)
+			{
+				const FIntVector SubBrickMin = FIntVector(SubBrickX, SubBrickY, SubBrickZ) * HVPT_SUB_BRICK_SIZE;
+				const FIntVector SubBrickMax(
+					FMath::Min(SubBrickMin.X + HVPT_SUB_BRICK_SIZE, VoxelResolution),
+					FMath::Min(SubBrickMin.Y + HVPT_SUB_BRICK_SIZE, VoxelResolution),
+					FMath::Min(SubBrickMin.Z + HVPT_SUB_BRICK_SIZE, VoxelResolution)
+				);
+
+				float SubBrickMajorant = 0.0f;
+				float SubBrickMean = 0.0f;
+				uint32 VoxelsContributingToSubBrick = 0;
+
+				const FIntVector FootprintMin(
+					FMath::Max(SubBrickMin.X - FilterApron, 0),
+					FMath::Max(SubBrickMin.Y - FilterApron, 0),
+					FMath::Max(SubBrickMin.Z - FilterApron, 0)
+				);
+				const FIntVector FootprintMax(
+					FMath::Min(SubBrickMax.X + FilterApron, VoxelResolution),
+					FMath::Min(SubBrickMax.Y + FilterApron, VoxelResolution),
+					FMath::Min(SubBrickMax.Z + FilterApron, VoxelResolution)
+				);
+
+				for (int32 Z = FootprintMin.Z; Z < FootprintMax.Z; ++Z)
+				for (int32 Y = FootprintMin.Y; Y < FootprintMax.Y; ++Y)
+				for (int32 X = FootprintMin.X; X < FootprintMax.X; ++X)
+				{
+					const float MaxComponent = LoadVoxel(HVPT_GRID_DATA_CHANNEL_EXTINCTION, FirstBottomLevelIndex + MortonEncode3(FIntVector(X, Y, Z))).GetMax();
+					SubBrickMajorant = FMath::Max(SubBrickMajorant, MaxComponent);
+					if (X >= SubBrickMin.X && Y >= SubBrickMin.Y && Z >= SubBrickMin.Z && X < SubBrickMax.X && Y < SubBrickMax.Y && Z < SubBrickMax.Z)
+					{
+						SubBrickMean += MaxComponent;
+						VoxelsContributingToSubBrick++;
+					}
+				}
+				SubBrickMajorant = FMath::Max(SubBrickMajorant, ApronMajorant);
+
+				Majorant = FMath::Max(Majorant, SubBrickMajorant);
+				Mean += SubBrickMean;
+				VoxelsContributingToMajorant += VoxelsContributingToSubBrick;
+
+				if (Settings.bBuildSubBrickMajorants)
+				{
+					SubBrickMean = (VoxelsContributingToSubBrick > 0) ? SubBrickMean / static_cast<float>(VoxelsContributingToSubBrick) : 0.0f;
+
+					const uint32 SubBrickIndex = FirstSubBrickIndex + SubBrickX + SubBrickResolution * (SubBrickY + SubBrickResolution * SubBrickZ);
+					SubBrickMajorants[SubBrickIndex] = PackMajorantData(SubBrickMajorant, SubBrickMean);
+				}
+			}
+		}
+
+		Mean = (VoxelsContributingToMajorant > 0) ? Mean / static_cast<float>(VoxelsContributingToMajorant) : 0.0f;
+		Majorants[LinearIndex] = PackMajorantData(Majorant, Mean);
+	}, GetParallelForFlags(Settings));
+
+	// HVPT_DownsampleMajorantGridCS, one level at a time
+	for (int32 MipLevel = 1; MipLevel < MajorantMipCount; ++MipLevel)
+	{
+		const FIntVector SrcMipResolution = HVPT::Private::CalcMajorantMipResolution(Resolution, MipLevel - 1);
+		const FIntVector DstMipResolution = HVPT::Private::CalcMajorantMipResolution(Resolution, MipLevel);
+		const uint32 SrcMipOffset = HVPT::Private::CalcMajorantMipOffset(Resolution, MipLevel - 1);
+		const uint32 DstMipOffset = HVPT::Private::CalcMajorantMipOffset(Resolution, MipLevel);
+
+		ParallelFor(DstMipResolution.X * DstMipResolution.Y * DstMipResolution.Z, [&](int32 DstCellIndex)
+		{
+			const FIntVector DstCell(
+				DstCellIndex % DstMipResolution.X,
+				(DstCellIndex / DstMipResolution.X) % DstMipResolution.Y,
+				DstCellIndex / (DstMipResolution.X * DstMipResolution.Y)
+			);
+
+			float Majorant = 0.0f;
+			float Mean = 0.0f;
+			uint32 ChildCount = 0;
+
+			for (int32 ChildIndex = 0; ChildIndex < 8; ++ChildIndex)
+			{
+				const FIntVector SrcCell = DstCell * 2 + FIntVector(ChildIndex & 1, (ChildIndex >> 1) & 1, (ChildIndex >> 2) & 1);
+				if (SrcCell.X < SrcMipResolution.X && SrcCell.Y < SrcMipResolution.Y && SrcCell.Z < SrcMipResolution.Z)
+				{
+					const uint32 ChildData = Majorants[SrcMipOffset + MortonEncode3(SrcCell)];
+					Majorant = FMath::Max(Majorant, GetMajorant(ChildData));
+					Mean += GetMean(ChildData);
+					ChildCount++;
+				}
+			}
+
+			Mean = (ChildCount > 0) ? Mean / static_cast<float>(ChildCount) : 0.0f;
+			Majorants[DstMipOffset + MortonEncode3(DstCell)] = PackMajorantData(Majorant, Mean);
+		}, GetParallelForFlags(Settings));
+	}
+}
+
+FVector3f FHVPTCpuOrthoGridBuilder::LoadVoxel(int32 Channel, uint32 VoxelIndex) const
+{
+	// Voxels are tightly packed in every format, see LoadPackedGridData
+	const uint32 Format = HVPT::Private::GetGridDataFormat(Settings.GridDataFormats, Channel);
+	const int32 BytesPerVoxel = HVPT::Private::CalcGridDataBytesPerVoxel(Format);
+
+	uint32 Packed[2] = { 0, 0 };
+	FMemory::Memcpy(Packed, ChannelData[Channel].GetData() + static_cast<int64>(VoxelIndex) * BytesPerVoxel, BytesPerVoxel);
+	return HVPT::Private::DecodeGridData(Format, Packed);
+}
+
+void FHVPTCpuOrthoGridBuilder::StoreVoxel(int32 Channel, uint32 VoxelIndex, const FVector3f& Value)
+{
+	const uint32 Format = HVPT::Private::GetGridDataFormat(Settings.GridDataFormats, Channel);
+	const int32 BytesPerVoxel = HVPT::Private::CalcGridDataBytesPerVoxel(Format);
+
+	uint32 Packed[2];
+	HVPT::Private::EncodeGridData(Format, Value, Packed);
+	FMemory::Memcpy(ChannelData[Channel].GetData() + static_cast<int64>(VoxelIndex) * BytesPerVoxel, Packed, BytesPerVoxel);
+}
+
+FHVPTBakedOrthoGrid FHVPTCpuOrthoGridBuilder::GetGrid() const
+{
+	FHVPTBakedOrthoGrid Grid;
+	Grid.TopLevelGridWorldBoundsMin = FVector3f(Settings.TopLevelGridWorldBounds.Min);
+	Grid.TopLevelGridWorldBoundsMax = FVector3f(Settings.TopLevelGridWorldBounds.Max);
+	Grid.TopLevelGridResolution = Settings.TopLevelGridResolution;
+	Grid.GridDataFormats = Settings.GridDataFormats;
+	Grid.VoxelsPerBrick = VoxelsPerBrick;
+	Grid.BrickCount = Settings.BrickCapacity;
+	Grid.MajorantMipCount = MajorantMipCount;
+	Grid.SubBricksPerBrick = Settings.bBuildSubBrickMajorants ? SubBricksPerBrick : 0;
+
+	Grid.TopLevelGrid = TopLevelGrid;
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		Grid.ChannelData[Channel] = ChannelData[Channel];
+	}
+	Grid.Majorants = Majorants;
+	Grid.SubBrickMajorants = Settings.bBuildSubBrickMajorants ? TConstArrayView<uint32>(SubBrickMajorants) : TConstArrayView<uint32>();
+	return Grid;
+}
+
+bool FHVPTCpuOrthoGridBuilder::ValidateGrid() const
+{
+	// Majorants are stored as half floats, rounded to nearest, so may be a little below the extinction they bound
+	const float MajorantTolerance = 1.0f - HVPT::Private::GetGridDataMaxRelativeError(HVPT_GRID_DATA_FORMAT_FLOAT16);
+
+	// Bricks of different sizes share slabs, so overlaps are found voxel by voxel
+	TBitArray<> UsedVoxels(false, Settings.BrickCapacity * VoxelsPerBrick);
+	int32 AllocatedCellCount = 0;
+
+	for (int32 LinearIndex = 0; LinearIndex < TopLevelGrid.Num(); ++LinearIndex)
+	{
+		const uint32 TopLevelGridData = TopLevelGrid[LinearIndex];
+		if (!IsBottomLevelAllocated(TopLevelGridData))
+		{
+			continue;
+		}
+
+		const uint32 BottomLevelIndex = GetBottomLevelIndex(TopLevelGridData);
+		const int32 VoxelResolution = GetBottomLevelVoxelResolution(TopLevelGridData);
+		if (VoxelResolution < 1 || VoxelResolution > Settings.BottomLevelGridResolution)
+		{
+			return false;
+		}
+
+		// A brick is aligned to its own size, so it never straddles two slabs
+		const int32 VoxelCount = FMath::Cube(VoxelResolution);
+		if (BottomLevelIndex % VoxelCount != 0 || static_cast<int64>(BottomLevelIndex) + VoxelCount > UsedVoxels.Num())
+		{
+			return false;
+		}
+		for (int32 VoxelIndex = 0; VoxelIndex < VoxelCount; ++VoxelIndex)
+		{
+			if (UsedVoxels[BottomLevelIndex + VoxelIndex])
+			{
+				return false;
+			}
+			UsedVoxels[BottomLevelIndex + VoxelIndex] = true;
+		}
+		AllocatedCellCount++;
+
+		const float CellMajorant = GetMajorant(Majorants[LinearIndex]);
+
+		// Filtered samples in the cell blend with the voxels half a voxel beyond it, in whichever cells those fall in
+		if (Settings.bTrilinearFiltering)
+		{
+			const FIntVector Cell = MortonDecode3(LinearIndex);
+			for (int32 Z = -1; Z <= VoxelResolution; ++Z)
+			for (int32 Y = -1; Y <= VoxelResolution; ++Y)
+			for (int32 X = -1; X <= VoxelResolution; ++X)
+			{
+				uint32 FootprintBottomLevelIndex;
+				const FVector3f TopLevelVoxelPos = FVector3f(Cell) + (FVector3f(X, Y, Z) + 0.5f) / static_cast<float>(VoxelResolution);
+				if (GetBottomLevelVoxel(TopLevelVoxelPos, FootprintBottomLevelIndex)
+					&& CellMajorant < LoadVoxel(HVPT_GRID_DATA_CHANNEL_EXTINCTION, FootprintBottomLevelIndex).GetMax() * MajorantTolerance)
+				{
+					return false;
+				}
+			}
+		}
+
+		for (int32 Z = 0; Z < VoxelResolution; ++Z)
+		for (int32 Y = 0; Y < VoxelResolution; ++Y)
+		for (int32 X = 0; X < VoxelResolution; ++X)
+		{
+			const float Extinction = LoadVoxel(HVPT_GRID_DATA_CHANNEL_EXTINCTION, BottomLevelIndex + MortonEncode3(FIntVector(X, Y, Z))).GetMax();
+			if (CellMajorant < Extinction * MajorantTolerance)
+			{
+				return false;
+			}
+
+			if (Settings.bBuildSubBrickMajorants)
+			{
+				const FIntVector SubBrick = FIntVector(X, Y, Z) / HVPT_SUB_BRICK_SIZE;
+				const int32 SubBrickResolution = FMath::DivideAndRoundUp(VoxelResolution, HVPT_SUB_BRICK_SIZE);
+				const uint32 SubBrickIndex = LinearIndex * SubBricksPerBrick + SubBrick.X + SubBrickResolution * (SubBrick.Y + SubBrickResolution * SubBrick.Z);
+				if (GetMajorant(SubBrickMajorants[SubBrickIndex]) < Extinction * MajorantTolerance)
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	if (AllocatedCellCount != BrickAllocator.GetAllocatedBrickCount())
+	{
+		return false;
+	}
+
+	// Every level of the pyramid must bound the level below it
+	for (int32 MipLevel = 1; MipLevel < MajorantMipCount; ++MipLevel)
+	{
+		const FIntVector SrcMipResolution = HVPT::Private::CalcMajorantMipResolution(Settings.TopLevelGridResolution, MipLevel - 1);
+		const uint32 SrcMipOffset = HVPT::Private::CalcMajorantMipOffset(Settings.TopLevelGridResolution, MipLevel - 1);
+		const uint32 DstMipOffset = HVPT::Private::CalcMajorantMipOffset(Settings.TopLevelGridResolution, MipLevel);
+
+		for (int32 Z = 0; Z < SrcMipResolution.Z; ++Z)
+		for (int32 Y = 0; Y < SrcMipResolution.Y; ++Y)
+		for (int32 X = 0; X < SrcMipResolution.X; ++X)
+		{
+			const FIntVector SrcCell(X, Y, Z);
+			if (GetMajorant(Majorants[DstMipOffset + MortonEncode3(SrcCell / 2)]) < GetMajorant(Majorants[SrcMipOffset + MortonEncode3(SrcCell)]))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void HVPT::Private::MakeSyntheticOrthoGridScene(int32 TopLevelGridResolution, FHVPTCpuOrthoGridBuildSettings& OutSettings, TArray<FHVPTCpuVolume>& OutVolumes)
+{
+	const float CellSize = 100.0f;
+	const float GridSize = CellSize * TopLevelGridResolution;
+
+	OutSettings = FHVPTCpuOrthoGridBuildSettings();
+	OutSettings.TopLevelGridWorldBounds = FBox(FVector(0.0f), FVector(GridSize));
+	OutSettings.TopLevelGridResolution = FIntVector(TopLevelGridResolution);
+	OutSettings.BottomLevelGridResolution = 4;
+	OutSettings.BrickCapacity = FMath::Cube(TopLevelGridResolution);
+	OutSettings.GridDataFormats = (HVPT_GRID_DATA_FORMAT_MONOCHROME16 << (4 * HVPT_GRID_DATA_CHANNEL_EXTINCTION))
+		| (HVPT_GRID_DATA_FORMAT_RGB9E5 << (4 * HVPT_GRID_DATA_CHANNEL_EMISSION))
+		| (HVPT_GRID_DATA_FORMAT_RGBE8 << (4 * HVPT_GRID_DATA_CHANNEL_SCATTERING))
+		| (HVPT_GRID_DATA_FORMAT_FLOAT16 << (4 * HVPT_GRID_DATA_CHANNEL_VELOCITY));
+	OutSettings.MinimumVoxelSize = CellSize / 4.0f;
+
+	OutVolumes.Reset();
+
+	const FVector3f SphereCentre(GridSize * 0.4f);
+	const float SphereRadius = GridSize * 0.3f;
+	FHVPTCpuVolume& Sphere = OutVolumes.AddDefaulted_GetRef();
+	Sphere.WorldBounds = FBox(FVector(SphereCentre - SphereRadius), FVector(SphereCentre + SphereRadius));
+	Sphere.Sample = [SphereCentre, SphereRadius](const FVector3f& WorldPosition)
+	{
+		const float Density = FMath::Clamp(1.0f - FVector3f::Distance(WorldPosition, SphereCentre) / SphereRadius, 0.0f, 1.0f);
+
+		FHVPTCpuVolumeSample Sample;
+		Sample.Extinction = FVector3f(Density * 0.05f);
+		Sample.Albedo = FVector3f(0.9f);
+		Sample.Velocity = FVector3f(0.0f, 0.0f, Density * 10.0f);
+		return Sample;
+	};
+
+	FHVPTCpuVolume& Box = OutVolumes.AddDefaulted_GetRef();
+	Box.WorldBounds = FBox(FVector(GridSize * 0.5f, GridSize * 0.1f, GridSize * 0.1f), FVector(GridSize * 0.9f, GridSize * 0.6f, GridSize * 0.3f));
+	Box.MinimumVoxelSize = CellSize / 2.0f;
+	// Coarser than its minimum voxel size asks for, to cover the per-volume level of detail limits
+	Box.MaxBrickResolution = 1;
+	Box.Sample = [](const FVector3f& WorldPosition)
+	{
+		FHVPTCpuVolumeSample Sample;
+		Sample.Extinction = FVector3f(0.002f);
+		Sample.Emission = FVector3f(1.0f, 0.4f, 0.1f);
+		Sample.Albedo = FVector3f(0.5f, 0.6f, 0.7f);
+		return Sample;
+	};
+
+	FHVPTCpuVolume& Empty = OutVolumes.AddDefaulted_GetRef();
+	Empty.WorldBounds = FBox(FVector(GridSize * 0.8f), FVector(GridSize));
+	Empty.Sample = [](const FVector3f& WorldPosition)
+	{
+		FHVPTCpuVolumeSample Sample;
+		Sample.Emission = FVector3f(1.0f);
+		return Sample;
+	};
+}
+
+FHVPTCpuOrthoGridBuilder::FTimings HVPT::Private::BenchmarkCpuOrthoGridBuilder(int32 TopLevelGridResolution, int32 Iterations, bool bMultithreaded, int32& OutAllocatedBrickCount)
+{
+	FHVPTCpuOrthoGridBuildSettings Settings;
+	TArray<FHVPTCpuVolume> Volumes;
+	MakeSyntheticOrthoGridScene(TopLevelGridResolution, Settings, Volumes);
+	Settings.bMultithreaded = bMultithreaded;
+
+	FHVPTCpuOrthoGridBuilder Builder;
+	FHVPTCpuOrthoGridBuilder::FTimings AverageTimings;
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		Builder.Build(Settings, Volumes);
+		AverageTimings.CalculateVoxelSizeSeconds += Builder.GetTimings().CalculateVoxelSizeSeconds / Iterations;
+		AverageTimings.AllocateBottomLevelGridSeconds += Builder.GetTimings().AllocateBottomLevelGridSeconds / Iterations;
+		AverageTimings.RasterizeSeconds += Builder.GetTimings().RasterizeSeconds / Iterations;
+		AverageTimings.BuildMajorantsSeconds += Builder.GetTimings().BuildMajorantsSeconds / Iterations;
+	}
+
+	OutAllocatedBrickCount = Builder.GetAllocatedBrickCount();
+	return AverageTimings;
+}
+
+
+static FAutoConsoleCommand CmdHVPTBenchmarkCpuOrthoGridBuilder(
+	TEXT("r.HVPT.OrthoGrid.BenchmarkCpuBuilder"),
+	TEXT("Builds a synthetic scene with the CPU reference ortho grid builder, single and multithreaded, and logs the average time taken by each step.\n")
+	TEXT("Every build of the CPU builder is also counted in stat HVPT.\n")
+	TEXT("Arguments: [TopLevelGridResolution = 32] [Iterations = 4]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 TopLevelGridResolution = FMath::RoundUpToPowerOfTwo(FMath::Clamp(Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 32, 1, 256));
+		const int32 Iterations = FMath::Max(Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 4, 1);
+
+		double SingleThreadedSeconds = 0.0;
+		for (const bool bMultithreaded : { false, true })
+		{
+			int32 AllocatedBrickCount = 0;
+			const FHVPTCpuOrthoGridBuilder::FTimings Timings = HVPT::Private::BenchmarkCpuOrthoGridBuilder(TopLevelGridResolution, Iterations, bMultithreaded, AllocatedBrickCount);
+			if (!bMultithreaded)
+			{
+				SingleThreadedSeconds = Timings.GetTotalSeconds();
+			}
+
+			UE_LOG(LogHVPT, Display, TEXT("CPU ortho grid build (%s, %d^3 cells, %d bricks): voxel size %.2f ms, allocate %.2f ms, rasterize %.2f ms, majorants %.2f ms, total %.2f ms (%.2fx)"),
+				bMultithreaded ? TEXT("multithreaded") : TEXT("single threaded"),
+				TopLevelGridResolution,
+				AllocatedBrickCount,
+				Timings.CalculateVoxelSizeSeconds * 1000.0,
+				Timings.AllocateBottomLevelGridSeconds * 1000.0,
+				Timings.RasterizeSeconds * 1000.0,
+				Timings.BuildMajorantsSeconds * 1000.0,
+				Timings.GetTotalSeconds() * 1000.0,
+				SingleThreadedSeconds / FMath::Max(Timings.GetTotalSeconds(), UE_DOUBLE_SMALL_NUMBER)
+			);
+		}
+	})
+);
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HVPTDefinitions.h"
+#include "BakedVoxelGrid.h"
+#include "BrickPool.h"
+
+
+// Properties of a volume at a point, in the form the material graph provides them to HVPT_RasterizeBottomLevelOrthoGridCS
+struct FHVPTCpuVolumeSample
+{
+	FVector3f Extinction = FVector3f::ZeroVector;
+	FVector3f Emission = FVector3f::ZeroVector;
+	FVector3f Albedo = FVector3f::ZeroVector;
+	FVector3f Velocity = FVector3f::ZeroVector;
+};
+
+// A volume to rasterize, standing in for a heterogeneous volume mesh batch and its material
+struct FHVPTCpuVolume
+{
+	FBox WorldBounds = FBox(ForceInit);
+
+	// Equivalent of IHeterogeneousVolumeInterface::GetMinimumVoxelSize
+	float MinimumVoxelSize = 0.0f;
+
+	// Equivalent of IHeterogeneousVolumeExInterface::GetMinBrickResolution and GetMaxBrickResolution
+	// 0 for the maximum uses the bottom-level grid resolution of the build
+	int32 MinBrickResolution = 1;
+	int32 MaxBrickResolution = 0;
+
+	// Called from several threads at once, and only for positions inside WorldBounds
+	TFunction<FHVPTCpuVolumeSample(const FVector3f& WorldPosition)> Sample;
+};
+
+struct FHVPTCpuOrthoGridBuildSettings
+{
+	FBox TopLevelGridWorldBounds = FBox(ForceInit);
+
+	// Cells are addressed with a morton code as on the GPU, so every dimension should be the same power of two
+	// See r.HVPT.ForceCubicTopLevelGrid
+	FIntVector TopLevelGridResolution = FIntVector(1);
+
+	// Rasterization evaluates a bottom-level grid with a single 4x4x4 thread group, so this is at most 4
+	int32 BottomLevelGridResolution = 4;
+	// Slabs of BottomLevelGridResolution^3 voxels, shared by bricks of the smaller resolutions, see FHVPTBrickPoolAllocator
+	int32 BrickCapacity = 0;
+	uint32 GridDataFormats = 0;
+	// Times the resolution of the lowest priority cells may be halved when the pool cannot hold every brick of the build
+	// See r.HVPT.OrthoGrid.MaxDegradationLevel. 0 leaves the cells that do not fit empty
+	int32 MaxDegradationLevel = 0;
+
+	int32 MaxMajorantMipCount = HVPT_MAX_MAJORANT_MIP_COUNT;
+	bool bBuildSubBrickMajorants = true;
+	// Majorants also bound the voxels that trilinear filtered samples blend with, see r.HVPT.OrthoGrid.TrilinearFiltering
+	bool bTrilinearFiltering = false;
+
+	// Voxel size of every cell touched by a volume, as with r.HVPT.MinimumVoxelSizeOutsideFrustum
+	// The GPU build can refine cells in view by their projected pixel size, which has no equivalent without a view
+	float MinimumVoxelSize = 1.0f;
+
+	// Bricks are allocated in the same order either way, so the result does not depend on this
+	bool bMultithreaded = true;
+};
+
+
+// CPU reference for the ortho grid build in VoxelGridBuild.usf and RasterizeBottomLevel.usf
+// Follows HVPT_TopLevelGridCalculateVoxelSizeCS, HVPT_AllocateBottomLevelGridCS, HVPT_PlanBrickDegradationCS,
+// HVPT_ApplyBrickDegradationCS, HVPT_RasterizeBottomLevelOrthoGridCS, HVPT_BuildMajorantVoxelGridCS and
+// HVPT_DownsampleMajorantGridCS step by step, producing buffers with the same packing.
+// The GPU hands out bricks in whatever order its thread groups happen to run, while this builder allocates them in morton order of
+// the cells, so grids built on either should be compared cell by cell rather than brick by brick.
+class FHVPTCpuOrthoGridBuilder
+{
+public:
+	void Build(const FHVPTCpuOrthoGridBuildSettings& InSettings, TConstArrayView<FHVPTCpuVolume> Volumes);
+
+	// Views into the buffers of the last build, in the layout they have on the GPU
+	// Can be passed to SerializeBakedOrthoGrid to bake a grid without a GPU
+	FHVPTBakedOrthoGrid GetGrid() const;
+
+	int32 GetAllocatedBrickCount() const { return BrickAllocator.GetAllocatedBrickCount(); }
+	const FHVPTBrickPoolAllocator& GetBrickAllocator() const { return BrickAllocator; }
+
+	struct FTimings
+	{
+		double CalculateVoxelSizeSeconds = 0.0;
+		double AllocateBottomLevelGridSeconds = 0.0;
+		double RasterizeSeconds = 0.0;
+		double BuildMajorantsSeconds = 0.0;
+
+		double GetTotalSeconds() const { return CalculateVoxelSizeSeconds + AllocateBottomLevelGridSeconds + RasterizeSeconds + BuildMajorantsSeconds; }
+	};
+	const FTimings& GetTimings() const { return Timings; }
+
+	// How the last build fitted its bricks in the pool, as HVPT_BRICK_DEGRADATION_STATS_* on the GPU
+	struct FDegradationStats
+	{
+		int32 DemandSlabCount = 0;
+		int32 Level = 0;
+		int32 DegradedCellCount = 0;
+		int32 MissingSlabCount = 0;
+	};
+	const FDegradationStats& GetDegradationStats() const { return DegradationStats; }
+
+	// Rank of each cell by the resolution it asked for, in morton order, see HVPT_BRICK_PRIORITY_BUCKET_COUNT
+	TConstArrayView<uint8> GetCellPriorities() const { return CellPriorities; }
+
+	// Checks that every cell refers to its own brick inside the pool, and that every majorant bounds the extinction beneath it
+	bool ValidateGrid() const;
+
+private:
+	void CalculateVoxelSize(TConstArrayView<FHVPTCpuVolume> Volumes);
+	void AllocateBottomLevelGrid();
+	// Lowers the demand of the lowest priority buckets until it fits in the pool, returning how many times each bucket is halved
+	void PlanBrickDegradation(TArrayView<int32> DemandByClass, TArrayView<int32> PriorityDemand, TArrayView<int32> OutBucketLevels);
+	void RasterizeVolume(const FHVPTCpuVolume& Volume);
+	void BuildMajorants();
+
+	FBox CalcCellWorldBounds(const FIntVector& Cell) const;
+
+	// GetOrthoGridBottomLevelVoxel in VoxelGridBuildUtils.ush
+	bool GetBottomLevelVoxel(const FVector3f& TopLevelVoxelPos, uint32& OutBottomLevelVoxelIndex) const;
+	// Largest extinction of the voxels in neighbouring cells that filtered samples in Cell blend with
+	float CalcApronMajorant(const FIntVector& Cell, int32 VoxelResolution) const;
+
+	FVector3f LoadVoxel(int32 Channel, uint32 VoxelIndex) const;
+	void StoreVoxel(int32 Channel, uint32 VoxelIndex, const FVector3f& Value);
+
+	FHVPTCpuOrthoGridBuildSettings Settings;
+	int32 VoxelsPerBrick = 0;
+	int32 SubBricksPerBrick = 0;
+	int32 MajorantMipCount = 0;
+
+	TArray<uint32> TopLevelGrid;
+	TArray<uint8> CellPriorities;
+	TArray<uint8> ChannelData[HVPT_GRID_DATA_CHANNEL_COUNT];
+	TArray<uint32> Majorants;
+	TArray<uint32> SubBrickMajorants;
+
+	FHVPTBrickPoolAllocator BrickAllocator;
+	FTimings Timings;
+	FDegradationStats DegradationStats;
+};
+
+
+namespace HVPT::Private
+{
+
+// Synthetic scene used to test and benchmark the builder: a dense sphere with a soft edge, a thin coloured box overlapping it,
+// and a volume with no extinction that must not allocate any bricks
+void MakeSyntheticOrthoGridScene(int32 TopLevelGridResolution, FHVPTCpuOrthoGridBuildSettings& OutSettings, TArray<FHVPTCpuVolume>& OutVolumes);
+
+// Builds the synthetic scene Iterations times and returns the average time of each step
+FHVPTCpuOrthoGridBuilder::FTimings BenchmarkCpuOrthoGridBuilder(int32 TopLevelGridResolution, int32 Iterations, bool bMultithreaded, int32& OutAllocatedBrickCount);
+
+}
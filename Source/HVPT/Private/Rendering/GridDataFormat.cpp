@@ -0,0 +1,226 @@
+#include "GridDataFormat.h"
+
+#include "HVPT.h"
+#include "VoxelGrid.h"
+
+
+uint32 HVPT::Private::GetGridDataFormats(bool bMonochromeExtinction)
+{
+	const uint32 ExtinctionFormat = bMonochromeExtinction ? HVPT_GRID_DATA_FORMAT_MONOCHROME16 : static_cast<uint32>(HVPT::GetGridDataFormatForExtinction());
+
+	// Velocity is signed, so it is always stored as half floats
+	return (ExtinctionFormat << (4 * HVPT_GRID_DATA_CHANNEL_EXTINCTION))
+		| (static_cast<uint32>(HVPT::GetGridDataFormatForEmission()) << (4 * HVPT_GRID_DATA_CHANNEL_EMISSION))
+		| (static_cast<uint32>(HVPT::GetGridDataFormatForScattering()) << (4 * HVPT_GRID_DATA_CHANNEL_SCATTERING))
+		| (static_cast<uint32>(HVPT_GRID_DATA_FORMAT_FLOAT16) << (4 * HVPT_GRID_DATA_CHANNEL_VELOCITY));
+}
+
+uint32 HVPT::Private::GetGridDataFormat(uint32 GridDataFormats, int32 Channel)
+{
+	return (GridDataFormats >> (4 * Channel)) & 0xF;
+}
+
+bool HVPT::Private::HasMonochromeExtinction(uint32 GridDataFormats)
+{
+	return GetGridDataFormat(GridDataFormats, HVPT_GRID_DATA_CHANNEL_EXTINCTION) == HVPT_GRID_DATA_FORMAT_MONOCHROME16;
+}
+
+int32 HVPT::Private::CalcGridDataBytesPerVoxel(uint32 Format)
+{
+	switch (Format)
+	{
+	case HVPT_GRID_DATA_FORMAT_FLOAT16:
+		return 8;
+	case HVPT_GRID_DATA_FORMAT_MONOCHROME16:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+int32 HVPT::Private::CalcGridDataBytesPerVoxelForAllChannels(uint32 GridDataFormats)
+{
+	int32 BytesPerVoxel = 0;
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		BytesPerVoxel += CalcGridDataBytesPerVoxel(GetGridDataFormat(GridDataFormats, Channel));
+	}
+	return BytesPerVoxel;
+}
+
+int32 HVPT::Private::CalcGridDataBufferSize(uint32 Format, int32 VoxelCount)
+{
+	return FMath::DivideAndRoundUp(VoxelCount, static_cast<int32>(sizeof(FHVPT_GridData)) / CalcGridDataBytesPerVoxel(Format));
+}
+
+
+// Exact floor(log2(X)) for positive normal floats, read from the exponent bits as the shaders do
+static int32 FloorLog2(float X)
+{
+	uint32 Bits;
+	FMemory::Memcpy(&Bits, &X, sizeof(Bits));
+	return static_cast<int32>(Bits >> 23) - 127;
+}
+
+static uint32 EncodeRGB9E5(FVector3f Value)
+{
+	const float MaxValue = 65408.0f;
+	Value = FVector3f(FMath::Clamp(Value.X, 0.0f, MaxValue), FMath::Clamp(Value.Y, 0.0f, MaxValue), FMath::Clamp(Value.Z, 0.0f, MaxValue));
+
+	const float MaxComponent = Value.GetMax();
+	int32 SharedExponent = FloorLog2(FMath::Max(MaxComponent, 1.0f / 65536.0f)) + 16;
+	float Scale = FMath::Exp2(static_cast<float>(SharedExponent - 24));
+
+	if (FMath::FloorToFloat(MaxComponent / Scale + 0.5f) >= 512.0f)
+	{
+		Scale *= 2.0f;
+		SharedExponent++;
+	}
+
+	const uint32 X = FMath::Min(static_cast<uint32>(FMath::FloorToFloat(Value.X / Scale + 0.5f)), 511u);
+	const uint32 Y = FMath::Min(static_cast<uint32>(FMath::FloorToFloat(Value.Y / Scale + 0.5f)), 511u);
+	const uint32 Z = FMath::Min(static_cast<uint32>(FMath::FloorToFloat(Value.Z / Scale + 0.5f)), 511u);
+	return X | (Y << 9) | (Z << 18) | (static_cast<uint32>(SharedExponent) << 27);
+}
+
+static FVector3f DecodeRGB9E5(uint32 Packed)
+{
+	const float Scale = FMath::Exp2(static_cast<float>(static_cast<int32>(Packed >> 27) - 24));
+	return FVector3f(Packed & 0x1FF, (Packed >> 9) & 0x1FF, (Packed >> 18) & 0x1FF) * Scale;
+}
+
+static uint32 EncodeRGBE8(FVector3f Value)
+{
+	const float MaxValue = 1e30f;
+	Value = FVector3f(FMath::Clamp(Value.X, 0.0f, MaxValue), FMath::Clamp(Value.Y, 0.0f, MaxValue), FMath::Clamp(Value.Z, 0.0f, MaxValue));
+
+	const float MaxComponent = Value.GetMax();
+	if (MaxComponent < 1e-30f)
+	{
+		return 0;
+	}
+
+	const int32 Exponent = FloorLog2(MaxComponent) + 1;
+	const float Scale = FMath::Exp2(static_cast<float>(8 - Exponent));
+
+	const uint32 X = FMath::Min(static_cast<uint32>(FMath::FloorToFloat(Value.X * Scale)), 255u);
+	const uint32 Y = FMath::Min(static_cast<uint32>(FMath::FloorToFloat(Value.Y * Scale)), 255u);
+	const uint32 Z = FMath::Min(static_cast<uint32>(FMath::FloorToFloat(Value.Z * Scale)), 255u);
+	return X | (Y << 8) | (Z << 16) | (static_cast<uint32>(Exponent + 127) << 24);
+}
+
+static FVector3f DecodeRGBE8(uint32 Packed)
+{
+	const uint32 BiasedExponent = Packed >> 24;
+	if (BiasedExponent == 0)
+	{
+		return FVector3f::ZeroVector;
+	}
+
+	const float Scale = FMath::Exp2(static_cast<float>(static_cast<int32>(BiasedExponent) - 127 - 8));
+	return (FVector3f(Packed & 0xFF, (Packed >> 8) & 0xFF, (Packed >> 16) & 0xFF) + 0.5f) * Scale;
+}
+
+void HVPT::Private::EncodeGridData(uint32 Format, const FVector3f& Value, uint32 Packed[2])
+{
+	Packed[0] = 0;
+	Packed[1] = 0;
+
+	switch (Format)
+	{
+	case HVPT_GRID_DATA_FORMAT_FLOAT16:
+		Packed[0] = FFloat16(Value.X).Encoded | (FFloat16(Value.Y).Encoded << 16);
+		Packed[1] = FFloat16(Value.Z).Encoded;
+		break;
+	case HVPT_GRID_DATA_FORMAT_RGB9E5:
+		Packed[0] = EncodeRGB9E5(Value);
+		break;
+	case HVPT_GRID_DATA_FORMAT_RGBE8:
+		Packed[0] = EncodeRGBE8(Value);
+		break;
+	case HVPT_GRID_DATA_FORMAT_MONOCHROME16:
+		Packed[0] = FFloat16(FMath::Max(Value.GetMax(), 0.0f)).Encoded;
+		break;
+	default:
+		checkNoEntry();
+		break;
+	}
+}
+
+FVector3f HVPT::Private::DecodeGridData(uint32 Format, const uint32 Packed[2])
+{
+	switch (Format)
+	{
+	case HVPT_GRID_DATA_FORMAT_FLOAT16:
+	{
+		FFloat16 X, Y, Z;
+		X.Encoded = static_cast<uint16>(Packed[0]);
+		Y.Encoded = static_cast<uint16>(Packed[0] >> 16);
+		Z.Encoded = static_cast<uint16>(Packed[1]);
+		return FVector3f(X.GetFloat(), Y.GetFloat(), Z.GetFloat());
+	}
+	case HVPT_GRID_DATA_FORMAT_RGB9E5:
+		return DecodeRGB9E5(Packed[0]);
+	case HVPT_GRID_DATA_FORMAT_RGBE8:
+		return DecodeRGBE8(Packed[0]);
+	case HVPT_GRID_DATA_FORMAT_MONOCHROME16:
+	{
+		FFloat16 Value;
+		Value.Encoded = static_cast<uint16>(Packed[0]);
+		return FVector3f(Value.GetFloat());
+	}
+	default:
+		checkNoEntry();
+		return FVector3f::ZeroVector;
+	}
+}
+
+float HVPT::Private::GetGridDataMaxRelativeError(uint32 Format)
+{
+	switch (Format)
+	{
+	case HVPT_GRID_DATA_FORMAT_FLOAT16:
+	case HVPT_GRID_DATA_FORMAT_MONOCHROME16:
+		return 1.0f / 2048.0f;	// Half of the 10 bit mantissa step
+	case HVPT_GRID_DATA_FORMAT_RGB9E5:
+		return 1.0f / 512.0f;	// Largest component has a mantissa of at least 256, rounded to nearest
+	case HVPT_GRID_DATA_FORMAT_RGBE8:
+		return 1.0f / 256.0f;	// Largest component has a mantissa of at least 128, reconstructed at the interval centre
+	default:
+		checkNoEntry();
+		return 0.0f;
+	}
+}
+
+float HVPT::Private::GetGridDataMaxValue(uint32 Format)
+{
+	switch (Format)
+	{
+	case HVPT_GRID_DATA_FORMAT_FLOAT16:
+	case HVPT_GRID_DATA_FORMAT_MONOCHROME16:
+		return 65504.0f;
+	case HVPT_GRID_DATA_FORMAT_RGB9E5:
+		return 65408.0f;
+	case HVPT_GRID_DATA_FORMAT_RGBE8:
+		return 1e30f;
+	default:
+		checkNoEntry();
+		return 0.0f;
+	}
+}
+
+bool HVPT::Private::ValidateGridDataRoundTrip(uint32 Format, const FVector3f& Value)
+{
+	uint32 Packed[2];
+	EncodeGridData(Format, Value, Packed);
+	const FVector3f Decoded = DecodeGridData(Format, Packed);
+
+	// Shared exponent formats lose precision on small components relative to the largest one.
+	// The smallest representable step of each format is allowed on top, for values that are close to zero
+	const bool bHalfFloat = Format == HVPT_GRID_DATA_FORMAT_FLOAT16 || Format == HVPT_GRID_DATA_FORMAT_MONOCHROME16;
+	const float SmallestStep = bHalfFloat ? FMath::Exp2(-14.0f) : FMath::Exp2(-24.0f);
+	const float MaxError = Value.GetAbsMax() * GetGridDataMaxRelativeError(Format) + SmallestStep;
+
+	const FVector3f Error = (Decoded - Value).GetAbs();
+	return Error.GetMax() <= MaxError;
+}
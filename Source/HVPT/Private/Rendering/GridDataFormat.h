@@ -0,0 +1,37 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HVPTDefinitions.h"
+
+
+namespace HVPT::Private
+{
+
+// Bottom-level voxel channel formats
+// The format of every channel is packed into a single uint, 4 bits per channel, as expected by GetGridDataFormat in VoxelGridBuildUtils.ush
+// Extinction is stored in HVPT_GRID_DATA_FORMAT_MONOCHROME16 if bMonochromeExtinction is set, ignoring r.HVPT.GridDataFormat.Extinction
+uint32 GetGridDataFormats(bool bMonochromeExtinction);
+uint32 GetGridDataFormat(uint32 GridDataFormats, int32 Channel);
+bool HasMonochromeExtinction(uint32 GridDataFormats);
+
+int32 CalcGridDataBytesPerVoxel(uint32 Format);
+int32 CalcGridDataBytesPerVoxelForAllChannels(uint32 GridDataFormats);
+
+// Number of FHVPT_GridData elements required to hold VoxelCount voxels. Formats smaller than 8 bytes pack several voxels into each element
+int32 CalcGridDataBufferSize(uint32 Format, int32 VoxelCount);
+
+// CPU reference for the encodings in VoxelGridBuildUtils.ush
+// Packed holds both uints of an FHVPT_GridData for HVPT_GRID_DATA_FORMAT_FLOAT16. Other formats only use Packed[0]
+// HVPT_GRID_DATA_FORMAT_MONOCHROME16 stores the largest component, and decodes to a grey value
+void EncodeGridData(uint32 Format, const FVector3f& Value, uint32 Packed[2]);
+FVector3f DecodeGridData(uint32 Format, const uint32 Packed[2]);
+
+// Largest error introduced by encoding, relative to the largest component of the value
+// Only holds for non-negative values within the range of the format
+float GetGridDataMaxRelativeError(uint32 Format);
+float GetGridDataMaxValue(uint32 Format);
+
+// Checks that every component of Value survives a round trip through Format within the error bound of the format
+bool ValidateGridDataRoundTrip(uint32 Format, const FVector3f& Value);
+
+}
@@ -13,6 +13,7 @@
 #include "PathTracing.h"
 #include "ScenePrivate.h"
 #include "RendererUtils.h"
+#include "RenderGraphUtils.h"
 #include "RayTracingShaderBindingLayout.h"
 #include "SceneCore.h"
 
@@ -34,8 +35,9 @@ public:
 
 	class FSurfaceContributions : SHADER_PERMUTATION_BOOL("USE_SURFACE_CONTRIBUTIONS");
 	class FApplyVolumetricFog : SHADER_PERMUTATION_BOOL("APPLY_VOLUMETRIC_FOG");
+	class FMonochromeExtinction : SHADER_PERMUTATION_BOOL("MONOCHROME_EXTINCTION");
 	class FDebugOutputEnabled : SHADER_PERMUTATION_BOOL("DEBUG_OUTPUT_ENABLED");
-	using FPermutationDomain = TShaderPermutationDomain<FSurfaceContributions, FApplyVolumetricFog, FDebugOutputEnabled>;
+	using FPermutationDomain = TShaderPermutationDomain<FSurfaceContributions, FApplyVolumetricFog, FMonochromeExtinction, FDebugOutputEnabled>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		// Scene data
@@ -77,6 +79,7 @@ public:
 		// Debug
 		SHADER_PARAMETER(uint32, DebugFlags)
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float3>, RWDebugTexture)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWCollisionStatsBuffer)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
@@ -106,6 +109,7 @@ void HVPT::PrepareRaytracingShaders(const FViewInfo& View, const FHVPTViewState&
 	FHVPT_RenderWithPathTracingRGS::FPermutationDomain PermutationVector;
 	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FSurfaceContributions>(HVPT::UseSurfaceContributions());
 	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FApplyVolumetricFog>(HVPT::GetFogCompositingMode() == EFogCompositionMode::PostAndPathTracing);
+	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FMonochromeExtinction>(HVPT::Private::ShouldUseMonochromeExtinction(View));
 	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FDebugOutputEnabled>(State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE);
 	auto RayGenShader = ShaderMap->GetShader<FHVPT_RenderWithPathTracingRGS>(PermutationVector);
 	OutRayGenShaders.Add(RayGenShader.GetRayTracingShader());
@@ -151,10 +155,18 @@ void HVPT::RenderWithPathTracing(
 
 	PassParameters->RWRadianceTexture = GraphBuilder.CreateUAV(State.RadianceTexture);
 
+	FRDGBufferRef CollisionStatsBuffer = nullptr;
 	if (State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE)
 	{
 		PassParameters->DebugFlags = State.DebugFlags;
 		PassParameters->RWDebugTexture = GraphBuilder.CreateUAV(State.DebugTexture);
+
+		CollisionStatsBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), HVPT_COLLISION_STATS_SIZE),
+			TEXT("HVPT.CollisionStats")
+		);
+		AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(CollisionStatsBuffer, PF_R32_UINT), 0);
+		PassParameters->RWCollisionStatsBuffer = GraphBuilder.CreateUAV(CollisionStatsBuffer, PF_R32_UINT);
 	}
 
 	FIntPoint DispatchSize = ViewInfo.ViewRect.Size();
@@ -162,6 +174,7 @@ void HVPT::RenderWithPathTracing(
 	FHVPT_RenderWithPathTracingRGS::FPermutationDomain PermutationVector;
 	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FSurfaceContributions>(HVPT::UseSurfaceContributions());
 	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FApplyVolumetricFog>(HVPT::GetFogCompositingMode() == EFogCompositionMode::PostAndPathTracing);
+	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FMonochromeExtinction>(HVPT::Private::ShouldUseMonochromeExtinction(ViewInfo));
 	PermutationVector.Set<FHVPT_RenderWithPathTracingRGS::FDebugOutputEnabled>(State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE);
 	TShaderMapRef<FHVPT_RenderWithPathTracingRGS> RayGenShader(ViewInfo.ShaderMap, PermutationVector);
 
@@ -198,6 +211,13 @@ void HVPT::RenderWithPathTracing(
 				DispatchSize.Y
 			);
 		});
+
+	// Only the collisions view mode writes the counters
+	if (CollisionStatsBuffer && (State.DebugFlags & 0xFF) == HVPT_DEBUG_VIEW_MODE_COLLISIONS)
+	{
+		HVPT::QueueCollisionStatsReadback(GraphBuilder, CollisionStatsBuffer, State.CollisionStatsReadback);
+	}
+	HVPT::UpdateCollisionStats(State.CollisionStatsReadback);
 }
 
 #endif
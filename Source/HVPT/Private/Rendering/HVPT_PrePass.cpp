@@ -6,6 +6,7 @@
 
 #include "HVPTViewState.h"
 #include "Helpers.h"
+#include "VoxelGrid.h"
 
 #include "HVPTDefinitions.h"
 
@@ -22,12 +23,14 @@ public:
 	class FStochasticGBufferWrites : SHADER_PERMUTATION_BOOL("STOCHASTIC_GBUFFER_WRITES");
 	class FWriteVelocity : SHADER_PERMUTATION_BOOL("WRITE_VELOCITY");
 	//class FDebugVisualizeVelocity : SHADER_PERMUTATION_BOOL("DEBUG_VISUALIZE_VELOCITY");
+	class FMonochromeExtinction : SHADER_PERMUTATION_BOOL("MONOCHROME_EXTINCTION");
 	class FDebugOutputEnabled : SHADER_PERMUTATION_BOOL("DEBUG_OUTPUT_ENABLED");
 	using FPermutationDomain = TShaderPermutationDomain<FWriteGBuffer,
 		FDensityGradientAsNormal,
 		FTransmittanceMode,
 		FStochasticGBufferWrites,
 		FWriteVelocity,
+		FMonochromeExtinction,
 		FDebugOutputEnabled>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
@@ -130,6 +133,7 @@ void HVPT::RenderPrePass(
 	Permutation.Set<FHVPT_PrePassPS::FTransmittanceMode>(HVPT::GetTransmittanceMode());
 	Permutation.Set<FHVPT_PrePassPS::FStochasticGBufferWrites>(HVPT::GetStochasticGBufferWrites());
 	Permutation.Set<FHVPT_PrePassPS::FWriteVelocity>(HVPT::ShouldWriteVelocity());
+	Permutation.Set<FHVPT_PrePassPS::FMonochromeExtinction>(HVPT::Private::ShouldUseMonochromeExtinction(ViewInfo));
 	Permutation.Set<FHVPT_PrePassPS::FDebugOutputEnabled>(State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE);
 
 	FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(ViewInfo.FeatureLevel);
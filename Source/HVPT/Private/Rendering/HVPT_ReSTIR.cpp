@@ -14,6 +14,7 @@
 
 #include "RayTracingShaderBindingLayout.h"
 #include "Helpers.h"
+#include "VoxelGrid.h"
 
 // Max bounces supported by ReSTIR pipeline
 constexpr uint32 kReSTIRMaxBounces = 8;
@@ -27,6 +28,15 @@ static TAutoConsoleVariable<bool> CVarHVPTReSTIRUseDispatchIndirect(
 	ECVF_RenderThreadSafe
 );
 
+static TAutoConsoleVariable<bool> CVarHVPTReSTIRAdaptiveCandidates(
+	TEXT("r.HVPT.ReSTIR.AdaptiveCandidates"),
+	false,
+	TEXT("Varies the number of initial candidates per reservoir between a quarter and all of r.HVPT.ReSTIR.NumInitialCandidates, ")
+	TEXT("based on prepass transmittance and the temporal variance of each reservoir's shaded luminance, reprojected with the motion vectors used by temporal reuse. ")
+	TEXT("Requires r.HVPT.ReSTIR.UseDispatchIndirect."),
+	ECVF_RenderThreadSafe
+);
+
 static TAutoConsoleVariable<bool> CVarHVPTReSTIRDeferEvaluateCandidateF(
 	TEXT("r.HVPT.ReSTIR.DeferEvaluateCandidateF"),
 	true,
@@ -86,6 +96,21 @@ static TAutoConsoleVariable<bool> CVarHVPTReSTIRMultiPassSpatialReuse16BitBuffer
 	ECVF_RenderThreadSafe
 );
 
+static TAutoConsoleVariable<bool> CVarHVPTReSTIRCompactReservoirs(
+	TEXT("r.HVPT.ReSTIR.CompactReservoirs"),
+	true,
+	TEXT("Stores reservoirs in 20 bytes instead of 28, with reduced precision weights and light samples. See FHVPT_CompactReservoir."),
+	ECVF_RenderThreadSafe
+);
+
+static TAutoConsoleVariable<int32> CVarHVPTReSTIRReservoirDownscale(
+	TEXT("r.HVPT.ReSTIR.ReservoirDownscale"),
+	1,
+	TEXT("Stores one reservoir per NxN block of pixels (1 - 4). Candidate generation, temporal reuse and spatial reuse run at the reduced resolution,")
+	TEXT("and final shading upsamples the reservoirs guided by depth and transmittance. The spatial reuse radius is measured in reservoirs."),
+	ECVF_RenderThreadSafe
+);
+
 static TAutoConsoleVariable<float> CVarHVPTReSTIRMaxPathIntensity(
 	TEXT("r.HVPT.ReSTIR.MaxPathIntensity"),
 	10.0f,
@@ -99,6 +124,27 @@ static bool DeferSurfaceHits()
 	return (HVPT::GetMaxBounces() > 1) && HVPT::UseSurfaceContributions() && CVarHVPTReSTIRDeferSurfaceBounces.GetValueOnRenderThread();
 }
 
+static bool UseCompactReservoirs()
+{
+	return CVarHVPTReSTIRCompactReservoirs.GetValueOnRenderThread();
+}
+
+static bool UseAdaptiveCandidates()
+{
+	return CVarHVPTReSTIRAdaptiveCandidates.GetValueOnRenderThread() && CVarHVPTReSTIRUseDispatchIndirect.GetValueOnRenderThread();
+}
+
+// Number of initial candidates generated by reservoirs in the bucket, see HVPT_CANDIDATE_BUCKET_COUNT
+static uint32 GetNumCandidatesForBucket(uint32 NumCandidates, uint32 Bucket)
+{
+	return FMath::Max(NumCandidates >> (HVPT_CANDIDATE_BUCKET_COUNT - 1 - Bucket), 1u);
+}
+
+static int32 GetReservoirDownscale()
+{
+	return FMath::Clamp(CVarHVPTReSTIRReservoirDownscale.GetValueOnRenderThread(), 1, 4);
+}
+
 
 #if RHI_RAYTRACING
 
@@ -114,6 +160,13 @@ BEGIN_SHADER_PARAMETER_STRUCT(FPathTracingLightParameters, )
 END_SHADER_PARAMETER_STRUCT()
 
 
+// Size of the reservoir grid, which may be a fraction of the view resolution
+BEGIN_SHADER_PARAMETER_STRUCT(FReSTIRReservoirLayoutParameters, )
+	SHADER_PARAMETER(uint32, ReservoirDownscale)
+	SHADER_PARAMETER(FUintVector2, ReservoirResolution)
+END_SHADER_PARAMETER_STRUCT()
+
+
 BEGIN_SHADER_PARAMETER_STRUCT(FReSTIRCommonParameters, )
 	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
 	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSceneUniformParameters, Scene)
@@ -130,6 +183,8 @@ BEGIN_SHADER_PARAMETER_STRUCT(FReSTIRCommonParameters, )
 
 	SHADER_PARAMETER(uint32, NumBounces)
 
+	SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRReservoirLayoutParameters, ReservoirLayout)
+
 	// For indirect dispatch
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, ReservoirIndices)
 	RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
@@ -146,12 +201,25 @@ public:
 	DECLARE_GLOBAL_SHADER(FReSTIRDispatchRaysDispatcherCS);
 	SHADER_USE_PARAMETER_STRUCT(FReSTIRDispatchRaysDispatcherCS, FGlobalShader);
 
+	class FAdaptiveCandidates : SHADER_PERMUTATION_BOOL("ADAPTIVE_CANDIDATES");
+	using FPermutationDomain = TShaderPermutationDomain<FAdaptiveCandidates>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRReservoirLayoutParameters, ReservoirLayout)
 		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<float2>, FeatureTexture)
 
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWAllocatorBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWReservoirIndices)
+
+		// For adaptive candidate counts
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSceneTextureParameters, SceneTextures)
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<float2>, TemporalFeatureTexture)
+		SHADER_PARAMETER(uint32, bEnableTemporalReprojection)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FVector3f>, PreviousLuminanceMoments)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FVector3f>, RWLuminanceMoments)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWCandidateBucketAllocatorBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWCandidateBucketReservoirIndices)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
@@ -173,6 +241,38 @@ public:
 IMPLEMENT_GLOBAL_SHADER(FReSTIRDispatchRaysDispatcherCS, "/Plugin/HVPT/Private/ReSTIR/Dispatcher.usf", "ReSTIRDispatchRaysDispatcherCS", SF_Compute)
 
 
+class FReSTIRUpdateLuminanceMomentsCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FReSTIRUpdateLuminanceMomentsCS);
+	SHADER_USE_PARAMETER_STRUCT(FReSTIRUpdateLuminanceMomentsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRReservoirLayoutParameters, ReservoirLayout)
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<float3>, RadianceTexture)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FVector3f>, RWLuminanceMoments)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_2D"), GetThreadGroupSize2D());
+	}
+
+	static uint32 GetThreadGroupSize2D() { return 8; }
+	static uint32 GetThreadGroupSize1D() { return GetThreadGroupSize2D() * GetThreadGroupSize2D(); }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FReSTIRUpdateLuminanceMomentsCS, "/Plugin/HVPT/Private/ReSTIR/Dispatcher.usf", "ReSTIRUpdateLuminanceMomentsCS", SF_Compute)
+
+
 class FReSTIRBaseRGS : public FGlobalShader
 {
 public:
@@ -182,13 +282,17 @@ public:
 	//class FApplyVolumetricFog : SHADER_PERMUTATION_BOOL("APPLY_VOLUMETRIC_FOG");
 	class FUseSER : SHADER_PERMUTATION_BOOL("USE_SER");
 	class FUseDispatchIndirect : SHADER_PERMUTATION_BOOL("USE_DISPATCH_INDIRECT");
+	class FMonochromeExtinction : SHADER_PERMUTATION_BOOL("MONOCHROME_EXTINCTION");
 	class FDebugOutputEnabled : SHADER_PERMUTATION_BOOL("DEBUG_OUTPUT_ENABLED");
+	class FCompactReservoirs : SHADER_PERMUTATION_BOOL("COMPACT_RESERVOIRS");
 	using FPermutationDomain = TShaderPermutationDomain<FMultipleBounces,
 														FUseSurfaceContributions,
 														//FApplyVolumetricFog,
 														FUseSER,
 														FUseDispatchIndirect,
-														FDebugOutputEnabled>;
+														FMonochromeExtinction,
+														FDebugOutputEnabled,
+														FCompactReservoirs>;
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
@@ -230,7 +334,9 @@ public:
 														FReSTIRBaseRGS::FUseSurfaceContributions,
 														FReSTIRBaseRGS::FUseSER,
 														FReSTIRBaseRGS::FUseDispatchIndirect,
+														FReSTIRBaseRGS::FMonochromeExtinction,
 														FReSTIRBaseRGS::FDebugOutputEnabled,
+														FReSTIRBaseRGS::FCompactReservoirs,
 														FDeferEvaluateF,
 														FDeferSurfaceHits,
 														FDeferSurfaceBouncesUseIndirection>;
@@ -254,6 +360,9 @@ public:
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_DeferredSurfaceBounce>, RWDeferredSurfaceBounces)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_Bounce>, RWDeferredSurfaceExtraBounces)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWDeferredSurfaceBouncesIndirection)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWDeferredSurfaceBouncesSortKeys)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWDeferredSurfaceBounceListHeads)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<uint>, RWDeferredSurfaceBounceListLinks)
 	END_SHADER_PARAMETER_STRUCT()
 };
 
@@ -269,19 +378,22 @@ public:
 	class FDeferSurfaceBouncesUseIndirection : SHADER_PERMUTATION_BOOL("SURFACE_BOUNCE_USE_INDIRECTION");
 	using FPermutationDomain = TShaderPermutationDomain<FDeferSurfaceBouncesUseIndirection,
 														FReSTIRBaseRGS::FUseSER,
-														FReSTIRBaseRGS::FDebugOutputEnabled>;
+														FReSTIRBaseRGS::FMonochromeExtinction,
+														FReSTIRBaseRGS::FDebugOutputEnabled,
+														FReSTIRBaseRGS::FCompactReservoirs>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRCommonParameters, Common)
 
 		SHADER_PARAMETER(uint32, bUseShadowTermForCandidateGeneration)
 
+		SHADER_PARAMETER(uint32, SurfaceBounceAllocatorSize)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, DeferredSurfaceBounceAllocator)
 		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_DeferredSurfaceBounce>, DeferredSurfaceBounces)
-		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_Bounce>, DeferredSurfaceExtraBounces)
 		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, DeferredSurfaceBouncesIndirection)
 
-		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_Reservoir>, RWCurrentReservoirs)
-		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_Bounce>, RWExtraBounces)
+		// Output
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_Reservoir>, RWDeferredSurfaceBounceResults)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
@@ -295,6 +407,68 @@ public:
 
 IMPLEMENT_GLOBAL_SHADER(FReSTIRCandidateEvaluateSurfaceBouncesRGS, "/Plugin/HVPT/Private/ReSTIR/CandidateGeneration.usf", "ReSTIRCandidateEvaluateSurfaceBouncesRGS", SF_RayGen)
 
+class FReSTIRDeferredSurfaceBouncesArgsCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FReSTIRDeferredSurfaceBouncesArgsCS);
+	SHADER_USE_PARAMETER_STRUCT(FReSTIRDeferredSurfaceBouncesArgsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(uint32, SurfaceBounceAllocatorSize)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, DeferredSurfaceBounceAllocator)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWDeferredSurfaceBouncesIndirectArgs)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+};
+
+IMPLEMENT_GLOBAL_SHADER(FReSTIRDeferredSurfaceBouncesArgsCS, "/Plugin/HVPT/Private/ReSTIR/DeferredSurfaceBounces.usf", "ReSTIRDeferredSurfaceBouncesArgsCS", SF_Compute)
+
+class FReSTIRDeferredSurfaceBouncesResolveCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FReSTIRDeferredSurfaceBouncesResolveCS);
+	SHADER_USE_PARAMETER_STRUCT(FReSTIRDeferredSurfaceBouncesResolveCS, FGlobalShader);
+
+	class FCompactReservoirs : SHADER_PERMUTATION_BOOL("COMPACT_RESERVOIRS");
+	using FPermutationDomain = TShaderPermutationDomain<FCompactReservoirs>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRReservoirLayoutParameters, ReservoirLayout)
+
+		SHADER_PARAMETER(uint32, TemporalSeed)
+		SHADER_PARAMETER(uint32, NumBounces)
+
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_Reservoir>, DeferredSurfaceBounceResults)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, DeferredSurfaceBounceListHeads)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<uint>, DeferredSurfaceBounceListLinks)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_Bounce>, DeferredSurfaceExtraBounces)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_Reservoir>, RWCurrentReservoirs)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_Bounce>, RWExtraBounces)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_2D"), GetThreadGroupSize2D());
+		OutEnvironment.SetDefine(TEXT("MULTIPLE_BOUNCES"), true);
+	}
+
+	static uint32 GetThreadGroupSize2D() { return 8; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FReSTIRDeferredSurfaceBouncesResolveCS, "/Plugin/HVPT/Private/ReSTIR/DeferredSurfaceBounces.usf", "ReSTIRDeferredSurfaceBouncesResolveCS", SF_Compute)
+
 class FReSTIRCandidateEvaluateFRGS : public FReSTIRBaseRGS
 {
 public:
@@ -384,10 +558,12 @@ public:
 
 	class FUse16BitResultBuffer : SHADER_PERMUTATION_BOOL("USE_16_BIT_RESULT_BUFFER");
 	class FDebugOutputEnabled : SHADER_PERMUTATION_BOOL("DEBUG_OUTPUT_ENABLED");
-	using FPermutationDomain = TShaderPermutationDomain<FUse16BitResultBuffer, FDebugOutputEnabled>;
+	class FCompactReservoirs : SHADER_PERMUTATION_BOOL("COMPACT_RESERVOIRS");
+	using FPermutationDomain = TShaderPermutationDomain<FUse16BitResultBuffer, FDebugOutputEnabled, FCompactReservoirs>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRReservoirLayoutParameters, ReservoirLayout)
 		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRMultiPassSpatialReuseCommonParameters, SpatialReuseCommon)
 
 		SHADER_PARAMETER(uint32, TemporalSeed)
@@ -445,7 +621,9 @@ public:
 														FReSTIRBaseRGS::FUseSurfaceContributions,
 														FReSTIRBaseRGS::FUseSER,
 														FReSTIRBaseRGS::FUseDispatchIndirect,
+														FReSTIRBaseRGS::FMonochromeExtinction,
 														FReSTIRBaseRGS::FDebugOutputEnabled,
+														FReSTIRBaseRGS::FCompactReservoirs,
 														FUse16BitResultBuffer>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
@@ -480,10 +658,12 @@ public:
 	class FMultipleBounces : SHADER_PERMUTATION_BOOL("MULTIPLE_BOUNCES");
 	class FUse16BitResultBuffer: SHADER_PERMUTATION_BOOL("USE_16_BIT_RESULT_BUFFER");
 	class FDebugOutputEnabled : SHADER_PERMUTATION_BOOL("DEBUG_OUTPUT_ENABLED");
-	using FPermutationDomain = TShaderPermutationDomain<FMultipleBounces, FUse16BitResultBuffer, FDebugOutputEnabled>;
+	class FCompactReservoirs : SHADER_PERMUTATION_BOOL("COMPACT_RESERVOIRS");
+	using FPermutationDomain = TShaderPermutationDomain<FMultipleBounces, FUse16BitResultBuffer, FDebugOutputEnabled, FCompactReservoirs>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRReservoirLayoutParameters, ReservoirLayout)
 		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRMultiPassSpatialReuseCommonParameters, SpatialReuseCommon)
 
 		SHADER_PARAMETER(uint32, TemporalSeed)
@@ -537,6 +717,17 @@ public:
 	DECLARE_GLOBAL_SHADER(FReSTIRFinalShadingRGS);
 	SHADER_USE_ROOT_PARAMETER_STRUCT(FReSTIRFinalShadingRGS, FReSTIRBaseRGS);
 
+	// Shades every pixel from the reservoirs around it, when reservoirs are stored at a reduced resolution
+	class FReservoirUpsample : SHADER_PERMUTATION_BOOL("RESERVOIR_UPSAMPLE");
+	using FPermutationDomain = TShaderPermutationDomain<FReSTIRBaseRGS::FMultipleBounces,
+														FReSTIRBaseRGS::FUseSurfaceContributions,
+														FReSTIRBaseRGS::FUseSER,
+														FReSTIRBaseRGS::FUseDispatchIndirect,
+														FReSTIRBaseRGS::FMonochromeExtinction,
+														FReSTIRBaseRGS::FDebugOutputEnabled,
+														FReSTIRBaseRGS::FCompactReservoirs,
+														FReservoirUpsample>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRCommonParameters, Common)
 
@@ -546,10 +737,24 @@ public:
 		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_Reservoir>, CurrentReservoirs)
 		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_Bounce>, ExtraBounces)
 
+		// Guides the upsample
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<float2>, FeatureTexture)
+
 		// Output
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float3>, RWRadianceTexture)
 
 	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain Permutation(Parameters.PermutationId);
+		// Upsampling shades every pixel, so is always dispatched directly
+		if (Permutation.Get<FReservoirUpsample>() && Permutation.Get<FReSTIRBaseRGS::FUseDispatchIndirect>())
+		{
+			return false;
+		}
+		return FReSTIRBaseRGS::ShouldCompilePermutation(Parameters);
+	}
 };
 
 IMPLEMENT_GLOBAL_SHADER(FReSTIRFinalShadingRGS, "/Plugin/HVPT/Private/ReSTIR/FinalShading.usf", "ReSTIRFinalShadingRGS", SF_RayGen)
@@ -561,6 +766,9 @@ public:
 	DECLARE_GLOBAL_SHADER(FReSTIRDebugVisualizationCS);
 	SHADER_USE_PARAMETER_STRUCT(FReSTIRDebugVisualizationCS, FGlobalShader)
 
+	class FCompactReservoirs : SHADER_PERMUTATION_BOOL("COMPACT_RESERVOIRS");
+	using FPermutationDomain = TShaderPermutationDomain<FCompactReservoirs>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_STRUCT_INCLUDE(FReSTIRCommonParameters, Common)
 
@@ -586,7 +794,7 @@ IMPLEMENT_GLOBAL_SHADER(FReSTIRDebugVisualizationCS, "/Plugin/HVPT/Private/ReSTI
 
 
 template<typename Shader>
-typename Shader::FPermutationDomain CreatePermutation(const FHVPTViewState& State)
+typename Shader::FPermutationDomain CreatePermutation(const FViewInfo& View, const FHVPTViewState& State)
 {
 	typename Shader::FPermutationDomain Permutation = typename Shader::FPermutationDomain{};
 	Permutation.Set<typename Shader::FMultipleBounces>(HVPT::GetMaxBounces() > 1);
@@ -594,7 +802,20 @@ typename Shader::FPermutationDomain CreatePermutation(const FHVPTViewState& Stat
 	//Permutation.Set<typename Shader::FApplyVolumetricFog>(HVPT::GetFogCompositingMode() == HVPT::EFogCompositionMode::PostAndPathTracing);
 	Permutation.Set<typename Shader::FUseSER>(HVPT::ShouldUseSER());
 	Permutation.Set<typename Shader::FUseDispatchIndirect>(CVarHVPTReSTIRUseDispatchIndirect.GetValueOnRenderThread());
+	Permutation.Set<typename Shader::FMonochromeExtinction>(HVPT::Private::ShouldUseMonochromeExtinction(View));
 	Permutation.Set<typename Shader::FDebugOutputEnabled>(State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE);
+	Permutation.Set<typename Shader::FCompactReservoirs>(UseCompactReservoirs());
+	return Permutation;
+}
+
+static FReSTIRFinalShadingRGS::FPermutationDomain CreateFinalShadingPermutation(const FViewInfo& View, const FHVPTViewState& State)
+{
+	FReSTIRFinalShadingRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRFinalShadingRGS>(View, State);
+	if (GetReservoirDownscale() > 1)
+	{
+		Permutation.Set<FReSTIRFinalShadingRGS::FReservoirUpsample>(true);
+		Permutation.Set<FReSTIRFinalShadingRGS::FUseDispatchIndirect>(false);
+	}
 	return Permutation;
 }
 
@@ -609,7 +830,7 @@ void HVPT::PrepareRaytracingShadersReSTIR(const FViewInfo& View, const FHVPTView
 
 	// AddShader<T>() does not compile
 	{
-		FReSTIRCandidateGenerationRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRCandidateGenerationRGS>(State);
+		FReSTIRCandidateGenerationRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRCandidateGenerationRGS>(View, State);
 		Permutation.Set<FReSTIRCandidateGenerationRGS::FDeferEvaluateF>(CVarHVPTReSTIRDeferEvaluateCandidateF.GetValueOnRenderThread());
 		Permutation.Set<FReSTIRCandidateGenerationRGS::FDeferSurfaceHits>(DeferSurfaceHits());
 		Permutation.Set<FReSTIRCandidateGenerationRGS::FDeferSurfaceBouncesUseIndirection>(DeferSurfaceHits() && CVarHVPTReSTIRDeferSurfaceBouncesSorting.GetValueOnRenderThread());
@@ -620,21 +841,23 @@ void HVPT::PrepareRaytracingShadersReSTIR(const FViewInfo& View, const FHVPTView
 		FReSTIRCandidateEvaluateSurfaceBouncesRGS::FPermutationDomain Permutation;
 		Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FDeferSurfaceBouncesUseIndirection>(CVarHVPTReSTIRDeferSurfaceBouncesSorting.GetValueOnRenderThread());
 		Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FUseSER>(HVPT::ShouldUseSER());
+		Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FMonochromeExtinction>(HVPT::Private::ShouldUseMonochromeExtinction(View));
 		Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FDebugOutputEnabled>(State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE);
+		Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FCompactReservoirs>(UseCompactReservoirs());
 		OutRayGenShaders.Add(ShaderMap->GetShader<FReSTIRCandidateEvaluateSurfaceBouncesRGS>(Permutation).GetRayTracingShader());
 	}
 	if (CVarHVPTReSTIRDeferEvaluateCandidateF.GetValueOnRenderThread())
-		AddShader.template operator()<FReSTIRCandidateEvaluateFRGS>(CreatePermutation<FReSTIRCandidateEvaluateFRGS>(State));
-	AddShader.template operator()<FReSTIRTemporalReuseRGS>(CreatePermutation<FReSTIRTemporalReuseRGS>(State));
+		AddShader.template operator()<FReSTIRCandidateEvaluateFRGS>(CreatePermutation<FReSTIRCandidateEvaluateFRGS>(View, State));
+	AddShader.template operator()<FReSTIRTemporalReuseRGS>(CreatePermutation<FReSTIRTemporalReuseRGS>(View, State));
 	if (HVPT::GetMultiPassSpatialReuseEnabled())
 	{
-		FReSTIRSpatialReuse_EvaluateRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRSpatialReuse_EvaluateRGS>(State);
+		FReSTIRSpatialReuse_EvaluateRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRSpatialReuse_EvaluateRGS>(View, State);
 		Permutation.Set<FReSTIRSpatialReuse_EvaluateRGS::FUse16BitResultBuffer>(CVarHVPTReSTIRMultiPassSpatialReuse16BitBuffer.GetValueOnRenderThread());
 		AddShader.template operator()<FReSTIRSpatialReuse_EvaluateRGS>(Permutation);
 	}
 	else
-		AddShader.template operator()<FReSTIRSpatialReuseRGS>(CreatePermutation<FReSTIRSpatialReuseRGS>(State));
-	AddShader.template operator()<FReSTIRFinalShadingRGS>(CreatePermutation<FReSTIRFinalShadingRGS>(State));
+		AddShader.template operator()<FReSTIRSpatialReuseRGS>(CreatePermutation<FReSTIRSpatialReuseRGS>(View, State));
+	AddShader.template operator()<FReSTIRFinalShadingRGS>(CreateFinalShadingPermutation(View, State));
 }
 
 
@@ -645,12 +868,13 @@ void AddRaytracingPass(
 	const FViewInfo& View,
 	const FHVPTViewState& State,
 	typename Shader::FParameters* PassParameters,
+	FIntPoint DispatchSize,
 	FRDGBufferRef ArgumentBuffer,
 	uint32 ArgumentOffset = 0
 )
 {
-	typename Shader::FPermutationDomain Permutation = CreatePermutation<Shader>(State);
-	AddRaytracingPass<Shader>(GraphBuilder, std::move(EventName), View, State, PassParameters, Permutation, ArgumentBuffer, ArgumentOffset);
+	typename Shader::FPermutationDomain Permutation = CreatePermutation<Shader>(View, State);
+	AddRaytracingPass<Shader>(GraphBuilder, std::move(EventName), View, State, PassParameters, Permutation, DispatchSize, ArgumentBuffer, ArgumentOffset);
 }
 
 template <typename Shader>
@@ -661,6 +885,7 @@ void AddRaytracingPass(
 	const FHVPTViewState& State,
 	typename Shader::FParameters* PassParameters,
 	typename Shader::FPermutationDomain& Permutation,
+	FIntPoint DispatchSize,
 	FRDGBufferRef ArgumentBuffer,
 	uint32 ArgumentOffset = 0
 )
@@ -674,7 +899,7 @@ void AddRaytracingPass(
 		std::move(EventName),
 		PassParameters,
 		ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
-		[PassParameters, SceneUniformBuffer, RayGenShader, ArgumentBuffer, ArgumentOffset, bDispatchIndirect, &ViewInfo](FRHICommandList& RHICmdList)
+		[PassParameters, SceneUniformBuffer, RayGenShader, DispatchSize, ArgumentBuffer, ArgumentOffset, bDispatchIndirect, &ViewInfo](FRHICommandList& RHICmdList)
 		{
 			if (ArgumentBuffer)
 				ArgumentBuffer->MarkResourceAsUsed();
@@ -709,7 +934,6 @@ void AddRaytracingPass(
 			}
 			else
 			{
-				auto DispatchSize = ViewInfo.ViewRect.Size();
 				RHICmdList.RayTraceDispatch(
 #if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 6
 					ViewInfo.MaterialRayTracingData.PipelineState,
@@ -738,12 +962,20 @@ void HVPT::RenderWithReSTIRPathTracing(
 	RDG_EVENT_SCOPE(GraphBuilder, "HVPT: ReSTIR");
 
 	// Create resources
-	const auto& Extent = ViewInfo.ViewRect.Size();
-	const uint32 NumReservoirs = Extent.X * Extent.Y;
+	const FIntPoint ViewExtent = ViewInfo.ViewRect.Size();
+	// Resampling passes run over the reservoir grid, while final shading always runs at view resolution
+	const int32 ReservoirDownscale = GetReservoirDownscale();
+	const FIntPoint ReservoirExtent = FIntPoint::DivideAndRoundUp(ViewExtent, ReservoirDownscale);
+	const uint32 NumReservoirs = ReservoirExtent.X * ReservoirExtent.Y;
+
+	FReSTIRReservoirLayoutParameters ReservoirLayout;
+	ReservoirLayout.ReservoirDownscale = ReservoirDownscale;
+	ReservoirLayout.ReservoirResolution = FUintVector2(ReservoirExtent.X, ReservoirExtent.Y);
 
 	bool bHasTemporalFeatureTexture = State.TemporalFeatureTexture != nullptr;
 
-	auto ReservoirDesc = FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_Reservoir), NumReservoirs);
+	// Switching format changes the stride, which also discards history in the old format
+	auto ReservoirDesc = FRDGBufferDesc::CreateStructuredDesc(UseCompactReservoirs() ? sizeof(FHVPT_CompactReservoir) : sizeof(FHVPT_Reservoir), NumReservoirs);
 	// When max bounces is 1 then extra bounce buffer is not needed - just creates buffer with 1 element
 	auto ExtraBounceDesc = FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_Bounce),
 		FMath::Max(NumReservoirs * static_cast<uint32>(HVPT::GetMaxBounces() - 1), 1u));
@@ -789,8 +1021,18 @@ void HVPT::RenderWithReSTIRPathTracing(
 	FHVPT_PathTracingFogParameters FogParameters = HVPT::Private::PrepareFogParameters(ViewInfo, Scene.ExponentialFogs[0]);
 
 	
+	if (CVarHVPTReSTIRAdaptiveCandidates.GetValueOnRenderThread() && !CVarHVPTReSTIRUseDispatchIndirect.GetValueOnRenderThread())
+	{
+		UE_LOG(LogHVPT, Error, TEXT("When using r.HVPT.ReSTIR.AdaptiveCandidates, you must also enable r.HVPT.ReSTIR.UseDispatchIndirect"));
+	}
+
 	FRDGBufferRef DispatchRaysIndirectArgumentBuffer = nullptr;
 	FRDGBufferRef ReservoirIndicesBuffer = nullptr;
+	// One list of reservoirs for each candidate count, see HVPT_CANDIDATE_BUCKET_COUNT
+	FRDGBufferRef CandidateBucketIndirectArgumentBuffer = nullptr;
+	FRDGBufferRef CandidateBucketReservoirIndicesBuffer = nullptr;
+	// Temporal luminance moments that choose each reservoir's bucket, carried forward by the dispatcher and updated after final shading
+	FRDGBufferRef LuminanceMomentsBuffer = nullptr;
 	if (CVarHVPTReSTIRUseDispatchIndirect.GetValueOnRenderThread())
 	{
 		RDG_EVENT_SCOPE(GraphBuilder, "HVPT: ReSTIR (Dispatcher)");
@@ -801,16 +1043,57 @@ void HVPT::RenderWithReSTIRPathTracing(
 			FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), NumReservoirs), TEXT("HVPT.ReSTIR.ReservoirIndices"));
 
 		AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(DispatchRaysIndirectArgumentBuffer), 0);
+
+		if (UseAdaptiveCandidates())
+		{
+			CandidateBucketIndirectArgumentBuffer = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(HVPT_CANDIDATE_BUCKET_COUNT), TEXT("HVPT.ReSTIR.CandidateBucketIndirectArgs"));
+			CandidateBucketReservoirIndicesBuffer = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), NumReservoirs * HVPT_CANDIDATE_BUCKET_COUNT), TEXT("HVPT.ReSTIR.CandidateBucketReservoirIndices"));
+
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(CandidateBucketIndirectArgumentBuffer), 0);
+
+			LuminanceMomentsBuffer = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateStructuredDesc(sizeof(FVector3f), NumReservoirs), TEXT("HVPT.ReSTIR.LuminanceMoments"));
+		}
+
 		// Execute dispatcher
 		{
 			FReSTIRDispatchRaysDispatcherCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRDispatchRaysDispatcherCS::FParameters>();
 			PassParameters->View = ViewInfo.ViewUniformBuffer;
+			PassParameters->ReservoirLayout = ReservoirLayout;
 			PassParameters->FeatureTexture = GraphBuilder.CreateSRV(State.FeatureTexture);
 			PassParameters->RWAllocatorBuffer = GraphBuilder.CreateUAV(DispatchRaysIndirectArgumentBuffer);
 			PassParameters->RWReservoirIndices = GraphBuilder.CreateUAV(ReservoirIndicesBuffer);
-			TShaderMapRef<FReSTIRDispatchRaysDispatcherCS> ComputeShader(ViewInfo.ShaderMap);
 
-			const auto GroupCount = FComputeShaderUtils::GetGroupCount(Extent, FReSTIRDispatchRaysDispatcherCS::GetThreadGroupSize2D());
+			if (UseAdaptiveCandidates())
+			{
+				// Without valid history every moment is cleared, which places every reservoir in the highest bucket until history builds up
+				FRDGBufferRef PreviousLuminanceMomentsBuffer = nullptr;
+				if (State.ReSTIRLuminanceMomentsCache.IsValid() && State.ReSTIRLuminanceMomentsCache->Desc == LuminanceMomentsBuffer->Desc)
+				{
+					PreviousLuminanceMomentsBuffer = GraphBuilder.RegisterExternalBuffer(State.ReSTIRLuminanceMomentsCache);
+				}
+				else
+				{
+					PreviousLuminanceMomentsBuffer = GraphBuilder.CreateBuffer(LuminanceMomentsBuffer->Desc, TEXT("HVPT.ReSTIR.PreviousLuminanceMoments"));
+					AddClearUAVFloatPass(GraphBuilder, GraphBuilder.CreateUAV(PreviousLuminanceMomentsBuffer), 0.0f);
+				}
+
+				PassParameters->SceneTextures = HVPT::Private::GetSceneTextureParameters(GraphBuilder, SceneTextures);
+				PassParameters->TemporalFeatureTexture = GraphBuilder.CreateSRV(bHasTemporalFeatureTexture ? State.TemporalFeatureTexture : GSystemTextures.GetBlackDummy(GraphBuilder));
+				PassParameters->bEnableTemporalReprojection = HVPT::GetTemporalReprojectionEnabled() && bHasTemporalFeatureTexture;
+				PassParameters->PreviousLuminanceMoments = GraphBuilder.CreateSRV(PreviousLuminanceMomentsBuffer);
+				PassParameters->RWLuminanceMoments = GraphBuilder.CreateUAV(LuminanceMomentsBuffer);
+				PassParameters->RWCandidateBucketAllocatorBuffer = GraphBuilder.CreateUAV(CandidateBucketIndirectArgumentBuffer);
+				PassParameters->RWCandidateBucketReservoirIndices = GraphBuilder.CreateUAV(CandidateBucketReservoirIndicesBuffer);
+			}
+
+			FReSTIRDispatchRaysDispatcherCS::FPermutationDomain Permutation;
+			Permutation.Set<FReSTIRDispatchRaysDispatcherCS::FAdaptiveCandidates>(UseAdaptiveCandidates());
+			TShaderMapRef<FReSTIRDispatchRaysDispatcherCS> ComputeShader(ViewInfo.ShaderMap, Permutation);
+
+			const auto GroupCount = FComputeShaderUtils::GetGroupCount(ReservoirExtent, FReSTIRDispatchRaysDispatcherCS::GetThreadGroupSize2D());
 			FComputeShaderUtils::AddPass(
 				GraphBuilder,
 				RDG_EVENT_NAME("ReSTIRDispatcher"),
@@ -824,6 +1107,8 @@ void HVPT::RenderWithReSTIRPathTracing(
 
 	uint32 MaxNumPasses = 4;
 	MaxNumPasses += CVarHVPTReSTIRDeferEvaluateCandidateF.GetValueOnRenderThread() ? 1 : 0;
+	MaxNumPasses += DeferSurfaceHits() ? 2 : 0;
+	MaxNumPasses += UseAdaptiveCandidates() ? HVPT_CANDIDATE_BUCKET_COUNT - 1 : 0;
 	MaxNumPasses += (State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE) ? 1 : 0;
 	MaxNumPasses += HVPT::GetMultiPassSpatialReuseEnabled() ? 24 : 0; // TODO: Actually calculate how many passes based off number of tiles
 	uint32 TemporalSeedOffset = 0;
@@ -845,6 +1130,8 @@ void HVPT::RenderWithReSTIRPathTracing(
 
 			Parameters->NumBounces = FMath::Clamp(HVPT::GetMaxBounces(), 1, kReSTIRMaxBounces);
 
+			Parameters->ReservoirLayout = ReservoirLayout;
+
 			if (CVarHVPTReSTIRUseDispatchIndirect.GetValueOnRenderThread())
 			{
 				Parameters->ReservoirIndices = GraphBuilder.CreateSRV(ReservoirIndicesBuffer);
@@ -866,18 +1153,8 @@ void HVPT::RenderWithReSTIRPathTracing(
 		// For indirect surface bounces
 		bool bDeferSurfaceHits = DeferSurfaceHits();
 		bool bSortSurfaceHits = CVarHVPTReSTIRDeferSurfaceBouncesSorting.GetValueOnRenderThread();
-		// Buffer allocation is split evenly among candidates
-		// Each candidate allocates into a different region of the buffer
-		// This is to allow deferred candidates to be evaluated over multiple passes to prevent race conditions on the reservoir buffer
+		// All candidates allocate from the same buffer, and their results and lists are per surface bounce
 		uint32 MaxDeferredSurfaceBounces = CVarHVPTReSTIRDeferredBounceBufferSize.GetValueOnRenderThread();
-		if (bSortSurfaceHits)
-		{
-			// When sorting, the direction is used as a key for the sort. To allow a reasonable amount of precision to represent
-			// the direction, 6 bits per component are allowed. This leaves 20 bits for an indirection index - which gives a
-			// maximum number of addressable surface bounces per candidate as 2^20 (~1,000,000).
-			MaxDeferredSurfaceBounces = FMath::Min(MaxDeferredSurfaceBounces, NumCandidates * (1U << 20U));
-		}
-		uint32 MaxDeferredSurfaceBouncesPerCandidate = MaxDeferredSurfaceBounces / NumCandidates;
 
 		if (bDeferSurfaceHits && !CVarHVPTReSTIRDeferEvaluateCandidateF.GetValueOnRenderThread())
 		{
@@ -888,31 +1165,66 @@ void HVPT::RenderWithReSTIRPathTracing(
 		FRDGBufferRef DeferredSurfaceBounces = nullptr;
 		FRDGBufferRef DeferredSurfaceExtraBounces = nullptr;
 		FRDGBufferRef DeferredSurfaceBouncesIndirection = nullptr;
+		FRDGBufferRef DeferredSurfaceBouncesSortKeys = nullptr;
+		FRDGBufferRef DeferredSurfaceBounceResults = nullptr;
+		FRDGBufferRef DeferredSurfaceBounceListHeads = nullptr;
+		FRDGBufferRef DeferredSurfaceBounceListLinks = nullptr;
 		if (bDeferSurfaceHits)
 		{
 			DeferredSurfaceBounceAllocator = GraphBuilder.CreateBuffer(
-				FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), NumCandidates), TEXT("HVPT.ReSTIR.DeferredSurfaceBounceAllocator"));
+				FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), 1), TEXT("HVPT.ReSTIR.DeferredSurfaceBounceAllocator"));
 			DeferredSurfaceBounces = GraphBuilder.CreateBuffer(
 				FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_DeferredSurfaceBounce), MaxDeferredSurfaceBounces), TEXT("HVPT.ReSTIR.DeferredSurfaceBounces"));
 			DeferredSurfaceExtraBounces = GraphBuilder.CreateBuffer(
 				FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_Bounce), MaxDeferredSurfaceBounces * HVPT::GetMaxBounces()), TEXT("HVPT.ReSTIR.DeferredSurfaceExtraBounces"));
 			if (bSortSurfaceHits)
 			{
+				// When sorting, the candidate index and direction are used as a key for the sort and the index of the surface bounce is sorted alongside it
 				DeferredSurfaceBouncesIndirection = GraphBuilder.CreateBuffer(
 					FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), MaxDeferredSurfaceBounces), TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesIndirection"));
+				DeferredSurfaceBouncesSortKeys = GraphBuilder.CreateBuffer(
+					FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), MaxDeferredSurfaceBounces), TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesSortKeys"));
 			}
 
+			// Evaluated surface bounces are stored alongside the compacted surface bounces so that they can all be evaluated in a single pass.
+			// Each reservoir links its own surface bounces into a list for the resolve to walk, so nothing is sized by reservoirs times candidates
+			DeferredSurfaceBounceResults = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateStructuredDesc(ReservoirDesc.BytesPerElement, MaxDeferredSurfaceBounces), TEXT("HVPT.ReSTIR.DeferredSurfaceBounceResults"));
+			DeferredSurfaceBounceListHeads = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), NumReservoirs), TEXT("HVPT.ReSTIR.DeferredSurfaceBounceListHeads"));
+			DeferredSurfaceBounceListLinks = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateStructuredDesc(sizeof(uint32), MaxDeferredSurfaceBounces), TEXT("HVPT.ReSTIR.DeferredSurfaceBounceListLinks"));
+
 			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(DeferredSurfaceBounceAllocator), 0);
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(DeferredSurfaceBounceListHeads), 0);
 		}
 
+		// With adaptive candidates, candidate generation runs once for each bucket of reservoirs produced by the dispatcher
+		const bool bAdaptiveCandidates = UseAdaptiveCandidates();
+		const uint32 NumCandidateBuckets = bAdaptiveCandidates ? HVPT_CANDIDATE_BUCKET_COUNT : 1;
+		for (uint32 Bucket = 0; Bucket < NumCandidateBuckets; Bucket++)
 		{
 			FReSTIRCandidateGenerationRGS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRCandidateGenerationRGS::FParameters>();
 			PopulateCommonParameters(&PassParameters->Common);
 
+			FRDGBufferRef ArgumentBuffer = DispatchRaysIndirectArgumentBuffer;
+			uint32 ArgumentOffset = 0;
+			if (bAdaptiveCandidates)
+			{
+				FRDGBufferSRVDesc BucketReservoirIndicesDesc(CandidateBucketReservoirIndicesBuffer);
+				BucketReservoirIndicesDesc.StartOffsetBytes = Bucket * NumReservoirs * sizeof(uint32);
+				BucketReservoirIndicesDesc.NumElements = NumReservoirs;
+				PassParameters->Common.ReservoirIndices = GraphBuilder.CreateSRV(BucketReservoirIndicesDesc);
+				PassParameters->Common.IndirectArgs = CandidateBucketIndirectArgumentBuffer;
+
+				ArgumentBuffer = CandidateBucketIndirectArgumentBuffer;
+				ArgumentOffset = Bucket * sizeof(FRHIDispatchIndirectParameters);
+			}
+
 			PassParameters->SceneDepthTexture_Copy = GraphBuilder.CreateSRV(State.DepthBufferCopy);
 			PassParameters->FeatureTexture = GraphBuilder.CreateSRV(State.FeatureTexture);
 
-			PassParameters->NumInitialCandidates = NumCandidates;
+			PassParameters->NumInitialCandidates = bAdaptiveCandidates ? GetNumCandidatesForBucket(NumCandidates, Bucket) : NumCandidates;
 			PassParameters->bUseShadowTermForCandidateGeneration = HVPT::GetUseShadowTermForCandidateGeneration();
 
 			PassParameters->RWCurrentReservoirs = GraphBuilder.CreateUAV(ReservoirsA);
@@ -921,132 +1233,153 @@ void HVPT::RenderWithReSTIRPathTracing(
 
 			if (bDeferSurfaceHits)
 			{
-				PassParameters->SurfaceBounceAllocatorSize = MaxDeferredSurfaceBouncesPerCandidate;
+				PassParameters->SurfaceBounceAllocatorSize = MaxDeferredSurfaceBounces;
 				PassParameters->RWDeferredSurfaceBounceAllocator = GraphBuilder.CreateUAV(DeferredSurfaceBounceAllocator);
 				PassParameters->RWDeferredSurfaceBounces = GraphBuilder.CreateUAV(DeferredSurfaceBounces);
 				PassParameters->RWDeferredSurfaceExtraBounces = GraphBuilder.CreateUAV(DeferredSurfaceExtraBounces);
+				PassParameters->RWDeferredSurfaceBounceListHeads = GraphBuilder.CreateUAV(DeferredSurfaceBounceListHeads);
+				PassParameters->RWDeferredSurfaceBounceListLinks = GraphBuilder.CreateUAV(DeferredSurfaceBounceListLinks);
 
 				if (bSortSurfaceHits)
 				{
 					PassParameters->RWDeferredSurfaceBouncesIndirection = GraphBuilder.CreateUAV(DeferredSurfaceBouncesIndirection, PF_R32_UINT);
+					PassParameters->RWDeferredSurfaceBouncesSortKeys = GraphBuilder.CreateUAV(DeferredSurfaceBouncesSortKeys, PF_R32_UINT);
 				}
 			}
 
-			FReSTIRCandidateGenerationRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRCandidateGenerationRGS>(State);
+			FReSTIRCandidateGenerationRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRCandidateGenerationRGS>(ViewInfo, State);
 			Permutation.Set<FReSTIRCandidateGenerationRGS::FDeferEvaluateF>(CVarHVPTReSTIRDeferEvaluateCandidateF.GetValueOnRenderThread());
 			Permutation.Set<FReSTIRCandidateGenerationRGS::FDeferSurfaceHits>(DeferSurfaceHits());
 			Permutation.Set<FReSTIRCandidateGenerationRGS::FDeferSurfaceBouncesUseIndirection>(DeferSurfaceHits() && CVarHVPTReSTIRDeferSurfaceBouncesSorting.GetValueOnRenderThread());
 			AddRaytracingPass<FReSTIRCandidateGenerationRGS>(
 				GraphBuilder,
-				RDG_EVENT_NAME("ReSTIRCandidateGeneration"),
+				RDG_EVENT_NAME("ReSTIRCandidateGeneration(Bucket=%d, Candidates=%d)", Bucket, PassParameters->NumInitialCandidates),
 				ViewInfo, 
 				State,
 				PassParameters,
 				Permutation,
-				DispatchRaysIndirectArgumentBuffer
+				ReservoirExtent,
+				ArgumentBuffer,
+				ArgumentOffset
 			);
 		}
 		if (bDeferSurfaceHits)
 		{
-			FRDGBufferRef IndirectionPing = nullptr;
-			FRDGBufferRef IndirectionPong = nullptr;
+			// Optionally sort buffer to improve coherence in ray tracing
 			if (bSortSurfaceHits)
 			{
-				const auto Desc = FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), MaxDeferredSurfaceBouncesPerCandidate);
-				IndirectionPing = GraphBuilder.CreateBuffer(Desc, TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesIndirectionPing"));
-				IndirectionPong = GraphBuilder.CreateBuffer(Desc, TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesIndirectionPong"));
+				RDG_EVENT_SCOPE(GraphBuilder, "Sort Surface Bounces");
+
+				TStaticArray<FRDGBufferRef, 2> KeyBuffers;
+				KeyBuffers[0] = DeferredSurfaceBouncesSortKeys;
+				KeyBuffers[1] = GraphBuilder.CreateBuffer(DeferredSurfaceBouncesSortKeys->Desc, TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesSortKeysPingPong"));
+				TStaticArray<FRDGBufferRef, 2> ValueBuffers;
+				ValueBuffers[0] = DeferredSurfaceBouncesIndirection;
+				ValueBuffers[1] = GraphBuilder.CreateBuffer(DeferredSurfaceBouncesIndirection->Desc, TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesIndirectionPingPong"));
+
+				// The candidate index sits above the direction in each key, so a single sort orders the bounces of every candidate
+				const uint32 SortKeyBits = HVPT_SURFACE_BOUNCE_DIRECTION_KEY_BITS + FMath::CeilLogTwo(NumCandidates);
+				uint32 BufferIndex = HVPT::Private::SortBufferIndirect(
+					GraphBuilder,
+					KeyBuffers,
+					ValueBuffers,
+					0,
+					DeferredSurfaceBounceAllocator,
+					0,
+					SortKeyBits < 32 ? (1u << SortKeyBits) - 1 : MAX_uint32,
+					ViewInfo.FeatureLevel,
+					MaxDeferredSurfaceBounces
+				);
+
+				DeferredSurfaceBouncesIndirection = ValueBuffers[BufferIndex];
 			}
 
-			// Multiple candidates for the same pixel may want to defer surface bounce evaluation.
-			// Evaluating the surface bounce requires both reading and writing to the reservoir buffer.
-			// Multiple passes are required to prevent race conditions on the reservoir buffer.
-			for (uint32 DeferredSurfaceBouncePass = 0; DeferredSurfaceBouncePass < NumCandidates; DeferredSurfaceBouncePass++)
+			// Setup indirect arguments, with one thread per allocated surface bounce
+			FRDGBufferRef DispatchDeferredSurfaceBounceIndirectArguments = GraphBuilder.CreateBuffer(
+				FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(), TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesIndirectArguments"));
 			{
-				FRDGBufferSRVRef IndirectionSRV = nullptr;
-
-				// Optionally sort buffer to improve coherence in ray tracing
-				if (bSortSurfaceHits)
-				{
-					RDG_EVENT_SCOPE(GraphBuilder, "Sort Surface Bounces");
-
-					// The copy is required because we are not able to specify a sub-region of a buffer when creating a UAV (RDG only supports this for SRVs)
-					// It is important that we sort a sub-region of the buffer at a time - so we copy the region of the buffer that we are interested in
-					// and then sort that.
-					const uint64 BytesPerCandidate = MaxDeferredSurfaceBouncesPerCandidate * sizeof(uint32);
-					AddCopyBufferPass(
-						GraphBuilder,
-						IndirectionPing,
-						0,
-						DeferredSurfaceBouncesIndirection,
-						DeferredSurfaceBouncePass * BytesPerCandidate,
-						BytesPerCandidate
-					);
-
-					// Sort deferred surface bounce buffer
-					TStaticArray<FRDGBufferSRVRef, 2> KeySRVs = {
-						GraphBuilder.CreateSRV(IndirectionPing, PF_R32_UINT),
-						GraphBuilder.CreateSRV(IndirectionPong, PF_R32_UINT)
-					};
-					TStaticArray<FRDGBufferUAVRef, 2> KeyUAVs = {
-						GraphBuilder.CreateUAV(IndirectionPing, PF_R32_UINT),
-						GraphBuilder.CreateUAV(IndirectionPong, PF_R32_UINT)
-					};
-					int32 BufferIndex = HVPT::Private::SortBufferIndirect(
-						GraphBuilder,
-						KeySRVs,
-						KeyUAVs,
-						{},
-						{},
-						0,
-						DeferredSurfaceBounceAllocator,
-						DeferredSurfaceBouncePass,
-						0xFFF00000,
-						ViewInfo.FeatureLevel
-					);
+				FReSTIRDeferredSurfaceBouncesArgsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRDeferredSurfaceBouncesArgsCS::FParameters>();
+				PassParameters->SurfaceBounceAllocatorSize = MaxDeferredSurfaceBounces;
+				PassParameters->DeferredSurfaceBounceAllocator = GraphBuilder.CreateSRV(DeferredSurfaceBounceAllocator);
+				PassParameters->RWDeferredSurfaceBouncesIndirectArgs = GraphBuilder.CreateUAV(DispatchDeferredSurfaceBounceIndirectArguments, PF_R32_UINT);
 
-					IndirectionSRV = KeySRVs[BufferIndex];
-				} 
-
-				// Setup indirect arguments
-				FRDGBufferRef DispatchDeferredSurfaceBounceIndirectArguments = FComputeShaderUtils::AddIndirectArgsSetupCsPass1D(
-					GraphBuilder, ViewInfo.FeatureLevel, DeferredSurfaceBounceAllocator, TEXT("HVPT.ReSTIR.DeferredSurfaceBouncesIndirectArguments"), 1, DeferredSurfaceBouncePass);
+				TShaderMapRef<FReSTIRDeferredSurfaceBouncesArgsCS> ComputeShader(ViewInfo.ShaderMap);
+				FComputeShaderUtils::AddPass(
+					GraphBuilder,
+					RDG_EVENT_NAME("ReSTIRDeferredSurfaceBouncesArgs"),
+					ERDGPassFlags::Compute,
+					ComputeShader,
+					PassParameters,
+					FIntVector(1, 1, 1)
+				);
+			}
 
+			// Evaluate the surface bounces of all candidates at once. Results are written to a separate slot for each surface bounce,
+			// which avoids race conditions on the reservoir buffer between bounces of the same reservoir
+			{
 				FReSTIRCandidateEvaluateSurfaceBouncesRGS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FParameters>();
 				PopulateCommonParameters(&PassParameters->Common);
 				PassParameters->Common.IndirectArgs = DispatchDeferredSurfaceBounceIndirectArguments;
 
 				PassParameters->bUseShadowTermForCandidateGeneration = HVPT::GetUseShadowTermForCandidateGeneration();
 
-				PassParameters->DeferredSurfaceBounces = GraphBuilder.CreateSRV(
-					FRDGBufferSRVDesc{ DeferredSurfaceBounces,
-					DeferredSurfaceBouncePass * MaxDeferredSurfaceBouncesPerCandidate * static_cast<uint32>(sizeof(FHVPT_DeferredSurfaceBounce)),
-					MaxDeferredSurfaceBouncesPerCandidate });
-				PassParameters->DeferredSurfaceExtraBounces = GraphBuilder.CreateSRV(
-					FRDGBufferSRVDesc{ DeferredSurfaceExtraBounces,
-					DeferredSurfaceBouncePass * MaxDeferredSurfaceBouncesPerCandidate * static_cast<uint32>(sizeof(FHVPT_Bounce)) * HVPT::GetMaxBounces(),
-					MaxDeferredSurfaceBouncesPerCandidate * HVPT::GetMaxBounces() });
+				PassParameters->SurfaceBounceAllocatorSize = MaxDeferredSurfaceBounces;
+				PassParameters->DeferredSurfaceBounceAllocator = GraphBuilder.CreateSRV(DeferredSurfaceBounceAllocator);
+				PassParameters->DeferredSurfaceBounces = GraphBuilder.CreateSRV(DeferredSurfaceBounces);
 				if (bSortSurfaceHits)
 				{
-					PassParameters->DeferredSurfaceBouncesIndirection = IndirectionSRV;
+					PassParameters->DeferredSurfaceBouncesIndirection = GraphBuilder.CreateSRV(DeferredSurfaceBouncesIndirection, PF_R32_UINT);
 				}
 
-				PassParameters->RWCurrentReservoirs = GraphBuilder.CreateUAV(ReservoirsA);
-				PassParameters->RWExtraBounces = GraphBuilder.CreateUAV(ExtraBouncesA);
+				PassParameters->RWDeferredSurfaceBounceResults = GraphBuilder.CreateUAV(DeferredSurfaceBounceResults);
 
 				FReSTIRCandidateEvaluateSurfaceBouncesRGS::FPermutationDomain Permutation;
-				Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FDeferSurfaceBouncesUseIndirection>(CVarHVPTReSTIRDeferSurfaceBouncesSorting.GetValueOnRenderThread());
+				Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FDeferSurfaceBouncesUseIndirection>(bSortSurfaceHits);
 				Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FUseSER>(HVPT::ShouldUseSER());
+				Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FMonochromeExtinction>(HVPT::Private::ShouldUseMonochromeExtinction(ViewInfo));
 				Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FDebugOutputEnabled>(State.DebugFlags& HVPT_DEBUG_FLAG_ENABLE);
+				Permutation.Set<FReSTIRCandidateEvaluateSurfaceBouncesRGS::FCompactReservoirs>(UseCompactReservoirs());
 				AddRaytracingPass<FReSTIRCandidateEvaluateSurfaceBouncesRGS>(
 					GraphBuilder,
-					RDG_EVENT_NAME("ReSTIRCandidateEvaluateSurfaceBounces(n=%d)", DeferredSurfaceBouncePass),
+					RDG_EVENT_NAME("ReSTIRCandidateEvaluateSurfaceBounces"),
 					ViewInfo,
 					State,
 					PassParameters,
 					Permutation,
+					ReservoirExtent,
 					DispatchDeferredSurfaceBounceIndirectArguments
 				);
 			}
+
+			// Stream the surface reservoirs of each reservoir's list into the reservoir buffer
+			{
+				FReSTIRDeferredSurfaceBouncesResolveCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRDeferredSurfaceBouncesResolveCS::FParameters>();
+				PassParameters->ReservoirLayout = ReservoirLayout;
+
+				uint32 FrameIndex = ViewInfo.ViewState ? ViewInfo.ViewState->FrameIndex : 0;
+				PassParameters->TemporalSeed = HVPT::GetFreezeTemporalSeed() ? 0 : MaxNumPasses * FrameIndex + TemporalSeedOffset++;
+				PassParameters->NumBounces = FMath::Clamp(HVPT::GetMaxBounces(), 1, kReSTIRMaxBounces);
+
+				PassParameters->DeferredSurfaceBounceResults = GraphBuilder.CreateSRV(DeferredSurfaceBounceResults);
+				PassParameters->DeferredSurfaceBounceListHeads = GraphBuilder.CreateSRV(DeferredSurfaceBounceListHeads);
+				PassParameters->DeferredSurfaceBounceListLinks = GraphBuilder.CreateSRV(DeferredSurfaceBounceListLinks);
+				PassParameters->DeferredSurfaceExtraBounces = GraphBuilder.CreateSRV(DeferredSurfaceExtraBounces);
+
+				PassParameters->RWCurrentReservoirs = GraphBuilder.CreateUAV(ReservoirsA);
+				PassParameters->RWExtraBounces = GraphBuilder.CreateUAV(ExtraBouncesA);
+
+				FReSTIRDeferredSurfaceBouncesResolveCS::FPermutationDomain Permutation;
+				Permutation.Set<FReSTIRDeferredSurfaceBouncesResolveCS::FCompactReservoirs>(UseCompactReservoirs());
+				TShaderMapRef<FReSTIRDeferredSurfaceBouncesResolveCS> ComputeShader(ViewInfo.ShaderMap, Permutation);
+				FComputeShaderUtils::AddPass(
+					GraphBuilder,
+					RDG_EVENT_NAME("ReSTIRDeferredSurfaceBouncesResolve"),
+					ERDGPassFlags::Compute,
+					ComputeShader,
+					PassParameters,
+					FComputeShaderUtils::GetGroupCount(ReservoirExtent, FReSTIRDeferredSurfaceBouncesResolveCS::GetThreadGroupSize2D())
+				);
+			}
 		}
 		if (CVarHVPTReSTIRDeferEvaluateCandidateF.GetValueOnRenderThread())
 		{
@@ -1063,6 +1396,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 				ViewInfo,
 				State,
 				PassParameters,
+				ReservoirExtent,
 				DispatchRaysIndirectArgumentBuffer
 			);
 		}
@@ -1097,6 +1431,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 			ViewInfo,
 			State,
 			PassParameters,
+			ReservoirExtent,
 			DispatchRaysIndirectArgumentBuffer
 		);
 	}
@@ -1135,6 +1470,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 				ViewInfo,
 				State,
 				PassParameters,
+				ReservoirExtent,
 				DispatchRaysIndirectArgumentBuffer
 			);
 		}
@@ -1151,8 +1487,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 			int32 SpatialReuseRadiusI = FMath::CeilToInt(SpatialReuseRadius) - 1;
 			uint32 NumSpatialSamples = FMath::Clamp(HVPT::GetNumSpatialReuseSamples(), 1, kReSTIRMaxSpatialSamples);
 
-			// Calculate number of tiles / size of tiles based on view size
-			const auto& ViewExtent = ViewInfo.ViewRect.Size();
+			// Calculate number of tiles / size of tiles based on the size of the reservoir grid
 			// The view rect will be processed in tiles. These tiles will be surrounded by a (up to) 10px buffer zone around each edge.
 			// Threads will be dispatched for the tile, but they may require evaluating domains outside of this rect, so the transient buffers must be big enough for this
 			int32 TileW = CVarHVPTReSTIRMultiPassSpatialReuseTileSize.GetValueOnRenderThread();
@@ -1165,8 +1500,8 @@ void HVPT::RenderWithReSTIRPathTracing(
 
 			const int32 IndirectionBufferElementCount = CVarHVPTReSTIRMultiPassSpatialReuseIndirectionBufferSize.GetValueOnRenderThread();
 
-			const int32 NumTilesX = FMath::DivideAndRoundUp(ViewExtent.X, TileW);
-			const int32 NumTilesY = FMath::DivideAndRoundUp(ViewExtent.Y, TileW);
+			const int32 NumTilesX = FMath::DivideAndRoundUp(ReservoirExtent.X, TileW);
+			const int32 NumTilesY = FMath::DivideAndRoundUp(ReservoirExtent.Y, TileW);
 
 			// Allocate transient buffers required for intermediate results
 			FRDGBufferRef NeighbourIndicesBuffer = GraphBuilder.CreateBuffer(
@@ -1193,7 +1528,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 				// The actual tile width may be less than TileW (if the tile is off of the screen)
 				// Calculate the actual tile size
 				FIntPoint TileStart{ X * TileW, Y * TileW };
-				FIntPoint TileEnd{ FMath::Min((X + 1) * TileW, ViewExtent.X), FMath::Min((Y + 1) * TileW, ViewExtent.Y) };
+				FIntPoint TileEnd{ FMath::Min((X + 1) * TileW, ReservoirExtent.X), FMath::Min((Y + 1) * TileW, ReservoirExtent.Y) };
 				FIntPoint TileSize = TileEnd - TileStart;
 
 				auto PopulateSpatialReuseCommonParameters = [&](FReSTIRMultiPassSpatialReuseCommonParameters& Parameters)
@@ -1220,6 +1555,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 				{
 					FReSTIRSpatialReuse_ChooseNeighboursCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRSpatialReuse_ChooseNeighboursCS::FParameters>();
 					PassParameters->View = ViewInfo.ViewUniformBuffer;
+					PassParameters->ReservoirLayout = ReservoirLayout;
 					PopulateSpatialReuseCommonParameters(PassParameters->SpatialReuseCommon);
 
 					uint32 FrameIndex = ViewInfo.ViewState ? ViewInfo.ViewState->FrameIndex : 0;
@@ -1245,6 +1581,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 					FReSTIRSpatialReuse_ChooseNeighboursCS::FPermutationDomain Permutation;
 					Permutation.Set<FReSTIRSpatialReuse_ChooseNeighboursCS::FUse16BitResultBuffer>(b16BitResultBuffer);
 					Permutation.Set<FReSTIRSpatialReuse_ChooseNeighboursCS::FDebugOutputEnabled>(State.DebugFlags & HVPT_DEBUG_FLAG_ENABLE);
+					Permutation.Set<FReSTIRSpatialReuse_ChooseNeighboursCS::FCompactReservoirs>(UseCompactReservoirs());
 					TShaderMapRef<FReSTIRSpatialReuse_ChooseNeighboursCS> ComputeShader(ShaderMap, Permutation);
 					FIntVector GroupCount = FComputeShaderUtils::GetGroupCount(static_cast<FIntPoint>(TileSize), FReSTIRSpatialReuse_ChooseNeighboursCS::GetThreadGroupSize2D());
 					FComputeShaderUtils::AddPass(
@@ -1301,7 +1638,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 					PassParameters->EvaluationIndirectionBuffer = GraphBuilder.CreateSRV(EvaluationIndirectionBuffer, PF_R32_UINT);
 					PassParameters->RWEvaluationResults = GraphBuilder.CreateUAV(EvaluationResultsBuffer, ResultBufferFormat);
 
-					FReSTIRSpatialReuse_EvaluateRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRSpatialReuse_EvaluateRGS>(State);
+					FReSTIRSpatialReuse_EvaluateRGS::FPermutationDomain Permutation = CreatePermutation<FReSTIRSpatialReuse_EvaluateRGS>(ViewInfo, State);
 					Permutation.Set<FReSTIRSpatialReuse_EvaluateRGS::FUse16BitResultBuffer>(b16BitResultBuffer);
 					AddRaytracingPass<FReSTIRSpatialReuse_EvaluateRGS>(
 						GraphBuilder,
@@ -1310,6 +1647,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 						State,
 						PassParameters,
 						Permutation,
+						ReservoirExtent,
 						IndirectArguments
 					);
 				}
@@ -1318,6 +1656,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 				{
 					FReSTIRSpatialReuse_GatherAndReuseCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRSpatialReuse_GatherAndReuseCS::FParameters>();
 					PassParameters->View = ViewInfo.ViewUniformBuffer;
+					PassParameters->ReservoirLayout = ReservoirLayout;
 					PopulateSpatialReuseCommonParameters(PassParameters->SpatialReuseCommon);
 
 					uint32 FrameIndex = ViewInfo.ViewState ? ViewInfo.ViewState->FrameIndex : 0;
@@ -1347,6 +1686,7 @@ void HVPT::RenderWithReSTIRPathTracing(
 					Permutation.Set<FReSTIRSpatialReuse_GatherAndReuseCS::FMultipleBounces>(HVPT::GetMaxBounces() > 1);
 					Permutation.Set<FReSTIRSpatialReuse_GatherAndReuseCS::FUse16BitResultBuffer>(b16BitResultBuffer);
 					Permutation.Set<FReSTIRSpatialReuse_GatherAndReuseCS::FDebugOutputEnabled>(State.DebugFlags& HVPT_DEBUG_FLAG_ENABLE);
+					Permutation.Set<FReSTIRSpatialReuse_GatherAndReuseCS::FCompactReservoirs>(UseCompactReservoirs());
 					TShaderMapRef<FReSTIRSpatialReuse_GatherAndReuseCS> ComputeShader(ShaderMap, Permutation);
 					FIntVector GroupCount = FComputeShaderUtils::GetGroupCount(static_cast<FIntPoint>(TileSize), FReSTIRSpatialReuse_GatherAndReuseCS::GetThreadGroupSize2D());
 					FComputeShaderUtils::AddPass(
@@ -1390,15 +1730,42 @@ void HVPT::RenderWithReSTIRPathTracing(
 		if (HVPT::GetMaxBounces() > 1)
 			PassParameters->ExtraBounces = GraphBuilder.CreateSRV(ExtraBouncesB);
 
+		PassParameters->FeatureTexture = GraphBuilder.CreateSRV(State.FeatureTexture);
+
 		PassParameters->RWRadianceTexture = GraphBuilder.CreateUAV(State.RadianceTexture);
 
+		// When upsampling, every pixel is shaded rather than every reservoir
+		FReSTIRFinalShadingRGS::FPermutationDomain Permutation = CreateFinalShadingPermutation(ViewInfo, State);
+		const bool bUpsample = Permutation.Get<FReSTIRFinalShadingRGS::FReservoirUpsample>();
 		AddRaytracingPass<FReSTIRFinalShadingRGS>(
 			GraphBuilder,
 			RDG_EVENT_NAME("ReSTIRFinalShading"),
 			ViewInfo, 
 			State,
 			PassParameters,
-			DispatchRaysIndirectArgumentBuffer
+			Permutation,
+			bUpsample ? ViewExtent : ReservoirExtent,
+			bUpsample ? nullptr : DispatchRaysIndirectArgumentBuffer
+		);
+	}
+
+	// Add this frame's shading to the luminance moments used to pick next frame's candidate buckets
+	if (LuminanceMomentsBuffer)
+	{
+		FReSTIRUpdateLuminanceMomentsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FReSTIRUpdateLuminanceMomentsCS::FParameters>();
+		PassParameters->View = ViewInfo.ViewUniformBuffer;
+		PassParameters->ReservoirLayout = ReservoirLayout;
+		PassParameters->RadianceTexture = GraphBuilder.CreateSRV(State.RadianceTexture);
+		PassParameters->RWLuminanceMoments = GraphBuilder.CreateUAV(LuminanceMomentsBuffer);
+
+		TShaderMapRef<FReSTIRUpdateLuminanceMomentsCS> ComputeShader(ViewInfo.ShaderMap);
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("ReSTIRUpdateLuminanceMoments"),
+			ERDGPassFlags::Compute,
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(ReservoirExtent, FReSTIRUpdateLuminanceMomentsCS::GetThreadGroupSize2D())
 		);
 	}
 
@@ -1414,8 +1781,11 @@ void HVPT::RenderWithReSTIRPathTracing(
 		if (HVPT::GetMaxBounces() > 1)
 			PassParameters->ExtraBounces = GraphBuilder.CreateSRV(ExtraBouncesB);
 
+		FReSTIRDebugVisualizationCS::FPermutationDomain Permutation;
+		Permutation.Set<FReSTIRDebugVisualizationCS::FCompactReservoirs>(UseCompactReservoirs());
+
 		FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(ViewInfo.FeatureLevel);
-		TShaderMapRef<FReSTIRDebugVisualizationCS> ComputeShader(ShaderMap);
+		TShaderMapRef<FReSTIRDebugVisualizationCS> ComputeShader(ShaderMap, Permutation);
 
 		FIntVector GroupCount = FComputeShaderUtils::GetGroupCount(ViewInfo.ViewRect.Size(), FReSTIRDebugVisualizationCS::GetThreadGroupSize2D());
 
@@ -1433,6 +1803,11 @@ void HVPT::RenderWithReSTIRPathTracing(
 	GraphBuilder.QueueBufferExtraction(ReservoirsB, &State.ReSTIRReservoirCache);
 	if (HasBeenProduced(ExtraBouncesB))
 		GraphBuilder.QueueBufferExtraction(ExtraBouncesB, &State.ReSTIRExtraBounceCache);
+	// Moments stop following the view while adaptive candidates are off, so they are dropped rather than kept stale
+	if (LuminanceMomentsBuffer)
+		GraphBuilder.QueueBufferExtraction(LuminanceMomentsBuffer, &State.ReSTIRLuminanceMomentsCache);
+	else
+		State.ReSTIRLuminanceMomentsCache.SafeRelease();
 }
 
 #endif
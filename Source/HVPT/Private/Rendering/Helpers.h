@@ -51,6 +51,7 @@ FHVPT_PathTracingFogParameters PrepareFogParameters(const FViewInfo& View, const
 // Can optionally sort arrays of values along with the keys
 // BufferIndex specifies the buffer containing unsorted data initially
 // Counter offset is the index (in num uints - not num bytes) into the buffer containing the counter to use for creating dispatch indirect args
+// The counter is clamped to MaxElementCount, for counters that can be incremented past the capacity of the buffers
 // Returns index of buffer containing sorted result
 // Implemented in RadixSort.cpp
 uint32 SortBufferIndirect(
@@ -61,7 +62,8 @@ uint32 SortBufferIndirect(
 	FRDGBufferRef Counter, 
 	uint32 CounterOffset, 
 	uint32 KeyMask, 
-	ERHIFeatureLevel::Type FeatureLevel
+	ERHIFeatureLevel::Type FeatureLevel,
+	uint32 MaxElementCount = MAX_uint32
 );
 
 // Overload with finer-grained control, for example in a situation with sub-allocating out of buffers
@@ -76,7 +78,8 @@ uint32 SortBufferIndirect(
 	FRDGBufferRef Counter,
 	uint32 CounterOffset,
 	uint32 KeyMask,
-	ERHIFeatureLevel::Type FeatureLevel
+	ERHIFeatureLevel::Type FeatureLevel,
+	uint32 MaxElementCount = MAX_uint32
 );
 
 }
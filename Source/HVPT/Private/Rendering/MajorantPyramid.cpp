@@ -0,0 +1,150 @@
+#include "MajorantPyramid.h"
+
+
+int32 HVPT::Private::CalcMajorantMipCount(const FIntVector& TopLevelGridResolution, int32 MaxMipCount)
+{
+	// Levels above the one with a single cell would all be identical
+	const int32 MaxDimension = FMath::Max(TopLevelGridResolution.GetMax(), 1);
+	const int32 FullMipCount = FMath::CeilLogTwo(MaxDimension) + 1;
+	return FMath::Clamp(FullMipCount, 1, FMath::Max(MaxMipCount, 1));
+}
+
+FIntVector HVPT::Private::CalcMajorantMipResolution(const FIntVector& TopLevelGridResolution, int32 MipLevel)
+{
+	const int32 Round = (1 << MipLevel) - 1;
+	return FIntVector(
+		FMath::Max((TopLevelGridResolution.X + Round) >> MipLevel, 1),
+		FMath::Max((TopLevelGridResolution.Y + Round) >> MipLevel, 1),
+		FMath::Max((TopLevelGridResolution.Z + Round) >> MipLevel, 1)
+	);
+}
+
+uint32 HVPT::Private::CalcMajorantMipSize(const FIntVector& MipResolution)
+{
+	// Cells are addressed with a morton code on the GPU, so the size is the code of the furthest cell
+	const FIntVector LastCell = MipResolution - FIntVector(1);
+	return (FMath::MortonCode3(LastCell.X) | (FMath::MortonCode3(LastCell.Y) << 1) | (FMath::MortonCode3(LastCell.Z) << 2)) + 1;
+}
+
+uint32 HVPT::Private::CalcMajorantMipOffset(const FIntVector& TopLevelGridResolution, int32 MipLevel)
+{
+	uint32 Offset = 0;
+	for (int32 Level = 0; Level < MipLevel; ++Level)
+	{
+		Offset += CalcMajorantMipSize(CalcMajorantMipResolution(TopLevelGridResolution, Level));
+	}
+	return Offset;
+}
+
+
+void FHVPTMajorantPyramid::Build(const FIntVector& TopLevelGridResolution, TConstArrayView<float> TopLevelMajorants, int32 MaxMipCount)
+{
+	check(TopLevelMajorants.Num() == TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z);
+
+	const int32 MipCount = HVPT::Private::CalcMajorantMipCount(TopLevelGridResolution, MaxMipCount);
+
+	Mips.SetNum(MipCount);
+	Mips[0].Resolution = TopLevelGridResolution;
+	Mips[0].Majorants = TopLevelMajorants;
+
+	// Matches HVPT_DownsampleMajorantGridCS
+	for (int32 MipLevel = 1; MipLevel < MipCount; ++MipLevel)
+	{
+		const FMip& SrcMip = Mips[MipLevel - 1];
+		FMip& DstMip = Mips[MipLevel];
+
+		DstMip.Resolution = HVPT::Private::CalcMajorantMipResolution(TopLevelGridResolution, MipLevel);
+		DstMip.Majorants.SetNumZeroed(DstMip.Resolution.X * DstMip.Resolution.Y * DstMip.Resolution.Z);
+
+		for (int32 Z = 0; Z < SrcMip.Resolution.Z; ++Z)
+		for (int32 Y = 0; Y < SrcMip.Resolution.Y; ++Y)
+		for (int32 X = 0; X < SrcMip.Resolution.X; ++X)
+		{
+			const float SrcMajorant = SrcMip.Majorants[X + SrcMip.Resolution.X * (Y + SrcMip.Resolution.Y * Z)];
+			float& DstMajorant = DstMip.Majorants[(X >> 1) + DstMip.Resolution.X * ((Y >> 1) + DstMip.Resolution.Y * (Z >> 1))];
+			DstMajorant = FMath::Max(DstMajorant, SrcMajorant);
+		}
+	}
+}
+
+float FHVPTMajorantPyramid::GetMajorant(int32 MipLevel, const FIntVector& MipCell) const
+{
+	const FMip& Mip = Mips[MipLevel];
+	return Mip.Majorants[MipCell.X + Mip.Resolution.X * (MipCell.Y + Mip.Resolution.Y * MipCell.Z)];
+}
+
+void FHVPTMajorantPyramid::TraceFlat(const FVector3f& Begin, const FVector3f& End, TArray<FSegment>& OutSegments) const
+{
+	Trace(Begin, End, 0, 0.0f, OutSegments);
+}
+
+void FHVPTMajorantPyramid::TraceHierarchical(const FVector3f& Begin, const FVector3f& End, float LeapThreshold, TArray<FSegment>& OutSegments) const
+{
+	Trace(Begin, End, Mips.Num() - 1, LeapThreshold, OutSegments);
+}
+
+void FHVPTMajorantPyramid::Trace(const FVector3f& Begin, const FVector3f& End, int32 MaxMipLevel, float LeapThreshold, TArray<FSegment>& OutSegments) const
+{
+	// Matches FHVPT_MajorantIterator::Next
+	OutSegments.Reset();
+	if (Mips.IsEmpty())
+	{
+		return;
+	}
+
+	const FIntVector GridResolution = Mips[0].Resolution;
+
+	FVector3f Direction = End - Begin;
+	const float TMax = Direction.Length();
+	if (!(TMax > 0.0f))
+	{
+		return;
+	}
+	Direction /= TMax;
+
+	float T = 0.0f;
+	int32 MipLevel = MaxMipLevel;
+	while (T < TMax)
+	{
+		const FVector3f Position = Begin + (T + 1e-4f) * Direction;
+		const FIntVector Cell(
+			FMath::Clamp(FMath::FloorToInt32(Position.X), 0, GridResolution.X - 1),
+			FMath::Clamp(FMath::FloorToInt32(Position.Y), 0, GridResolution.Y - 1),
+			FMath::Clamp(FMath::FloorToInt32(Position.Z), 0, GridResolution.Z - 1)
+		);
+
+		MipLevel = FMath::Min(MipLevel + 1, MaxMipLevel);
+		for (; MipLevel > 0; --MipLevel)
+		{
+			if (GetMajorant(MipLevel, FIntVector(Cell.X >> MipLevel, Cell.Y >> MipLevel, Cell.Z >> MipLevel)) <= LeapThreshold)
+			{
+				break;
+			}
+		}
+
+		const FIntVector MipCell(Cell.X >> MipLevel, Cell.Y >> MipLevel, Cell.Z >> MipLevel);
+
+		float CellExitT = TMax;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (Direction[Axis] != 0.0f)
+			{
+				const float CellMin = static_cast<float>(MipCell[Axis] << MipLevel);
+				const float CellMax = static_cast<float>(FMath::Min((MipCell[Axis] + 1) << MipLevel, GridResolution[Axis]));
+				const float Boundary = Direction[Axis] > 0.0f ? CellMax : CellMin;
+				CellExitT = FMath::Min(CellExitT, (Boundary - Begin[Axis]) / Direction[Axis]);
+			}
+		}
+
+		const float DeltaT = FMath::Min(FMath::Max(CellExitT - T, 1e-4f), TMax - T);
+
+		FSegment& Segment = OutSegments.AddDefaulted_GetRef();
+		Segment.TMin = T;
+		Segment.TMax = T + DeltaT;
+		Segment.MipLevel = MipLevel;
+		Segment.MipCell = MipCell;
+		Segment.Majorant = GetMajorant(MipLevel, MipCell);
+
+		T += DeltaT;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+namespace HVPT::Private
+{
+
+// Majorant pyramid layout
+// Level 0 has one cell per top-level grid cell, and each level above it halves the resolution, rounding up.
+// All levels are stored consecutively in the majorant grid buffer. Must match the helpers in VoxelGridBuildUtils.ush
+int32 CalcMajorantMipCount(const FIntVector& TopLevelGridResolution, int32 MaxMipCount);
+FIntVector CalcMajorantMipResolution(const FIntVector& TopLevelGridResolution, int32 MipLevel);
+uint32 CalcMajorantMipSize(const FIntVector& MipResolution);
+uint32 CalcMajorantMipOffset(const FIntVector& TopLevelGridResolution, int32 MipLevel);
+
+}
+
+
+// CPU reference for the majorant pyramid and the hierarchical traversal through it in FHVPT_MajorantIterator (DDAUtils.ush)
+// Rays are given in top-level voxel space, and must begin and end inside the grid
+class FHVPTMajorantPyramid
+{
+public:
+	struct FSegment
+	{
+		float TMin;
+		float TMax;
+
+		int32 MipLevel;
+		FIntVector MipCell;
+		float Majorant;
+	};
+
+	// TopLevelMajorants holds one majorant per top-level cell, in x-major order
+	void Build(const FIntVector& TopLevelGridResolution, TConstArrayView<float> TopLevelMajorants, int32 MaxMipCount);
+
+	int32 GetMipCount() const { return Mips.Num(); }
+	float GetMajorant(int32 MipLevel, const FIntVector& MipCell) const;
+
+	// Steps through every top-level cell along the ray
+	void TraceFlat(const FVector3f& Begin, const FVector3f& End, TArray<FSegment>& OutSegments) const;
+
+	// Steps through the coarsest cells with a majorant at most LeapThreshold, as the GPU traversal does
+	void TraceHierarchical(const FVector3f& Begin, const FVector3f& End, float LeapThreshold, TArray<FSegment>& OutSegments) const;
+
+private:
+	void Trace(const FVector3f& Begin, const FVector3f& End, int32 MaxMipLevel, float LeapThreshold, TArray<FSegment>& OutSegments) const;
+
+	struct FMip
+	{
+		FIntVector Resolution;
+		TArray<float> Majorants;
+	};
+	TArray<FMip> Mips;
+};
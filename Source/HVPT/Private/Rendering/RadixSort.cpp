@@ -8,7 +8,7 @@
 	This is based on GPUSort.h/cpp implemented in Unreal Engine
 	However, there is two critical differences between the algorithm implemented there
 	and the algorithm required in HVPT's ReSTIR implementation.
-	1.	I only require sorting an array of keys, rather than two linked arrays of key-value pairs
+	1.	Sorting values along with the keys is optional, as sometimes only an array of keys needs sorting
 	2.	This sort should be GPU-driven - i.e., the number of items to sort is not known to the CPU
 		but instead determined by prior GPU work.
 -----------------------------------------------------*/
@@ -56,6 +56,7 @@ public:
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_RDG_BUFFER_SRV(RWStructuredBuffer<uint>, Counter)
+		SHADER_PARAMETER(uint32, MaxKeyCount)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FRadixSortParameters>, RWRadixSortParameterBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWIndirectArgs)
 	END_SHADER_PARAMETER_STRUCT()
@@ -177,7 +178,8 @@ uint32 HVPT::Private::SortBufferIndirect(
 	FRDGBufferRef Counter, 
 	uint32 CounterOffset, 
 	uint32 KeyMask, 
-	ERHIFeatureLevel::Type FeatureLevel)
+	ERHIFeatureLevel::Type FeatureLevel,
+	uint32 MaxElementCount)
 {
 	check(InKeyBuffers.Num() >= 2); // Only element 0 and 1 will ever be used, but it's not invalid to have a larger array
 	check(InKeyBuffers[0] && InKeyBuffers[1]);
@@ -210,7 +212,8 @@ uint32 HVPT::Private::SortBufferIndirect(
 		Counter,
 		CounterOffset,
 		KeyMask,
-		FeatureLevel
+		FeatureLevel,
+		MaxElementCount
 	);
 }
 
@@ -224,7 +227,8 @@ uint32 HVPT::Private::SortBufferIndirect(
 	FRDGBufferRef Counter, 
 	uint32 CounterOffset, 
 	uint32 KeyMask, 
-	ERHIFeatureLevel::Type FeatureLevel
+	ERHIFeatureLevel::Type FeatureLevel,
+	uint32 MaxElementCount
 )
 {
 	check(BufferIndex >= 0 && BufferIndex < 2);
@@ -262,6 +266,7 @@ uint32 HVPT::Private::SortBufferIndirect(
 	{
 		FHVPT_RadixSortPopulateParametersCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_RadixSortPopulateParametersCS::FParameters>();
 		PassParameters->Counter = GraphBuilder.CreateSRV(FRDGBufferSRVDesc{ Counter, static_cast<uint32>(CounterOffset * sizeof(uint32)), 1 });
+		PassParameters->MaxKeyCount = MaxElementCount;
 		PassParameters->RWRadixSortParameterBuffer = GraphBuilder.CreateUAV(ParameterBuffer);
 		PassParameters->RWIndirectArgs = GraphBuilder.CreateUAV(IndirectArgs);
 
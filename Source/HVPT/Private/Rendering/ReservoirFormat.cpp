@@ -0,0 +1,19 @@
+#include "ReservoirFormat.h"
+
+
+static_assert(sizeof(FHVPT_Reservoir) == 28, "FHVPT_Reservoir must match the layout of the shader struct");
+static_assert(sizeof(FHVPT_CompactReservoir) == 20, "FHVPT_CompactReservoir must match the layout of the shader struct");
+
+bool HVPT::Private::ValidateCompactReservoirRoundTrip(const FHVPT_Reservoir& Reservoir)
+{
+	const FHVPT_Reservoir Decoded = UE::HLSL::HVPT_UnpackCompactReservoir(UE::HLSL::HVPT_PackCompactReservoir(Reservoir));
+
+	// Packed data is copied untouched, and the light sample is only ever read as random numbers in [0, 1)
+	bool bValid = Decoded.PackedData == Reservoir.PackedData;
+	bValid &= FMath::Abs(Decoded.RunningSum - Reservoir.RunningSum) <= Reservoir.RunningSum * HVPT_COMPACT_RESERVOIR_WEIGHT_MAX_RELATIVE_ERROR;
+	bValid &= FMath::Abs(Decoded.P_y - Reservoir.P_y) <= Reservoir.P_y * HVPT_COMPACT_RESERVOIR_WEIGHT_MAX_RELATIVE_ERROR;
+	bValid &= FMath::Abs(Decoded.M - Reservoir.M) <= Reservoir.M * HVPT_COMPACT_RESERVOIR_M_MAX_RELATIVE_ERROR;
+	bValid &= FMath::Abs(Decoded.LightSample.X - Reservoir.LightSample.X) <= HVPT_COMPACT_RESERVOIR_LIGHT_SAMPLE_MAX_ERROR;
+	bValid &= FMath::Abs(Decoded.LightSample.Y - Reservoir.LightSample.Y) <= HVPT_COMPACT_RESERVOIR_LIGHT_SAMPLE_MAX_ERROR;
+	return bValid;
+}
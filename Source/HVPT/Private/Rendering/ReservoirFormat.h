@@ -0,0 +1,15 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HVPTDefinitions.h"
+
+
+namespace HVPT::Private
+{
+
+// The packing helpers of FHVPT_CompactReservoir in HVPTDefinitions.h are shared with the shaders, so the CPU encodes exactly as the GPU does
+
+// Checks that every member of Reservoir survives a round trip through FHVPT_CompactReservoir within the error bounds of its encoding
+bool ValidateCompactReservoirRoundTrip(const FHVPT_Reservoir& Reservoir);
+
+}
@@ -1,15 +1,30 @@
 #include "VoxelGrid.h"
 
 #include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
 #include "SceneRendering.h"
 #include "SystemTextures.h"
+#include "RenderUtils.h"
 
+#include "MajorantPyramid.h"
+#include "GridDataFormat.h"
+#include "VoxelGridStats.h"
+
+#include "HVPTSceneState.h"
 #include "HVPTViewState.h"
 
 IMPLEMENT_UNIFORM_BUFFER_STRUCT(FHVPTOrthoGridUniformBufferParameters, "HVPT_OrthoGrid")
 IMPLEMENT_UNIFORM_BUFFER_STRUCT(FHVPTFrustumGridUniformBufferParameters, "HVPT_FrustumGrid")
 
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Degradation Level"), STAT_HVPTOrthoGridDegradationLevel, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Degraded Cells"), STAT_HVPTOrthoGridDegradedCells, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Brick Demand"), STAT_HVPTOrthoGridBrickDemand, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Overflowed Bricks"), STAT_HVPTOrthoGridOverflowBricks, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Overflow Events"), STAT_HVPTOrthoGridOverflowEvents, STATGROUP_HVPT);
+
+
 //////////////////////////
 // --- FRUSTUM GRID --- //
 //////////////////////////
@@ -30,6 +45,9 @@ TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters> HVPT::CreateEmptyF
 		UniformBufferParameters->EmissionFroxelGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_GridData)));
 		UniformBufferParameters->ScatteringFroxelGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_GridData)));
 		UniformBufferParameters->VelocityFroxelGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_GridData)));
+		UniformBufferParameters->GridDataFormats = 0;
+		UniformBufferParameters->ShadingFroxelGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_ShadingGridData)));
+		UniformBufferParameters->bUseInterleavedShadingData = false;
 
 		UniformBufferParameters->TopLevelGridWorldBoundsMin = FVector3f(0);
 		UniformBufferParameters->TopLevelGridWorldBoundsMax = FVector3f(0);
@@ -39,6 +57,12 @@ TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters> HVPT::CreateEmptyF
 		UniformBufferParameters->NearPlaneDepth = 0.0;
 		UniformBufferParameters->FarPlaneDepth = 0.0;
 		UniformBufferParameters->TanHalfFOV = 1.0;
+
+		const FHVPTFrustumGridDepthSliceDistribution DepthSliceDistribution = FHVPTFrustumGridDepthSliceDistribution::MakeLinear();
+		for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+		{
+			UniformBufferParameters->DepthSliceDistribution[i] = DepthSliceDistribution.BinStarts[i];
+		}
 	}
 	return GraphBuilder.CreateUniformBuffer(UniformBufferParameters);
 }
@@ -73,6 +97,12 @@ void HVPT::ExtractFrustumVoxelGridUniformBuffer(
 	ParameterCache.NearPlaneDepth = Parameters->NearPlaneDepth;
 	ParameterCache.FarPlaneDepth = Parameters->FarPlaneDepth;
 	ParameterCache.TanHalfFOV = Parameters->TanHalfFOV;
+	for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+	{
+		ParameterCache.DepthSliceDistribution.BinStarts[i] = Parameters->DepthSliceDistribution[i];
+	}
+	ParameterCache.GridDataFormats = Parameters->GridDataFormats;
+	ParameterCache.bUseInterleavedShadingData = Parameters->bUseInterleavedShadingData;
 
 
 	ParameterCache.WorldToClip = Parameters->WorldToClip;
@@ -92,6 +122,7 @@ void HVPT::ExtractFrustumVoxelGridUniformBuffer(
 	GraphBuilder.QueueBufferExtraction(Parameters->EmissionFroxelGridBuffer->GetParent(), &ParameterCache.EmissionGridBuffer);
 	GraphBuilder.QueueBufferExtraction(Parameters->ScatteringFroxelGridBuffer->GetParent(), &ParameterCache.ScatteringGridBuffer);
 	GraphBuilder.QueueBufferExtraction(Parameters->VelocityFroxelGridBuffer->GetParent(), &ParameterCache.VelocityGridBuffer);
+	GraphBuilder.QueueBufferExtraction(Parameters->ShadingFroxelGridBuffer->GetParent(), &ParameterCache.ShadingGridBuffer);
 }
 
 void HVPT::RegisterExternalFrustumVoxelGridUniformBuffer(
@@ -117,6 +148,10 @@ void HVPT::RegisterExternalFrustumVoxelGridUniformBuffer(
 		Parameters->NearPlaneDepth = ParameterCache.NearPlaneDepth;
 		Parameters->FarPlaneDepth = ParameterCache.FarPlaneDepth;
 		Parameters->TanHalfFOV = ParameterCache.TanHalfFOV;
+		for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+		{
+			Parameters->DepthSliceDistribution[i] = ParameterCache.DepthSliceDistribution.BinStarts[i];
+		}
 
 		// Frustum assignment
 		for (int i = 0; i < 6; ++i)
@@ -129,12 +164,15 @@ void HVPT::RegisterExternalFrustumVoxelGridUniformBuffer(
 		Parameters->EmissionFroxelGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.EmissionGridBuffer));
 		Parameters->ScatteringFroxelGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.ScatteringGridBuffer));
 		Parameters->VelocityFroxelGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.VelocityGridBuffer));
+		Parameters->GridDataFormats = ParameterCache.GridDataFormats;
+		Parameters->ShadingFroxelGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.ShadingGridBuffer));
+		Parameters->bUseInterleavedShadingData = ParameterCache.bUseInterleavedShadingData;
 	}
 	FrustumGridUniformBuffer = GraphBuilder.CreateUniformBuffer(Parameters);
 }
 
 void HVPT::BuildFrustumVoxelGrid(
-	FRDGBuilder& GraphBuilder, const FScene* Scene, const FViewInfo& View, const FHVPT_VoxelGridBuildOptions& BuildOptions, TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters>& FrustumGridUniformBuffer
+	FRDGBuilder& GraphBuilder, const FScene* Scene, const FViewInfo& View, const FHVPT_VoxelGridBuildOptions& BuildOptions, FHVPTBrickPool& BrickPool, TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters>& FrustumGridUniformBuffer
 )
 {
 	if (!HVPT::ShouldRenderHVPTForView(View) || !HVPT::EnableFrustumGrid() || !BuildOptions.bBuildFrustumGrid)
@@ -161,13 +199,15 @@ void HVPT::BuildFrustumVoxelGrid(
 	HVPT::Private::ClipNearFarDistances(View, TopLevelGridBounds, NearPlaneDistance, FarPlaneDistance);
 
 	FIntVector TopLevelGridResolution;
+	FHVPTFrustumGridDepthSliceDistribution DepthSliceDistribution;
 	HVPT::Private::CalculateTopLevelGridResolutionForFrustumGrid(
 		View,
 		BuildOptions,
 		MinimumVoxelSize,
 		NearPlaneDistance,
 		FarPlaneDistance,
-		TopLevelGridResolution
+		TopLevelGridResolution,
+		DepthSliceDistribution
 	);
 
 	// Construct top-level grid over global bounding domain with some pre-determined resolution
@@ -189,8 +229,10 @@ void HVPT::BuildFrustumVoxelGrid(
 		TopLevelGridResolution,
 		NearPlaneDistance,
 		FarPlaneDistance,
+		DepthSliceDistribution,
 		ViewToWorld,
-		TopLevelGridBuffer
+		TopLevelGridBuffer,
+		BuildOptions.ComputePassFlags
 	);
 
 	// Generate raster tiles of approximately equal work
@@ -204,13 +246,43 @@ void HVPT::BuildFrustumVoxelGrid(
 		TopLevelGridBuffer,
 		// Tile data
 		RasterTileBuffer,
-		RasterTileAllocatorBuffer
+		RasterTileAllocatorBuffer,
+		BuildOptions.ComputePassFlags
 	);
 
+	// The frustum grid is rebuilt from scratch each time, so every brick in the pool is free again
+	// Cells of the frustum grid are always marked with a resolution of 4, so every brick fills a whole slab and none need reserving
+	const int32 VoxelsPerBrick = 4 * 4 * 4;
+	const uint32 GridDataFormats = HVPT::Private::GetGridDataFormats(HVPT::Private::ShouldUseMonochromeExtinction(View));
+	const bool bInterleavedShadingData = HVPT::UseInterleavedShadingData();
+	const int32 BrickCapacity = HVPT::Private::CalcBrickCapacity(HVPT::GetMaxBottomLevelMemoryInMegabytesForFrustumGrid(), VoxelsPerBrick, GridDataFormats, bInterleavedShadingData);
+
 	FRDGBufferRef ExtinctionGridBuffer;
 	FRDGBufferRef EmissionGridBuffer;
 	FRDGBufferRef ScatteringGridBuffer;
 	FRDGBufferRef VelocityGridBuffer;
+	FRDGBufferRef ShadingGridBuffer;
+	FRDGBufferRef BrickFreeListBuffer;
+	HVPT::Private::SetupBrickPool(
+		GraphBuilder,
+		Scene,
+		BrickPool,
+		BrickCapacity,
+		VoxelsPerBrick,
+		GridDataFormats,
+		bInterleavedShadingData,
+		true,
+		ExtinctionGridBuffer,
+		EmissionGridBuffer,
+		ScatteringGridBuffer,
+		VelocityGridBuffer,
+		ShadingGridBuffer,
+		BrickFreeListBuffer,
+		BuildOptions.ComputePassFlags
+	);
+	HVPT::SetShadingDataMemoryStats(false, BrickCapacity * VoxelsPerBrick, GridDataFormats, bInterleavedShadingData);
+	FRDGBufferRef BrickOverflowCountBuffer = HVPT::Private::CreateBrickOverflowCountBuffer(GraphBuilder, BuildOptions.ComputePassFlags);
+
 	HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 		GraphBuilder,
 		Scene,
@@ -219,6 +291,7 @@ void HVPT::BuildFrustumVoxelGrid(
 		ViewToWorld,
 		NearPlaneDistance,
 		FarPlaneDistance,
+		DepthSliceDistribution,
 		// Raster tile
 		RasterTileBuffer,
 		RasterTileAllocatorBuffer,
@@ -229,9 +302,29 @@ void HVPT::BuildFrustumVoxelGrid(
 		ExtinctionGridBuffer,
 		EmissionGridBuffer,
 		ScatteringGridBuffer,
-		VelocityGridBuffer
+		VelocityGridBuffer,
+		BrickFreeListBuffer,
+		BrickOverflowCountBuffer,
+		GridDataFormats
 	);
 
+	if (bInterleavedShadingData)
+	{
+		HVPT::Private::InterleaveShadingGridData(
+			GraphBuilder,
+			Scene,
+			RasterTileBuffer,
+			RasterTileAllocatorBuffer,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			GridDataFormats,
+			ShadingGridBuffer,
+			BuildOptions.ComputePassFlags
+		);
+	}
+
 	// Create Voxel Grid uniform buffer
 	FHVPTFrustumGridUniformBufferParameters* UniformBufferParameters = GraphBuilder.AllocParameters<FHVPTFrustumGridUniformBufferParameters>();
 	{
@@ -263,6 +356,10 @@ void HVPT::BuildFrustumVoxelGrid(
 		UniformBufferParameters->NearPlaneDepth = NearPlaneDistance;
 		UniformBufferParameters->FarPlaneDepth = FarPlaneDistance;
 		UniformBufferParameters->TanHalfFOV = Private::CalcTanHalfFOV(View.FOV);
+		for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+		{
+			UniformBufferParameters->DepthSliceDistribution[i] = DepthSliceDistribution.BinStarts[i];
+		}
 
 		// Frustum assignment
 		{
@@ -297,15 +394,194 @@ void HVPT::BuildFrustumVoxelGrid(
 		UniformBufferParameters->EmissionFroxelGridBuffer = GraphBuilder.CreateSRV(EmissionGridBuffer);
 		UniformBufferParameters->ScatteringFroxelGridBuffer = GraphBuilder.CreateSRV(ScatteringGridBuffer);
 		UniformBufferParameters->VelocityFroxelGridBuffer = GraphBuilder.CreateSRV(VelocityGridBuffer);
+		UniformBufferParameters->GridDataFormats = GridDataFormats;
+		UniformBufferParameters->ShadingFroxelGridBuffer = GraphBuilder.CreateSRV(ShadingGridBuffer);
+		UniformBufferParameters->bUseInterleavedShadingData = bInterleavedShadingData;
 	}
 
 	FrustumGridUniformBuffer = GraphBuilder.CreateUniformBuffer(UniformBufferParameters);
 }
 
+bool HVPT::ShouldRebuildFrustumVoxelGrid(const FViewInfo& View, bool bHasCachedGrid, FHVPTFrustumGridRebuildState& RebuildState)
+{
+	// Collect the timing of the last rebuild once the GPU has got to it
+	if (RebuildState.BeginTimestampQuery.IsValid() && RebuildState.EndTimestampQuery.IsValid())
+	{
+		uint64 BeginMicroseconds = 0;
+		uint64 EndMicroseconds = 0;
+		if (RHIGetRenderQueryResult(RebuildState.BeginTimestampQuery.GetQuery(), BeginMicroseconds, false)
+			&& RHIGetRenderQueryResult(RebuildState.EndTimestampQuery.GetQuery(), EndMicroseconds, false))
+		{
+			RebuildState.RebuildMilliseconds = EndMicroseconds > BeginMicroseconds ? (EndMicroseconds - BeginMicroseconds) / 1000.0f : 0.0f;
+			RebuildState.BeginTimestampQuery.ReleaseQuery();
+			RebuildState.EndTimestampQuery.ReleaseQuery();
+		}
+	}
+
+	// Rebuilding every N frames amortizes the cost of a rebuild to 1/N of it per frame
+	// so the interval is stretched until that fits within the budget
+	int32 RebuildInterval = HVPT::GetRebuildIntervalForFrustumGrid();
+	const float RebuildBudget = HVPT::GetRebuildBudgetMillisecondsForFrustumGrid();
+	if (RebuildBudget > 0.0f && RebuildState.RebuildMilliseconds > 0.0f)
+	{
+		RebuildInterval = FMath::Max(RebuildInterval, FMath::CeilToInt(RebuildState.RebuildMilliseconds / RebuildBudget));
+	}
+	RebuildInterval = FMath::Min(RebuildInterval, HVPT::GetMaxRebuildIntervalForFrustumGrid());
+
+	// A camera cut would leave the cached grid covering somewhere else entirely
+	RebuildState.FramesSinceRebuild++;
+	if (!bHasCachedGrid || View.bCameraCut || RebuildState.FramesSinceRebuild >= RebuildInterval)
+	{
+		RebuildState.FramesSinceRebuild = 0;
+		return true;
+	}
+	return false;
+}
+
+void HVPT::BeginFrustumVoxelGridRebuildTiming(FRDGBuilder& GraphBuilder, const FHVPT_VoxelGridBuildOptions& BuildOptions, FHVPTFrustumGridRebuildState& RebuildState)
+{
+	// Timestamps are written on the graphics pipe, so they do not bracket a build on async compute
+	// The last measurement is kept in that case, and until the previous one has been collected
+	if (!GSupportsTimestampRenderQueries
+		|| EnumHasAnyFlags(BuildOptions.ComputePassFlags, ERDGPassFlags::AsyncCompute)
+		|| RebuildState.BeginTimestampQuery.IsValid())
+	{
+		return;
+	}
+
+	if (!RebuildState.TimestampQueryPool)
+	{
+		RebuildState.TimestampQueryPool = RHICreateRenderQueryPool(RQT_AbsoluteTime);
+	}
+	RebuildState.BeginTimestampQuery = RebuildState.TimestampQueryPool->AllocateQuery();
+
+	FRHIRenderQuery* Query = RebuildState.BeginTimestampQuery.GetQuery();
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("BeginFrustumGridRebuildTiming"),
+		ERDGPassFlags::NeverCull,
+		[Query](FRHICommandListImmediate& RHICmdList)
+		{
+			RHICmdList.EndRenderQuery(Query);
+		}
+	);
+}
+
+void HVPT::EndFrustumVoxelGridRebuildTiming(FRDGBuilder& GraphBuilder, FHVPTFrustumGridRebuildState& RebuildState)
+{
+	if (!RebuildState.BeginTimestampQuery.IsValid() || RebuildState.EndTimestampQuery.IsValid())
+	{
+		return;
+	}
+
+	RebuildState.EndTimestampQuery = RebuildState.TimestampQueryPool->AllocateQuery();
+
+	FRHIRenderQuery* Query = RebuildState.EndTimestampQuery.GetQuery();
+	GraphBuilder.AddPass(
+		RDG_EVENT_NAME("EndFrustumGridRebuildTiming"),
+		ERDGPassFlags::NeverCull,
+		[Query](FRHICommandListImmediate& RHICmdList)
+		{
+			RHICmdList.EndRenderQuery(Query);
+		}
+	);
+}
+
 ///////////////////////
 // --- ORTHO GRID--- //
 ///////////////////////
 
+void HVPT::Private::SetMajorantPyramidParameters(FHVPTOrthoGridUniformBufferParameters& Parameters, const FIntVector& TopLevelGridResolution, int32 MajorantMipCount)
+{
+	Parameters.MajorantMipCount = MajorantMipCount;
+	for (int32 MipLevel = 0; MipLevel < HVPT_MAX_MAJORANT_MIP_COUNT; ++MipLevel)
+	{
+		Parameters.MajorantMipOffsets[MipLevel / 4][MipLevel % 4] = (MipLevel < MajorantMipCount) ? HVPT::Private::CalcMajorantMipOffset(TopLevelGridResolution, MipLevel) : 0;
+	}
+	Parameters.MajorantLeapThreshold = HVPT::GetMajorantLeapThresholdForOrthoGrid();
+}
+
+void HVPT::Private::SetDirectVolumeParameters(FHVPTOrthoGridUniformBufferParameters& Parameters, TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes)
+{
+	static_assert(HVPT_MAX_DIRECT_VOLUME_TEXTURES == 4, "The uniform buffer declares one set of textures per direct volume texture slot");
+	static_assert(HVPT_MAX_DIRECT_VOLUMES % 4 == 0, "Texture slots of direct volumes are packed four to an element");
+	check(DirectVolumes.Num() <= HVPT_MAX_DIRECT_VOLUMES);
+
+	FRHITexture* PageTables[HVPT_MAX_DIRECT_VOLUME_TEXTURES];
+	FRHITexture* PhysicalTileDataA[HVPT_MAX_DIRECT_VOLUME_TEXTURES];
+	FRHITexture* PhysicalTileDataB[HVPT_MAX_DIRECT_VOLUME_TEXTURES];
+
+	// Unused texture slots are never sampled, as no volume refers to them
+	for (int32 TextureSlot = 0; TextureSlot < HVPT_MAX_DIRECT_VOLUME_TEXTURES; ++TextureSlot)
+	{
+		Parameters.DirectVolumePackedUniforms0[TextureSlot] = FUintVector4(0);
+		Parameters.DirectVolumePackedUniforms1[TextureSlot] = FUintVector4(0);
+
+		PageTables[TextureSlot] = GBlackUintVolumeTexture->TextureRHI;
+		PhysicalTileDataA[TextureSlot] = GBlackVolumeTexture->TextureRHI;
+		PhysicalTileDataB[TextureSlot] = GBlackVolumeTexture->TextureRHI;
+	}
+
+	Parameters.NumDirectVolumes = DirectVolumes.Num();
+	for (int32 Slot = 0; Slot < HVPT_MAX_DIRECT_VOLUMES; ++Slot)
+	{
+		if (Slot < DirectVolumes.Num())
+		{
+			const FHVPTOrthoGridDirectVolume& DirectVolume = DirectVolumes[Slot];
+			Parameters.DirectVolumeWorldToUVW[Slot] = DirectVolume.WorldToUVW;
+			Parameters.DirectVolumeScattering[Slot] = FVector4f(DirectVolume.Albedo.R, DirectVolume.Albedo.G, DirectVolume.Albedo.B, DirectVolume.ExtinctionScale);
+			Parameters.DirectVolumeEmission[Slot] = FVector4f(DirectVolume.EmissionScale, DirectVolume.MaxDensity, 0.0f, 0.0f);
+
+			const int32 TextureSlot = DirectVolume.TextureSlot;
+			check(TextureSlot >= 0 && TextureSlot < HVPT_MAX_DIRECT_VOLUME_TEXTURES);
+			Parameters.DirectVolumeTextureSlots[Slot / 4][Slot % 4] = TextureSlot;
+
+			// Every instance sharing the slot has the same textures, so the last one to write them is as good as any
+			Parameters.DirectVolumePackedUniforms0[TextureSlot] = DirectVolume.PackedUniforms0;
+			Parameters.DirectVolumePackedUniforms1[TextureSlot] = DirectVolume.PackedUniforms1;
+			PageTables[TextureSlot] = DirectVolume.PageTableTexture;
+			PhysicalTileDataA[TextureSlot] = DirectVolume.PhysicalTileDataATexture;
+			PhysicalTileDataB[TextureSlot] = DirectVolume.PhysicalTileDataBTexture;
+		}
+		else
+		{
+			Parameters.DirectVolumeWorldToUVW[Slot] = FMatrix44f::Identity;
+			Parameters.DirectVolumeScattering[Slot] = FVector4f(0.0f);
+			Parameters.DirectVolumeEmission[Slot] = FVector4f(0.0f);
+			Parameters.DirectVolumeTextureSlots[Slot / 4][Slot % 4] = 0;
+		}
+	}
+
+	Parameters.DirectVolumePageTable0 = PageTables[0];
+	Parameters.DirectVolumePageTable1 = PageTables[1];
+	Parameters.DirectVolumePageTable2 = PageTables[2];
+	Parameters.DirectVolumePageTable3 = PageTables[3];
+	Parameters.DirectVolumePhysicalTileDataA0 = PhysicalTileDataA[0];
+	Parameters.DirectVolumePhysicalTileDataA1 = PhysicalTileDataA[1];
+	Parameters.DirectVolumePhysicalTileDataA2 = PhysicalTileDataA[2];
+	Parameters.DirectVolumePhysicalTileDataA3 = PhysicalTileDataA[3];
+	Parameters.DirectVolumePhysicalTileDataB0 = PhysicalTileDataB[0];
+	Parameters.DirectVolumePhysicalTileDataB1 = PhysicalTileDataB[1];
+	Parameters.DirectVolumePhysicalTileDataB2 = PhysicalTileDataB[2];
+	Parameters.DirectVolumePhysicalTileDataB3 = PhysicalTileDataB[3];
+	Parameters.DirectVolumeSampler = TStaticSamplerState<SF_Point>::GetRHI();
+}
+
+void HVPT::Private::SetInstancedVolumeParameters(
+	FRDGBuilder& GraphBuilder,
+	FHVPTOrthoGridUniformBufferParameters& Parameters,
+	int32 NumInstancedVolumes,
+	FRDGBufferRef InstancedVolumeBuffer,
+	FRDGBufferRef InstancedVolumeCellBuffer
+)
+{
+	check(NumInstancedVolumes <= HVPT_MAX_INSTANCED_VOLUMES);
+
+	const bool bHasInstancedVolumes = NumInstancedVolumes > 0 && InstancedVolumeBuffer && InstancedVolumeCellBuffer;
+	Parameters.NumInstancedVolumes = bHasInstancedVolumes ? NumInstancedVolumes : 0;
+	Parameters.InstancedVolumeBuffer = GraphBuilder.CreateSRV(bHasInstancedVolumes ? InstancedVolumeBuffer : GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_InstancedVolumeData)));
+	Parameters.InstancedVolumeCellBuffer = GraphBuilder.CreateSRV(bHasInstancedVolumes ? InstancedVolumeCellBuffer : GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_TopLevelGridData)));
+}
+
 TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> HVPT::CreateEmptyOrthoVoxelGridUniformBuffer(FRDGBuilder& GraphBuilder)
 {
 	FHVPTOrthoGridUniformBufferParameters* OrthoGridUniformBufferParameters = GraphBuilder.AllocParameters<FHVPTOrthoGridUniformBufferParameters>();
@@ -319,24 +595,41 @@ TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> HVPT::CreateEmptyOrt
 		OrthoGridUniformBufferParameters->EmissionGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_GridData)));
 		OrthoGridUniformBufferParameters->ScatteringGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_GridData)));
 		OrthoGridUniformBufferParameters->VelocityGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_GridData)));
+		OrthoGridUniformBufferParameters->GridDataFormats = 0;
+		OrthoGridUniformBufferParameters->ShadingGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_ShadingGridData)));
+		OrthoGridUniformBufferParameters->bUseInterleavedShadingData = false;
 
 		OrthoGridUniformBufferParameters->bUseOrthoGrid = false;
 		OrthoGridUniformBufferParameters->MajorantGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_MajorantGridData)));
+		HVPT::Private::SetMajorantPyramidParameters(*OrthoGridUniformBufferParameters, FIntVector(0), 1);
+		HVPT::Private::SetDirectVolumeParameters(*OrthoGridUniformBufferParameters, {});
+		HVPT::Private::SetInstancedVolumeParameters(GraphBuilder, *OrthoGridUniformBufferParameters, 0, nullptr, nullptr);
+
+		OrthoGridUniformBufferParameters->SubBrickMajorantGridBuffer = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_MajorantGridData)));
+		OrthoGridUniformBufferParameters->bUseSubBrickMajorants = false;
+		OrthoGridUniformBufferParameters->bUseTrilinearFiltering = false;
+		OrthoGridUniformBufferParameters->VoxelsPerBrick = 1;
+		OrthoGridUniformBufferParameters->SubBricksPerBrick = 1;
 	}
 	return GraphBuilder.CreateUniformBuffer(OrthoGridUniformBufferParameters);
 }
 
-TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> HVPT::GetOrthoVoxelGridUniformBuffer(FRDGBuilder& GraphBuilder, FHVPTViewState& ViewState)
+TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> HVPT::GetOrthoVoxelGridUniformBuffer(FRDGBuilder& GraphBuilder, const FViewInfo& View, FHVPTSceneState& SceneState)
 {
-	if (ViewState.OrthoGridUniformBuffer)
+	const bool bCreatedByThisViewFamily = SceneState.OrthoGridUniformBufferViewFamily == View.Family && SceneState.OrthoGridUniformBufferFrameNumber == View.Family->FrameNumber;
+	if (SceneState.OrthoGridUniformBuffer && bCreatedByThisViewFamily)
 	{
-		return ViewState.OrthoGridUniformBuffer;
+		return SceneState.OrthoGridUniformBuffer;
 	}
 
-	if (ViewState.OrthoGridParameterCache.TopLevelGridBuffer)
+	if (SceneState.OrthoGridParameterCache.TopLevelGridBuffer)
 	{
-		RegisterExternalOrthoVoxelGridUniformBuffer(GraphBuilder, ViewState.OrthoGridParameterCache, ViewState.OrthoGridUniformBuffer);
-		return ViewState.OrthoGridUniformBuffer;
+		RegisterExternalOrthoVoxelGridUniformBuffer(GraphBuilder, SceneState.OrthoGridParameterCache, SceneState.OrthoGridUniformBuffer);
+
+		// Let the other views of this family share the registration
+		SceneState.OrthoGridUniformBufferViewFamily = View.Family;
+		SceneState.OrthoGridUniformBufferFrameNumber = View.Family->FrameNumber;
+		return SceneState.OrthoGridUniformBuffer;
 	}
 
 	return nullptr;
@@ -352,6 +645,13 @@ void HVPT::ExtractOrthoVoxelGridUniformBuffer(
 	ParameterCache.TopLevelGridWorldBoundsMax = Parameters->TopLevelGridWorldBoundsMax;
 	ParameterCache.TopLevelGridResolution = Parameters->TopLevelGridResolution;
 	ParameterCache.bUseOrthoGrid = Parameters->bUseOrthoGrid;
+	ParameterCache.MajorantMipCount = Parameters->MajorantMipCount;
+	ParameterCache.bUseSubBrickMajorants = Parameters->bUseSubBrickMajorants;
+	ParameterCache.bUseTrilinearFiltering = Parameters->bUseTrilinearFiltering;
+	ParameterCache.VoxelsPerBrick = Parameters->VoxelsPerBrick;
+	ParameterCache.SubBricksPerBrick = Parameters->SubBricksPerBrick;
+	ParameterCache.GridDataFormats = Parameters->GridDataFormats;
+	ParameterCache.bUseInterleavedShadingData = Parameters->bUseInterleavedShadingData;
 
 	GraphBuilder.QueueBufferExtraction(Parameters->TopLevelGridBuffer->GetParent(), &ParameterCache.TopLevelGridBuffer);
 
@@ -359,7 +659,22 @@ void HVPT::ExtractOrthoVoxelGridUniformBuffer(
 	GraphBuilder.QueueBufferExtraction(Parameters->EmissionGridBuffer->GetParent(), &ParameterCache.EmissionGridBuffer);
 	GraphBuilder.QueueBufferExtraction(Parameters->ScatteringGridBuffer->GetParent(), &ParameterCache.ScatteringGridBuffer);
 	GraphBuilder.QueueBufferExtraction(Parameters->VelocityGridBuffer->GetParent(), &ParameterCache.VelocityGridBuffer);
+	GraphBuilder.QueueBufferExtraction(Parameters->ShadingGridBuffer->GetParent(), &ParameterCache.ShadingGridBuffer);
 	GraphBuilder.QueueBufferExtraction(Parameters->MajorantGridBuffer->GetParent(), &ParameterCache.MajorantGridBuffer);
+	GraphBuilder.QueueBufferExtraction(Parameters->SubBrickMajorantGridBuffer->GetParent(), &ParameterCache.SubBrickMajorantGridBuffer);
+
+	// Without instanced volumes the buffers are the shared defaults, which are not kept
+	ParameterCache.NumInstancedVolumes = Parameters->NumInstancedVolumes;
+	if (Parameters->NumInstancedVolumes > 0)
+	{
+		GraphBuilder.QueueBufferExtraction(Parameters->InstancedVolumeBuffer->GetParent(), &ParameterCache.InstancedVolumeBuffer);
+		GraphBuilder.QueueBufferExtraction(Parameters->InstancedVolumeCellBuffer->GetParent(), &ParameterCache.InstancedVolumeCellBuffer);
+	}
+	else
+	{
+		ParameterCache.InstancedVolumeBuffer = nullptr;
+		ParameterCache.InstancedVolumeCellBuffer = nullptr;
+	}
 }
 
 void HVPT::RegisterExternalOrthoVoxelGridUniformBuffer(
@@ -379,48 +694,165 @@ void HVPT::RegisterExternalOrthoVoxelGridUniformBuffer(
 		UniformBufferParameters->EmissionGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.EmissionGridBuffer));
 		UniformBufferParameters->ScatteringGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.ScatteringGridBuffer));
 		UniformBufferParameters->VelocityGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.VelocityGridBuffer));
+		UniformBufferParameters->GridDataFormats = ParameterCache.GridDataFormats;
+		UniformBufferParameters->ShadingGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.ShadingGridBuffer));
+		UniformBufferParameters->bUseInterleavedShadingData = ParameterCache.bUseInterleavedShadingData;
 		UniformBufferParameters->MajorantGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.MajorantGridBuffer));
+		HVPT::Private::SetMajorantPyramidParameters(*UniformBufferParameters, ParameterCache.TopLevelGridResolution, ParameterCache.MajorantMipCount);
+		HVPT::Private::SetDirectVolumeParameters(*UniformBufferParameters, ParameterCache.DirectVolumes);
+		HVPT::Private::SetInstancedVolumeParameters(
+			GraphBuilder,
+			*UniformBufferParameters,
+			ParameterCache.NumInstancedVolumes,
+			ParameterCache.InstancedVolumeBuffer ? GraphBuilder.RegisterExternalBuffer(ParameterCache.InstancedVolumeBuffer) : nullptr,
+			ParameterCache.InstancedVolumeCellBuffer ? GraphBuilder.RegisterExternalBuffer(ParameterCache.InstancedVolumeCellBuffer) : nullptr
+		);
+
+		UniformBufferParameters->SubBrickMajorantGridBuffer = GraphBuilder.CreateSRV(GraphBuilder.RegisterExternalBuffer(ParameterCache.SubBrickMajorantGridBuffer));
+		UniformBufferParameters->bUseSubBrickMajorants = ParameterCache.bUseSubBrickMajorants;
+		UniformBufferParameters->bUseTrilinearFiltering = ParameterCache.bUseTrilinearFiltering;
+		UniformBufferParameters->VoxelsPerBrick = ParameterCache.VoxelsPerBrick;
+		UniformBufferParameters->SubBricksPerBrick = ParameterCache.SubBricksPerBrick;
 	}
 	OrthoGridUniformBuffer = GraphBuilder.CreateUniformBuffer(UniformBufferParameters);
 }
 
+float HVPT::CalcOrthoGridMinimumVoxelSize(const FViewInfo& View, const FHVPT_VoxelGridBuildOptions& BuildOptions)
+{
+	TSet<FVolumetricMeshBatch> HeterogeneousVolumesMeshBatches;
+	HVPT::Private::CollectHeterogeneousVolumeMeshBatches(View, HeterogeneousVolumesMeshBatches);
+
+	FBoxSphereBounds::Builder BoundsBuilder;
+	float MinimumVoxelSize;
+	HVPT::Private::CalcGlobalBoundsAndMinimumVoxelSize(View, HeterogeneousVolumesMeshBatches, BuildOptions, BoundsBuilder, MinimumVoxelSize);
+
+	return MinimumVoxelSize;
+}
+
+void HVPT::UpdateOrthoVoxelGridAllocationStats(FHVPTOrthoGridAllocationState& AllocationState)
+{
+	if (AllocationState.bReadbackPending && AllocationState.DegradationStatsReadback->IsReady() && AllocationState.OverflowBrickCountReadback->IsReady())
+	{
+		const uint32* DegradationStats = static_cast<const uint32*>(AllocationState.DegradationStatsReadback->Lock(HVPT_BRICK_DEGRADATION_STATS_SIZE * sizeof(uint32)));
+		const int32 DegradationLevel = static_cast<int32>(DegradationStats[HVPT_BRICK_DEGRADATION_STATS_LEVEL]);
+		AllocationState.DegradedCellCount = static_cast<int32>(DegradationStats[HVPT_BRICK_DEGRADATION_STATS_CELLS]);
+		AllocationState.BrickDemand = static_cast<int32>(DegradationStats[HVPT_BRICK_DEGRADATION_STATS_DEMAND]);
+		const int32 MissingSlabCount = static_cast<int32>(DegradationStats[HVPT_BRICK_DEGRADATION_STATS_MISSING]);
+		AllocationState.DegradationStatsReadback->Unlock();
+		const uint32 OverflowBrickCount = *static_cast<const uint32*>(AllocationState.OverflowBrickCountReadback->Lock(sizeof(uint32)));
+		AllocationState.OverflowBrickCountReadback->Unlock();
+		AllocationState.bReadbackPending = false;
+
+		if (DegradationLevel != AllocationState.DegradationLevel)
+		{
+			UE_LOG(LogHVPT, Log, TEXT("Ortho grid degradation level changed from %d to %d for a demand of %d slabs, %d cells were lowered in resolution"),
+				AllocationState.DegradationLevel, DegradationLevel, AllocationState.BrickDemand, AllocationState.DegradedCellCount);
+			AllocationState.DegradationLevel = DegradationLevel;
+		}
+
+		// The demand counts every marked cell, including those rasterization finds empty, so a build can be short of slabs and still not overflow
+		const bool bWasOverflowing = AllocationState.OverflowBrickCount > 0;
+		AllocationState.OverflowBrickCount = static_cast<int32>(OverflowBrickCount);
+		if (AllocationState.OverflowBrickCount > 0)
+		{
+			AllocationState.OverflowEventCount++;
+			INC_DWORD_STAT(STAT_HVPTOrthoGridOverflowEvents);
+
+			if (!bWasOverflowing)
+			{
+				UE_LOG(LogHVPT, Warning, TEXT("The ortho grid needs %d more slabs than fit in r.HVPT.OrthoGrid.MaxBottomLevelMemoryMegabytes after lowering its cells %d times. %d cells that did not fit are left empty."),
+					MissingSlabCount, AllocationState.DegradationLevel, AllocationState.OverflowBrickCount);
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_HVPTOrthoGridDegradationLevel, AllocationState.DegradationLevel);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridDegradedCells, AllocationState.DegradedCellCount);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridBrickDemand, AllocationState.BrickDemand);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridOverflowBricks, AllocationState.OverflowBrickCount);
+}
+
+void HVPT::QueueOrthoVoxelGridAllocationReadback(
+	FRDGBuilder& GraphBuilder, FRDGBufferRef BrickDegradationStatsBuffer, FRDGBufferRef BrickOverflowCountBuffer, FHVPTOrthoGridAllocationState& AllocationState
+)
+{
+	if (AllocationState.bReadbackPending)
+	{
+		return;
+	}
+
+	if (!AllocationState.DegradationStatsReadback.IsValid())
+	{
+		AllocationState.DegradationStatsReadback = MakeUnique<FRHIGPUBufferReadback>(TEXT("HVPT.OrthoGridDegradationStatsReadback"));
+		AllocationState.OverflowBrickCountReadback = MakeUnique<FRHIGPUBufferReadback>(TEXT("HVPT.OrthoGridOverflowBrickCountReadback"));
+	}
+
+	AddEnqueueCopyPass(GraphBuilder, AllocationState.DegradationStatsReadback.Get(), BrickDegradationStatsBuffer, HVPT_BRICK_DEGRADATION_STATS_SIZE * sizeof(uint32));
+	AddEnqueueCopyPass(GraphBuilder, AllocationState.OverflowBrickCountReadback.Get(), BrickOverflowCountBuffer, sizeof(uint32));
+
+	AllocationState.bReadbackPending = true;
+}
+
 void HVPT::BuildOrthoVoxelGrid(
-	FRDGBuilder& GraphBuilder, const FScene* Scene, const FViewInfo& View, const FHVPT_VoxelGridBuildOptions& BuildOptions, TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer
+	FRDGBuilder& GraphBuilder, const FScene* Scene, TConstArrayView<const FViewInfo*> Views, const FHVPT_VoxelGridBuildOptions& BuildOptions, FHVPTSceneState& SceneState, TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer
 )
 {
-	if (!HVPT::ShouldRenderHVPTForView(View) || !HVPT::EnableOrthoGrid() || !BuildOptions.bBuildOrthoGrid)
+	FHVPTOrthoGridParameterCache& ParameterCache = SceneState.OrthoGridParameterCache;
+	FHVPTBrickPool& BrickPool = SceneState.OrthoGridBrickPool;
+
+	if (Views.IsEmpty() || !HVPT::EnableOrthoGrid() || !BuildOptions.bBuildOrthoGrid)
 	{
+		ParameterCache.VolumeRecords.Reset();
+		ParameterCache.DirectVolumes.Reset();
 		OrthoGridUniformBuffer = CreateEmptyOrthoVoxelGridUniformBuffer(GraphBuilder);
 		return;
 	}
 
 	RDG_EVENT_SCOPE(GraphBuilder, "HVPT: Ortho Grid Build");
 
+	// Rasterization only reads view-independent inputs such as the material time from the view, so any view of the family can be used
+	const FViewInfo& View = *Views[0];
+
+	// A volume only needs to be in the grid if it is visible to at least one of the views
 	TSet<FVolumetricMeshBatch> HeterogeneousVolumesMeshBatches;
-	HVPT::Private::CollectHeterogeneousVolumeMeshBatches(
-		View,
-		HeterogeneousVolumesMeshBatches
-	);
+	for (const FViewInfo* BuildView : Views)
+	{
+		TSet<FVolumetricMeshBatch> ViewMeshBatches;
+		HVPT::Private::CollectHeterogeneousVolumeMeshBatches(
+			*BuildView,
+			ViewMeshBatches
+		);
+		HeterogeneousVolumesMeshBatches.Append(ViewMeshBatches);
+	}
 
 	if (HeterogeneousVolumesMeshBatches.IsEmpty())
 	{
+		ParameterCache.VolumeRecords.Reset();
+		ParameterCache.DirectVolumes.Reset();
 		OrthoGridUniformBuffer = CreateEmptyOrthoVoxelGridUniformBuffer(GraphBuilder);
 		return;
 	}
 
-	// Collect global bounds
+	// Collect global bounds, and the finest voxel size required by any view of the scene
 	FBoxSphereBounds::Builder TopLevelGridBoundsBuilder;
-	float GlobalMinimumVoxelSize;
-	HVPT::Private::CalcGlobalBoundsAndMinimumVoxelSize(
-		View,
-		HeterogeneousVolumesMeshBatches,
-		BuildOptions,
-		TopLevelGridBoundsBuilder,
-		GlobalMinimumVoxelSize
-	);
+	float GlobalMinimumVoxelSize = SceneState.PreviousFrameMinimumVoxelSize;
+	for (const FViewInfo* BuildView : Views)
+	{
+		float ViewMinimumVoxelSize;
+		HVPT::Private::CalcGlobalBoundsAndMinimumVoxelSize(
+			*BuildView,
+			HeterogeneousVolumesMeshBatches,
+			BuildOptions,
+			TopLevelGridBoundsBuilder,
+			ViewMinimumVoxelSize
+		);
+		GlobalMinimumVoxelSize = FMath::Min(GlobalMinimumVoxelSize, ViewMinimumVoxelSize);
+	}
 
 	if (!TopLevelGridBoundsBuilder.IsValid())
 	{
+		ParameterCache.VolumeRecords.Reset();
+		ParameterCache.DirectVolumes.Reset();
 		OrthoGridUniformBuffer = CreateEmptyOrthoVoxelGridUniformBuffer(GraphBuilder);
 		return;
 	}
@@ -434,28 +866,325 @@ void HVPT::BuildOrthoVoxelGrid(
 		TopLevelGridResolution
 	);
 
-	// Calculate the preferred voxel size for each bottom-level grid in a top-level cell
-	FRDGBufferRef TopLevelGridBuffer;
-	HVPT::Private::CalculateVoxelSize(
-		GraphBuilder,
+	// Isolated volumes are sampled from their sparse volume texture, and only the remaining volumes are rasterized
+	TArray<FHVPTOrthoGridDirectVolume> DirectVolumes;
+	TSet<FVolumetricMeshBatch> NonDirectMeshBatches;
+	HVPT::Private::CollectOrthoGridDirectVolumes(
 		View,
 		HeterogeneousVolumesMeshBatches,
-		BuildOptions,
 		TopLevelGridBounds,
 		TopLevelGridResolution,
-		TopLevelGridBuffer
+		DirectVolumes,
+		NonDirectMeshBatches
 	);
 
-	// Allocate bottom-level grid
-	HVPT::Private::MarkTopLevelGrid(
+	// Volumes shown by several instances are rasterized once into a shared local grid, and the rest are rasterized as usual
+	TArray<FHVPTOrthoGridInstancedAsset> InstancedAssets;
+	TArray<FHVPTOrthoGridInstancedVolume> InstancedVolumes;
+	TSet<FVolumetricMeshBatch> GridMeshBatches;
+	HVPT::Private::CollectOrthoGridInstancedVolumes(
+		View,
+		HeterogeneousVolumesMeshBatches,
+		NonDirectMeshBatches,
+		TopLevelGridBounds,
+		TopLevelGridResolution,
+		InstancedAssets,
+		InstancedVolumes,
+		GridMeshBatches
+	);
+
+	// Work out which parts of the previous grid (if any) can be kept
+	TMap<uint64, FHVPTOrthoGridVolumeRecord> VolumeRecords;
+	HVPT::Private::CollectOrthoGridVolumeRecords(View, HeterogeneousVolumesMeshBatches, VolumeRecords);
+
+	// Changing the extinction format changes the hash, so a volume losing its monochrome flag forces a full rebuild
+	const bool bMonochromeExtinction = HVPT::UseMonochromeExtinction() && HVPT::Private::AreAllVolumesMonochrome(View, HeterogeneousVolumesMeshBatches);
+	const uint32 GridDataFormats = HVPT::Private::GetGridDataFormats(bMonochromeExtinction);
+	const bool bInterleavedShadingData = HVPT::UseInterleavedShadingData();
+
+	FHVPTOrthoGridAllocationState& AllocationState = SceneState.OrthoGridAllocationState;
+	HVPT::UpdateOrthoVoxelGridAllocationStats(AllocationState);
+
+	const int32 BottomLevelGridResolution = HVPT::GetBottomLevelGridResolution();
+
+	const int32 VoxelsPerBrick = FMath::Cube(BottomLevelGridResolution);
+	const int32 BrickCapacity = HVPT::Private::CalcBrickCapacity(HVPT::GetMaxBottomLevelMemoryInMegabytesForOrthoGrid(), VoxelsPerBrick, GridDataFormats, bInterleavedShadingData);
+	const uint32 BuildSettingsHash = HVPT::Private::CalcOrthoGridBuildSettingsHash(BuildOptions, BottomLevelGridResolution, BrickCapacity, GridDataFormats, bInterleavedShadingData, DirectVolumes, InstancedVolumes);
+
+	TArray<FHVPTOrthoGridDirtyRegion> DirtyRegions;
+	bool bBuildIncrementally = !BuildOptions.bBuildIntoBackBuffers
+		&& HVPT::Private::CanBuildOrthoVoxelGridIncrementally(ParameterCache, BrickPool, TopLevelGridBounds, TopLevelGridResolution, BuildSettingsHash)
+		&& HVPT::Private::CalculateDirtyRegionsForOrthoGrid(ParameterCache.VolumeRecords, VolumeRecords, TopLevelGridBounds, TopLevelGridResolution, DirtyRegions);
+
+	// Reclaiming bricks only sees the bricks referenced by the top-level grid, so the bricks of the local grids would be handed out again
+	if (bBuildIncrementally && !DirtyRegions.IsEmpty() && !InstancedVolumes.IsEmpty())
+	{
+		bBuildIncrementally = false;
+	}
+
+	ParameterCache.VolumeRecords = MoveTemp(VolumeRecords);
+	ParameterCache.DirectVolumes = DirectVolumes;
+
+	if (bBuildIncrementally && DirtyRegions.IsEmpty())
+	{
+		// Nothing has changed, so the previous grid can be used as-is
+		ParameterCache.FramesSinceFullRebuild++;
+		RegisterExternalOrthoVoxelGridUniformBuffer(GraphBuilder, ParameterCache, OrthoGridUniformBuffer);
+		return;
+	}
+
+	FRDGBufferRef TopLevelGridBuffer;
+	FRDGBufferRef ExtinctionGridBuffer;
+	FRDGBufferRef EmissionGridBuffer;
+	FRDGBufferRef ScatteringGridBuffer;
+	FRDGBufferRef VelocityGridBuffer;
+	FRDGBufferRef ShadingGridBuffer;
+	FRDGBufferRef BrickFreeListBuffer;
+
+	// Only cells marked in this buffer will be rasterized into
+	FRDGBufferRef RasterTopLevelGridBuffer;
+	// Rank of each marked cell, for lowering the resolution of the least important cells when the pool is full
+	FRDGBufferRef CellPriorityBuffer;
+
+	TSet<FVolumetricMeshBatch> DirtyMeshBatches;
+	const TSet<FVolumetricMeshBatch>* RasterMeshBatches = &GridMeshBatches;
+
+	if (bBuildIncrementally)
+	{
+		RDG_EVENT_SCOPE(GraphBuilder, "Incremental Update");
+		ParameterCache.FramesSinceFullRebuild++;
+
+		TopLevelGridBuffer = GraphBuilder.RegisterExternalBuffer(ParameterCache.TopLevelGridBuffer);
+
+		// Keep the bricks of the previous build
+		HVPT::Private::SetupBrickPool(
+			GraphBuilder,
+			Scene,
+			BrickPool,
+			BrickCapacity,
+			VoxelsPerBrick,
+			GridDataFormats,
+			bInterleavedShadingData,
+			false,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			ShadingGridBuffer,
+			BrickFreeListBuffer,
+			BuildOptions.ComputePassFlags
+		);
+
+		// Every volume overlapping a dirty region contributes to the cells being rebuilt
+		HVPT::Private::CollectMeshBatchesIntersectingDirtyRegions(GridMeshBatches, DirtyRegions, DirtyMeshBatches);
+		RasterMeshBatches = &DirtyMeshBatches;
+
+		// Calculate voxel sizes for the whole grid from the volumes in the dirty regions only
+		FRDGBufferRef DirtyTopLevelGridBuffer;
+		HVPT::Private::CalculateVoxelSize(
+			GraphBuilder,
+			Views,
+			DirtyMeshBatches,
+			BuildOptions,
+			TopLevelGridBounds,
+			TopLevelGridResolution,
+			DirtyTopLevelGridBuffer
+		);
+
+		HVPT::Private::MarkTopLevelGrid(
+			GraphBuilder,
+			Scene,
+			TopLevelGridBounds,
+			TopLevelGridResolution,
+			BottomLevelGridResolution,
+			DirtyTopLevelGridBuffer,
+			CellPriorityBuffer,
+			BuildOptions.ComputePassFlags
+		);
+
+		// Copy the dirty cells into the cached grid, reusing bricks where the resolution is unchanged
+		HVPT::Private::MergeDirtyTopLevelGridCells(
+			GraphBuilder,
+			Scene,
+			TopLevelGridResolution,
+			DirtyRegions,
+			DirtyTopLevelGridBuffer,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			BrickFreeListBuffer,
+			GridDataFormats,
+			RasterTopLevelGridBuffer,
+			BuildOptions.ComputePassFlags
+		);
+
+		// Bricks freed by the merge stay in the class they were allocated from, so slabs left without live bricks are made whole again
+		HVPT::Private::ReclaimBricks(
+			GraphBuilder,
+			Scene,
+			TopLevelGridResolution,
+			TopLevelGridBuffer,
+			BrickCapacity,
+			VoxelsPerBrick,
+			BrickFreeListBuffer,
+			BuildOptions.ComputePassFlags
+		);
+	}
+	else
+	{
+		ParameterCache.FramesSinceFullRebuild = 0;
+		ParameterCache.BuildSettingsHash = BuildSettingsHash;
+
+		// Calculate the preferred voxel size for each bottom-level grid in a top-level cell
+		HVPT::Private::CalculateVoxelSize(
+			GraphBuilder,
+			Views,
+			GridMeshBatches,
+			BuildOptions,
+			TopLevelGridBounds,
+			TopLevelGridResolution,
+			TopLevelGridBuffer
+		);
+
+		// Allocate bottom-level grid
+		HVPT::Private::MarkTopLevelGrid(
+			GraphBuilder,
+			Scene,
+			// Grid data
+			TopLevelGridBounds,
+			TopLevelGridResolution,
+			BottomLevelGridResolution,
+			TopLevelGridBuffer,
+			CellPriorityBuffer,
+			BuildOptions.ComputePassFlags
+		);
+
+		// None of the bricks from the previous build are referenced anymore, so they can all be returned to the pool
+		HVPT::Private::SetupBrickPool(
+			GraphBuilder,
+			Scene,
+			BrickPool,
+			BrickCapacity,
+			VoxelsPerBrick,
+			GridDataFormats,
+			bInterleavedShadingData,
+			true,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			ShadingGridBuffer,
+			BrickFreeListBuffer,
+			BuildOptions.ComputePassFlags
+		);
+
+		RasterTopLevelGridBuffer = TopLevelGridBuffer;
+	}
+	HVPT::SetShadingDataMemoryStats(true, BrickCapacity * VoxelsPerBrick, GridDataFormats, bInterleavedShadingData);
+
+	FRDGBufferRef BrickOverflowCountBuffer = HVPT::Private::CreateBrickOverflowCountBuffer(GraphBuilder, BuildOptions.ComputePassFlags);
+
+	// Both restoring cached cells and rasterization allocate bricks of the resolution each cell was marked with
+	// The lowest priority cells are lowered in resolution first if the pool cannot hold them all
+	FRDGBufferRef BrickDegradationStatsBuffer;
+	HVPT::Private::ReserveBricks(
 		GraphBuilder,
 		Scene,
-		// Grid data
-		TopLevelGridBounds,
 		TopLevelGridResolution,
-		TopLevelGridBuffer
+		TopLevelGridBuffer,
+		RasterTopLevelGridBuffer,
+		CellPriorityBuffer,
+		HVPT::GetMaxDegradationLevelForOrthoGrid(),
+		BrickCapacity,
+		VoxelsPerBrick,
+		BrickFreeListBuffer,
+		BrickDegradationStatsBuffer,
+		BuildOptions.ComputePassFlags
 	);
 
+	// Cells of animated volumes showing a frame that has been rasterized before are copied from the brick cache instead
+	TArray<FHVPTBrickCacheVolume> BrickCacheVolumes;
+	if (HVPT::EnableBrickCacheForOrthoGrid())
+	{
+		HVPT::Private::CollectOrthoGridBrickCacheVolumes(HeterogeneousVolumesMeshBatches, *RasterMeshBatches, TopLevelGridBounds, TopLevelGridResolution, BrickCacheVolumes);
+	}
+	else
+	{
+		SceneState.OrthoGridBrickCache = FHVPTBrickCache();
+	}
+
+	FRDGBufferRef CacheCellBuffer = nullptr;
+	FRDGBufferRef CacheExtinctionGridBuffer = nullptr;
+	FRDGBufferRef CacheEmissionGridBuffer = nullptr;
+	FRDGBufferRef CacheScatteringGridBuffer = nullptr;
+	FRDGBufferRef CacheVelocityGridBuffer = nullptr;
+	if (!BrickCacheVolumes.IsEmpty())
+	{
+		RDG_EVENT_SCOPE(GraphBuilder, "Brick Cache");
+
+		const int32 CacheSlotCapacity = HVPT::Private::CalcBrickCacheSlotCapacity(HVPT::GetBrickCacheMemoryInMegabytesForOrthoGrid(), VoxelsPerBrick, GridDataFormats);
+		HVPT::Private::SetupBrickCache(
+			GraphBuilder,
+			SceneState.OrthoGridBrickCache,
+			CacheSlotCapacity,
+			VoxelsPerBrick,
+			GridDataFormats,
+			BuildSettingsHash,
+			CacheCellBuffer,
+			CacheExtinctionGridBuffer,
+			CacheEmissionGridBuffer,
+			CacheScatteringGridBuffer,
+			CacheVelocityGridBuffer
+		);
+		HVPT::Private::AssignBrickCacheSlots(SceneState.OrthoGridBrickCache.Allocator, BrickCacheVolumes);
+
+		// A full build rasterizes every marked cell of the grid, so restored cells are unmarked in a copy of it
+		const bool bAnyRestored = BrickCacheVolumes.ContainsByPredicate([](const FHVPTBrickCacheVolume& Volume) { return Volume.bRestore || Volume.bDeferredRestore; });
+		if (bAnyRestored && RasterTopLevelGridBuffer == TopLevelGridBuffer)
+		{
+			RasterTopLevelGridBuffer = GraphBuilder.CreateBuffer(TopLevelGridBuffer->Desc, TEXT("HVPT.OrthoGrid.RasterTopLevelGridBuffer"));
+			AddCopyBufferPass(GraphBuilder, RasterTopLevelGridBuffer, TopLevelGridBuffer);
+		}
+
+		// Instances of a volume whose entry is created by this build are only rasterized where they differ from the instance creating it
+		HVPT::Private::DeferBrickCacheVolumes(
+			GraphBuilder,
+			Scene,
+			TopLevelGridResolution,
+			BrickCacheVolumes,
+			RasterTopLevelGridBuffer,
+			BuildOptions.ComputePassFlags
+		);
+
+		HVPT::Private::RestoreBrickCacheVolumes(
+			GraphBuilder,
+			Scene,
+			TopLevelGridResolution,
+			BrickCacheVolumes,
+			false,
+			CacheCellBuffer,
+			CacheExtinctionGridBuffer,
+			CacheEmissionGridBuffer,
+			CacheScatteringGridBuffer,
+			CacheVelocityGridBuffer,
+			RasterTopLevelGridBuffer,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			ShadingGridBuffer,
+			bInterleavedShadingData,
+			BrickFreeListBuffer,
+			BrickOverflowCountBuffer,
+			VoxelsPerBrick,
+			GridDataFormats,
+			BuildOptions.ComputePassFlags
+		);
+	}
+
 	// Generate raster tiles
 	FRDGBufferRef RasterTileBuffer;
 	FRDGBufferRef RasterTileAllocatorBuffer;
@@ -464,22 +1193,18 @@ void HVPT::BuildOrthoVoxelGrid(
 		Scene,
 		// Grid data
 		TopLevelGridResolution,
-		TopLevelGridBuffer,
+		RasterTopLevelGridBuffer,
 		// Tile data
 		RasterTileBuffer,
-		RasterTileAllocatorBuffer
+		RasterTileAllocatorBuffer,
+		BuildOptions.ComputePassFlags
 	);
 
-	FRDGBufferRef ExtinctionGridBuffer;
-	FRDGBufferRef EmissionGridBuffer;
-	FRDGBufferRef ScatteringGridBuffer;
-	FRDGBufferRef VelocityGridBuffer;
-
 	HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 		GraphBuilder,
 		Scene,
 		View,
-		HeterogeneousVolumesMeshBatches,
+		*RasterMeshBatches,
 		BuildOptions,
 		// Tile data
 		RasterTileBuffer,
@@ -487,15 +1212,160 @@ void HVPT::BuildOrthoVoxelGrid(
 		// Grid data
 		TopLevelGridBounds,
 		TopLevelGridResolution,
+		FMatrix::Identity,
 		TopLevelGridBuffer,
 		ExtinctionGridBuffer,
 		EmissionGridBuffer,
 		ScatteringGridBuffer,
-		VelocityGridBuffer
+		VelocityGridBuffer,
+		BrickFreeListBuffer,
+		BrickOverflowCountBuffer,
+		GridDataFormats
 	);
 
+	if (!BrickCacheVolumes.IsEmpty())
+	{
+		HVPT::Private::CaptureBrickCacheVolumes(
+			GraphBuilder,
+			Scene,
+			TopLevelGridResolution,
+			BrickCacheVolumes,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			CacheCellBuffer,
+			CacheExtinctionGridBuffer,
+			CacheEmissionGridBuffer,
+			CacheScatteringGridBuffer,
+			CacheVelocityGridBuffer,
+			VoxelsPerBrick,
+			GridDataFormats,
+			BuildOptions.ComputePassFlags
+		);
+
+		HVPT::Private::RestoreBrickCacheVolumes(
+			GraphBuilder,
+			Scene,
+			TopLevelGridResolution,
+			BrickCacheVolumes,
+			true,
+			CacheCellBuffer,
+			CacheExtinctionGridBuffer,
+			CacheEmissionGridBuffer,
+			CacheScatteringGridBuffer,
+			CacheVelocityGridBuffer,
+			RasterTopLevelGridBuffer,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			ShadingGridBuffer,
+			bInterleavedShadingData,
+			BrickFreeListBuffer,
+			BrickOverflowCountBuffer,
+			VoxelsPerBrick,
+			GridDataFormats,
+			BuildOptions.ComputePassFlags
+		);
+	}
+
+	// The local grids take their bricks from what the ortho grid left free, so they are rasterized once it is done
+	FRDGBufferRef InstancedVolumeBuffer;
+	FRDGBufferRef InstancedVolumeCellBuffer;
+	FRDGBufferRef InstancedAssetMajorantBuffer;
+	HVPT::Private::BuildInstancedAssets(
+		GraphBuilder,
+		Scene,
+		View,
+		BuildOptions,
+		InstancedAssets,
+		InstancedVolumes,
+		BottomLevelGridResolution,
+		ExtinctionGridBuffer,
+		EmissionGridBuffer,
+		ScatteringGridBuffer,
+		VelocityGridBuffer,
+		ShadingGridBuffer,
+		bInterleavedShadingData,
+		BrickFreeListBuffer,
+		BrickOverflowCountBuffer,
+		GridDataFormats,
+		InstancedVolumeBuffer,
+		InstancedVolumeCellBuffer,
+		InstancedAssetMajorantBuffer
+	);
+
+	// Cells of directly sampled and instanced volumes were left empty by rasterization, as none of their mesh batches were rasterized
+	HVPT::Private::MarkDirectVolumeCells(
+		GraphBuilder,
+		Scene,
+		TopLevelGridBounds,
+		TopLevelGridResolution,
+		BottomLevelGridResolution,
+		DirectVolumes,
+		TopLevelGridBuffer,
+		BuildOptions.ComputePassFlags
+	);
+	HVPT::Private::MarkInstancedVolumeCells(
+		GraphBuilder,
+		Scene,
+		TopLevelGridBounds,
+		TopLevelGridResolution,
+		BottomLevelGridResolution,
+		InstancedVolumes,
+		TopLevelGridBuffer,
+		BuildOptions.ComputePassFlags
+	);
+
+	HVPT::QueueOrthoVoxelGridAllocationReadback(GraphBuilder, BrickDegradationStatsBuffer, BrickOverflowCountBuffer, AllocationState);
+
+	// Only the rasterized cells are copied, the interleaved data of the other cells is still valid from the previous build
+	if (bInterleavedShadingData)
+	{
+		HVPT::Private::InterleaveShadingGridData(
+			GraphBuilder,
+			Scene,
+			RasterTileBuffer,
+			RasterTileAllocatorBuffer,
+			TopLevelGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			GridDataFormats,
+			ShadingGridBuffer,
+			BuildOptions.ComputePassFlags
+		);
+	}
+
+	const int32 MajorantMipCount = HVPT::Private::CalcMajorantMipCount(TopLevelGridResolution, HVPT::GetMajorantMipCountForOrthoGrid());
+
+	const bool bUseSubBrickMajorants = HVPT::UseSubBrickMajorantsForOrthoGrid();
+	const bool bUseTrilinearFiltering = HVPT::UseTrilinearFilteringForOrthoGrid();
+	const int32 SubBricksPerBrick = FMath::Cube(FMath::DivideAndRoundUp(BottomLevelGridResolution, HVPT_SUB_BRICK_SIZE));
+
 	FRDGBufferRef MajorantGridBuffer;
-	HVPT::Private::BuildMajorantVoxelGrid(GraphBuilder, Scene, TopLevelGridResolution, TopLevelGridBuffer, ExtinctionGridBuffer, MajorantGridBuffer);
+	FRDGBufferRef SubBrickMajorantGridBuffer;
+	HVPT::Private::BuildMajorantVoxelGrid(
+		GraphBuilder,
+		Scene,
+		TopLevelGridResolution,
+		MajorantMipCount,
+		bUseSubBrickMajorants,
+		bUseTrilinearFiltering,
+		SubBricksPerBrick,
+		GridDataFormats,
+		DirectVolumes,
+		InstancedVolumeBuffer,
+		InstancedAssetMajorantBuffer,
+		TopLevelGridBuffer,
+		ExtinctionGridBuffer,
+		MajorantGridBuffer,
+		SubBrickMajorantGridBuffer,
+		BuildOptions.ComputePassFlags
+	);
 
 	// Create Adpative Voxel Grid uniform buffer
 	FHVPTOrthoGridUniformBufferParameters* OrthoGridUniformBufferParameters = GraphBuilder.AllocParameters<FHVPTOrthoGridUniformBufferParameters>();
@@ -509,9 +1379,21 @@ void HVPT::BuildOrthoVoxelGrid(
 		OrthoGridUniformBufferParameters->EmissionGridBuffer = GraphBuilder.CreateSRV(EmissionGridBuffer);
 		OrthoGridUniformBufferParameters->ScatteringGridBuffer = GraphBuilder.CreateSRV(ScatteringGridBuffer);
 		OrthoGridUniformBufferParameters->VelocityGridBuffer = GraphBuilder.CreateSRV(VelocityGridBuffer);
+		OrthoGridUniformBufferParameters->GridDataFormats = GridDataFormats;
+		OrthoGridUniformBufferParameters->ShadingGridBuffer = GraphBuilder.CreateSRV(ShadingGridBuffer);
+		OrthoGridUniformBufferParameters->bUseInterleavedShadingData = bInterleavedShadingData;
 
 		OrthoGridUniformBufferParameters->bUseOrthoGrid = HVPT::EnableOrthoGrid();
 		OrthoGridUniformBufferParameters->MajorantGridBuffer = GraphBuilder.CreateSRV(MajorantGridBuffer);
+		HVPT::Private::SetMajorantPyramidParameters(*OrthoGridUniformBufferParameters, TopLevelGridResolution, MajorantMipCount);
+		HVPT::Private::SetDirectVolumeParameters(*OrthoGridUniformBufferParameters, DirectVolumes);
+		HVPT::Private::SetInstancedVolumeParameters(GraphBuilder, *OrthoGridUniformBufferParameters, InstancedVolumes.Num(), InstancedVolumeBuffer, InstancedVolumeCellBuffer);
+
+		OrthoGridUniformBufferParameters->SubBrickMajorantGridBuffer = GraphBuilder.CreateSRV(SubBrickMajorantGridBuffer);
+		OrthoGridUniformBufferParameters->bUseSubBrickMajorants = bUseSubBrickMajorants;
+		OrthoGridUniformBufferParameters->bUseTrilinearFiltering = bUseTrilinearFiltering;
+		OrthoGridUniformBufferParameters->VoxelsPerBrick = VoxelsPerBrick;
+		OrthoGridUniformBufferParameters->SubBricksPerBrick = SubBricksPerBrick;
 	}
 
 	OrthoGridUniformBuffer = GraphBuilder.CreateUniformBuffer(OrthoGridUniformBufferParameters);
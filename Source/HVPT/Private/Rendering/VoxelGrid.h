@@ -2,11 +2,17 @@
 
 #include "ShaderParameterStruct.h"
 #include "HVPT.h"
+#include "BrickPool.h"
+#include "HVPTDefinitions.h"
 
 class FScene;
+class FRHIGPUBufferReadback;
 
 struct FHVPTViewState;
+struct FHVPTSceneState;
 struct FVolumetricMeshBatch;
+struct FMeshBatch;
+class FPrimitiveSceneProxy;
 
 // Voxel Grid structures
 
@@ -25,6 +31,22 @@ struct FHVPT_MajorantGridData
 	uint32 PackedData[1];
 };
 
+struct FHVPT_ShadingGridData
+{
+	uint32 PackedData[6];
+};
+
+// Slot of an instanced volume, see FHVPTOrthoGridInstancedVolume
+struct FHVPT_InstancedVolumeData
+{
+	// Rows of the affine transform from world space to the top-level voxel space of the local grid
+	FVector4f WorldToLocalVoxel[3];
+	FIntVector LocalGridResolution;
+	uint32 FirstCell;
+	uint32 AssetIndex;
+	uint32 Padding[3];
+};
+
 
 BEGIN_UNIFORM_BUFFER_STRUCT(FHVPTOrthoGridUniformBufferParameters, )
 	SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMin)
@@ -38,7 +60,55 @@ BEGIN_UNIFORM_BUFFER_STRUCT(FHVPTOrthoGridUniformBufferParameters, )
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, EmissionGridBuffer)
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ScatteringGridBuffer)
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, VelocityGridBuffer)
+	SHADER_PARAMETER(uint32, GridDataFormats) // See GridDataFormat.h
+	// Extinction, scattering and emission interleaved per voxel, only valid if bUseInterleavedShadingData is set
+	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_ShadingGridData>, ShadingGridBuffer)
+	SHADER_PARAMETER(int32, bUseInterleavedShadingData)
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_MajorantGridData>, MajorantGridBuffer)
+
+	// Majorant pyramid used to skip empty space, see MajorantPyramid.h
+	SHADER_PARAMETER(int32, MajorantMipCount)
+	SHADER_PARAMETER_ARRAY(FUintVector4, MajorantMipOffsets, [HVPT_MAX_MAJORANT_MIP_COUNT / 4])
+	SHADER_PARAMETER(float, MajorantLeapThreshold)
+
+	// Majorants of each HVPT_SUB_BRICK_SIZE^3 sub-brick of the bottom-level grids, indexed by top-level cell
+	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_MajorantGridData>, SubBrickMajorantGridBuffer)
+	SHADER_PARAMETER(int32, bUseSubBrickMajorants)
+	// Voxels in each slab of the brick pool, which is the size of a brick at the largest resolution
+	SHADER_PARAMETER(int32, VoxelsPerBrick)
+	SHADER_PARAMETER(int32, SubBricksPerBrick)
+
+	// Blend the voxels around each sample instead of taking the nearest, majorants must have been built to bound the blend
+	SHADER_PARAMETER(int32, bUseTrilinearFiltering)
+
+	// Volumes whose sparse volume texture is sampled directly by the cells covering them, see FHVPTOrthoGridDirectVolume
+	SHADER_PARAMETER(int32, NumDirectVolumes)
+	SHADER_PARAMETER_ARRAY(FMatrix44f, DirectVolumeWorldToUVW, [HVPT_MAX_DIRECT_VOLUMES])
+	SHADER_PARAMETER_ARRAY(FVector4f, DirectVolumeScattering, [HVPT_MAX_DIRECT_VOLUMES]) // Albedo in rgb, extinction scale in w
+	SHADER_PARAMETER_ARRAY(FVector4f, DirectVolumeEmission, [HVPT_MAX_DIRECT_VOLUMES]) // Emission scale in x, max density in y
+	SHADER_PARAMETER_ARRAY(FUintVector4, DirectVolumeTextureSlots, [HVPT_MAX_DIRECT_VOLUMES / 4])
+	// Textures shared by every instance of the same sparse volume texture frame
+	SHADER_PARAMETER_ARRAY(FUintVector4, DirectVolumePackedUniforms0, [HVPT_MAX_DIRECT_VOLUME_TEXTURES])
+	SHADER_PARAMETER_ARRAY(FUintVector4, DirectVolumePackedUniforms1, [HVPT_MAX_DIRECT_VOLUME_TEXTURES])
+	SHADER_PARAMETER_TEXTURE(Texture3D<uint>, DirectVolumePageTable0)
+	SHADER_PARAMETER_TEXTURE(Texture3D<uint>, DirectVolumePageTable1)
+	SHADER_PARAMETER_TEXTURE(Texture3D<uint>, DirectVolumePageTable2)
+	SHADER_PARAMETER_TEXTURE(Texture3D<uint>, DirectVolumePageTable3)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataA0)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataA1)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataA2)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataA3)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataB0)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataB1)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataB2)
+	SHADER_PARAMETER_TEXTURE(Texture3D, DirectVolumePhysicalTileDataB3)
+	SHADER_PARAMETER_SAMPLER(SamplerState, DirectVolumeSampler)
+
+	// Volumes looked up through the local grid their asset was rasterized into once, see FHVPTOrthoGridInstancedVolume
+	SHADER_PARAMETER(int32, NumInstancedVolumes)
+	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_InstancedVolumeData>, InstancedVolumeBuffer)
+	// Cells of the local grid of every instanced asset, one grid after another
+	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, InstancedVolumeCellBuffer)
 END_UNIFORM_BUFFER_STRUCT()
 
 BEGIN_UNIFORM_BUFFER_STRUCT(FHVPTFrustumGridUniformBufferParameters, )
@@ -61,6 +131,7 @@ BEGIN_UNIFORM_BUFFER_STRUCT(FHVPTFrustumGridUniformBufferParameters, )
 	SHADER_PARAMETER(float, NearPlaneDepth)
 	SHADER_PARAMETER(float, FarPlaneDepth)
 	SHADER_PARAMETER(float, TanHalfFOV)
+	SHADER_PARAMETER_ARRAY(FVector4f, DepthSliceDistribution, [HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4])
 
 	SHADER_PARAMETER_ARRAY(FVector4f, ViewFrustumPlanes, [6])
 
@@ -69,6 +140,9 @@ BEGIN_UNIFORM_BUFFER_STRUCT(FHVPTFrustumGridUniformBufferParameters, )
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, EmissionFroxelGridBuffer)
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ScatteringFroxelGridBuffer)
 	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, VelocityFroxelGridBuffer)
+	SHADER_PARAMETER(uint32, GridDataFormats)
+	SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_ShadingGridData>, ShadingFroxelGridBuffer)
+	SHADER_PARAMETER(int32, bUseInterleavedShadingData)
 END_UNIFORM_BUFFER_STRUCT()
 
 
@@ -81,6 +155,23 @@ struct FHVPT_VoxelGridBuildOptions
 	bool bBuildFrustumGrid = true;
 	bool bUseProjectedPixelSizeForOrthoGrid = true;
 	bool bJitter = HVPT::GetShouldJitter();
+
+	// ERDGPassFlags::AsyncCompute to build on the async compute queue, see HVPT::UseAsyncComputeForGridBuild
+	ERDGPassFlags ComputePassFlags = ERDGPassFlags::Compute;
+
+	// Set when the grid is built into a second set of buffers while the cached grid is still being rendered from
+	// The cached grid cannot be updated in place then, so the ortho grid is always fully rebuilt
+	bool bBuildIntoBackBuffers = false;
+};
+
+// Normalized depth at which each of the HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT equal ranges of view depth between the near and far planes starts
+// Four bins are packed into each element, matching DepthSliceDistribution in FrustumUtils.ush
+struct FHVPTFrustumGridDepthSliceDistribution
+{
+	FVector4f BinStarts[HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4];
+
+	// Slices spread evenly between the near and far planes
+	static FHVPTFrustumGridDepthSliceDistribution MakeLinear();
 };
 
 struct FHVPTFrustumGridParameterCache
@@ -104,6 +195,7 @@ struct FHVPTFrustumGridParameterCache
 	float NearPlaneDepth;
 	float FarPlaneDepth;
 	float TanHalfFOV;
+	FHVPTFrustumGridDepthSliceDistribution DepthSliceDistribution;
 
 	FVector4f ViewFrustumPlanes[6];
 
@@ -112,6 +204,108 @@ struct FHVPTFrustumGridParameterCache
 	TRefCountPtr<FRDGPooledBuffer> EmissionGridBuffer = nullptr;
 	TRefCountPtr<FRDGPooledBuffer> ScatteringGridBuffer = nullptr;
 	TRefCountPtr<FRDGPooledBuffer> VelocityGridBuffer = nullptr;
+	uint32 GridDataFormats = 0;
+	TRefCountPtr<FRDGPooledBuffer> ShadingGridBuffer = nullptr;
+	int32 bUseInterleavedShadingData = false;
+};
+
+// Schedules rebuilds of a view's frustum grid, see r.HVPT.FrustumGrid.RebuildInterval and r.HVPT.FrustumGrid.RebuildBudgetMs
+// Between rebuilds the view renders from the cached grid, whose lookups go through the matrices it was built with
+struct FHVPTFrustumGridRebuildState
+{
+	int32 FramesSinceRebuild = 0;
+
+	// GPU time of the last rebuild that could be measured, or 0 if none has been yet
+	float RebuildMilliseconds = 0.0f;
+
+	FRenderQueryPoolRHIRef TimestampQueryPool;
+	FRHIPooledRenderQuery BeginTimestampQuery;
+	FRHIPooledRenderQuery EndTimestampQuery;
+};
+// State of a volume when it was last rasterized into the ortho grid, used to detect which volumes have changed between builds
+struct FHVPTOrthoGridVolumeRecord
+{
+	const FPrimitiveSceneProxy* Proxy = nullptr;
+	const FMaterialRenderProxy* MaterialRenderProxy = nullptr;
+	FMatrix InstanceToWorld = FMatrix::Identity;
+	FBox WorldBounds = FBox(ForceInit);
+
+	// Copied from the proxy so that the record can still be described once the proxy is gone, see r.HVPT.OrthoGrid.DumpStats
+	FName OwnerName = NAME_None;
+
+	// Only volumes with the extended interface can report changes to their data (e.g. animation frame)
+	// Volumes without a revision are considered changed every build
+	uint32 DataRevision = 0;
+	bool bHasDataRevision = false;
+};
+
+// A box of top-level cells that must be re-rasterized during an incremental build
+struct FHVPTOrthoGridDirtyRegion
+{
+	FIntVector CellMin;
+	FIntVector CellMax; // Inclusive
+	FBox WorldBounds; // Snapped to top-level cell boundaries
+};
+
+// A volume whose sparse volume texture is sampled directly when tracing the ortho grid, instead of being rasterized into bricks
+// Its cells hold DIRECT_VOLUME_INDEX_BASE + the index of the volume in place of a brick, see VoxelGridBuildUtils.ush
+// Instances of the same texture frame only differ by their transform and scales, and share a texture slot
+struct FHVPTOrthoGridDirectVolume
+{
+	uint64 VolumeKey = 0;
+
+	// From the space of the grid to the texture coordinates of the volume
+	FMatrix44f WorldToUVW = FMatrix44f::Identity;
+
+	// Texture slot the textures below are bound to, shared with every other instance of the same texture frame
+	int32 TextureSlot = 0;
+	FUintVector4 PackedUniforms0 = FUintVector4(0, 0, 0, 0);
+	FUintVector4 PackedUniforms1 = FUintVector4(0, 0, 0, 0);
+	TRefCountPtr<FRHITexture> PageTableTexture;
+	TRefCountPtr<FRHITexture> PhysicalTileDataATexture;
+	TRefCountPtr<FRHITexture> PhysicalTileDataBTexture;
+
+	FLinearColor Albedo = FLinearColor::White;
+	float ExtinctionScale = 1.0f;
+	float MaxDensity = 1.0f;
+	float EmissionScale = 0.0f;
+
+	FBox WorldBounds = FBox(ForceInit);
+	// Inclusive box of top-level cells the volume may touch
+	FIntVector CellMin = FIntVector::ZeroValue;
+	FIntVector CellMax = FIntVector::ZeroValue;
+};
+
+// A volume shown by two or more instances with the same material and sparse volume texture frame, see FHeterogeneousVolumeExFrameKey
+// It is rasterized once into a local grid covering its bounds in instance space, with bricks from the same pool as the ortho grid
+struct FHVPTOrthoGridInstancedAsset
+{
+	// Rasterized as seen through the first of its instances
+	const FMeshBatch* Mesh = nullptr;
+	const FPrimitiveSceneProxy* Proxy = nullptr;
+	FMatrix ReferenceInstanceToWorld = FMatrix::Identity;
+
+	// Bounds of the volume in instance space, split into the cells of the local grid
+	FBox LocalBounds = FBox(ForceInit);
+	FIntVector LocalGridResolution = FIntVector(1);
+	// First cell of the local grid in the instanced volume cell buffer
+	uint32 FirstCell = 0;
+};
+
+// An instance of an instanced asset, which looks up the local grid of the asset through its own transform
+// Its cells hold INSTANCED_VOLUME_INDEX_BASE + the index of the instance in place of a brick, see VoxelGridBuildUtils.ush
+struct FHVPTOrthoGridInstancedVolume
+{
+	uint64 VolumeKey = 0;
+	int32 AssetIndex = INDEX_NONE;
+
+	// From the space of the grid to the top-level voxel space of the local grid of the asset
+	FMatrix44f WorldToLocalVoxel = FMatrix44f::Identity;
+
+	FBox WorldBounds = FBox(ForceInit);
+	// Inclusive box of top-level cells the volume may touch
+	FIntVector CellMin = FIntVector::ZeroValue;
+	FIntVector CellMax = FIntVector::ZeroValue;
 };
 
 struct FHVPTOrthoGridParameterCache
@@ -127,8 +321,49 @@ struct FHVPTOrthoGridParameterCache
 	TRefCountPtr<FRDGPooledBuffer> EmissionGridBuffer = nullptr;
 	TRefCountPtr<FRDGPooledBuffer> ScatteringGridBuffer = nullptr;
 	TRefCountPtr<FRDGPooledBuffer> VelocityGridBuffer = nullptr;
+	uint32 GridDataFormats = 0;
+	TRefCountPtr<FRDGPooledBuffer> ShadingGridBuffer = nullptr;
+	int32 bUseInterleavedShadingData = false;
 
 	TRefCountPtr<FRDGPooledBuffer> MajorantGridBuffer = nullptr;
+	int32 MajorantMipCount = 1;
+
+	TRefCountPtr<FRDGPooledBuffer> SubBrickMajorantGridBuffer = nullptr;
+	int32 bUseSubBrickMajorants = false;
+	int32 VoxelsPerBrick = 1;
+	int32 SubBricksPerBrick = 1;
+
+	int32 bUseTrilinearFiltering = false;
+
+	TArray<FHVPTOrthoGridDirectVolume> DirectVolumes;
+
+	int32 NumInstancedVolumes = 0;
+	TRefCountPtr<FRDGPooledBuffer> InstancedVolumeBuffer = nullptr;
+	TRefCountPtr<FRDGPooledBuffer> InstancedVolumeCellBuffer = nullptr;
+
+	// Incremental build state
+	TMap<uint64, FHVPTOrthoGridVolumeRecord> VolumeRecords;
+	uint32 BuildSettingsHash = 0;
+	int32 FramesSinceFullRebuild = 0;
+};
+
+// How the last ortho grid build that was read back fitted its bricks in the pool, see r.HVPT.OrthoGrid.MaxDegradationLevel
+// Each build lowers the resolution of its own lowest priority cells as needed, so this is only kept for stats and warnings
+struct FHVPTOrthoGridAllocationState
+{
+	// Most times the resolution of any cell was halved, and the number of cells that were lowered
+	int32 DegradationLevel = 0;
+	int32 DegradedCellCount = 0;
+
+	// Slabs of the pool the cells of the build asked for before any were lowered, and the bricks that still did not fit
+	int32 BrickDemand = 0;
+	int32 OverflowBrickCount = 0;
+	// Number of builds that have run out of bricks
+	int32 OverflowEventCount = 0;
+
+	TUniquePtr<FRHIGPUBufferReadback> DegradationStatsReadback;
+	TUniquePtr<FRHIGPUBufferReadback> OverflowBrickCountReadback;
+	bool bReadbackPending = false;
 };
 
 namespace HVPT
@@ -162,9 +397,29 @@ void BuildFrustumVoxelGrid(
 	const FScene* Scene,
 	const FViewInfo& View,
 	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	FHVPTBrickPool& BrickPool,
 	TRDGUniformBufferRef<FHVPTFrustumGridUniformBufferParameters>& FrustumVoxelGridUniformBuffer
 );
 
+// Whether the frustum grid should be rebuilt this frame, rather than rendered from the cached grid
+bool ShouldRebuildFrustumVoxelGrid(
+	const FViewInfo& View,
+	bool bHasCachedGrid,
+	FHVPTFrustumGridRebuildState& RebuildState
+);
+
+// Brackets a rebuild with GPU timestamps, so that r.HVPT.FrustumGrid.RebuildBudgetMs can spread rebuilds out by their cost
+void BeginFrustumVoxelGridRebuildTiming(
+	FRDGBuilder& GraphBuilder,
+	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	FHVPTFrustumGridRebuildState& RebuildState
+);
+
+void EndFrustumVoxelGridRebuildTiming(
+	FRDGBuilder& GraphBuilder,
+	FHVPTFrustumGridRebuildState& RebuildState
+);
+
 
 // --- ORTHO GRID --- //
 
@@ -172,9 +427,11 @@ TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> CreateEmptyOrthoVoxe
 	FRDGBuilder& GraphBuilder
 );
 
+// Returns the ortho grid shared by all views of the scene, or nullptr if it has never been built
 TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters> GetOrthoVoxelGridUniformBuffer(
 	FRDGBuilder& GraphBuilder,
-	FHVPTViewState& ViewState
+	const FViewInfo& View,
+	FHVPTSceneState& SceneState
 );
 
 void ExtractOrthoVoxelGridUniformBuffer(
@@ -189,14 +446,37 @@ void RegisterExternalOrthoVoxelGridUniformBuffer(
 	TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer
 );
 
+// Rebuilds the ortho grid shared by all views of the scene. When possible, only the top-level cells touched by volumes that have
+// changed since the cached grid was built are re-rasterized, and the rest of the grid is kept.
+// Each cell is built at the finest voxel size required by any of Views, or by views that reported their requirement to SceneState.
 void BuildOrthoVoxelGrid(
 	FRDGBuilder& GraphBuilder,
 	const FScene* Scene,
-	const FViewInfo& View,
+	TConstArrayView<const FViewInfo*> Views,
 	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	FHVPTSceneState& SceneState,
 	TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoVoxelGridUniformBuffer
 );
 
+// Picks up the brick demand and degradation of the last build once its readback has completed, and warns when it overflowed
+void UpdateOrthoVoxelGridAllocationStats(
+	FHVPTOrthoGridAllocationState& AllocationState
+);
+
+// Reads back how a build lowered its cells and how many bricks it could not allocate, if no earlier readback is still in flight
+void QueueOrthoVoxelGridAllocationReadback(
+	FRDGBuilder& GraphBuilder,
+	FRDGBufferRef BrickDegradationStatsBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	FHVPTOrthoGridAllocationState& AllocationState
+);
+
+// Finest voxel size the ortho grid must provide for View to be rendered at its requested shading rate
+float CalcOrthoGridMinimumVoxelSize(
+	const FViewInfo& View,
+	const FHVPT_VoxelGridBuildOptions& BuildOptions
+);
+
 
 namespace Private
 {
@@ -222,13 +502,23 @@ void ClipNearFarDistances(
 	float& FarPlaneDistance
 );
 
+// Builds a histogram of the depths covered by volumes in view, and spreads depth slices over the occupied ranges
+// Returns the length of view depth, weighted by how densely each range is sliced, that the depth slices are spread over
+float CalculateDepthSliceDistributionForFrustumGrid(
+	const FViewInfo& View,
+	float NearPlaneDistance,
+	float FarPlaneDistance,
+	FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution
+);
+
 void CalculateTopLevelGridResolutionForFrustumGrid(
 	const FViewInfo& View,
 	const FHVPT_VoxelGridBuildOptions& BuildOptions,
 	float MinimumVoxelSize,
 	float NearPlaneDistance,
 	float& FarPlaneDistance,
-	FIntVector& TopLevelGridResolution
+	FIntVector& TopLevelGridResolution,
+	FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution
 );
 
 void MarkTopLevelGridVoxelsForFrustumGrid(
@@ -237,8 +527,10 @@ void MarkTopLevelGridVoxelsForFrustumGrid(
 	FIntVector TopLevelGridResolution,
 	float NearPlaneDistance,
 	float FarPlaneDistance,
+	const FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution,
 	const FMatrix& ViewToWorld,
-	FRDGBufferRef& TopLevelGridBuffer
+	FRDGBufferRef& TopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
 );
 
 void GenerateRasterTiles(
@@ -247,7 +539,8 @@ void GenerateRasterTiles(
 	FIntVector TopLevelGridResolution,
 	FRDGBufferRef TopLevelGridBuffer,
 	FRDGBufferRef& RasterTileBuffer,
-	FRDGBufferRef& RasterTileAllocatorBuffer
+	FRDGBufferRef& RasterTileAllocatorBuffer,
+	ERDGPassFlags ComputePassFlags
 );
 
 void RasterizeVolumesIntoFrustumVoxelGrid(
@@ -259,27 +552,79 @@ void RasterizeVolumesIntoFrustumVoxelGrid(
 	FMatrix& ViewToWorld,
 	float NearPlaneDistance,
 	float FarPlaneDistance,
+	const FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution,
 	// Raster tile
 	FRDGBufferRef RasterTileBuffer,
 	FRDGBufferRef RasterTileAllocatorBuffer,
 	// Top-level grid
 	FIntVector TopLevelGridResolution,
-	FRDGBufferRef& TopLevelGridBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
 	// Bottom-level grid
-	FRDGBufferRef& ExtinctionGridBuffer,
-	FRDGBufferRef& EmissionGridBuffer,
-	FRDGBufferRef& ScatteringGridBuffer,
-	FRDGBufferRef& VelocityGridBuffer
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	uint32 GridDataFormats
 );
 
 
 // Ortho Grid Builder Helpers
 
+// Majorant pyramid layout and traversal settings of the uniform buffer
+void SetMajorantPyramidParameters(
+	FHVPTOrthoGridUniformBufferParameters& Parameters,
+	const FIntVector& TopLevelGridResolution,
+	int32 MajorantMipCount
+);
+
+// Binds the textures of each directly sampled volume to its slot of the uniform buffer, and black textures to the unused slots
+void SetDirectVolumeParameters(
+	FHVPTOrthoGridUniformBufferParameters& Parameters,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes
+);
+
+// Binds the instance slots and the local grids they look up, or empty buffers if there are no instanced volumes
+void SetInstancedVolumeParameters(
+	FRDGBuilder& GraphBuilder,
+	FHVPTOrthoGridUniformBufferParameters& Parameters,
+	int32 NumInstancedVolumes,
+	FRDGBufferRef InstancedVolumeBuffer,
+	FRDGBufferRef InstancedVolumeCellBuffer
+);
+
 void CollectHeterogeneousVolumeMeshBatches(
 	const FViewInfo& View,
 	TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches
 );
 
+// True if there is at least one volume, and every volume has declared that its extinction is grey
+bool AreAllVolumesMonochrome(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches
+);
+
+// Whether the grids and tracking shaders for this view should use single channel extinction
+bool ShouldUseMonochromeExtinction(const FViewInfo& View);
+
+// Level of detail a volume asks for in the ortho grid, resolved against r.HVPT.BottomLevelGridResolution
+// Volumes without the extended interface get the defaults, which leave the voxel size as it was
+struct FHVPTVolumeLODPolicy
+{
+	// Powers of two, with MinBrickResolution <= MaxBrickResolution
+	int32 MinBrickResolution = 1;
+	int32 MaxBrickResolution = 1;
+
+	// Scales the projected pixel size that voxels in view follow
+	float ProjectedVoxelSizeScale = 1.0f;
+};
+
+FHVPTVolumeLODPolicy GetVolumeLODPolicy(
+	const FPrimitiveSceneProxy* PrimitiveSceneProxy,
+	const IHeterogeneousVolumeInterface* HeterogeneousVolume
+);
+
 void CalcGlobalBoundsAndMinimumVoxelSize(
 	const FViewInfo& View,
 	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
@@ -294,9 +639,10 @@ void CalculateTopLevelGridResolution(
 	FIntVector& TopLevelGridResolution
 );
 
+// Each cell takes the finest voxel size required by any of the views
 void CalculateVoxelSize(
 	FRDGBuilder& GraphBuilder,
-	const FViewInfo& View,
+	TConstArrayView<const FViewInfo*> Views,
 	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
 	const FHVPT_VoxelGridBuildOptions& BuildOptions,
 	const FBoxSphereBounds& TopLevelGridBounds,
@@ -304,12 +650,114 @@ void CalculateVoxelSize(
 	FRDGBufferRef& TopLevelGridBuffer
 );
 
+// Picks the volumes that can be sampled directly, see FHVPTOrthoGridDirectVolume. Every other mesh batch is returned in RasterMeshBatches
+void CollectOrthoGridDirectVolumes(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTOrthoGridDirectVolume>& DirectVolumes,
+	TSet<FVolumetricMeshBatch>& RasterMeshBatches
+);
+
+// Points the cells of each directly sampled volume at its slot. Must run after rasterization, which would otherwise allocate bricks for them
+void MarkDirectVolumeCells(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	int32 BottomLevelGridResolution,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes,
+	FRDGBufferRef TopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Cells of the local grid of an instanced asset per side, so that they are no larger than the top-level cells around the instance
+// scaled up the most, up to HVPT_MAX_INSTANCED_ASSET_GRID_RESOLUTION
+FIntVector CalcInstancedAssetGridResolution(
+	const FBox& LocalBounds,
+	const FVector& MaxInstanceScale,
+	const FVector& TopLevelVoxelSize
+);
+
+// From world space to the top-level voxel space of a local grid over LocalBounds, as placed in the world by InstanceToWorld
+FMatrix CalcInstancedVolumeWorldToLocalVoxel(
+	const FMatrix& InstanceToWorld,
+	const FBox& LocalBounds,
+	const FIntVector& LocalGridResolution
+);
+
+// Groups the volumes of CandidateMeshBatches showing the same frame in two or more places into instanced assets, see FHVPTOrthoGridInstancedAsset
+// As with directly sampled volumes, an instance must share no cells with any other volume. Every other mesh batch is returned in RasterMeshBatches
+void CollectOrthoGridInstancedVolumes(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const TSet<FVolumetricMeshBatch>& CandidateMeshBatches,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTOrthoGridInstancedAsset>& InstancedAssets,
+	TArray<FHVPTOrthoGridInstancedVolume>& InstancedVolumes,
+	TSet<FVolumetricMeshBatch>& RasterMeshBatches
+);
+
+// Rasterizes each instanced asset once into its local grid, and uploads the slot of every instance
+// Bricks come from the slabs the ortho grid left free, so this must run after the ortho grid has been rasterized
+// InstancedAssetMajorantBuffer holds the largest extinction in each local grid, as the bits of a float
+void BuildInstancedAssets(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FViewInfo& View,
+	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	TConstArrayView<FHVPTOrthoGridInstancedAsset> InstancedAssets,
+	TConstArrayView<FHVPTOrthoGridInstancedVolume> InstancedVolumes,
+	int32 BottomLevelGridResolution,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef ShadingGridBuffer,
+	bool bInterleavedShadingData,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	uint32 GridDataFormats,
+	FRDGBufferRef& InstancedVolumeBuffer,
+	FRDGBufferRef& InstancedVolumeCellBuffer,
+	FRDGBufferRef& InstancedAssetMajorantBuffer
+);
+
+// Points the cells of each instanced volume at its slot. Must run after rasterization, for the same reason as MarkDirectVolumeCells
+void MarkInstancedVolumeCells(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	int32 BottomLevelGridResolution,
+	TConstArrayView<FHVPTOrthoGridInstancedVolume> InstancedVolumes,
+	FRDGBufferRef TopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+// Finds the volumes about to be rasterized whose bricks can be restored from or kept in the brick cache, see r.HVPT.OrthoGrid.BrickCache
+// As with directly sampled volumes, a volume must share no cells with any other volume, so that its cells hold nothing else
+void CollectOrthoGridBrickCacheVolumes(
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const TSet<FVolumetricMeshBatch>& RasterMeshBatches,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTBrickCacheVolume>& CacheVolumes
+);
+
+// Cells are given at most MaxVoxelResolution voxels per side, which must fit in a brick of the pool
+// CellPriorityBuffer ranks each marked cell by the resolution it asked for, see HVPT_BRICK_PRIORITY_BUCKET_COUNT
 void MarkTopLevelGrid(
 	FRDGBuilder& GraphBuilder,
 	const FScene* Scene,
 	const FBoxSphereBounds& TopLevelGridBounds,
 	FIntVector TopLevelGridResolution,
-	FRDGBufferRef& TopLevelGridBuffer
+	int32 MaxVoxelResolution,
+	FRDGBufferRef& TopLevelGridBuffer,
+	FRDGBufferRef& CellPriorityBuffer,
+	ERDGPassFlags ComputePassFlags
 );
 
 void RasterizeVolumesIntoOrthoVoxelGrid(
@@ -324,21 +772,114 @@ void RasterizeVolumesIntoOrthoVoxelGrid(
 	// Top-level grid
 	FBoxSphereBounds TopLevelGridBounds,
 	FIntVector TopLevelGridResolution,
-	FRDGBufferRef& TopLevelGridBuffer,
+	// Identity, unless TopLevelGridBounds are in the instance space of an instanced asset, see FHVPTOrthoGridInstancedAsset
+	const FMatrix& GridToWorld,
+	FRDGBufferRef TopLevelGridBuffer,
 	// Bottom-level grid
-	FRDGBufferRef& ExtinctionGridBuffer,
-	FRDGBufferRef& EmissionGridBuffer,
-	FRDGBufferRef& ScatteringGridBuffer,
-	FRDGBufferRef& VelocityGridBuffer
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	uint32 GridDataFormats
+);
+
+// Copies extinction, scattering and emission of every brick listed in the raster tiles into ShadingGridBuffer
+// Shared by both grids, and must run after rasterization has finished writing to the bricks
+void InterleaveShadingGridData(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FRDGBufferRef RasterTileBuffer,
+	FRDGBufferRef RasterTileAllocatorBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	uint32 GridDataFormats,
+	FRDGBufferRef ShadingGridBuffer,
+	ERDGPassFlags ComputePassFlags
 );
 
+// Builds all MajorantMipCount levels of the majorant pyramid
+// If bBuildSubBrickMajorants is set, also builds SubBricksPerBrick majorants for each top-level cell
+// If bTrilinearFiltering is set, each majorant also bounds the voxels that filtered samples in it blend with
 void BuildMajorantVoxelGrid(
 	FRDGBuilder& GraphBuilder,
 	const FScene* Scene,
 	const FIntVector& TopLevelGridResolution,
+	int32 MajorantMipCount,
+	bool bBuildSubBrickMajorants,
+	bool bTrilinearFiltering,
+	int32 SubBricksPerBrick,
+	uint32 GridDataFormats,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes,
+	FRDGBufferRef InstancedVolumeBuffer,
+	FRDGBufferRef InstancedAssetMajorantBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef& MajorantVoxelGridBuffer,
+	FRDGBufferRef& SubBrickMajorantGridBuffer,
+	ERDGPassFlags ComputePassFlags
+);
+
+
+// Incremental Ortho Grid Builder Helpers
+
+void CollectOrthoGridVolumeRecords(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	TMap<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecords
+);
+
+uint32 CalcOrthoGridBuildSettingsHash(
+	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	int32 BottomLevelGridResolution,
+	int32 BrickCapacity,
+	uint32 GridDataFormats,
+	bool bInterleavedShadingData,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes,
+	TConstArrayView<FHVPTOrthoGridInstancedVolume> InstancedVolumes
+);
+
+bool CanBuildOrthoVoxelGridIncrementally(
+	const FHVPTOrthoGridParameterCache& ParameterCache,
+	const FHVPTBrickPool& BrickPool,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	uint32 BuildSettingsHash
+);
+
+// Returns false if so much of the grid has changed that a full rebuild is preferable
+bool CalculateDirtyRegionsForOrthoGrid(
+	const TMap<uint64, FHVPTOrthoGridVolumeRecord>& PreviousVolumeRecords,
+	const TMap<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecords,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTOrthoGridDirtyRegion>& DirtyRegions
+);
+
+void CollectMeshBatchesIntersectingDirtyRegions(
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const TArray<FHVPTOrthoGridDirtyRegion>& DirtyRegions,
+	TSet<FVolumetricMeshBatch>& DirtyMeshBatches
+);
+
+void MergeDirtyTopLevelGridCells(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	const TArray<FHVPTOrthoGridDirtyRegion>& DirtyRegions,
+	FRDGBufferRef DirtyTopLevelGridBuffer,
 	FRDGBufferRef TopLevelGridBuffer,
 	FRDGBufferRef ExtinctionGridBuffer,
-	FRDGBufferRef& MajorantVoxelGridBuffer
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef BrickFreeListBuffer,
+	uint32 GridDataFormats,
+	FRDGBufferRef& RasterTopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
 );
 
 }
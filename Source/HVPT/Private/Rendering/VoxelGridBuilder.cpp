@@ -1,12 +1,20 @@
 #include "VoxelGrid.h"
+#include "MajorantPyramid.h"
+#include "GridDataFormat.h"
 
 #include "HeterogeneousVolumeExInterface.h"
 
 #include "ScenePrivate.h"
+#include "RenderGraphUtils.h"
+#include "SystemTextures.h"
 #include "MeshPassUtils.h"
 #include "Materials/MaterialRenderProxy.h"
 #include "HeterogeneousVolumeInterface.h"
 #include "SceneCore.h"
+#include "SparseVolumeTexture/SparseVolumeTexture.h"
+
+
+DECLARE_GPU_STAT_NAMED(HVPTInterleaveShadingData, TEXT("HVPT Interleave Shading Data"));
 
 
 static TAutoConsoleVariable<bool> CVarHVPTForceCubicTopLevelGrid(
@@ -53,6 +61,7 @@ class FHVPT_MarkTopLevelGridVoxelsForFrustumGridCS : public FGlobalShader
 		SHADER_PARAMETER(float, TanHalfFOV)
 		SHADER_PARAMETER(float, NearPlaneDepth)
 		SHADER_PARAMETER(float, FarPlaneDepth)
+		SHADER_PARAMETER_ARRAY(FVector4f, DepthSliceDistribution, [HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4])
 
 		SHADER_PARAMETER(FIntVector, VoxelDimensions)
 
@@ -159,8 +168,9 @@ class FHVPT_RasterizeBottomLevelFrustumGridCS : public FMeshMaterialShader
 		SHADER_PARAMETER(float, TanHalfFOV)
 		SHADER_PARAMETER(float, NearPlaneDepth)
 		SHADER_PARAMETER(float, FarPlaneDepth)
+		SHADER_PARAMETER_ARRAY(FVector4f, DepthSliceDistribution, [HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4])
 
-		SHADER_PARAMETER(int, BottomLevelGridBufferSize)
+		SHADER_PARAMETER(uint32, GridDataFormats)
 
 		// Velocity data
 		SHADER_PARAMETER(FMatrix44f, LocalToWorld_Velocity)
@@ -177,7 +187,8 @@ class FHVPT_RasterizeBottomLevelFrustumGridCS : public FMeshMaterialShader
 		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
 
 		// Grid data
-		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBottomLevelGridAllocatorBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickOverflowCountBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWExtinctionGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWEmissionGridBuffer)
@@ -266,8 +277,9 @@ class FHVPT_RasterizeFogFrustumGridCS : public FGlobalShader
 		SHADER_PARAMETER(float, TanHalfFOV)
 		SHADER_PARAMETER(float, NearPlaneDepth)
 		SHADER_PARAMETER(float, FarPlaneDepth)
+		SHADER_PARAMETER_ARRAY(FVector4f, DepthSliceDistribution, [HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4])
 
-		SHADER_PARAMETER(int, BottomLevelGridBufferSize)
+		SHADER_PARAMETER(uint32, GridDataFormats)
 
 		// Sampling data
 		SHADER_PARAMETER(int, bJitter)
@@ -281,7 +293,8 @@ class FHVPT_RasterizeFogFrustumGridCS : public FGlobalShader
 		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
 
 		// Grid data
-		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBottomLevelGridAllocatorBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickOverflowCountBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWExtinctionGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWEmissionGridBuffer)
@@ -330,6 +343,10 @@ class FHVPT_TopLevelGridCalculateVoxelSizeCS : public FGlobalShader
 		SHADER_PARAMETER(float, MinVoxelSizeOutOfFrustum)
 		SHADER_PARAMETER(int, bUseProjectedPixelSize)
 
+		SHADER_PARAMETER(float, ProjectedVoxelSizeScale)
+		SHADER_PARAMETER(int, MinBrickResolution)
+		SHADER_PARAMETER(int, MaxBrickResolution)
+
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
 	END_SHADER_PARAMETER_STRUCT()
 
@@ -366,6 +383,7 @@ class FHVPT_AllocateBottomLevelGridCS : public FGlobalShader
 		SHADER_PARAMETER(int, MaxVoxelResolution)
 
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWCellPriorityBuffer)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
@@ -411,8 +429,9 @@ class FHVPT_RasterizeBottomLevelOrthoGridCS : public FMeshMaterialShader
 		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
 		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMin)
 		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMax)
+		SHADER_PARAMETER(FMatrix44f, GridToWorld)
 
-		SHADER_PARAMETER(int, BottomLevelGridBufferSize)
+		SHADER_PARAMETER(uint32, GridDataFormats)
 
 		// Velocity data
 		SHADER_PARAMETER(FMatrix44f, LocalToWorld_Velocity)
@@ -433,7 +452,8 @@ class FHVPT_RasterizeBottomLevelOrthoGridCS : public FMeshMaterialShader
 		// Grid data
 		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
 
-		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBottomLevelGridAllocatorBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickOverflowCountBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWExtinctionGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWEmissionGridBuffer)
@@ -520,7 +540,7 @@ class FHVPT_RasterizeFogOrthoGridCS : public FGlobalShader
 		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMin)
 		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMax)
 
-		SHADER_PARAMETER(int, BottomLevelGridBufferSize)
+		SHADER_PARAMETER(uint32, GridDataFormats)
 
 		// Sampling data
 		SHADER_PARAMETER_STRUCT_REF(FBlueNoise, BlueNoise)
@@ -534,7 +554,8 @@ class FHVPT_RasterizeFogOrthoGridCS : public FGlobalShader
 		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
 
 		// Grid data
-		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBottomLevelGridAllocatorBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickOverflowCountBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWExtinctionGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWEmissionGridBuffer)
@@ -574,8 +595,22 @@ class FHVPT_BuildMajorantVoxelGridCS : public FGlobalShader
 		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
 		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ExtinctionGridBuffer)
 
+		// Sub-brick majorants
+		SHADER_PARAMETER(int32, bBuildSubBrickMajorants)
+		SHADER_PARAMETER(int32, bTrilinearFiltering)
+		SHADER_PARAMETER(int32, SubBricksPerBrick)
+		SHADER_PARAMETER(uint32, GridDataFormats)
+
+		// Directly sampled volumes
+		SHADER_PARAMETER_ARRAY(FVector4f, DirectVolumeMajorants, [HVPT_MAX_DIRECT_VOLUMES])
+
+		// Instanced volumes
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_InstancedVolumeData>, InstancedVolumeBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, InstancedAssetMajorantBuffer)
+
 		// Output
 		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_MajorantGridData>, RWMajorantVoxelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_MajorantGridData>, RWSubBrickMajorantGridBuffer)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
@@ -597,6 +632,249 @@ class FHVPT_BuildMajorantVoxelGridCS : public FGlobalShader
 IMPLEMENT_GLOBAL_SHADER(FHVPT_BuildMajorantVoxelGridCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_BuildMajorantVoxelGridCS", SF_Compute);
 
 
+class FHVPT_MarkDirectVolumeCellsCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_MarkDirectVolumeCellsCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_MarkDirectVolumeCellsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMin)
+		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMax)
+
+		// Volume data
+		SHADER_PARAMETER(FVector3f, PrimitiveWorldBoundsMin)
+		SHADER_PARAMETER(FVector3f, PrimitiveWorldBoundsMax)
+		SHADER_PARAMETER(FIntVector, DirectVolumeCellMin)
+		SHADER_PARAMETER(FIntVector, DirectVolumeCellMax)
+		SHADER_PARAMETER(int32, DirectVolumeSlot)
+		SHADER_PARAMETER(int32, DirectVolumeVoxelResolution)
+
+		// Output
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_MarkDirectVolumeCellsCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_MarkDirectVolumeCellsCS", SF_Compute);
+
+
+// Mirrors FHVPT_InstancedVolumeCellBox in VoxelGridBuild.usf
+struct FHVPT_InstancedVolumeCellBox
+{
+	FIntVector4 CellMin;
+	FIntVector4 CellMax;
+	FVector4f WorldBoundsMin;
+	FVector4f WorldBoundsMax;
+};
+
+class FHVPT_MarkInstancedVolumeCellsCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_MarkInstancedVolumeCellsCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_MarkInstancedVolumeCellsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMin)
+		SHADER_PARAMETER(FVector3f, TopLevelGridWorldBoundsMax)
+
+		// Volume data
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_InstancedVolumeCellBox>, InstancedVolumeCellBoxBuffer)
+		SHADER_PARAMETER(int32, NumInstancedVolumes)
+		SHADER_PARAMETER(int32, InstancedVolumeVoxelResolution)
+
+		// Output
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_MarkInstancedVolumeCellsCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_MarkInstancedVolumeCellsCS", SF_Compute);
+
+
+class FHVPT_CalcInstancedAssetMajorantCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_CalcInstancedAssetMajorantCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_CalcInstancedAssetMajorantCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+
+		// Local grid of the asset
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ExtinctionGridBuffer)
+		SHADER_PARAMETER(uint32, GridDataFormats)
+		SHADER_PARAMETER(int32, InstancedAssetIndex)
+
+		// Output
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWInstancedAssetMajorantBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_CalcInstancedAssetMajorantCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_CalcInstancedAssetMajorantCS", SF_Compute);
+
+
+class FHVPT_DownsampleMajorantGridCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_DownsampleMajorantGridCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_DownsampleMajorantGridCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, SrcMipResolution)
+		SHADER_PARAMETER(FIntVector, DstMipResolution)
+		SHADER_PARAMETER(uint32, SrcMipOffset)
+		SHADER_PARAMETER(uint32, DstMipOffset)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_MajorantGridData>, RWMajorantVoxelGridBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_DownsampleMajorantGridCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_DownsampleMajorantGridCS", SF_Compute);
+
+
+class FHVPT_MergeDirtyTopLevelGridCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_MergeDirtyTopLevelGridCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_MergeDirtyTopLevelGridCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER(FIntVector, DirtyCellMin)
+		SHADER_PARAMETER(FIntVector, DirtyCellMax)
+
+		// Grid data
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, DirtyTopLevelGridBuffer)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_TopLevelGridData>, RWRasterTopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWExtinctionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWEmissionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWScatteringGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_GridData>, RWVelocityGridBuffer)
+
+		// Brick pool
+		SHADER_PARAMETER(uint32, GridDataFormats)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBrickFreeListBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_MergeDirtyTopLevelGridCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_MergeDirtyTopLevelGridCS", SF_Compute);
+
+
+class FHVPT_InterleaveShadingGridDataCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_InterleaveShadingGridDataCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_InterleaveShadingGridDataCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		// Raster tile data
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, RasterTileAllocatorBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FRasterTileData>, RasterTileBuffer)
+
+		// Indirect args
+		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
+
+		// Grid data
+		SHADER_PARAMETER(uint32, GridDataFormats)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ExtinctionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, EmissionGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_GridData>, ScatteringGridBuffer)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FHVPT_ShadingGridData>, RWShadingGridBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_InterleaveShadingGridDataCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_InterleaveShadingGridDataCS", SF_Compute);
+
+
 float HVPT::Private::CalcTanHalfFOV(float FOVInDegrees)
 {
 	return FMath::Tan(FMath::DegreesToRadians(FOVInDegrees * 0.5));
@@ -676,8 +954,95 @@ void HVPT::Private::ClipNearFarDistances(
 	FarPlaneDistance = FMath::Max(FarPlaneDistance, NearDistance + 1.0);
 }
 
+FHVPTFrustumGridDepthSliceDistribution FHVPTFrustumGridDepthSliceDistribution::MakeLinear()
+{
+	FHVPTFrustumGridDepthSliceDistribution Distribution;
+	for (int32 Bin = 0; Bin < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT; ++Bin)
+	{
+		Distribution.BinStarts[Bin / 4][Bin % 4] = static_cast<float>(Bin) / HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT;
+	}
+	return Distribution;
+}
+
+float HVPT::Private::CalculateDepthSliceDistributionForFrustumGrid(
+	const FViewInfo& View, float NearPlaneDistance, float FarPlaneDistance, FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution
+)
+{
+	DepthSliceDistribution = FHVPTFrustumGridDepthSliceDistribution::MakeLinear();
+
+	const float DepthRange = FarPlaneDistance - NearPlaneDistance;
+	if (!HVPT::UseAdaptiveDepthSlicesForFrustumGrid() || DepthRange <= 0.0f)
+	{
+		return DepthRange;
+	}
+
+	// Histogram of the view depths covered by the bounds of each volume in view
+	const float BinLength = DepthRange / HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT;
+	const FVector ViewDirection = View.GetViewDirection();
+	const FVector ViewOrigin = View.ViewMatrices.GetViewOrigin();
+
+	bool bBinOccupied[HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT] = {};
+	bool bAnyBinOccupied = false;
+
+	for (int32 MeshBatchIndex = 0; MeshBatchIndex < View.HeterogeneousVolumesMeshBatches.Num(); ++MeshBatchIndex)
+	{
+		const FMeshBatch* Mesh = View.HeterogeneousVolumesMeshBatches[MeshBatchIndex].Mesh;
+		const FPrimitiveSceneProxy* PrimitiveSceneProxy = View.HeterogeneousVolumesMeshBatches[MeshBatchIndex].Proxy;
+		if (!HVPT::ShouldRenderMeshBatchWithHVPT(Mesh, PrimitiveSceneProxy, View.GetFeatureLevel()))
+			continue;
+
+		for (int32 VolumeIndex = 0; VolumeIndex < Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			const IHeterogeneousVolumeInterface* HeterogeneousVolume = static_cast<const IHeterogeneousVolumeInterface*>(Mesh->Elements[VolumeIndex].UserData);
+
+			const FBoxSphereBounds& PrimitiveBounds = HeterogeneousVolume->GetBounds();
+			if (!View.ViewFrustum.IntersectBox(PrimitiveBounds.Origin, PrimitiveBounds.BoxExtent))
+				continue;
+
+			// Extent of the bounding box along the view direction
+			const float CenterDepth = FVector::DotProduct(PrimitiveBounds.Origin - ViewOrigin, ViewDirection);
+			const float HalfDepth = FVector::DotProduct(PrimitiveBounds.BoxExtent, ViewDirection.GetAbs());
+			if (CenterDepth + HalfDepth < NearPlaneDistance || CenterDepth - HalfDepth > FarPlaneDistance)
+				continue;
+
+			const int32 FirstBin = FMath::Clamp(FMath::FloorToInt32((CenterDepth - HalfDepth - NearPlaneDistance) / BinLength), 0, HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT - 1);
+			const int32 LastBin = FMath::Clamp(FMath::FloorToInt32((CenterDepth + HalfDepth - NearPlaneDistance) / BinLength), 0, HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT - 1);
+			for (int32 Bin = FirstBin; Bin <= LastBin; ++Bin)
+			{
+				bBinOccupied[Bin] = true;
+			}
+			bAnyBinOccupied = true;
+		}
+	}
+
+	if (!bAnyBinOccupied)
+	{
+		return DepthRange;
+	}
+
+	// Empty ranges keep a few slices so that the distribution can still be inverted, and so lookups there find empty cells
+	const float EmptyBinWeight = HVPT::GetEmptyDepthSliceWeightForFrustumGrid();
+
+	float TotalWeight = 0.0f;
+	for (int32 Bin = 0; Bin < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT; ++Bin)
+	{
+		TotalWeight += bBinOccupied[Bin] ? 1.0f : EmptyBinWeight;
+	}
+
+	float CumulativeWeight = 0.0f;
+	for (int32 Bin = 0; Bin < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT; ++Bin)
+	{
+		DepthSliceDistribution.BinStarts[Bin / 4][Bin % 4] = CumulativeWeight / TotalWeight;
+		CumulativeWeight += bBinOccupied[Bin] ? 1.0f : EmptyBinWeight;
+	}
+
+	// Slices in occupied bins are as thick as they would be if evenly spread over this length
+	return TotalWeight * BinLength;
+}
+
 void HVPT::Private::CalculateTopLevelGridResolutionForFrustumGrid(
-	const FViewInfo& View, const FHVPT_VoxelGridBuildOptions& BuildOptions, float MinimumVoxelSize, float NearPlaneDistance, float& FarPlaneDistance, FIntVector& TopLevelGridResolution
+	const FViewInfo& View, const FHVPT_VoxelGridBuildOptions& BuildOptions, float MinimumVoxelSize, float NearPlaneDistance, float& FarPlaneDistance, FIntVector& TopLevelGridResolution,
+	FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution
 )
 {
 	// Determine top-level grid resolution
@@ -702,7 +1067,9 @@ void HVPT::Private::CalculateTopLevelGridResolutionForFrustumGrid(
 	}
 
 	// Depth slices should not be smaller than the declared minimum voxel size
-	int32 MaxDepth = FMath::CeilToInt32((FarPlaneDistance - NearPlaneDistance) / MinimumVoxelSize);
+	// Concentrating slices on the depths volumes occupy makes them thinner there, so fewer slices reach that limit
+	const float SlicedDepth = CalculateDepthSliceDistributionForFrustumGrid(View, NearPlaneDistance, FarPlaneDistance, DepthSliceDistribution);
+	int32 MaxDepth = FMath::CeilToInt32(SlicedDepth / MinimumVoxelSize);
 	int32 Depth = FMath::Min(FMath::CeilToInt32(HVPT::GetDepthSliceCountForFrustumGrid() / ShadingRate), MaxDepth);
 
 	TopLevelGridResolution = FIntVector(Width, Height, Depth);
@@ -712,7 +1079,7 @@ void HVPT::Private::CalculateTopLevelGridResolutionForFrustumGrid(
 }
 
 void HVPT::Private::MarkTopLevelGridVoxelsForFrustumGrid(
-	FRDGBuilder& GraphBuilder, const FViewInfo& View, FIntVector TopLevelGridResolution, float NearPlaneDistance, float FarPlaneDistance, const FMatrix& ViewToWorld, FRDGBufferRef& TopLevelGridBuffer
+	FRDGBuilder& GraphBuilder, const FViewInfo& View, FIntVector TopLevelGridResolution, float NearPlaneDistance, float FarPlaneDistance, const FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution, const FMatrix& ViewToWorld, FRDGBufferRef& TopLevelGridBuffer, ERDGPassFlags ComputePassFlags
 )
 {
 	int32 TopLevelVoxelCount = TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z;
@@ -721,7 +1088,7 @@ void HVPT::Private::MarkTopLevelGridVoxelsForFrustumGrid(
 		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_TopLevelGridData), TopLevelVoxelCount),
 		TEXT("HVPT.FrustumGrid.TopLevelGridBuffer")
 	);
-	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(TopLevelGridBuffer), 0xFFFFFFF8);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(TopLevelGridBuffer), 0xFFFFFFF8, ComputePassFlags);
 
 	for (int32 MeshBatchIndex = 0; MeshBatchIndex < View.HeterogeneousVolumesMeshBatches.Num(); ++MeshBatchIndex)
 	{
@@ -745,6 +1112,10 @@ void HVPT::Private::MarkTopLevelGridVoxelsForFrustumGrid(
 				PassParameters->TanHalfFOV = CalcTanHalfFOV(View.FOV);
 				PassParameters->NearPlaneDepth = NearPlaneDistance;
 				PassParameters->FarPlaneDepth = FarPlaneDistance;
+				for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+				{
+					PassParameters->DepthSliceDistribution[i] = DepthSliceDistribution.BinStarts[i];
+				}
 
 				PassParameters->VoxelDimensions = TopLevelGridResolution;
 				PassParameters->TopLevelGridResolution = TopLevelGridResolution;
@@ -761,7 +1132,7 @@ void HVPT::Private::MarkTopLevelGridVoxelsForFrustumGrid(
 			FComputeShaderUtils::AddPass(
 				GraphBuilder,
 				RDG_EVENT_NAME("MarkTopLevelGridVoxelsForFrustumGrid"),
-				ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+				ComputePassFlags | ERDGPassFlags::NeverCull,
 				ComputeShader,
 				PassParameters,
 				GroupCount
@@ -771,7 +1142,7 @@ void HVPT::Private::MarkTopLevelGridVoxelsForFrustumGrid(
 }
 
 void HVPT::Private::GenerateRasterTiles(
-	FRDGBuilder& GraphBuilder, const FScene* Scene, FIntVector TopLevelGridResolution, FRDGBufferRef TopLevelGridBuffer, FRDGBufferRef& RasterTileBuffer, FRDGBufferRef& RasterTileAllocatorBuffer
+	FRDGBuilder& GraphBuilder, const FScene* Scene, FIntVector TopLevelGridResolution, FRDGBufferRef TopLevelGridBuffer, FRDGBufferRef& RasterTileBuffer, FRDGBufferRef& RasterTileAllocatorBuffer, ERDGPassFlags ComputePassFlags
 )
 {
 	const uint32 RasterTileVoxelResolution = HVPT::GetBottomLevelGridResolution();
@@ -785,7 +1156,7 @@ void HVPT::Private::GenerateRasterTiles(
 		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 1),
 		TEXT("HVPT.RasterTileAllocatorBuffer")
 	);
-	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(RasterTileAllocatorBuffer, PF_R32_UINT), 0);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(RasterTileAllocatorBuffer, PF_R32_UINT), 0, ComputePassFlags);
 
 	FHVPT_GenerateRasterTilesCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_GenerateRasterTilesCS::FParameters>();
 	{
@@ -810,7 +1181,7 @@ void HVPT::Private::GenerateRasterTiles(
 	FComputeShaderUtils::AddPass(
 		GraphBuilder,
 		RDG_EVENT_NAME("GenerateRasterTiles"),
-		ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+		ComputePassFlags | ERDGPassFlags::NeverCull,
 		ComputeShader,
 		PassParameters,
 		GroupCount
@@ -825,14 +1196,18 @@ void HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 	FMatrix& ViewToWorld,
 	float NearPlaneDistance,
 	float FarPlaneDistance,
+	const FHVPTFrustumGridDepthSliceDistribution& DepthSliceDistribution,
 	FRDGBufferRef RasterTileBuffer,
 	FRDGBufferRef RasterTileAllocatorBuffer,
 	FIntVector TopLevelGridResolution,
-	FRDGBufferRef& TopLevelGridBuffer,
-	FRDGBufferRef& ExtinctionGridBuffer,
-	FRDGBufferRef& EmissionGridBuffer,
-	FRDGBufferRef& ScatteringGridBuffer,
-	FRDGBufferRef& VelocityGridBuffer
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	uint32 GridDataFormats
 )
 {
 	//Setup indirect dispatch
@@ -856,40 +1231,13 @@ void HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 		FComputeShaderUtils::AddPass(
 			GraphBuilder,
 			RDG_EVENT_NAME("SetRasterizeBottomLevelGridIndirectArgs"),
-			ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+			BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
 			ComputeShader,
 			IndirectArgsPassParameters,
 			GroupCount
 		);
 	}
 
-	// Pre-allocate bottom-level voxel grid pool based on user-defined budget
-	int32 MaxBottomLevelVoxelCount = (HVPT::GetMaxBottomLevelMemoryInMegabytesForFrustumGrid() * 1e6) / sizeof(FHVPT_GridData);
-	int32 BottomLevelGridBufferSize = MaxBottomLevelVoxelCount;
-
-	ExtinctionGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.FrustumGrid.ExtinctionGridBuffer")
-	);
-	EmissionGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.FrustumGrid.EmissionGridBuffer")
-	);
-	ScatteringGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.FrustumGrid.ScatteringGridBuffer")
-	);
-	VelocityGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.FrustumGrid.VelocityGridBuffer")
-	);
-
-	FRDGBufferRef BottomLevelGridAllocatorBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 2),
-		TEXT("HVPT.FrustumGrid.BottomLevelGridAllocatorBuffer")
-	);
-	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(BottomLevelGridAllocatorBuffer, PF_R32_UINT), 0);
-
 	// Rasterize volumes into bottom-level grid
 	for (int32 MeshBatchIndex = 0; MeshBatchIndex < View.HeterogeneousVolumesMeshBatches.Num(); ++MeshBatchIndex)
 	{
@@ -944,6 +1292,10 @@ void HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 				PassParameters->TanHalfFOV = CalcTanHalfFOV(View.FOV);
 				PassParameters->NearPlaneDepth = NearPlaneDistance;
 				PassParameters->FarPlaneDepth = FarPlaneDistance;
+				for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+				{
+					PassParameters->DepthSliceDistribution[i] = DepthSliceDistribution.BinStarts[i];
+				}
 
 				PassParameters->LocalToWorld_Velocity = FMatrix44f(HeterogeneousVolumeInterface->GetLocalToWorld());
 
@@ -960,20 +1312,21 @@ void HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 				PassParameters->IndirectArgs = RasterizeBottomLevelGridIndirectArgsBuffer;
 
 				// Grid data
-				PassParameters->RWBottomLevelGridAllocatorBuffer = GraphBuilder.CreateUAV(BottomLevelGridAllocatorBuffer, PF_R32_UINT);
+				PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+				PassParameters->RWBrickOverflowCountBuffer = GraphBuilder.CreateUAV(BrickOverflowCountBuffer, PF_R32_UINT);
 				PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
 
 				PassParameters->RWExtinctionGridBuffer = GraphBuilder.CreateUAV(ExtinctionGridBuffer);
 				PassParameters->RWEmissionGridBuffer = GraphBuilder.CreateUAV(EmissionGridBuffer);
 				PassParameters->RWScatteringGridBuffer = GraphBuilder.CreateUAV(ScatteringGridBuffer);
 				PassParameters->RWVelocityGridBuffer = GraphBuilder.CreateUAV(VelocityGridBuffer);
-				PassParameters->BottomLevelGridBufferSize = BottomLevelGridBufferSize;
+				PassParameters->GridDataFormats = GridDataFormats;
 			}
 
 			GraphBuilder.AddPass(
 				RDG_EVENT_NAME("FrustumGrid.RasterizeBottomLevelGrid"),
 				PassParameters,
-				ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+				BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
 				[PassParameters, Scene, MaterialRenderProxy, &Material, bEnableVelocity](FRDGAsyncTask, FRHIComputeCommandList& RHICmdList)
 				{
 					FHVPT_RasterizeBottomLevelFrustumGridCS::FPermutationDomain PermutationVector;
@@ -1018,6 +1371,10 @@ void HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 		PassParameters->TanHalfFOV = CalcTanHalfFOV(View.FOV);
 		PassParameters->NearPlaneDepth = NearPlaneDistance;
 		PassParameters->FarPlaneDepth = FarPlaneDistance;
+		for (int32 i = 0; i < HVPT_FRUSTUM_GRID_DEPTH_BIN_COUNT / 4; ++i)
+		{
+			PassParameters->DepthSliceDistribution[i] = DepthSliceDistribution.BinStarts[i];
+		}
 
 		// Sampling data
 		PassParameters->bJitter = BuildOptions.bJitter;
@@ -1032,21 +1389,22 @@ void HVPT::Private::RasterizeVolumesIntoFrustumVoxelGrid(
 		PassParameters->IndirectArgs = RasterizeBottomLevelGridIndirectArgsBuffer;
 
 		// Grid data
-		PassParameters->RWBottomLevelGridAllocatorBuffer = GraphBuilder.CreateUAV(BottomLevelGridAllocatorBuffer, PF_R32_UINT);
+		PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+		PassParameters->RWBrickOverflowCountBuffer = GraphBuilder.CreateUAV(BrickOverflowCountBuffer, PF_R32_UINT);
 		PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
 
 		PassParameters->RWExtinctionGridBuffer = GraphBuilder.CreateUAV(ExtinctionGridBuffer);
 		PassParameters->RWEmissionGridBuffer = GraphBuilder.CreateUAV(EmissionGridBuffer);
 		PassParameters->RWScatteringGridBuffer = GraphBuilder.CreateUAV(ScatteringGridBuffer);
 		PassParameters->RWVelocityGridBuffer = GraphBuilder.CreateUAV(VelocityGridBuffer);
-		PassParameters->BottomLevelGridBufferSize = BottomLevelGridBufferSize;
+		PassParameters->GridDataFormats = GridDataFormats;
 
 		TShaderRef<FHVPT_RasterizeFogFrustumGridCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_RasterizeFogFrustumGridCS>();
 
 		GraphBuilder.AddPass(
 			RDG_EVENT_NAME("RasterizeFogFrustumGridCS"),
 			PassParameters,
-			ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+			BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
 			[PassParameters, ComputeShader](FRDGAsyncTask, FRHIComputeCommandList& RHICmdList)
 			{
 				ClearUnusedGraphResources(ComputeShader, PassParameters);
@@ -1073,15 +1431,95 @@ void HVPT::Private::CollectHeterogeneousVolumeMeshBatches(
 	}
 }
 
-void HVPT::Private::CalcGlobalBoundsAndMinimumVoxelSize(
-	const FViewInfo& View,
-	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
-	const FHVPT_VoxelGridBuildOptions& BuildOptions,
-	FBoxSphereBounds::Builder& TopLevelGridBoundsBuilder,
-	float& GlobalMinimumVoxelSize
+bool HVPT::Private::AreAllVolumesMonochrome(
+	const FViewInfo& View, const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches
 )
 {
-	GlobalMinimumVoxelSize = HVPT::GetMinimumVoxelSizeOutsideFrustum();
+	bool bAnyVolumes = false;
+	for (auto MeshBatchIt = HeterogeneousVolumesMeshBatches.begin(); MeshBatchIt != HeterogeneousVolumesMeshBatches.end(); ++MeshBatchIt)
+	{
+		const FVolumetricMeshBatch& MeshBatch = *MeshBatchIt;
+		const FMeshBatch* Mesh = MeshBatch.Mesh;
+		const FPrimitiveSceneProxy* PrimitiveSceneProxy = MeshBatch.Proxy;
+
+		if (!HVPT::ShouldRenderMeshBatchWithHVPT(Mesh, PrimitiveSceneProxy, View.GetFeatureLevel()))
+		{
+			continue;
+		}
+
+		// Extinction of the material cannot be inspected on the CPU, so volumes must declare that it is grey
+		if (!HVPT::HasExtendedInterface(PrimitiveSceneProxy))
+		{
+			return false;
+		}
+
+		for (int32 VolumeIndex = 0; VolumeIndex < Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			const IHeterogeneousVolumeInterface* HeterogeneousVolumeInterface = static_cast<const IHeterogeneousVolumeInterface*>(Mesh->Elements[VolumeIndex].UserData);
+			auto HeterogeneousVolumeExInterface = static_cast<const IHeterogeneousVolumeExInterface*>(HeterogeneousVolumeInterface);
+			if (!HeterogeneousVolumeExInterface->HasMonochromeExtinction())
+			{
+				return false;
+			}
+			bAnyVolumes = true;
+		}
+	}
+	return bAnyVolumes;
+}
+
+bool HVPT::Private::ShouldUseMonochromeExtinction(const FViewInfo& View)
+{
+	if (!HVPT::UseMonochromeExtinction())
+	{
+		return false;
+	}
+
+	TSet<FVolumetricMeshBatch> HeterogeneousVolumesMeshBatches;
+	CollectHeterogeneousVolumeMeshBatches(View, HeterogeneousVolumesMeshBatches);
+	return AreAllVolumesMonochrome(View, HeterogeneousVolumesMeshBatches);
+}
+
+FHVPTVolumeLODPolicy HVPT::Private::GetVolumeLODPolicy(
+	const FPrimitiveSceneProxy* PrimitiveSceneProxy, const IHeterogeneousVolumeInterface* HeterogeneousVolume
+)
+{
+	const int32 BottomLevelGridResolution = HVPT::GetBottomLevelGridResolution();
+
+	FHVPTVolumeLODPolicy Policy;
+	Policy.MinBrickResolution = 1;
+	Policy.MaxBrickResolution = BottomLevelGridResolution;
+
+	if (HVPT::HasExtendedInterface(PrimitiveSceneProxy))
+	{
+		auto HeterogeneousVolumeExInterface = static_cast<const IHeterogeneousVolumeExInterface*>(HeterogeneousVolume);
+
+		// Cells are only ever given power of two resolutions, so round the limits inwards to the ones they allow
+		if (HeterogeneousVolumeExInterface->GetMaxBrickResolution() > 0)
+		{
+			const int32 MaxBrickResolution = FMath::Clamp(HeterogeneousVolumeExInterface->GetMaxBrickResolution(), 1, BottomLevelGridResolution);
+			Policy.MaxBrickResolution = 1 << FMath::FloorLog2(MaxBrickResolution);
+		}
+
+		const int32 MinBrickResolution = FMath::Clamp(HeterogeneousVolumeExInterface->GetMinBrickResolution(), 1, Policy.MaxBrickResolution);
+		Policy.MinBrickResolution = FMath::Min(static_cast<int32>(FMath::RoundUpToPowerOfTwo(MinBrickResolution)), Policy.MaxBrickResolution);
+
+		// Importance is a share of memory, which goes with the cube of the resolution
+		const float Importance = FMath::Max(HeterogeneousVolumeExInterface->GetLODImportance(), 0.01f);
+		Policy.ProjectedVoxelSizeScale = FMath::Exp2(HeterogeneousVolumeExInterface->GetLODDistanceBias()) / FMath::Pow(Importance, 1.0f / 3.0f);
+	}
+
+	return Policy;
+}
+
+void HVPT::Private::CalcGlobalBoundsAndMinimumVoxelSize(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	FBoxSphereBounds::Builder& TopLevelGridBoundsBuilder,
+	float& GlobalMinimumVoxelSize
+)
+{
+	GlobalMinimumVoxelSize = HVPT::GetMinimumVoxelSizeOutsideFrustum();
 
 	// Build view bounds
 	FVector WorldCameraOrigin = View.ViewMatrices.GetViewOrigin();
@@ -1173,7 +1611,7 @@ void HVPT::Private::CalculateTopLevelGridResolution(
 
 void HVPT::Private::CalculateVoxelSize(
 	FRDGBuilder& GraphBuilder,
-	const FViewInfo& View, 
+	TConstArrayView<const FViewInfo*> Views,
 	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
 	const FHVPT_VoxelGridBuildOptions& BuildOptions,
 	const FBoxSphereBounds& TopLevelGridBounds, 
@@ -1185,7 +1623,7 @@ void HVPT::Private::CalculateVoxelSize(
 		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_TopLevelGridData), TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z),
 		TEXT("HVPT.TopLevelGridBuffer")
 	);
-	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(TopLevelGridBuffer), 0xFFFFFFF8);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(TopLevelGridBuffer), 0xFFFFFFF8, BuildOptions.ComputePassFlags);
 
 	for (auto MeshBatchIt = HeterogeneousVolumesMeshBatches.begin(); MeshBatchIt != HeterogeneousVolumesMeshBatches.end(); ++MeshBatchIt)
 	{
@@ -1197,48 +1635,801 @@ void HVPT::Private::CalculateVoxelSize(
 			const IHeterogeneousVolumeInterface* HeterogeneousVolume = static_cast<const IHeterogeneousVolumeInterface*>(Mesh->Elements[VolumeIndex].UserData);
 
 			const FBoxSphereBounds& PrimitiveBounds = HeterogeneousVolume->GetBounds();
-			FHVPT_TopLevelGridCalculateVoxelSizeCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_TopLevelGridCalculateVoxelSizeCS::FParameters>();
+			const FHVPTVolumeLODPolicy LODPolicy = GetVolumeLODPolicy(MeshBatch.Proxy, HeterogeneousVolume);
+
+			// Each pass keeps the minimum of its own voxel size and the one already in the cell, so dispatching once per view
+			// leaves the finest voxel size that any view requires
+			for (const FViewInfo* View : Views)
 			{
-				PassParameters->View = View.ViewUniformBuffer;
+				FHVPT_TopLevelGridCalculateVoxelSizeCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_TopLevelGridCalculateVoxelSizeCS::FParameters>();
+				{
+					PassParameters->View = View->ViewUniformBuffer;
 
-				PassParameters->TopLevelGridResolution = TopLevelGridResolution;
-				PassParameters->TopLevelGridWorldBoundsMin = FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent);
-				PassParameters->TopLevelGridWorldBoundsMax = FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
+					PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+					PassParameters->TopLevelGridWorldBoundsMin = FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent);
+					PassParameters->TopLevelGridWorldBoundsMax = FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
 
-				PassParameters->PrimitiveWorldBoundsMin = FVector3f(PrimitiveBounds.Origin - PrimitiveBounds.BoxExtent);
-				PassParameters->PrimitiveWorldBoundsMax = FVector3f(PrimitiveBounds.Origin + PrimitiveBounds.BoxExtent);
+					PassParameters->PrimitiveWorldBoundsMin = FVector3f(PrimitiveBounds.Origin - PrimitiveBounds.BoxExtent);
+					PassParameters->PrimitiveWorldBoundsMax = FVector3f(PrimitiveBounds.Origin + PrimitiveBounds.BoxExtent);
+
+					PassParameters->ShadingRateInFrustum = BuildOptions.ShadingRateInFrustum;
+					PassParameters->ShadingRateOutOfFrustum = BuildOptions.ShadingRateOutOfFrustum;
+					PassParameters->MinVoxelSizeInFrustum = FMath::Max(HeterogeneousVolume->GetMinimumVoxelSize(), HVPT::GetMinimumVoxelSizeInsideFrustum());
+					PassParameters->MinVoxelSizeOutOfFrustum = HVPT::GetMinimumVoxelSizeOutsideFrustum();
+					PassParameters->bUseProjectedPixelSize = BuildOptions.bUseProjectedPixelSizeForOrthoGrid;
+
+					PassParameters->ProjectedVoxelSizeScale = LODPolicy.ProjectedVoxelSizeScale;
+					PassParameters->MinBrickResolution = LODPolicy.MinBrickResolution;
+					PassParameters->MaxBrickResolution = LODPolicy.MaxBrickResolution;
+
+					PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+				}
+
+				FIntVector GroupCount;
+				GroupCount.X = FMath::DivideAndRoundUp(TopLevelGridResolution.X, FHVPT_TopLevelGridCalculateVoxelSizeCS::GetThreadGroupSize3D());
+				GroupCount.Y = FMath::DivideAndRoundUp(TopLevelGridResolution.Y, FHVPT_TopLevelGridCalculateVoxelSizeCS::GetThreadGroupSize3D());
+				GroupCount.Z = FMath::DivideAndRoundUp(TopLevelGridResolution.Z, FHVPT_TopLevelGridCalculateVoxelSizeCS::GetThreadGroupSize3D());
+
+				TShaderRef<FHVPT_TopLevelGridCalculateVoxelSizeCS> ComputeShader = View->ShaderMap->GetShader<FHVPT_TopLevelGridCalculateVoxelSizeCS>();
+				FComputeShaderUtils::AddPass(
+					GraphBuilder,
+					RDG_EVENT_NAME("TopLevelGridCalculateVoxelSize"),
+					BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
+					ComputeShader,
+					PassParameters,
+					GroupCount
+				);
+			}
+		}
+	}
+}
+
+// Inclusive box of top-level cells that Bounds may touch, padded as cells only touching the bounds are also considered intersecting by the GPU
+static void CalcPaddedCellBox(const FBox& Bounds, const FBoxSphereBounds& TopLevelGridBounds, FIntVector TopLevelGridResolution, FIntVector& CellMin, FIntVector& CellMax)
+{
+	const FVector TopLevelGridWorldBoundsMin = TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent;
+	const FVector TopLevelVoxelSize = (TopLevelGridBounds.BoxExtent * 2.0) / FVector(TopLevelGridResolution);
+
+	const FVector CellMinAsFloat = (Bounds.Min - TopLevelGridWorldBoundsMin) / TopLevelVoxelSize;
+	const FVector CellMaxAsFloat = (Bounds.Max - TopLevelGridWorldBoundsMin) / TopLevelVoxelSize;
+
+	CellMin = FIntVector(
+		FMath::Max(FMath::FloorToInt(CellMinAsFloat.X) - 1, 0),
+		FMath::Max(FMath::FloorToInt(CellMinAsFloat.Y) - 1, 0),
+		FMath::Max(FMath::FloorToInt(CellMinAsFloat.Z) - 1, 0)
+	);
+	CellMax = FIntVector(
+		FMath::Min(FMath::FloorToInt(CellMaxAsFloat.X) + 1, TopLevelGridResolution.X - 1),
+		FMath::Min(FMath::FloorToInt(CellMaxAsFloat.Y) + 1, TopLevelGridResolution.Y - 1),
+		FMath::Min(FMath::FloorToInt(CellMaxAsFloat.Z) + 1, TopLevelGridResolution.Z - 1)
+	);
+}
+
+void HVPT::Private::CollectOrthoGridDirectVolumes(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTOrthoGridDirectVolume>& DirectVolumes,
+	TSet<FVolumetricMeshBatch>& RasterMeshBatches
+)
+{
+	DirectVolumes.Reset();
+	RasterMeshBatches = HeterogeneousVolumesMeshBatches;
+
+	// Fog is rasterized into the bricks of every occupied cell, which directly sampled cells do not have
+	if (!HVPT::EnableDirectVolumesForOrthoGrid() || HVPT::GetFogCompositingMode() == EFogCompositionMode::PostAndPathTracing)
+	{
+		return;
+	}
+
+	struct FVolumeCells
+	{
+		FIntVector CellMin;
+		FIntVector CellMax;
+	};
+	TArray<FVolumeCells> AllVolumeCells;
+
+	struct FCandidate
+	{
+		FVolumetricMeshBatch MeshBatch;
+		const IHeterogeneousVolumeExInterface* HeterogeneousVolume = nullptr;
+		uint64 VolumeKey = 0;
+		int32 VolumeCellsIndex = INDEX_NONE;
+	};
+	TArray<FCandidate> Candidates;
+
+	for (auto MeshBatchIt = HeterogeneousVolumesMeshBatches.begin(); MeshBatchIt != HeterogeneousVolumesMeshBatches.end(); ++MeshBatchIt)
+	{
+		const FVolumetricMeshBatch& MeshBatch = *MeshBatchIt;
+		const FMeshBatch* Mesh = MeshBatch.Mesh;
+		const FPrimitiveSceneProxy* PrimitiveSceneProxy = MeshBatch.Proxy;
+
+		for (int32 VolumeIndex = 0; VolumeIndex < Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			const IHeterogeneousVolumeInterface* HeterogeneousVolumeInterface = static_cast<const IHeterogeneousVolumeInterface*>(Mesh->Elements[VolumeIndex].UserData);
+
+			FVolumeCells& VolumeCells = AllVolumeCells.AddDefaulted_GetRef();
+			CalcPaddedCellBox(HeterogeneousVolumeInterface->GetBounds().GetBox(), TopLevelGridBounds, TopLevelGridResolution, VolumeCells.CellMin, VolumeCells.CellMax);
+
+			// A slot replaces the whole mesh batch, so it must contain only this volume
+			if (Mesh->Elements.Num() != 1
+				|| !HVPT::ShouldRenderMeshBatchWithHVPT(Mesh, PrimitiveSceneProxy, View.GetFeatureLevel())
+				|| !HVPT::HasExtendedInterface(PrimitiveSceneProxy))
+			{
+				continue;
+			}
+
+			auto HeterogeneousVolumeExInterface = static_cast<const IHeterogeneousVolumeExInterface*>(HeterogeneousVolumeInterface);
+			const UE::SVT::FTextureRenderResources* TextureRenderResources = HeterogeneousVolumeExInterface->GetDirectSparseVolumeTexture();
+			if (!TextureRenderResources
+				|| !TextureRenderResources->GetPageTableTexture()
+				|| !TextureRenderResources->GetPhysicalTileDataATexture()
+				|| !TextureRenderResources->GetPhysicalTileDataBTexture())
+			{
+				continue;
+			}
+
+			FCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+			Candidate.MeshBatch = MeshBatch;
+			Candidate.HeterogeneousVolume = HeterogeneousVolumeExInterface;
+			Candidate.VolumeKey = (static_cast<uint64>(PrimitiveSceneProxy->GetPrimitiveComponentId().PrimIDValue) << 32) | static_cast<uint64>(VolumeIndex);
+			Candidate.VolumeCellsIndex = AllVolumeCells.Num() - 1;
+		}
+	}
+
+	// Give slots in a stable order, so that the same volumes keep the same slots between builds
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.VolumeKey < B.VolumeKey; });
+
+	// Instances of the same texture frame are only given their own transform, and share the textures of a single texture slot
+	TArray<const UE::SVT::FTextureRenderResources*, TInlineAllocator<HVPT_MAX_DIRECT_VOLUME_TEXTURES>> Textures;
+
+	for (const FCandidate& Candidate : Candidates)
+	{
+		if (DirectVolumes.Num() >= HVPT_MAX_DIRECT_VOLUMES)
+		{
+			break;
+		}
+
+		// Cells hold either a brick or a slot, so the volume must not share a cell with any other volume
+		const FVolumeCells& CandidateCells = AllVolumeCells[Candidate.VolumeCellsIndex];
+		bool bSharesCells = false;
+		for (int32 VolumeCellsIndex = 0; VolumeCellsIndex < AllVolumeCells.Num() && !bSharesCells; ++VolumeCellsIndex)
+		{
+			const FVolumeCells& OtherCells = AllVolumeCells[VolumeCellsIndex];
+			bSharesCells = VolumeCellsIndex != Candidate.VolumeCellsIndex
+				&& CandidateCells.CellMin.X <= OtherCells.CellMax.X && OtherCells.CellMin.X <= CandidateCells.CellMax.X
+				&& CandidateCells.CellMin.Y <= OtherCells.CellMax.Y && OtherCells.CellMin.Y <= CandidateCells.CellMax.Y
+				&& CandidateCells.CellMin.Z <= OtherCells.CellMax.Z && OtherCells.CellMin.Z <= CandidateCells.CellMax.Z;
+		}
+		if (bSharesCells)
+		{
+			continue;
+		}
+
+		const IHeterogeneousVolumeExInterface* HeterogeneousVolume = Candidate.HeterogeneousVolume;
+		const UE::SVT::FTextureRenderResources* TextureRenderResources = HeterogeneousVolume->GetDirectSparseVolumeTexture();
+
+		int32 TextureSlot = Textures.Find(TextureRenderResources);
+		if (TextureSlot == INDEX_NONE)
+		{
+			if (Textures.Num() >= HVPT_MAX_DIRECT_VOLUME_TEXTURES)
+			{
+				continue;
+			}
+			TextureSlot = Textures.Add(TextureRenderResources);
+		}
+
+		FHVPTOrthoGridDirectVolume& DirectVolume = DirectVolumes.AddDefaulted_GetRef();
+		DirectVolume.VolumeKey = Candidate.VolumeKey;
+		DirectVolume.TextureSlot = TextureSlot;
+
+		// Texture coordinates span the bounds of the volume in instance space, matching the UVW the material is rasterized with
+		const FMatrix InstanceToLocal = HeterogeneousVolume->GetInstanceToLocal();
+		const FBoxSphereBounds InstanceBounds = HeterogeneousVolume->GetLocalBounds().TransformBy(InstanceToLocal.Inverse());
+		const FVector InstanceBoundsMin = InstanceBounds.Origin - InstanceBounds.BoxExtent;
+		const FVector InstanceBoundsSize = FVector::Max(InstanceBounds.BoxExtent * 2.0, FVector(UE_SMALL_NUMBER));
+		const FMatrix WorldToUVW = HeterogeneousVolume->GetInstanceToWorld().Inverse() * FTranslationMatrix(-InstanceBoundsMin) * FScaleMatrix(FVector(1.0) / InstanceBoundsSize);
+		DirectVolume.WorldToUVW = FMatrix44f(WorldToUVW);
+
+		TextureRenderResources->GetPackedUniforms(DirectVolume.PackedUniforms0, DirectVolume.PackedUniforms1);
+		DirectVolume.PageTableTexture = TextureRenderResources->GetPageTableTexture();
+		DirectVolume.PhysicalTileDataATexture = TextureRenderResources->GetPhysicalTileDataATexture();
+		DirectVolume.PhysicalTileDataBTexture = TextureRenderResources->GetPhysicalTileDataBTexture();
+
+		DirectVolume.Albedo = HeterogeneousVolume->GetDirectAlbedo();
+		DirectVolume.ExtinctionScale = FMath::Max(HeterogeneousVolume->GetDirectExtinctionScale(), 0.0f);
+		DirectVolume.MaxDensity = FMath::Max(HeterogeneousVolume->GetDirectMaxDensity(), 0.0f);
+		DirectVolume.EmissionScale = FMath::Max(HeterogeneousVolume->GetDirectEmissionScale(), 0.0f);
+
+		DirectVolume.WorldBounds = HeterogeneousVolume->GetBounds().GetBox();
+		DirectVolume.CellMin = CandidateCells.CellMin;
+		DirectVolume.CellMax = CandidateCells.CellMax;
+
+		RasterMeshBatches.Remove(Candidate.MeshBatch);
+	}
+}
+
+void HVPT::Private::MarkDirectVolumeCells(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	int32 BottomLevelGridResolution,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes,
+	FRDGBufferRef TopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+
+	for (int32 Slot = 0; Slot < DirectVolumes.Num(); ++Slot)
+	{
+		const FHVPTOrthoGridDirectVolume& DirectVolume = DirectVolumes[Slot];
+
+		FHVPT_MarkDirectVolumeCellsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_MarkDirectVolumeCellsCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->TopLevelGridWorldBoundsMin = FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent);
+			PassParameters->TopLevelGridWorldBoundsMax = FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
+
+			PassParameters->PrimitiveWorldBoundsMin = FVector3f(DirectVolume.WorldBounds.Min);
+			PassParameters->PrimitiveWorldBoundsMax = FVector3f(DirectVolume.WorldBounds.Max);
+			PassParameters->DirectVolumeCellMin = DirectVolume.CellMin;
+			PassParameters->DirectVolumeCellMax = DirectVolume.CellMax;
+			PassParameters->DirectVolumeSlot = Slot;
+			PassParameters->DirectVolumeVoxelResolution = BottomLevelGridResolution;
+
+			PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+		}
+
+		const FIntVector CellCount = DirectVolume.CellMax - DirectVolume.CellMin + FIntVector(1);
+		FIntVector GroupCount;
+		GroupCount.X = FMath::DivideAndRoundUp(CellCount.X, FHVPT_MarkDirectVolumeCellsCS::GetThreadGroupSize3D());
+		GroupCount.Y = FMath::DivideAndRoundUp(CellCount.Y, FHVPT_MarkDirectVolumeCellsCS::GetThreadGroupSize3D());
+		GroupCount.Z = FMath::DivideAndRoundUp(CellCount.Z, FHVPT_MarkDirectVolumeCellsCS::GetThreadGroupSize3D());
+
+		TShaderRef<FHVPT_MarkDirectVolumeCellsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_MarkDirectVolumeCellsCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("MarkDirectVolumeCells"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			GroupCount
+		);
+	}
+}
+
+FIntVector HVPT::Private::CalcInstancedAssetGridResolution(
+	const FBox& LocalBounds,
+	const FVector& MaxInstanceScale,
+	const FVector& TopLevelVoxelSize
+)
+{
+	const FVector CellCount = LocalBounds.GetSize() * MaxInstanceScale / FVector::Max(TopLevelVoxelSize, FVector(UE_SMALL_NUMBER));
+	return FIntVector(
+		FMath::Clamp(FMath::CeilToInt(CellCount.X), 1, HVPT_MAX_INSTANCED_ASSET_GRID_RESOLUTION),
+		FMath::Clamp(FMath::CeilToInt(CellCount.Y), 1, HVPT_MAX_INSTANCED_ASSET_GRID_RESOLUTION),
+		FMath::Clamp(FMath::CeilToInt(CellCount.Z), 1, HVPT_MAX_INSTANCED_ASSET_GRID_RESOLUTION)
+	);
+}
+
+FMatrix HVPT::Private::CalcInstancedVolumeWorldToLocalVoxel(
+	const FMatrix& InstanceToWorld,
+	const FBox& LocalBounds,
+	const FIntVector& LocalGridResolution
+)
+{
+	const FVector LocalBoundsSize = FVector::Max(LocalBounds.GetSize(), FVector(UE_SMALL_NUMBER));
+	return InstanceToWorld.Inverse() * FTranslationMatrix(-LocalBounds.Min) * FScaleMatrix(FVector(LocalGridResolution) / LocalBoundsSize);
+}
+
+void HVPT::Private::CollectOrthoGridInstancedVolumes(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const TSet<FVolumetricMeshBatch>& CandidateMeshBatches,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTOrthoGridInstancedAsset>& InstancedAssets,
+	TArray<FHVPTOrthoGridInstancedVolume>& InstancedVolumes,
+	TSet<FVolumetricMeshBatch>& RasterMeshBatches
+)
+{
+	InstancedAssets.Reset();
+	InstancedVolumes.Reset();
+	RasterMeshBatches = CandidateMeshBatches;
+
+	// Fog is rasterized into the bricks of every occupied cell, which instanced cells do not have
+	if (!HVPT::EnableInstancedVolumesForOrthoGrid() || HVPT::GetFogCompositingMode() == EFogCompositionMode::PostAndPathTracing)
+	{
+		return;
+	}
+
+	struct FVolumeCells
+	{
+		const IHeterogeneousVolumeInterface* HeterogeneousVolume = nullptr;
+		FIntVector CellMin;
+		FIntVector CellMax;
+	};
+	TArray<FVolumeCells> AllVolumeCells;
+	for (const FVolumetricMeshBatch& MeshBatch : HeterogeneousVolumesMeshBatches)
+	{
+		for (int32 VolumeIndex = 0; VolumeIndex < MeshBatch.Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			FVolumeCells& VolumeCells = AllVolumeCells.AddDefaulted_GetRef();
+			VolumeCells.HeterogeneousVolume = static_cast<const IHeterogeneousVolumeInterface*>(MeshBatch.Mesh->Elements[VolumeIndex].UserData);
+			CalcPaddedCellBox(VolumeCells.HeterogeneousVolume->GetBounds().GetBox(), TopLevelGridBounds, TopLevelGridResolution, VolumeCells.CellMin, VolumeCells.CellMax);
+		}
+	}
+
+	struct FCandidate
+	{
+		FVolumetricMeshBatch MeshBatch;
+		const IHeterogeneousVolumeExInterface* HeterogeneousVolume = nullptr;
+		uint64 VolumeKey = 0;
+		FBox InstanceBounds = FBox(ForceInit);
+		const FVolumeCells* VolumeCells = nullptr;
+	};
+	TArray<FCandidate> Candidates;
+
+	for (const FVolumetricMeshBatch& MeshBatch : CandidateMeshBatches)
+	{
+		// An instance replaces the whole mesh batch, so it must contain only this volume, and the volume must be able to identify its frame
+		if (MeshBatch.Mesh->Elements.Num() != 1
+			|| !HVPT::ShouldRenderMeshBatchWithHVPT(MeshBatch.Mesh, MeshBatch.Proxy, View.GetFeatureLevel())
+			|| !HVPT::HasExtendedInterface(MeshBatch.Proxy))
+		{
+			continue;
+		}
+
+		auto HeterogeneousVolume = static_cast<const IHeterogeneousVolumeExInterface*>(MeshBatch.Mesh->Elements[0].UserData);
+		if (!HeterogeneousVolume->GetFrameCacheKey().IsValid())
+		{
+			continue;
+		}
+
+		// Cells hold either a brick or a slot, so the volume must not share a cell with any other volume
+		const FVolumeCells* CandidateCells = AllVolumeCells.FindByPredicate([HeterogeneousVolume](const FVolumeCells& VolumeCells) { return VolumeCells.HeterogeneousVolume == HeterogeneousVolume; });
+		if (!CandidateCells)
+		{
+			continue;
+		}
+
+		const bool bSharesCells = AllVolumeCells.ContainsByPredicate([CandidateCells](const FVolumeCells& OtherCells)
+			{
+				return &OtherCells != CandidateCells
+					&& CandidateCells->CellMin.X <= OtherCells.CellMax.X && OtherCells.CellMin.X <= CandidateCells->CellMax.X
+					&& CandidateCells->CellMin.Y <= OtherCells.CellMax.Y && OtherCells.CellMin.Y <= CandidateCells->CellMax.Y
+					&& CandidateCells->CellMin.Z <= OtherCells.CellMax.Z && OtherCells.CellMin.Z <= CandidateCells->CellMax.Z;
+			});
+		if (bSharesCells)
+		{
+			continue;
+		}
+
+		FCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+		Candidate.MeshBatch = MeshBatch;
+		Candidate.HeterogeneousVolume = HeterogeneousVolume;
+		Candidate.VolumeKey = static_cast<uint64>(MeshBatch.Proxy->GetPrimitiveComponentId().PrimIDValue) << 32;
+		Candidate.InstanceBounds = HeterogeneousVolume->GetLocalBounds().TransformBy(HeterogeneousVolume->GetInstanceToLocal().Inverse()).GetBox();
+		Candidate.VolumeCells = CandidateCells;
+	}
+
+	// Group and give slots in a stable order, so that the same volumes keep the same slots between builds
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.VolumeKey < B.VolumeKey; });
+
+	// Volumes showing the same frame over the same bounds in instance space only differ by their instance transform
+	TArray<TArray<int32, TInlineAllocator<4>>> Groups;
+	for (int32 CandidateIndex = 0; CandidateIndex < Candidates.Num(); ++CandidateIndex)
+	{
+		const FCandidate& Candidate = Candidates[CandidateIndex];
+		TArray<int32, TInlineAllocator<4>>* Group = Groups.FindByPredicate([&Candidates, &Candidate](const TArray<int32, TInlineAllocator<4>>& OtherGroup)
+			{
+				const FCandidate& Other = Candidates[OtherGroup[0]];
+				return Other.HeterogeneousVolume->GetFrameCacheKey() == Candidate.HeterogeneousVolume->GetFrameCacheKey()
+					&& Other.InstanceBounds.Min.Equals(Candidate.InstanceBounds.Min, 0.01)
+					&& Other.InstanceBounds.Max.Equals(Candidate.InstanceBounds.Max, 0.01);
+			});
+		if (Group)
+		{
+			Group->Add(CandidateIndex);
+		}
+		else
+		{
+			Groups.AddDefaulted_GetRef().Add(CandidateIndex);
+		}
+	}
+
+	const FVector TopLevelVoxelSize = (TopLevelGridBounds.BoxExtent * 2.0) / FVector(TopLevelGridResolution);
+
+	uint32 NextFirstCell = 0;
+	for (const TArray<int32, TInlineAllocator<4>>& Group : Groups)
+	{
+		// A single volume gains nothing from a local grid, and is left to be rasterized as usual
+		if (Group.Num() < 2 || InstancedVolumes.Num() + Group.Num() > HVPT_MAX_INSTANCED_VOLUMES)
+		{
+			continue;
+		}
+
+		const FCandidate& Reference = Candidates[Group[0]];
+		const int32 AssetIndex = InstancedAssets.Num();
+
+		FHVPTOrthoGridInstancedAsset& InstancedAsset = InstancedAssets.AddDefaulted_GetRef();
+		InstancedAsset.Mesh = Reference.MeshBatch.Mesh;
+		InstancedAsset.Proxy = Reference.MeshBatch.Proxy;
+		InstancedAsset.ReferenceInstanceToWorld = Reference.HeterogeneousVolume->GetInstanceToWorld();
+		InstancedAsset.LocalBounds = Reference.InstanceBounds;
+
+		// The local grid is made as fine as the ortho grid around the instance scaled up the most
+		FVector MaxInstanceScale = FVector::ZeroVector;
+		for (int32 CandidateIndex : Group)
+		{
+			MaxInstanceScale = FVector::Max(MaxInstanceScale, Candidates[CandidateIndex].HeterogeneousVolume->GetInstanceToWorld().GetScaleVector());
+		}
+		InstancedAsset.LocalGridResolution = CalcInstancedAssetGridResolution(InstancedAsset.LocalBounds, MaxInstanceScale, TopLevelVoxelSize);
+		InstancedAsset.FirstCell = NextFirstCell;
+		NextFirstCell += CalcMajorantMipSize(InstancedAsset.LocalGridResolution);
+
+		for (int32 CandidateIndex : Group)
+		{
+			const FCandidate& Candidate = Candidates[CandidateIndex];
+
+			FHVPTOrthoGridInstancedVolume& InstancedVolume = InstancedVolumes.AddDefaulted_GetRef();
+			InstancedVolume.VolumeKey = Candidate.VolumeKey;
+			InstancedVolume.AssetIndex = AssetIndex;
+			InstancedVolume.WorldToLocalVoxel = FMatrix44f(CalcInstancedVolumeWorldToLocalVoxel(Candidate.HeterogeneousVolume->GetInstanceToWorld(), InstancedAsset.LocalBounds, InstancedAsset.LocalGridResolution));
+			InstancedVolume.WorldBounds = Candidate.HeterogeneousVolume->GetBounds().GetBox();
+			InstancedVolume.CellMin = Candidate.VolumeCells->CellMin;
+			InstancedVolume.CellMax = Candidate.VolumeCells->CellMax;
+
+			RasterMeshBatches.Remove(Candidate.MeshBatch);
+		}
+	}
+}
+
+void HVPT::Private::BuildInstancedAssets(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FViewInfo& View,
+	const FHVPT_VoxelGridBuildOptions& BuildOptions,
+	TConstArrayView<FHVPTOrthoGridInstancedAsset> InstancedAssets,
+	TConstArrayView<FHVPTOrthoGridInstancedVolume> InstancedVolumes,
+	int32 BottomLevelGridResolution,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef ShadingGridBuffer,
+	bool bInterleavedShadingData,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	uint32 GridDataFormats,
+	FRDGBufferRef& InstancedVolumeBuffer,
+	FRDGBufferRef& InstancedVolumeCellBuffer,
+	FRDGBufferRef& InstancedAssetMajorantBuffer
+)
+{
+	InstancedAssetMajorantBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), FMath::Max(InstancedAssets.Num(), 1)),
+		TEXT("HVPT.OrthoGrid.InstancedAssetMajorantBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(InstancedAssetMajorantBuffer, PF_R32_UINT), 0, BuildOptions.ComputePassFlags);
+
+	if (InstancedAssets.IsEmpty())
+	{
+		InstancedVolumeBuffer = GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_InstancedVolumeData));
+		InstancedVolumeCellBuffer = GSystemTextures.GetDefaultStructuredBuffer(GraphBuilder, sizeof(FHVPT_TopLevelGridData));
+		return;
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "Instanced Assets");
+
+	const FHVPTOrthoGridInstancedAsset& LastAsset = InstancedAssets.Last();
+	InstancedVolumeCellBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_TopLevelGridData), LastAsset.FirstCell + CalcMajorantMipSize(LastAsset.LocalGridResolution)),
+		TEXT("HVPT.OrthoGrid.InstancedVolumeCellBuffer")
+	);
+
+	// Every cell starts out marked at the largest resolution, the size class ReserveBricks leaves the free slabs in,
+	// and is given a brick by rasterization only if the volume has extinction in it
+	constexpr uint32 EmptyVoxelIndex = 0x1FFFFFFF;
+	const uint32 MarkedCell = (EmptyVoxelIndex << 3) | static_cast<uint32>(BottomLevelGridResolution);
+
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+
+	for (int32 AssetIndex = 0; AssetIndex < InstancedAssets.Num(); ++AssetIndex)
+	{
+		const FHVPTOrthoGridInstancedAsset& InstancedAsset = InstancedAssets[AssetIndex];
+		const uint32 CellCount = CalcMajorantMipSize(InstancedAsset.LocalGridResolution);
+
+		FRDGBufferRef LocalGridBuffer = GraphBuilder.CreateBuffer(
+			FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_TopLevelGridData), CellCount),
+			TEXT("HVPT.OrthoGrid.InstancedAssetGridBuffer")
+		);
+		AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(LocalGridBuffer), MarkedCell, BuildOptions.ComputePassFlags);
+
+		FRDGBufferRef RasterTileBuffer;
+		FRDGBufferRef RasterTileAllocatorBuffer;
+		HVPT::Private::GenerateRasterTiles(
+			GraphBuilder,
+			Scene,
+			InstancedAsset.LocalGridResolution,
+			LocalGridBuffer,
+			RasterTileBuffer,
+			RasterTileAllocatorBuffer,
+			BuildOptions.ComputePassFlags
+		);
 
-				PassParameters->ShadingRateInFrustum = BuildOptions.ShadingRateInFrustum;
-				PassParameters->ShadingRateOutOfFrustum = BuildOptions.ShadingRateOutOfFrustum;
-				PassParameters->MinVoxelSizeInFrustum = FMath::Max(HeterogeneousVolume->GetMinimumVoxelSize(), HVPT::GetMinimumVoxelSizeInsideFrustum());
-				PassParameters->MinVoxelSizeOutOfFrustum = HVPT::GetMinimumVoxelSizeOutsideFrustum();
-				PassParameters->bUseProjectedPixelSize = BuildOptions.bUseProjectedPixelSizeForOrthoGrid;
+		// The local grid covers the bounds of the volume in instance space, placed in the world by the first instance
+		FVolumetricMeshBatch AssetMeshBatch;
+		AssetMeshBatch.Mesh = InstancedAsset.Mesh;
+		AssetMeshBatch.Proxy = InstancedAsset.Proxy;
+		TSet<FVolumetricMeshBatch> AssetMeshBatches;
+		AssetMeshBatches.Add(AssetMeshBatch);
+
+		HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
+			GraphBuilder,
+			Scene,
+			View,
+			AssetMeshBatches,
+			BuildOptions,
+			RasterTileBuffer,
+			RasterTileAllocatorBuffer,
+			FBoxSphereBounds(InstancedAsset.LocalBounds),
+			InstancedAsset.LocalGridResolution,
+			InstancedAsset.ReferenceInstanceToWorld,
+			LocalGridBuffer,
+			ExtinctionGridBuffer,
+			EmissionGridBuffer,
+			ScatteringGridBuffer,
+			VelocityGridBuffer,
+			BrickFreeListBuffer,
+			BrickOverflowCountBuffer,
+			GridDataFormats
+		);
+
+		if (bInterleavedShadingData)
+		{
+			HVPT::Private::InterleaveShadingGridData(
+				GraphBuilder,
+				Scene,
+				RasterTileBuffer,
+				RasterTileAllocatorBuffer,
+				LocalGridBuffer,
+				ExtinctionGridBuffer,
+				EmissionGridBuffer,
+				ScatteringGridBuffer,
+				GridDataFormats,
+				ShadingGridBuffer,
+				BuildOptions.ComputePassFlags
+			);
+		}
+
+		// Every instance takes the majorant of the whole local grid for its cells, see HVPT_BuildMajorantVoxelGridCS
+		FHVPT_CalcInstancedAssetMajorantCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_CalcInstancedAssetMajorantCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = InstancedAsset.LocalGridResolution;
+			PassParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(LocalGridBuffer);
+			PassParameters->ExtinctionGridBuffer = GraphBuilder.CreateSRV(ExtinctionGridBuffer);
+			PassParameters->GridDataFormats = GridDataFormats;
+			PassParameters->InstancedAssetIndex = AssetIndex;
+			PassParameters->RWInstancedAssetMajorantBuffer = GraphBuilder.CreateUAV(InstancedAssetMajorantBuffer, PF_R32_UINT);
+		}
+
+		TShaderRef<FHVPT_CalcInstancedAssetMajorantCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_CalcInstancedAssetMajorantCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("CalcInstancedAssetMajorant"),
+			BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			InstancedAsset.LocalGridResolution
+		);
+
+		AddCopyBufferPass(
+			GraphBuilder,
+			InstancedVolumeCellBuffer,
+			InstancedAsset.FirstCell * sizeof(FHVPT_TopLevelGridData),
+			LocalGridBuffer,
+			0,
+			CellCount * sizeof(FHVPT_TopLevelGridData)
+		);
+	}
+
+	// The transform is stored as the columns of the row vector matrix, so that the shader can take one dot product per axis
+	TArray<FHVPT_InstancedVolumeData> InstancedVolumeData;
+	InstancedVolumeData.SetNumZeroed(InstancedVolumes.Num());
+	for (int32 Slot = 0; Slot < InstancedVolumes.Num(); ++Slot)
+	{
+		const FHVPTOrthoGridInstancedVolume& InstancedVolume = InstancedVolumes[Slot];
+		const FHVPTOrthoGridInstancedAsset& InstancedAsset = InstancedAssets[InstancedVolume.AssetIndex];
+		const FMatrix44f& WorldToLocalVoxel = InstancedVolume.WorldToLocalVoxel;
+
+		FHVPT_InstancedVolumeData& Data = InstancedVolumeData[Slot];
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Data.WorldToLocalVoxel[Axis] = FVector4f(WorldToLocalVoxel.M[0][Axis], WorldToLocalVoxel.M[1][Axis], WorldToLocalVoxel.M[2][Axis], WorldToLocalVoxel.M[3][Axis]);
+		}
+		Data.LocalGridResolution = InstancedAsset.LocalGridResolution;
+		Data.FirstCell = InstancedAsset.FirstCell;
+		Data.AssetIndex = InstancedVolume.AssetIndex;
+	}
+
+	InstancedVolumeBuffer = CreateStructuredBuffer(
+		GraphBuilder,
+		TEXT("HVPT.OrthoGrid.InstancedVolumeBuffer"),
+		sizeof(FHVPT_InstancedVolumeData),
+		InstancedVolumeData.Num(),
+		InstancedVolumeData.GetData(),
+		InstancedVolumeData.Num() * sizeof(FHVPT_InstancedVolumeData)
+	);
+}
+
+void HVPT::Private::MarkInstancedVolumeCells(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	int32 BottomLevelGridResolution,
+	TConstArrayView<FHVPTOrthoGridInstancedVolume> InstancedVolumes,
+	FRDGBufferRef TopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	if (InstancedVolumes.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<FHVPT_InstancedVolumeCellBox> CellBoxes;
+	CellBoxes.SetNumZeroed(InstancedVolumes.Num());
+	for (int32 Slot = 0; Slot < InstancedVolumes.Num(); ++Slot)
+	{
+		const FHVPTOrthoGridInstancedVolume& InstancedVolume = InstancedVolumes[Slot];
+		CellBoxes[Slot].CellMin = FIntVector4(InstancedVolume.CellMin, 0);
+		CellBoxes[Slot].CellMax = FIntVector4(InstancedVolume.CellMax, 0);
+		CellBoxes[Slot].WorldBoundsMin = FVector4f(FVector3f(InstancedVolume.WorldBounds.Min), 0.0f);
+		CellBoxes[Slot].WorldBoundsMax = FVector4f(FVector3f(InstancedVolume.WorldBounds.Max), 0.0f);
+	}
+
+	FRDGBufferRef CellBoxBuffer = CreateStructuredBuffer(
+		GraphBuilder,
+		TEXT("HVPT.OrthoGrid.InstancedVolumeCellBoxBuffer"),
+		sizeof(FHVPT_InstancedVolumeCellBox),
+		CellBoxes.Num(),
+		CellBoxes.GetData(),
+		CellBoxes.Num() * sizeof(FHVPT_InstancedVolumeCellBox)
+	);
+
+	FHVPT_MarkInstancedVolumeCellsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_MarkInstancedVolumeCellsCS::FParameters>();
+	{
+		PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+		PassParameters->TopLevelGridWorldBoundsMin = FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent);
+		PassParameters->TopLevelGridWorldBoundsMax = FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
+
+		PassParameters->InstancedVolumeCellBoxBuffer = GraphBuilder.CreateSRV(CellBoxBuffer);
+		PassParameters->NumInstancedVolumes = InstancedVolumes.Num();
+		PassParameters->InstancedVolumeVoxelResolution = BottomLevelGridResolution;
+
+		PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+	}
+
+	// One group per instance, so the whole set is marked in a single dispatch
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+	TShaderRef<FHVPT_MarkInstancedVolumeCellsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_MarkInstancedVolumeCellsCS>();
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("MarkInstancedVolumeCells"),
+		ComputePassFlags | ERDGPassFlags::NeverCull,
+		ComputeShader,
+		PassParameters,
+		FIntVector(InstancedVolumes.Num(), 1, 1)
+	);
+}
+
+void HVPT::Private::CollectOrthoGridBrickCacheVolumes(
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const TSet<FVolumetricMeshBatch>& RasterMeshBatches,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTBrickCacheVolume>& CacheVolumes
+)
+{
+	CacheVolumes.Reset();
+
+	// Fog is rasterized into the bricks of every occupied cell, and does not follow the frame of the volume
+	if (HVPT::GetFogCompositingMode() == EFogCompositionMode::PostAndPathTracing)
+	{
+		return;
+	}
+
+	const FVector TopLevelGridWorldBoundsMin = TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent;
+	const FVector TopLevelVoxelSize = (TopLevelGridBounds.BoxExtent * 2.0) / FVector(TopLevelGridResolution);
+
+	struct FVolumeCells
+	{
+		const IHeterogeneousVolumeInterface* HeterogeneousVolume = nullptr;
+		FIntVector CellMin;
+		FIntVector CellMax;
+	};
+	TArray<FVolumeCells> AllVolumeCells;
+	for (const FVolumetricMeshBatch& MeshBatch : HeterogeneousVolumesMeshBatches)
+	{
+		for (int32 VolumeIndex = 0; VolumeIndex < MeshBatch.Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			FVolumeCells& VolumeCells = AllVolumeCells.AddDefaulted_GetRef();
+			VolumeCells.HeterogeneousVolume = static_cast<const IHeterogeneousVolumeInterface*>(MeshBatch.Mesh->Elements[VolumeIndex].UserData);
+			CalcPaddedCellBox(VolumeCells.HeterogeneousVolume->GetBounds().GetBox(), TopLevelGridBounds, TopLevelGridResolution, VolumeCells.CellMin, VolumeCells.CellMax);
+		}
+	}
+
+	for (const FVolumetricMeshBatch& MeshBatch : RasterMeshBatches)
+	{
+		// Only volumes that can identify their frame
+		if (MeshBatch.Mesh->Elements.Num() != 1 || !HVPT::HasExtendedInterface(MeshBatch.Proxy))
+		{
+			continue;
+		}
 
-				PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
-			}
+		auto HeterogeneousVolume = static_cast<const IHeterogeneousVolumeExInterface*>(MeshBatch.Mesh->Elements[0].UserData);
+		const FHeterogeneousVolumeExFrameKey& FrameCacheKey = HeterogeneousVolume->GetFrameCacheKey();
+		if (!FrameCacheKey.IsValid())
+		{
+			continue;
+		}
 
-			FIntVector GroupCount;
-			GroupCount.X = FMath::DivideAndRoundUp(TopLevelGridResolution.X, FHVPT_TopLevelGridCalculateVoxelSizeCS::GetThreadGroupSize3D());
-			GroupCount.Y = FMath::DivideAndRoundUp(TopLevelGridResolution.Y, FHVPT_TopLevelGridCalculateVoxelSizeCS::GetThreadGroupSize3D());
-			GroupCount.Z = FMath::DivideAndRoundUp(TopLevelGridResolution.Z, FHVPT_TopLevelGridCalculateVoxelSizeCS::GetThreadGroupSize3D());
+		// A cached brick must hold nothing but this volume, so the volume must not share a cell with any other volume
+		const FVolumeCells* CandidateCells = AllVolumeCells.FindByPredicate([HeterogeneousVolume](const FVolumeCells& VolumeCells) { return VolumeCells.HeterogeneousVolume == HeterogeneousVolume; });
+		if (!CandidateCells)
+		{
+			continue;
+		}
 
-			TShaderRef<FHVPT_TopLevelGridCalculateVoxelSizeCS> ComputeShader = View.ShaderMap->GetShader<FHVPT_TopLevelGridCalculateVoxelSizeCS>();
-			FComputeShaderUtils::AddPass(
-				GraphBuilder,
-				RDG_EVENT_NAME("TopLevelGridCalculateVoxelSize"),
-				ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
-				ComputeShader,
-				PassParameters,
-				GroupCount
-			);
+		const bool bSharesCells = AllVolumeCells.ContainsByPredicate([CandidateCells](const FVolumeCells& OtherCells)
+			{
+				return &OtherCells != CandidateCells
+					&& CandidateCells->CellMin.X <= OtherCells.CellMax.X && OtherCells.CellMin.X <= CandidateCells->CellMax.X
+					&& CandidateCells->CellMin.Y <= OtherCells.CellMax.Y && OtherCells.CellMin.Y <= CandidateCells->CellMax.Y
+					&& CandidateCells->CellMin.Z <= OtherCells.CellMax.Z && OtherCells.CellMin.Z <= CandidateCells->CellMax.Z;
+			});
+		if (bSharesCells)
+		{
+			continue;
 		}
+
+		// The bricks only depend on where the volume sits within the cells, so instances offset from each other by whole cells share an entry.
+		// The offset within a cell is quantized, as instances are rarely placed exactly the same
+		const FMatrix InstanceToWorld = HeterogeneousVolume->GetInstanceToWorld();
+		const FVector OriginInCells = (InstanceToWorld.GetOrigin() - TopLevelGridWorldBoundsMin) / TopLevelVoxelSize;
+		const FIntVector OriginCell(FMath::FloorToInt(OriginInCells.X), FMath::FloorToInt(OriginInCells.Y), FMath::FloorToInt(OriginInCells.Z));
+		const FVector OffsetInCell = OriginInCells - FVector(OriginCell);
+		const FIntVector QuantizedOffsetInCell(FMath::RoundToInt(OffsetInCell.X * 1024.0), FMath::RoundToInt(OffsetInCell.Y * 1024.0), FMath::RoundToInt(OffsetInCell.Z * 1024.0));
+
+		FHVPTBrickCacheVolume& CacheVolume = CacheVolumes.AddDefaulted_GetRef();
+		CacheVolume.Key.Frame = FrameCacheKey;
+		CacheVolume.Key.QuantizedOffsetInCell = QuantizedOffsetInCell;
+		CacheVolume.Key.TopLevelVoxelSize = TopLevelVoxelSize;
+		CacheVolume.Key.InstanceAxisX = InstanceToWorld.GetScaledAxis(EAxis::X);
+		CacheVolume.Key.InstanceAxisY = InstanceToWorld.GetScaledAxis(EAxis::Y);
+		CacheVolume.Key.InstanceAxisZ = InstanceToWorld.GetScaledAxis(EAxis::Z);
+		CacheVolume.Key.CellMin = CandidateCells->CellMin - OriginCell;
+		CacheVolume.Key.CellMax = CandidateCells->CellMax - OriginCell;
+		CacheVolume.CellMin = CandidateCells->CellMin;
+		CacheVolume.CellMax = CandidateCells->CellMax;
 	}
 }
 
 void HVPT::Private::MarkTopLevelGrid(
-	FRDGBuilder& GraphBuilder, const FScene* Scene, const FBoxSphereBounds& TopLevelGridBounds, FIntVector TopLevelGridResolution, FRDGBufferRef& TopLevelGridBuffer
+	FRDGBuilder& GraphBuilder, const FScene* Scene, const FBoxSphereBounds& TopLevelGridBounds, FIntVector TopLevelGridResolution, int32 MaxVoxelResolution, FRDGBufferRef& TopLevelGridBuffer, FRDGBufferRef& CellPriorityBuffer, ERDGPassFlags ComputePassFlags
 )
 {
+	// Only read for the cells marked here, so it is left uninitialized
+	CellPriorityBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z),
+		TEXT("HVPT.OrthoGrid.CellPriorityBuffer")
+	);
+
 	FHVPT_AllocateBottomLevelGridCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_AllocateBottomLevelGridCS::FParameters>();
 	{
 		//PassParameters->View = View.ViewUniformBuffer;
@@ -1246,9 +2437,10 @@ void HVPT::Private::MarkTopLevelGrid(
 		PassParameters->TopLevelGridWorldBoundsMin = FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent);
 		PassParameters->TopLevelGridWorldBoundsMax = FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
 
-		PassParameters->MaxVoxelResolution = HVPT::GetBottomLevelGridResolution();
+		PassParameters->MaxVoxelResolution = MaxVoxelResolution;
 
 		PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+		PassParameters->RWCellPriorityBuffer = GraphBuilder.CreateUAV(CellPriorityBuffer, PF_R32_UINT);
 	}
 
 	FIntVector GroupCount;
@@ -1262,7 +2454,7 @@ void HVPT::Private::MarkTopLevelGrid(
 	FComputeShaderUtils::AddPass(
 		GraphBuilder,
 		RDG_EVENT_NAME("AllocateBottomLevelGrid"),
-		ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+		ComputePassFlags | ERDGPassFlags::NeverCull,
 		ComputeShader,
 		PassParameters,
 		GroupCount
@@ -1279,11 +2471,15 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 	FRDGBufferRef RasterTileAllocatorBuffer, 
 	FBoxSphereBounds TopLevelGridBounds, 
 	FIntVector TopLevelGridResolution, 
-	FRDGBufferRef& TopLevelGridBuffer, 
-	FRDGBufferRef& ExtinctionGridBuffer, 
-	FRDGBufferRef& EmissionGridBuffer, 
-	FRDGBufferRef& ScatteringGridBuffer, 
-	FRDGBufferRef& VelocityGridBuffer
+	const FMatrix& GridToWorld,
+	FRDGBufferRef TopLevelGridBuffer, 
+	FRDGBufferRef ExtinctionGridBuffer, 
+	FRDGBufferRef EmissionGridBuffer, 
+	FRDGBufferRef ScatteringGridBuffer, 
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef BrickFreeListBuffer,
+	FRDGBufferRef BrickOverflowCountBuffer,
+	uint32 GridDataFormats
 )
 {
 	// Setup indirect dispatch
@@ -1307,7 +2503,7 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 		FComputeShaderUtils::AddPass(
 			GraphBuilder,
 			RDG_EVENT_NAME("SetRasterizeBottomLevelGridIndirectArgs"),
-			ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+			BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
 			ComputeShader,
 			IndirectArgsPassParameters,
 			GroupCount
@@ -1315,31 +2511,6 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 	}
 
 	// Volume rasterization
-	int32 BottomLevelGridBufferSize = (HVPT::GetMaxBottomLevelMemoryInMegabytesForOrthoGrid() * 1e6) / sizeof(FHVPT_GridData);
-
-	ExtinctionGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.OrthoGrid.ExtinctionGridBuffer")
-	);
-	EmissionGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.OrthoGrid.EmissionGridBuffer")
-	);
-	ScatteringGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.OrthoGrid.ScatteringGridBuffer")
-	);
-	VelocityGridBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_GridData), BottomLevelGridBufferSize),
-		TEXT("HVPT.OrthoGrid.VelocityGridBuffer")
-	);
-
-	FRDGBufferRef BottomLevelGridAllocatorBuffer = GraphBuilder.CreateBuffer(
-		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 2),
-		TEXT("HVPT.OrthoGrid.BottomLevelGridAllocatorBuffer")
-	);
-	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(BottomLevelGridAllocatorBuffer, PF_R32_UINT), 0);
-
 	for (auto MeshBatchIt = HeterogeneousVolumesMeshBatches.begin(); MeshBatchIt != HeterogeneousVolumesMeshBatches.end(); ++MeshBatchIt)
 	{
 		FVolumetricMeshBatch VolumetricMeshBatch = *MeshBatchIt;
@@ -1391,6 +2562,7 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 				PassParameters->TopLevelGridResolution = TopLevelGridResolution;
 				PassParameters->TopLevelGridWorldBoundsMin = FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent);
 				PassParameters->TopLevelGridWorldBoundsMax = FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
+				PassParameters->GridToWorld = FMatrix44f(GridToWorld);
 
 				PassParameters->LocalToWorld_Velocity = FMatrix44f(HeterogeneousVolumeInterface->GetLocalToWorld());
 
@@ -1402,7 +2574,7 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 				PassParameters->PrimitiveWorldBoundsMin = FVector3f(PrimitiveBounds.Origin - PrimitiveBounds.BoxExtent);
 				PassParameters->PrimitiveWorldBoundsMax = FVector3f(PrimitiveBounds.Origin + PrimitiveBounds.BoxExtent);
 
-				PassParameters->BottomLevelGridBufferSize = BottomLevelGridBufferSize;
+				PassParameters->GridDataFormats = GridDataFormats;
 
 				// Raster tile data
 				PassParameters->RasterTileAllocatorBuffer = GraphBuilder.CreateSRV(RasterTileAllocatorBuffer, PF_R32_UINT);
@@ -1416,7 +2588,8 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 
 				// Grid data
 				PassParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(TopLevelGridBuffer);
-				PassParameters->RWBottomLevelGridAllocatorBuffer = GraphBuilder.CreateUAV(BottomLevelGridAllocatorBuffer, PF_R32_UINT);
+				PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+				PassParameters->RWBrickOverflowCountBuffer = GraphBuilder.CreateUAV(BrickOverflowCountBuffer, PF_R32_UINT);
 				PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
 				PassParameters->RWExtinctionGridBuffer = GraphBuilder.CreateUAV(ExtinctionGridBuffer);
 				PassParameters->RWEmissionGridBuffer = GraphBuilder.CreateUAV(EmissionGridBuffer);
@@ -1427,7 +2600,7 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 			GraphBuilder.AddPass(
 				RDG_EVENT_NAME("RasterizeBottomLevelGrid"),
 				PassParameters,
-				ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+				BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
 				[PassParameters, Scene, MaterialRenderProxy, &Material, bEnableVelocity](FRDGAsyncTask, FRHIComputeCommandList& RHICmdList)
 				{
 					FHVPT_RasterizeBottomLevelOrthoGridCS::FPermutationDomain PermutationVector;
@@ -1475,7 +2648,7 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 		FBlueNoise BlueNoise = GetBlueNoiseGlobalParameters();
 		PassParameters->BlueNoise = CreateUniformBufferImmediate(BlueNoise, EUniformBufferUsage::UniformBuffer_SingleDraw);
 
-		PassParameters->BottomLevelGridBufferSize = BottomLevelGridBufferSize;
+		PassParameters->GridDataFormats = GridDataFormats;
 
 		// Raster tile data
 		PassParameters->RasterTileAllocatorBuffer = GraphBuilder.CreateSRV(RasterTileAllocatorBuffer, PF_R32_UINT);
@@ -1488,7 +2661,8 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 		PassParameters->bJitter = BuildOptions.bJitter;
 
 		// Grid data
-		PassParameters->RWBottomLevelGridAllocatorBuffer = GraphBuilder.CreateUAV(BottomLevelGridAllocatorBuffer, PF_R32_UINT);
+		PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+		PassParameters->RWBrickOverflowCountBuffer = GraphBuilder.CreateUAV(BrickOverflowCountBuffer, PF_R32_UINT);
 		PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
 		PassParameters->RWExtinctionGridBuffer = GraphBuilder.CreateUAV(ExtinctionGridBuffer);
 		PassParameters->RWEmissionGridBuffer = GraphBuilder.CreateUAV(EmissionGridBuffer);
@@ -1500,7 +2674,7 @@ void HVPT::Private::RasterizeVolumesIntoOrthoVoxelGrid(
 		GraphBuilder.AddPass(
 			RDG_EVENT_NAME("RasterizeFogOrthoGridCS"),
 			PassParameters,
-			ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+			BuildOptions.ComputePassFlags | ERDGPassFlags::NeverCull,
 			[PassParameters, ComputeShader](FRDGAsyncTask, FRHIComputeCommandList& RHICmdList)
 			{
 				ClearUnusedGraphResources(ComputeShader, PassParameters);
@@ -1514,17 +2688,42 @@ void HVPT::Private::BuildMajorantVoxelGrid(
 	FRDGBuilder& GraphBuilder, 
 	const FScene* Scene, 
 	const FIntVector& TopLevelGridResolution, 
+	int32 MajorantMipCount,
+	bool bBuildSubBrickMajorants,
+	bool bTrilinearFiltering,
+	int32 SubBricksPerBrick,
+	uint32 GridDataFormats,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes,
+	FRDGBufferRef InstancedVolumeBuffer,
+	FRDGBufferRef InstancedAssetMajorantBuffer,
 	FRDGBufferRef TopLevelGridBuffer, 
 	FRDGBufferRef ExtinctionGridBuffer, 
-	FRDGBufferRef& MajorantVoxelGridBuffer
+	FRDGBufferRef& MajorantVoxelGridBuffer,
+	FRDGBufferRef& SubBrickMajorantGridBuffer,
+	ERDGPassFlags ComputePassFlags
 )
 {
-	uint32 MajorantVoxelGridBufferSize = TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z;
+	// All levels of the pyramid are stored consecutively, with level 0 at the start
+	uint32 MajorantVoxelGridBufferSize = 0;
+	for (int32 MipLevel = 0; MipLevel < MajorantMipCount; ++MipLevel)
+	{
+		MajorantVoxelGridBufferSize += HVPT::Private::CalcMajorantMipSize(HVPT::Private::CalcMajorantMipResolution(TopLevelGridResolution, MipLevel));
+	}
 	MajorantVoxelGridBuffer = GraphBuilder.CreateBuffer(
 		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_MajorantGridData), MajorantVoxelGridBufferSize),
 		TEXT("HVPT.MajorantVoxelGridBuffer")
 	);
 
+	// Sub-brick majorants are stored per top-level cell, as bricks of different resolutions share the slabs of the pool
+	SubBrickMajorantGridBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_MajorantGridData), bBuildSubBrickMajorants ? HVPT::Private::CalcMajorantMipSize(TopLevelGridResolution) * SubBricksPerBrick : 1),
+		TEXT("HVPT.SubBrickMajorantGridBuffer")
+	);
+	if (!bBuildSubBrickMajorants)
+	{
+		AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(SubBrickMajorantGridBuffer), 0, ComputePassFlags);
+	}
+
 	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
 
 	{
@@ -1533,7 +2732,18 @@ void HVPT::Private::BuildMajorantVoxelGrid(
 			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
 			PassParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(TopLevelGridBuffer);
 			PassParameters->ExtinctionGridBuffer = GraphBuilder.CreateSRV(ExtinctionGridBuffer);
+			PassParameters->bBuildSubBrickMajorants = bBuildSubBrickMajorants;
+			PassParameters->bTrilinearFiltering = bTrilinearFiltering;
+			PassParameters->GridDataFormats = GridDataFormats;
+			PassParameters->SubBricksPerBrick = SubBricksPerBrick;
+			for (int32 Slot = 0; Slot < DirectVolumes.Num(); ++Slot)
+			{
+				PassParameters->DirectVolumeMajorants[Slot] = FVector4f(DirectVolumes[Slot].MaxDensity * DirectVolumes[Slot].ExtinctionScale, 0.0f, 0.0f, 0.0f);
+			}
+			PassParameters->InstancedVolumeBuffer = GraphBuilder.CreateSRV(InstancedVolumeBuffer);
+			PassParameters->InstancedAssetMajorantBuffer = GraphBuilder.CreateSRV(InstancedAssetMajorantBuffer, PF_R32_UINT);
 			PassParameters->RWMajorantVoxelGridBuffer = GraphBuilder.CreateUAV(MajorantVoxelGridBuffer);
+			PassParameters->RWSubBrickMajorantGridBuffer = GraphBuilder.CreateUAV(SubBrickMajorantGridBuffer);
 		}
 
 		TShaderRef<FHVPT_BuildMajorantVoxelGridCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_BuildMajorantVoxelGridCS>();
@@ -1547,10 +2757,450 @@ void HVPT::Private::BuildMajorantVoxelGrid(
 		FComputeShaderUtils::AddPass(
 			GraphBuilder,
 			RDG_EVENT_NAME("BuildMajorantVoxelGridCS"),
-			ERDGPassFlags::Compute | ERDGPassFlags::NeverCull,
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			GroupCount
+		);
+	}
+
+	// Build the rest of the pyramid one level at a time
+	for (int32 MipLevel = 1; MipLevel < MajorantMipCount; ++MipLevel)
+	{
+		const FIntVector SrcMipResolution = HVPT::Private::CalcMajorantMipResolution(TopLevelGridResolution, MipLevel - 1);
+		const FIntVector DstMipResolution = HVPT::Private::CalcMajorantMipResolution(TopLevelGridResolution, MipLevel);
+
+		FHVPT_DownsampleMajorantGridCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_DownsampleMajorantGridCS::FParameters>();
+		{
+			PassParameters->SrcMipResolution = SrcMipResolution;
+			PassParameters->DstMipResolution = DstMipResolution;
+			PassParameters->SrcMipOffset = HVPT::Private::CalcMajorantMipOffset(TopLevelGridResolution, MipLevel - 1);
+			PassParameters->DstMipOffset = HVPT::Private::CalcMajorantMipOffset(TopLevelGridResolution, MipLevel);
+			PassParameters->RWMajorantVoxelGridBuffer = GraphBuilder.CreateUAV(MajorantVoxelGridBuffer);
+		}
+
+		TShaderRef<FHVPT_DownsampleMajorantGridCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_DownsampleMajorantGridCS>();
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("DownsampleMajorantGridCS(Mip=%d)", MipLevel),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			PassParameters,
+			FComputeShaderUtils::GetGroupCount(DstMipResolution, FHVPT_DownsampleMajorantGridCS::GetThreadGroupSize3D())
+		);
+	}
+}
+
+
+static bool HasOrthoGridVolumeChanged(const FHVPTOrthoGridVolumeRecord& PreviousRecord, const FHVPTOrthoGridVolumeRecord& Record)
+{
+	// Without a data revision there is no way to tell if the volume contents have changed
+	if (!Record.bHasDataRevision || !PreviousRecord.bHasDataRevision)
+	{
+		return true;
+	}
+
+	return PreviousRecord.DataRevision != Record.DataRevision
+		|| PreviousRecord.Proxy != Record.Proxy
+		|| PreviousRecord.MaterialRenderProxy != Record.MaterialRenderProxy
+		|| PreviousRecord.WorldBounds != Record.WorldBounds
+		|| !PreviousRecord.InstanceToWorld.Equals(Record.InstanceToWorld, 0.0);
+}
+
+void HVPT::Private::CollectOrthoGridVolumeRecords(
+	const FViewInfo& View,
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	TMap<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecords
+)
+{
+	VolumeRecords.Reset();
+
+	for (auto MeshBatchIt = HeterogeneousVolumesMeshBatches.begin(); MeshBatchIt != HeterogeneousVolumesMeshBatches.end(); ++MeshBatchIt)
+	{
+		const FVolumetricMeshBatch& MeshBatch = *MeshBatchIt;
+		const FMeshBatch* Mesh = MeshBatch.Mesh;
+		const FPrimitiveSceneProxy* PrimitiveSceneProxy = MeshBatch.Proxy;
+
+		if (!HVPT::ShouldRenderMeshBatchWithHVPT(Mesh, PrimitiveSceneProxy, View.GetFeatureLevel()))
+		{
+			continue;
+		}
+
+		for (int32 VolumeIndex = 0; VolumeIndex < Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			const IHeterogeneousVolumeInterface* HeterogeneousVolumeInterface = static_cast<const IHeterogeneousVolumeInterface*>(Mesh->Elements[VolumeIndex].UserData);
+
+			FHVPTOrthoGridVolumeRecord Record;
+			Record.Proxy = PrimitiveSceneProxy;
+			Record.MaterialRenderProxy = Mesh->MaterialRenderProxy;
+			Record.InstanceToWorld = HeterogeneousVolumeInterface->GetInstanceToWorld();
+			Record.WorldBounds = HeterogeneousVolumeInterface->GetBounds().GetBox();
+			Record.OwnerName = PrimitiveSceneProxy->GetOwnerName();
+
+			if (HVPT::HasExtendedInterface(PrimitiveSceneProxy))
+			{
+				auto HeterogeneousVolumeExInterface = static_cast<const IHeterogeneousVolumeExInterface*>(HeterogeneousVolumeInterface);
+				Record.DataRevision = HeterogeneousVolumeExInterface->GetDataRevision();
+				Record.bHasDataRevision = true;
+			}
+
+			// Key by component rather than proxy, as the proxy is recreated whenever the render state is dirtied
+			const uint64 VolumeKey = (static_cast<uint64>(PrimitiveSceneProxy->GetPrimitiveComponentId().PrimIDValue) << 32) | static_cast<uint64>(VolumeIndex);
+			VolumeRecords.Add(VolumeKey, Record);
+		}
+	}
+}
+
+uint32 HVPT::Private::CalcOrthoGridBuildSettingsHash(
+	const FHVPT_VoxelGridBuildOptions& BuildOptions, int32 BottomLevelGridResolution, int32 BrickCapacity, uint32 GridDataFormats, bool bInterleavedShadingData,
+	TConstArrayView<FHVPTOrthoGridDirectVolume> DirectVolumes,
+	TConstArrayView<FHVPTOrthoGridInstancedVolume> InstancedVolumes
+)
+{
+	// Any setting that affects the layout or contents of cells that are not dirty must be part of this hash
+	uint32 Hash = GetTypeHash(BrickCapacity);
+	Hash = HashCombineFast(Hash, GetTypeHash(BottomLevelGridResolution));
+	Hash = HashCombineFast(Hash, GetTypeHash(HVPT::GetMinimumVoxelSizeInsideFrustum()));
+	Hash = HashCombineFast(Hash, GetTypeHash(HVPT::GetMinimumVoxelSizeOutsideFrustum()));
+	Hash = HashCombineFast(Hash, GetTypeHash(static_cast<int32>(HVPT::GetFogCompositingMode())));
+	Hash = HashCombineFast(Hash, GetTypeHash(BuildOptions.ShadingRateInFrustum));
+	Hash = HashCombineFast(Hash, GetTypeHash(BuildOptions.ShadingRateOutOfFrustum));
+	Hash = HashCombineFast(Hash, GetTypeHash(BuildOptions.bUseProjectedPixelSizeForOrthoGrid));
+	Hash = HashCombineFast(Hash, GetTypeHash(HVPT::GetMajorantMipCountForOrthoGrid()));
+	Hash = HashCombineFast(Hash, GetTypeHash(HVPT::UseTrilinearFilteringForOrthoGrid()));
+	Hash = HashCombineFast(Hash, GetTypeHash(GridDataFormats));
+	Hash = HashCombineFast(Hash, GetTypeHash(bInterleavedShadingData));
+
+	// Cells of directly sampled volumes refer to them by slot, and volumes moving in or out of a slot change which cells are rasterized
+	for (const FHVPTOrthoGridDirectVolume& DirectVolume : DirectVolumes)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(DirectVolume.VolumeKey));
+	}
+
+	// The same holds for instanced volumes, which also change slots when they are grouped into different assets
+	for (const FHVPTOrthoGridInstancedVolume& InstancedVolume : InstancedVolumes)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(InstancedVolume.VolumeKey));
+		Hash = HashCombineFast(Hash, GetTypeHash(InstancedVolume.AssetIndex));
+	}
+	return Hash;
+}
+
+bool HVPT::Private::CanBuildOrthoVoxelGridIncrementally(
+	const FHVPTOrthoGridParameterCache& ParameterCache,
+	const FHVPTBrickPool& BrickPool,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	uint32 BuildSettingsHash
+)
+{
+	if (!HVPT::EnableIncrementalRebuildForOrthoGrid())
+	{
+		return false;
+	}
+
+	// Require a previously built grid to update
+	if (!ParameterCache.bUseOrthoGrid || !ParameterCache.TopLevelGridBuffer || !BrickPool.IsValid())
+	{
+		return false;
+	}
+
+	// Periodically rebuild everything to refresh view-dependent voxel sizes and reclaim bricks that are no longer referenced
+	const int32 FullRebuildInterval = HVPT::GetFullRebuildIntervalForOrthoGrid();
+	if (FullRebuildInterval > 0 && ParameterCache.FramesSinceFullRebuild >= FullRebuildInterval)
+	{
+		return false;
+	}
+
+	// Cached cells can only be kept if the grid layout is unchanged
+	return ParameterCache.BuildSettingsHash == BuildSettingsHash
+		&& ParameterCache.TopLevelGridResolution == TopLevelGridResolution
+		&& ParameterCache.TopLevelGridWorldBoundsMin == FVector3f(TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent)
+		&& ParameterCache.TopLevelGridWorldBoundsMax == FVector3f(TopLevelGridBounds.Origin + TopLevelGridBounds.BoxExtent);
+}
+
+bool HVPT::Private::CalculateDirtyRegionsForOrthoGrid(
+	const TMap<uint64, FHVPTOrthoGridVolumeRecord>& PreviousVolumeRecords,
+	const TMap<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecords,
+	const FBoxSphereBounds& TopLevelGridBounds,
+	FIntVector TopLevelGridResolution,
+	TArray<FHVPTOrthoGridDirtyRegion>& DirtyRegions
+)
+{
+	// Each dirty region costs a pass, so beyond this a full rebuild is likely to be faster anyway
+	const int32 MaxDirtyRegions = 64;
+
+	DirtyRegions.Reset();
+
+	// Both the old and new bounds of a changed volume must be rasterized again
+	TArray<FBox> DirtyBounds;
+	int32 ChangedVolumeCount = 0;
+	for (const auto& [VolumeKey, Record] : VolumeRecords)
+	{
+		const FHVPTOrthoGridVolumeRecord* PreviousRecord = PreviousVolumeRecords.Find(VolumeKey);
+		if (!PreviousRecord)
+		{
+			DirtyBounds.Add(Record.WorldBounds);
+			ChangedVolumeCount++;
+		}
+		else if (HasOrthoGridVolumeChanged(*PreviousRecord, Record))
+		{
+			DirtyBounds.Add(PreviousRecord->WorldBounds);
+			if (PreviousRecord->WorldBounds != Record.WorldBounds)
+			{
+				DirtyBounds.Add(Record.WorldBounds);
+			}
+			ChangedVolumeCount++;
+		}
+	}
+
+	// Volumes that have been removed or hidden
+	for (const auto& [VolumeKey, PreviousRecord] : PreviousVolumeRecords)
+	{
+		if (!VolumeRecords.Contains(VolumeKey))
+		{
+			DirtyBounds.Add(PreviousRecord.WorldBounds);
+		}
+	}
+
+	if (ChangedVolumeCount == VolumeRecords.Num())
+	{
+		return false;
+	}
+
+	const FVector TopLevelGridWorldBoundsMin = TopLevelGridBounds.Origin - TopLevelGridBounds.BoxExtent;
+	const FVector TopLevelVoxelSize = (TopLevelGridBounds.BoxExtent * 2.0) / FVector(TopLevelGridResolution);
+
+	for (const FBox& Bounds : DirtyBounds)
+	{
+		const FVector CellMinAsFloat = (Bounds.Min - TopLevelGridWorldBoundsMin) / TopLevelVoxelSize;
+		const FVector CellMaxAsFloat = (Bounds.Max - TopLevelGridWorldBoundsMin) / TopLevelVoxelSize;
+
+		// Pad by a cell so that cells only touching the bounds, which the GPU also considers as intersecting, are included
+		FIntVector CellMin(FMath::FloorToInt(CellMinAsFloat.X) - 1, FMath::FloorToInt(CellMinAsFloat.Y) - 1, FMath::FloorToInt(CellMinAsFloat.Z) - 1);
+		FIntVector CellMax(FMath::FloorToInt(CellMaxAsFloat.X) + 1, FMath::FloorToInt(CellMaxAsFloat.Y) + 1, FMath::FloorToInt(CellMaxAsFloat.Z) + 1);
+
+		if (CellMax.X < 0 || CellMax.Y < 0 || CellMax.Z < 0
+			|| CellMin.X >= TopLevelGridResolution.X || CellMin.Y >= TopLevelGridResolution.Y || CellMin.Z >= TopLevelGridResolution.Z)
+		{
+			continue;
+		}
+
+		FHVPTOrthoGridDirtyRegion DirtyRegion;
+		DirtyRegion.CellMin = FIntVector(FMath::Max(CellMin.X, 0), FMath::Max(CellMin.Y, 0), FMath::Max(CellMin.Z, 0));
+		DirtyRegion.CellMax = FIntVector(
+			FMath::Min(CellMax.X, TopLevelGridResolution.X - 1),
+			FMath::Min(CellMax.Y, TopLevelGridResolution.Y - 1),
+			FMath::Min(CellMax.Z, TopLevelGridResolution.Z - 1)
+		);
+		DirtyRegions.Add(DirtyRegion);
+	}
+
+	// Merge overlapping regions so that no cell is processed more than necessary
+	for (bool bMerged = true; bMerged;)
+	{
+		bMerged = false;
+		for (int32 i = 0; i < DirtyRegions.Num() && !bMerged; ++i)
+		{
+			for (int32 j = i + 1; j < DirtyRegions.Num(); ++j)
+			{
+				FHVPTOrthoGridDirtyRegion& A = DirtyRegions[i];
+				const FHVPTOrthoGridDirtyRegion& B = DirtyRegions[j];
+				const bool bOverlaps = A.CellMin.X <= B.CellMax.X && B.CellMin.X <= A.CellMax.X
+					&& A.CellMin.Y <= B.CellMax.Y && B.CellMin.Y <= A.CellMax.Y
+					&& A.CellMin.Z <= B.CellMax.Z && B.CellMin.Z <= A.CellMax.Z;
+				if (bOverlaps)
+				{
+					A.CellMin = FIntVector(FMath::Min(A.CellMin.X, B.CellMin.X), FMath::Min(A.CellMin.Y, B.CellMin.Y), FMath::Min(A.CellMin.Z, B.CellMin.Z));
+					A.CellMax = FIntVector(FMath::Max(A.CellMax.X, B.CellMax.X), FMath::Max(A.CellMax.Y, B.CellMax.Y), FMath::Max(A.CellMax.Z, B.CellMax.Z));
+					DirtyRegions.RemoveAtSwap(j);
+					bMerged = true;
+					break;
+				}
+			}
+		}
+	}
+
+	if (DirtyRegions.Num() > MaxDirtyRegions)
+	{
+		DirtyRegions.Reset();
+		return false;
+	}
+
+	for (FHVPTOrthoGridDirtyRegion& DirtyRegion : DirtyRegions)
+	{
+		DirtyRegion.WorldBounds = FBox(
+			TopLevelGridWorldBoundsMin + FVector(DirtyRegion.CellMin) * TopLevelVoxelSize,
+			TopLevelGridWorldBoundsMin + FVector(DirtyRegion.CellMax + FIntVector(1)) * TopLevelVoxelSize
+		);
+	}
+
+	return true;
+}
+
+void HVPT::Private::CollectMeshBatchesIntersectingDirtyRegions(
+	const TSet<FVolumetricMeshBatch>& HeterogeneousVolumesMeshBatches,
+	const TArray<FHVPTOrthoGridDirtyRegion>& DirtyRegions,
+	TSet<FVolumetricMeshBatch>& DirtyMeshBatches
+)
+{
+	DirtyMeshBatches.Reset();
+
+	for (auto MeshBatchIt = HeterogeneousVolumesMeshBatches.begin(); MeshBatchIt != HeterogeneousVolumesMeshBatches.end(); ++MeshBatchIt)
+	{
+		const FVolumetricMeshBatch& MeshBatch = *MeshBatchIt;
+		const FMeshBatch* Mesh = MeshBatch.Mesh;
+
+		for (int32 VolumeIndex = 0; VolumeIndex < Mesh->Elements.Num(); ++VolumeIndex)
+		{
+			const IHeterogeneousVolumeInterface* HeterogeneousVolumeInterface = static_cast<const IHeterogeneousVolumeInterface*>(Mesh->Elements[VolumeIndex].UserData);
+			const FBox PrimitiveBounds = HeterogeneousVolumeInterface->GetBounds().GetBox();
+
+			// Any volume overlapping a dirty cell must be rasterized again, even if it hasn't changed itself
+			const bool bIntersectsDirtyRegion = DirtyRegions.ContainsByPredicate([&PrimitiveBounds](const FHVPTOrthoGridDirtyRegion& DirtyRegion)
+				{
+					return DirtyRegion.WorldBounds.Intersect(PrimitiveBounds);
+				});
+
+			if (bIntersectsDirtyRegion)
+			{
+				DirtyMeshBatches.Add(MeshBatch);
+				break;
+			}
+		}
+	}
+}
+
+void HVPT::Private::MergeDirtyTopLevelGridCells(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FIntVector TopLevelGridResolution,
+	const TArray<FHVPTOrthoGridDirtyRegion>& DirtyRegions,
+	FRDGBufferRef DirtyTopLevelGridBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	FRDGBufferRef VelocityGridBuffer,
+	FRDGBufferRef BrickFreeListBuffer,
+	uint32 GridDataFormats,
+	FRDGBufferRef& RasterTopLevelGridBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	RasterTopLevelGridBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateStructuredDesc(sizeof(FHVPT_TopLevelGridData), TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z),
+		TEXT("HVPT.OrthoGrid.RasterTopLevelGridBuffer")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(RasterTopLevelGridBuffer), 0xFFFFFFF8, ComputePassFlags);
+
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+	TShaderRef<FHVPT_MergeDirtyTopLevelGridCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_MergeDirtyTopLevelGridCS>();
+
+	for (const FHVPTOrthoGridDirtyRegion& DirtyRegion : DirtyRegions)
+	{
+		FHVPT_MergeDirtyTopLevelGridCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_MergeDirtyTopLevelGridCS::FParameters>();
+		{
+			PassParameters->TopLevelGridResolution = TopLevelGridResolution;
+			PassParameters->DirtyCellMin = DirtyRegion.CellMin;
+			PassParameters->DirtyCellMax = DirtyRegion.CellMax;
+
+			PassParameters->DirtyTopLevelGridBuffer = GraphBuilder.CreateSRV(DirtyTopLevelGridBuffer);
+
+			PassParameters->RWTopLevelGridBuffer = GraphBuilder.CreateUAV(TopLevelGridBuffer);
+			PassParameters->RWRasterTopLevelGridBuffer = GraphBuilder.CreateUAV(RasterTopLevelGridBuffer);
+			PassParameters->RWExtinctionGridBuffer = GraphBuilder.CreateUAV(ExtinctionGridBuffer);
+			PassParameters->RWEmissionGridBuffer = GraphBuilder.CreateUAV(EmissionGridBuffer);
+			PassParameters->RWScatteringGridBuffer = GraphBuilder.CreateUAV(ScatteringGridBuffer);
+			PassParameters->RWVelocityGridBuffer = GraphBuilder.CreateUAV(VelocityGridBuffer);
+
+			PassParameters->GridDataFormats = GridDataFormats;
+			PassParameters->RWBrickFreeListBuffer = GraphBuilder.CreateUAV(BrickFreeListBuffer, PF_R32_UINT);
+		}
+
+		const FIntVector DirtyCellCount = DirtyRegion.CellMax - DirtyRegion.CellMin + FIntVector(1);
+		FIntVector GroupCount;
+		GroupCount.X = FMath::DivideAndRoundUp(DirtyCellCount.X, FHVPT_MergeDirtyTopLevelGridCS::GetThreadGroupSize3D());
+		GroupCount.Y = FMath::DivideAndRoundUp(DirtyCellCount.Y, FHVPT_MergeDirtyTopLevelGridCS::GetThreadGroupSize3D());
+		GroupCount.Z = FMath::DivideAndRoundUp(DirtyCellCount.Z, FHVPT_MergeDirtyTopLevelGridCS::GetThreadGroupSize3D());
+
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("MergeDirtyTopLevelGrid"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
 			ComputeShader,
 			PassParameters,
 			GroupCount
 		);
 	}
 }
+
+void HVPT::Private::InterleaveShadingGridData(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	FRDGBufferRef RasterTileBuffer,
+	FRDGBufferRef RasterTileAllocatorBuffer,
+	FRDGBufferRef TopLevelGridBuffer,
+	FRDGBufferRef ExtinctionGridBuffer,
+	FRDGBufferRef EmissionGridBuffer,
+	FRDGBufferRef ScatteringGridBuffer,
+	uint32 GridDataFormats,
+	FRDGBufferRef ShadingGridBuffer,
+	ERDGPassFlags ComputePassFlags
+)
+{
+	RDG_GPU_STAT_SCOPE(GraphBuilder, HVPTInterleaveShadingData);
+
+	FRDGBufferRef IndirectArgsBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(1),
+		TEXT("HVPT.InterleaveShadingGridDataIndirectArgs")
+	);
+
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+
+	{
+		FHVPT_SetRasterizeBottomLevelGridIndirectArgsCS::FParameters* IndirectArgsPassParameters = GraphBuilder.AllocParameters<FHVPT_SetRasterizeBottomLevelGridIndirectArgsCS::FParameters>();
+		{
+			IndirectArgsPassParameters->MaxDispatchThreadGroupsPerDimension = GRHIMaxDispatchThreadGroupsPerDimension;
+			IndirectArgsPassParameters->RasterTileAllocatorBuffer = GraphBuilder.CreateSRV(RasterTileAllocatorBuffer, PF_R32_UINT);
+			IndirectArgsPassParameters->RWRasterizeBottomLevelGridIndirectArgsBuffer = GraphBuilder.CreateUAV(IndirectArgsBuffer, PF_R32_UINT);
+		}
+
+		FIntVector GroupCount(1, 1, 1);
+		TShaderRef<FHVPT_SetRasterizeBottomLevelGridIndirectArgsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_SetRasterizeBottomLevelGridIndirectArgsCS>();
+		FComputeShaderUtils::AddPass(
+			GraphBuilder,
+			RDG_EVENT_NAME("SetInterleaveShadingGridDataIndirectArgs"),
+			ComputePassFlags | ERDGPassFlags::NeverCull,
+			ComputeShader,
+			IndirectArgsPassParameters,
+			GroupCount
+		);
+	}
+
+	FHVPT_InterleaveShadingGridDataCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_InterleaveShadingGridDataCS::FParameters>();
+	{
+		PassParameters->RasterTileAllocatorBuffer = GraphBuilder.CreateSRV(RasterTileAllocatorBuffer, PF_R32_UINT);
+		PassParameters->RasterTileBuffer = GraphBuilder.CreateSRV(RasterTileBuffer);
+		PassParameters->IndirectArgs = IndirectArgsBuffer;
+
+		PassParameters->GridDataFormats = GridDataFormats;
+		PassParameters->TopLevelGridBuffer = GraphBuilder.CreateSRV(TopLevelGridBuffer);
+		PassParameters->ExtinctionGridBuffer = GraphBuilder.CreateSRV(ExtinctionGridBuffer);
+		PassParameters->EmissionGridBuffer = GraphBuilder.CreateSRV(EmissionGridBuffer);
+		PassParameters->ScatteringGridBuffer = GraphBuilder.CreateSRV(ScatteringGridBuffer);
+		PassParameters->RWShadingGridBuffer = GraphBuilder.CreateUAV(ShadingGridBuffer);
+	}
+
+	TShaderRef<FHVPT_InterleaveShadingGridDataCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_InterleaveShadingGridDataCS>();
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("InterleaveShadingGridData"),
+		ComputePassFlags | ERDGPassFlags::NeverCull,
+		ComputeShader,
+		PassParameters,
+		IndirectArgsBuffer,
+		0
+	);
+}
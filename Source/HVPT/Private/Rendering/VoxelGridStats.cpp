@@ -0,0 +1,347 @@
+#include "VoxelGridStats.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "ScenePrivate.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+#include "GridDataFormat.h"
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Top-Level Cells"), STAT_HVPTOrthoGridTopLevelCells, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Allocated Bricks"), STAT_HVPTOrthoGridAllocatedBricks, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Brick Capacity"), STAT_HVPTOrthoGridBrickCapacity, STATGROUP_HVPT);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Ortho Grid Brick Pool Occupancy (%)"), STAT_HVPTOrthoGridBrickPoolOccupancy, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Cells At Resolution 1"), STAT_HVPTOrthoGridCellsAtResolution1, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Cells At Resolution 2"), STAT_HVPTOrthoGridCellsAtResolution2, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Cells At Resolution 4"), STAT_HVPTOrthoGridCellsAtResolution4, STATGROUP_HVPT);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Ortho Grid Largest Volume Voxels"), STAT_HVPTOrthoGridLargestVolumeVoxels, STATGROUP_HVPT);
+DECLARE_MEMORY_STAT(TEXT("Ortho Grid Brick Pool"), STAT_HVPTOrthoGridBrickPoolMemory, STATGROUP_HVPT);
+DECLARE_MEMORY_STAT(TEXT("Ortho Grid Allocated Bricks"), STAT_HVPTOrthoGridAllocatedBrickMemory, STATGROUP_HVPT);
+DECLARE_MEMORY_STAT(TEXT("Ortho Grid Shading Data (Per-Channel)"), STAT_HVPTOrthoGridPerChannelShadingDataMemory, STATGROUP_HVPT);
+DECLARE_MEMORY_STAT(TEXT("Ortho Grid Shading Data (Interleaved)"), STAT_HVPTOrthoGridInterleavedShadingDataMemory, STATGROUP_HVPT);
+DECLARE_MEMORY_STAT(TEXT("Frustum Grid Shading Data (Per-Channel)"), STAT_HVPTFrustumGridPerChannelShadingDataMemory, STATGROUP_HVPT);
+DECLARE_MEMORY_STAT(TEXT("Frustum Grid Shading Data (Interleaved)"), STAT_HVPTFrustumGridInterleavedShadingDataMemory, STATGROUP_HVPT);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Null Collisions Per Path"), STAT_HVPTNullCollisionsPerPath, STATGROUP_HVPT);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Real Collisions Per Path"), STAT_HVPTRealCollisionsPerPath, STATGROUP_HVPT);
+
+CSV_DEFINE_CATEGORY(HVPT, true);
+
+
+class FHVPT_CollectOrthoGridStatsCS : public FGlobalShader
+{
+	DECLARE_GLOBAL_SHADER(FHVPT_CollectOrthoGridStatsCS);
+	SHADER_USE_PARAMETER_STRUCT(FHVPT_CollectOrthoGridStatsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER(FIntVector, TopLevelGridResolution)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FHVPT_TopLevelGridData>, TopLevelGridBuffer)
+
+		SHADER_PARAMETER(int, NumStatsVolumes)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<int4>, StatsVolumeCellBoundsBuffer)
+
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWOrthoGridStatsBuffer)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return HVPT::DoesPlatformSupportHVPT(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FMaterialShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_1D"), GetThreadGroupSize1D());
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE_3D"), GetThreadGroupSize3D());
+	}
+
+	static int32 GetThreadGroupSize1D() { return GetThreadGroupSize3D() * GetThreadGroupSize3D() * GetThreadGroupSize3D(); }
+	static int32 GetThreadGroupSize3D() { return 4; }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FHVPT_CollectOrthoGridStatsCS, "/Plugin/HVPT/Private/VoxelGrid/VoxelGridBuild.usf", "HVPT_CollectOrthoGridStatsCS", SF_Compute);
+
+
+void HVPT::QueueOrthoVoxelGridStatsReadback(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer,
+	const FHVPTBrickPool& BrickPool,
+	const TMap<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecords,
+	FHVPTOrthoGridStatsReadback& StatsReadback
+)
+{
+	if (StatsReadback.bReadbackPending)
+	{
+		return;
+	}
+
+	const TRDGParameterStruct<FHVPTOrthoGridUniformBufferParameters>& Parameters = OrthoGridUniformBuffer->GetParameters();
+	if (!Parameters->bUseOrthoGrid || Parameters->TopLevelGridWorldBoundsMin == Parameters->TopLevelGridWorldBoundsMax)
+	{
+		return;
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "HVPT: Ortho Grid Stats");
+
+	FHVPTOrthoGridStats& Stats = StatsReadback.PendingStats;
+	Stats = FHVPTOrthoGridStats();
+	Stats.TopLevelGridResolution = Parameters->TopLevelGridResolution;
+	Stats.VoxelsPerBrick = Parameters->VoxelsPerBrick;
+
+	Stats.BytesPerVoxel = CalcGridDataBytesPerVoxelForAllChannels(Parameters->GridDataFormats);
+	if (Parameters->bUseInterleavedShadingData)
+	{
+		Stats.BytesPerVoxel += sizeof(FHVPT_ShadingGridData);
+	}
+	Stats.BrickCapacity = BrickPool.IsValid() ? BrickPool.BrickCapacity : 0;
+
+	// Volumes are attributed the cells their bounds overlap, found by snapping the bounds outwards to the top-level grid
+	const FVector3f GridMin = Parameters->TopLevelGridWorldBoundsMin;
+	const FVector3f CellSize = (Parameters->TopLevelGridWorldBoundsMax - GridMin) / FVector3f(Stats.TopLevelGridResolution);
+	const FIntVector MaxCell = Stats.TopLevelGridResolution - FIntVector(1);
+
+	TArray<FIntVector4> VolumeCellBounds;
+	for (const TPair<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecord : VolumeRecords)
+	{
+		if (Stats.Volumes.Num() == HVPT_ORTHO_GRID_STATS_MAX_VOLUMES)
+		{
+			Stats.UncountedVolumeCount++;
+			continue;
+		}
+
+		const FHVPTOrthoGridVolumeRecord& Record = VolumeRecord.Value;
+		const FVector3f CellMin = (FVector3f(Record.WorldBounds.Min) - GridMin) / CellSize;
+		const FVector3f CellMax = (FVector3f(Record.WorldBounds.Max) - GridMin) / CellSize;
+		const FIntVector MinIndex = FIntVector(FMath::FloorToInt(CellMin.X), FMath::FloorToInt(CellMin.Y), FMath::FloorToInt(CellMin.Z));
+		const FIntVector MaxIndex = FIntVector(FMath::FloorToInt(CellMax.X), FMath::FloorToInt(CellMax.Y), FMath::FloorToInt(CellMax.Z));
+		VolumeCellBounds.Emplace(MinIndex.ComponentMax(FIntVector::ZeroValue), 0);
+		VolumeCellBounds.Emplace(MaxIndex.ComponentMin(MaxCell), 0);
+
+		// The low bits of the key are the index of the volume within its component
+		const uint32 VolumeIndex = static_cast<uint32>(VolumeRecord.Key);
+		FHVPTOrthoGridVolumeStats& VolumeStats = Stats.Volumes.AddDefaulted_GetRef();
+		VolumeStats.Name = VolumeIndex > 0 ? FString::Printf(TEXT("%s[%u]"), *Record.OwnerName.ToString(), VolumeIndex) : Record.OwnerName.ToString();
+	}
+
+	// Buffers cannot be empty
+	if (VolumeCellBounds.IsEmpty())
+	{
+		VolumeCellBounds.AddZeroed(2);
+	}
+
+	FRDGBufferRef VolumeCellBoundsBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(FIntVector4), VolumeCellBounds.Num()),
+		TEXT("HVPT.OrthoGridStatsVolumeCellBounds")
+	);
+	GraphBuilder.QueueBufferUpload(VolumeCellBoundsBuffer, VolumeCellBounds.GetData(), VolumeCellBounds.Num() * VolumeCellBounds.GetTypeSize());
+
+	const int32 NumCounters = HVPT_ORTHO_GRID_STATS_VOLUME_VOXEL_COUNTS + Stats.Volumes.Num();
+	FRDGBufferRef StatsBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumCounters),
+		TEXT("HVPT.OrthoGridStats")
+	);
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(StatsBuffer, PF_R32_UINT), 0);
+
+	FHVPT_CollectOrthoGridStatsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHVPT_CollectOrthoGridStatsCS::FParameters>();
+	{
+		PassParameters->TopLevelGridResolution = Stats.TopLevelGridResolution;
+		PassParameters->TopLevelGridBuffer = Parameters->TopLevelGridBuffer;
+
+		PassParameters->NumStatsVolumes = Stats.Volumes.Num();
+		PassParameters->StatsVolumeCellBoundsBuffer = GraphBuilder.CreateSRV(VolumeCellBoundsBuffer, PF_R32G32B32A32_SINT);
+
+		PassParameters->RWOrthoGridStatsBuffer = GraphBuilder.CreateUAV(StatsBuffer, PF_R32_UINT);
+	}
+
+	const FIntVector GroupCount = FComputeShaderUtils::GetGroupCount(Stats.TopLevelGridResolution, FHVPT_CollectOrthoGridStatsCS::GetThreadGroupSize3D());
+
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+	TShaderRef<FHVPT_CollectOrthoGridStatsCS> ComputeShader = GlobalShaderMap->GetShader<FHVPT_CollectOrthoGridStatsCS>();
+	FComputeShaderUtils::AddPass(
+		GraphBuilder,
+		RDG_EVENT_NAME("CollectOrthoGridStats"),
+		ComputeShader,
+		PassParameters,
+		GroupCount
+	);
+
+	if (!StatsReadback.Readback.IsValid())
+	{
+		StatsReadback.Readback = MakeUnique<FRHIGPUBufferReadback>(TEXT("HVPT.OrthoGridStatsReadback"));
+	}
+	AddEnqueueCopyPass(GraphBuilder, StatsReadback.Readback.Get(), StatsBuffer, NumCounters * sizeof(uint32));
+
+	StatsReadback.bReadbackPending = true;
+}
+
+void HVPT::UpdateOrthoVoxelGridStats(FHVPTOrthoGridStatsReadback& StatsReadback)
+{
+	if (StatsReadback.bReadbackPending && StatsReadback.Readback->IsReady())
+	{
+		FHVPTOrthoGridStats& Stats = StatsReadback.PendingStats;
+
+		const int32 NumCounters = HVPT_ORTHO_GRID_STATS_VOLUME_VOXEL_COUNTS + Stats.Volumes.Num();
+		const uint32* Counters = static_cast<const uint32*>(StatsReadback.Readback->Lock(NumCounters * sizeof(uint32)));
+
+		Stats.AllocatedBrickCount = Counters[HVPT_ORTHO_GRID_STATS_ALLOCATED_CELL_COUNT];
+		Stats.UsedVoxelCount = Counters[HVPT_ORTHO_GRID_STATS_USED_VOXEL_COUNT];
+		for (int32 ResolutionIndex = 0; ResolutionIndex < HVPT_ORTHO_GRID_STATS_RESOLUTION_COUNT; ++ResolutionIndex)
+		{
+			Stats.CellCountByResolution[ResolutionIndex] = Counters[HVPT_ORTHO_GRID_STATS_CELLS_BY_RESOLUTION + ResolutionIndex];
+		}
+		for (int32 VolumeIndex = 0; VolumeIndex < Stats.Volumes.Num(); ++VolumeIndex)
+		{
+			Stats.Volumes[VolumeIndex].VoxelCount = Counters[HVPT_ORTHO_GRID_STATS_VOLUME_VOXEL_COUNTS + VolumeIndex];
+		}
+
+		StatsReadback.Readback->Unlock();
+
+		Stats.Volumes.Sort([](const FHVPTOrthoGridVolumeStats& A, const FHVPTOrthoGridVolumeStats& B)
+		{
+			return A.VoxelCount > B.VoxelCount;
+		});
+
+		StatsReadback.Stats = MoveTemp(Stats);
+		StatsReadback.PendingStats = FHVPTOrthoGridStats();
+		StatsReadback.bHasStats = true;
+		StatsReadback.bReadbackPending = false;
+
+		if (StatsReadback.bDumpWhenReady)
+		{
+			DumpOrthoVoxelGridStats(StatsReadback.Stats);
+			StatsReadback.bDumpWhenReady = false;
+		}
+	}
+
+	if (!StatsReadback.bHasStats)
+	{
+		return;
+	}
+
+	const FHVPTOrthoGridStats& Stats = StatsReadback.Stats;
+	const int32 TopLevelCellCount = Stats.TopLevelGridResolution.X * Stats.TopLevelGridResolution.Y * Stats.TopLevelGridResolution.Z;
+	const int64 PoolVoxelCount = static_cast<int64>(Stats.BrickCapacity) * Stats.VoxelsPerBrick;
+	const float BrickPoolOccupancy = PoolVoxelCount > 0 ? 100.0f * Stats.UsedVoxelCount / PoolVoxelCount : 0.0f;
+
+	SET_DWORD_STAT(STAT_HVPTOrthoGridTopLevelCells, TopLevelCellCount);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridAllocatedBricks, Stats.AllocatedBrickCount);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridBrickCapacity, Stats.BrickCapacity);
+	SET_FLOAT_STAT(STAT_HVPTOrthoGridBrickPoolOccupancy, BrickPoolOccupancy);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridCellsAtResolution1, Stats.CellCountByResolution[0]);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridCellsAtResolution2, Stats.CellCountByResolution[1]);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridCellsAtResolution4, Stats.CellCountByResolution[2]);
+	SET_DWORD_STAT(STAT_HVPTOrthoGridLargestVolumeVoxels, Stats.Volumes.IsEmpty() ? 0 : Stats.Volumes[0].VoxelCount);
+	SET_MEMORY_STAT(STAT_HVPTOrthoGridBrickPoolMemory, PoolVoxelCount * Stats.BytesPerVoxel);
+	SET_MEMORY_STAT(STAT_HVPTOrthoGridAllocatedBrickMemory, Stats.UsedVoxelCount * Stats.BytesPerVoxel);
+
+	CSV_CUSTOM_STAT(HVPT, OrthoGridAllocatedBricks, Stats.AllocatedBrickCount, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(HVPT, OrthoGridBrickCapacity, Stats.BrickCapacity, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(HVPT, OrthoGridBrickPoolOccupancy, BrickPoolOccupancy, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(HVPT, OrthoGridBrickPoolMB, static_cast<float>(PoolVoxelCount * Stats.BytesPerVoxel / (1024.0 * 1024.0)), ECsvCustomStatOp::Set);
+}
+
+void HVPT::DumpOrthoVoxelGridStats(const FHVPTOrthoGridStats& Stats)
+{
+	const double BytesToMegabytes = 1.0 / (1024.0 * 1024.0);
+	const int64 PoolVoxelCount = static_cast<int64>(Stats.BrickCapacity) * Stats.VoxelsPerBrick;
+
+	UE_LOG(LogHVPT, Log, TEXT("Ortho grid stats:"));
+	UE_LOG(LogHVPT, Log, TEXT("  Top-level grid: %dx%dx%d cells"), Stats.TopLevelGridResolution.X, Stats.TopLevelGridResolution.Y, Stats.TopLevelGridResolution.Z);
+	UE_LOG(LogHVPT, Log, TEXT("  Bricks: %d allocated from %d slabs of %d voxels"), Stats.AllocatedBrickCount, Stats.BrickCapacity, Stats.VoxelsPerBrick);
+	UE_LOG(LogHVPT, Log, TEXT("  Voxels: %lld of %lld in the pool are allocated (%.1f%%), %.1f of %.1f MB"),
+		Stats.UsedVoxelCount, PoolVoxelCount, PoolVoxelCount > 0 ? 100.0 * Stats.UsedVoxelCount / PoolVoxelCount : 0.0,
+		Stats.UsedVoxelCount * Stats.BytesPerVoxel * BytesToMegabytes, PoolVoxelCount * Stats.BytesPerVoxel * BytesToMegabytes);
+	UE_LOG(LogHVPT, Log, TEXT("  Cells by resolution: 1: %d, 2: %d, 4: %d"),
+		Stats.CellCountByResolution[0], Stats.CellCountByResolution[1], Stats.CellCountByResolution[2]);
+
+	UE_LOG(LogHVPT, Log, TEXT("  Volumes (cells shared by overlapping volumes count towards each):"));
+	for (const FHVPTOrthoGridVolumeStats& VolumeStats : Stats.Volumes)
+	{
+		UE_LOG(LogHVPT, Log, TEXT("    %s: %lld voxels, %.1f MB"), *VolumeStats.Name, VolumeStats.VoxelCount, VolumeStats.VoxelCount * Stats.BytesPerVoxel * BytesToMegabytes);
+	}
+	if (Stats.UncountedVolumeCount > 0)
+	{
+		UE_LOG(LogHVPT, Log, TEXT("    %d more volumes were not counted"), Stats.UncountedVolumeCount);
+	}
+}
+
+void HVPT::SetShadingDataMemoryStats(bool bOrthoGrid, int32 BottomLevelVoxelCount, uint32 GridDataFormats, bool bInterleavedShadingData)
+{
+	int64 PerChannelBytes = 0;
+	for (int32 Channel : { HVPT_GRID_DATA_CHANNEL_EXTINCTION, HVPT_GRID_DATA_CHANNEL_SCATTERING, HVPT_GRID_DATA_CHANNEL_EMISSION })
+	{
+		PerChannelBytes += static_cast<int64>(CalcGridDataBufferSize(GetGridDataFormat(GridDataFormats, Channel), BottomLevelVoxelCount)) * sizeof(FHVPT_GridData);
+	}
+	const int64 InterleavedBytes = bInterleavedShadingData ? static_cast<int64>(BottomLevelVoxelCount) * sizeof(FHVPT_ShadingGridData) : 0;
+
+	const double BytesToMegabytes = 1.0 / (1024.0 * 1024.0);
+	if (bOrthoGrid)
+	{
+		SET_MEMORY_STAT(STAT_HVPTOrthoGridPerChannelShadingDataMemory, PerChannelBytes);
+		SET_MEMORY_STAT(STAT_HVPTOrthoGridInterleavedShadingDataMemory, InterleavedBytes);
+
+		CSV_CUSTOM_STAT(HVPT, OrthoGridPerChannelShadingDataMB, static_cast<float>(PerChannelBytes * BytesToMegabytes), ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(HVPT, OrthoGridInterleavedShadingDataMB, static_cast<float>(InterleavedBytes * BytesToMegabytes), ECsvCustomStatOp::Set);
+	}
+	else
+	{
+		SET_MEMORY_STAT(STAT_HVPTFrustumGridPerChannelShadingDataMemory, PerChannelBytes);
+		SET_MEMORY_STAT(STAT_HVPTFrustumGridInterleavedShadingDataMemory, InterleavedBytes);
+
+		CSV_CUSTOM_STAT(HVPT, FrustumGridPerChannelShadingDataMB, static_cast<float>(PerChannelBytes * BytesToMegabytes), ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(HVPT, FrustumGridInterleavedShadingDataMB, static_cast<float>(InterleavedBytes * BytesToMegabytes), ECsvCustomStatOp::Set);
+	}
+}
+
+void HVPT::QueueCollisionStatsReadback(FRDGBuilder& GraphBuilder, FRDGBufferRef CollisionStatsBuffer, FHVPTCollisionStatsReadback& StatsReadback)
+{
+	if (StatsReadback.bReadbackPending)
+	{
+		return;
+	}
+
+	if (!StatsReadback.Readback.IsValid())
+	{
+		StatsReadback.Readback = MakeUnique<FRHIGPUBufferReadback>(TEXT("HVPT.CollisionStatsReadback"));
+	}
+	AddEnqueueCopyPass(GraphBuilder, StatsReadback.Readback.Get(), CollisionStatsBuffer, HVPT_COLLISION_STATS_SIZE * sizeof(uint32));
+
+	StatsReadback.bReadbackPending = true;
+}
+
+void HVPT::UpdateCollisionStats(FHVPTCollisionStatsReadback& StatsReadback)
+{
+	if (StatsReadback.bReadbackPending && StatsReadback.Readback->IsReady())
+	{
+		const uint32* Counters = static_cast<const uint32*>(StatsReadback.Readback->Lock(HVPT_COLLISION_STATS_SIZE * sizeof(uint32)));
+
+		auto ReadCount = [Counters](int32 CounterIndex)
+		{
+			return static_cast<uint64>(Counters[CounterIndex]) | (static_cast<uint64>(Counters[CounterIndex + 1]) << 32);
+		};
+		const uint64 PathCount = Counters[HVPT_COLLISION_STATS_PATH_COUNT];
+		const uint64 NullCollisionCount = ReadCount(HVPT_COLLISION_STATS_NULL_COUNT);
+		const uint64 RealCollisionCount = ReadCount(HVPT_COLLISION_STATS_REAL_COUNT);
+
+		StatsReadback.Readback->Unlock();
+
+		StatsReadback.PathCount = PathCount;
+		StatsReadback.NullCollisionsPerPath = PathCount > 0 ? static_cast<float>(static_cast<double>(NullCollisionCount) / PathCount) : 0.0f;
+		StatsReadback.RealCollisionsPerPath = PathCount > 0 ? static_cast<float>(static_cast<double>(RealCollisionCount) / PathCount) : 0.0f;
+		StatsReadback.bHasStats = true;
+		StatsReadback.bReadbackPending = false;
+	}
+
+	if (!StatsReadback.bHasStats)
+	{
+		return;
+	}
+
+	SET_FLOAT_STAT(STAT_HVPTNullCollisionsPerPath, StatsReadback.NullCollisionsPerPath);
+	SET_FLOAT_STAT(STAT_HVPTRealCollisionsPerPath, StatsReadback.RealCollisionsPerPath);
+
+	CSV_CUSTOM_STAT(HVPT, NullCollisionsPerPath, StatsReadback.NullCollisionsPerPath, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(HVPT, RealCollisionsPerPath, StatsReadback.RealCollisionsPerPath, ECsvCustomStatOp::Set);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphFwd.h"
+#include "Stats/Stats.h"
+#include "VoxelGrid.h"
+
+class FScene;
+class FRHIGPUBufferReadback;
+
+DECLARE_STATS_GROUP(TEXT("HVPT"), STATGROUP_HVPT, STATCAT_Advanced);
+
+
+// Bricks used by one volume of the ortho grid
+struct FHVPTOrthoGridVolumeStats
+{
+	FString Name;
+
+	// Voxels of the bricks of the allocated cells within the bounds of the volume
+	// Cells shared by overlapping volumes are counted for each of them
+	int64 VoxelCount = 0;
+};
+
+// Occupancy of the ortho grid and its brick pool, see r.HVPT.OrthoGrid.Stats
+struct FHVPTOrthoGridStats
+{
+	FIntVector TopLevelGridResolution = FIntVector::ZeroValue;
+
+	// Slabs of the pool, zero for a baked grid, which does not have a pool
+	int32 BrickCapacity = 0;
+	int32 VoxelsPerBrick = 0;
+	int64 BytesPerVoxel = 0;
+
+	// Every allocated cell holds exactly one brick of its own resolution
+	int32 AllocatedBrickCount = 0;
+	// Voxels of the allocated bricks, which is all of the pool memory they use as bricks are sized to their resolution
+	int64 UsedVoxelCount = 0;
+	int32 CellCountByResolution[HVPT_ORTHO_GRID_STATS_RESOLUTION_COUNT] = {};
+
+	// Largest first. Only the first HVPT_ORTHO_GRID_STATS_MAX_VOLUMES volumes of the grid are counted
+	TArray<FHVPTOrthoGridVolumeStats> Volumes;
+	int32 UncountedVolumeCount = 0;
+};
+
+// Readback of the ortho grid stats, which completes a few frames after the build it describes
+struct FHVPTOrthoGridStatsReadback
+{
+	// Results of the last readback to complete
+	FHVPTOrthoGridStats Stats;
+	bool bHasStats = false;
+
+	// Readback in flight, and the parts of its stats that are already known on the CPU
+	TUniquePtr<FRHIGPUBufferReadback> Readback;
+	FHVPTOrthoGridStats PendingStats;
+	bool bReadbackPending = false;
+
+	// Set by r.HVPT.OrthoGrid.DumpStats, to log the stats once the next readback completes
+	bool bDumpWhenReady = false;
+};
+
+// Readback of the collisions of the path tracing pipeline, taken while r.HVPT.DebugViewMode shows collisions
+// Averaged over every path of the view, so the totals stay comparable when toggling r.HVPT.OrthoGrid.SubBrickMajorants
+struct FHVPTCollisionStatsReadback
+{
+	// Results of the last readback to complete
+	uint64 PathCount = 0;
+	float NullCollisionsPerPath = 0.0f;
+	float RealCollisionsPerPath = 0.0f;
+	bool bHasStats = false;
+
+	TUniquePtr<FRHIGPUBufferReadback> Readback;
+	bool bReadbackPending = false;
+};
+
+
+namespace HVPT
+{
+
+// Counts the allocated cells of OrthoGridUniformBuffer on the GPU and queues a readback of the counts, unless a readback is still in flight
+void QueueOrthoVoxelGridStatsReadback(
+	FRDGBuilder& GraphBuilder,
+	const FScene* Scene,
+	const TRDGUniformBufferRef<FHVPTOrthoGridUniformBufferParameters>& OrthoGridUniformBuffer,
+	const FHVPTBrickPool& BrickPool,
+	const TMap<uint64, FHVPTOrthoGridVolumeRecord>& VolumeRecords,
+	FHVPTOrthoGridStatsReadback& StatsReadback
+);
+
+// Picks up the counts once the readback has completed, and publishes the latest stats to stat HVPT and the CSV profiler
+void UpdateOrthoVoxelGridStats(FHVPTOrthoGridStatsReadback& StatsReadback);
+
+void DumpOrthoVoxelGridStats(const FHVPTOrthoGridStats& Stats);
+
+// Publishes the memory of the extinction, scattering and emission channels of a grid to stat HVPT and the CSV profiler, in both layouts
+// With r.HVPT.InterleavedShadingData the interleaved copy is kept on top of the per-channel buffers, so it adds to their memory
+void SetShadingDataMemoryStats(bool bOrthoGrid, int32 BottomLevelVoxelCount, uint32 GridDataFormats, bool bInterleavedShadingData);
+
+// Queues a readback of the HVPT_COLLISION_STATS_SIZE counters of CollisionStatsBuffer, unless a readback is still in flight
+void QueueCollisionStatsReadback(FRDGBuilder& GraphBuilder, FRDGBufferRef CollisionStatsBuffer, FHVPTCollisionStatsReadback& StatsReadback);
+
+// Picks up the averages once the readback has completed, and publishes the latest ones to stat HVPT and the CSV profiler
+void UpdateCollisionStats(FHVPTCollisionStatsReadback& StatsReadback);
+
+}
@@ -0,0 +1,168 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/BakedVoxelGrid.h"
+#include "Rendering/GridDataFormat.h"
+#include "Rendering/MajorantPyramid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+// Matches the encoding of FHVPT_TopLevelGridData in VoxelGridBuildUtils.ush
+constexpr uint32 EmptyVoxelIndex = 0x1FFFFFFF;
+
+uint32 GetBottomLevelIndex(uint32 TopLevelGridData)
+{
+	return TopLevelGridData >> 3;
+}
+
+bool IsBottomLevelAllocated(uint32 TopLevelGridData)
+{
+	return GetBottomLevelIndex(TopLevelGridData) != EmptyVoxelIndex;
+}
+
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTBakedOrthoGridRoundTripTest, "HVPT.BakedOrthoGrid.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTBakedOrthoGridRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace HVPT::Private;
+
+	// Every size of voxel
+	const uint32 GridDataFormats = (HVPT_GRID_DATA_FORMAT_MONOCHROME16 << (4 * HVPT_GRID_DATA_CHANNEL_EXTINCTION))
+		| (HVPT_GRID_DATA_FORMAT_RGB9E5 << (4 * HVPT_GRID_DATA_CHANNEL_EMISSION))
+		| (HVPT_GRID_DATA_FORMAT_RGBE8 << (4 * HVPT_GRID_DATA_CHANNEL_SCATTERING))
+		| (HVPT_GRID_DATA_FORMAT_FLOAT16 << (4 * HVPT_GRID_DATA_CHANNEL_VELOCITY));
+
+	const FIntVector TopLevelGridResolution(3, 2, 2);
+	const int32 TopLevelCellCount = TopLevelGridResolution.X * TopLevelGridResolution.Y * TopLevelGridResolution.Z;
+	const int32 VoxelsPerBrick = 64;
+	const int32 PoolBrickCapacity = 6;
+	const int32 SubBricksPerBrick = 2;
+	const int32 MajorantMipCount = CalcMajorantMipCount(TopLevelGridResolution, HVPT_MAX_MAJORANT_MIP_COUNT);
+
+	// Slabs out of order and with gaps between them, as left behind by incremental builds.
+	// Cells 3 and 10 share slab 2 with bricks of different sizes, and cell 9 is marked but was not allocated, so has no brick
+	TArray<uint32> TopLevelGrid;
+	TopLevelGrid.Init(0xFFFFFFF8, TopLevelCellCount);
+	TopLevelGrid[1] = ((4 * VoxelsPerBrick) << 3) | 4;
+	TopLevelGrid[3] = ((2 * VoxelsPerBrick + 56) << 3) | 2;
+	TopLevelGrid[5] = ((0 * VoxelsPerBrick + 8) << 3) | 2;
+	TopLevelGrid[7] = ((3 * VoxelsPerBrick) << 3) | 4;
+	TopLevelGrid[9] = (EmptyVoxelIndex << 3) | 2;
+	TopLevelGrid[10] = ((2 * VoxelsPerBrick + 3) << 3) | 1;
+
+	TArray<uint8> ChannelData[HVPT_GRID_DATA_CHANNEL_COUNT];
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		ChannelData[Channel].SetNumUninitialized(CalcBakedChannelDataSize(GridDataFormats, Channel, VoxelsPerBrick, PoolBrickCapacity));
+		for (int32 Index = 0; Index < ChannelData[Channel].Num(); ++Index)
+		{
+			ChannelData[Channel][Index] = static_cast<uint8>(Index * 7 + Channel * 31);
+		}
+	}
+
+	TArray<uint32> Majorants;
+	Majorants.SetNumUninitialized(CalcMajorantMipOffset(TopLevelGridResolution, MajorantMipCount));
+	for (int32 Index = 0; Index < Majorants.Num(); ++Index)
+	{
+		Majorants[Index] = Index * 2654435761u;
+	}
+
+	TArray<uint32> SubBrickMajorants;
+	SubBrickMajorants.SetNumUninitialized(CalcMajorantMipSize(TopLevelGridResolution) * SubBricksPerBrick);
+	for (int32 Index = 0; Index < SubBrickMajorants.Num(); ++Index)
+	{
+		SubBrickMajorants[Index] = 1000 + Index;
+	}
+
+	FHVPTBakedOrthoGrid SourceGrid;
+	SourceGrid.TopLevelGridWorldBoundsMin = FVector3f(-100.0f, -50.0f, 0.0f);
+	SourceGrid.TopLevelGridWorldBoundsMax = FVector3f(200.0f, 150.0f, 400.0f);
+	SourceGrid.TopLevelGridResolution = TopLevelGridResolution;
+	SourceGrid.GridDataFormats = GridDataFormats;
+	SourceGrid.VoxelsPerBrick = VoxelsPerBrick;
+	SourceGrid.BrickCount = PoolBrickCapacity;
+	SourceGrid.MajorantMipCount = MajorantMipCount;
+	SourceGrid.SubBricksPerBrick = SubBricksPerBrick;
+	SourceGrid.TopLevelGrid = TopLevelGrid;
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		SourceGrid.ChannelData[Channel] = ChannelData[Channel];
+	}
+	SourceGrid.Majorants = Majorants;
+	SourceGrid.SubBrickMajorants = SubBrickMajorants;
+
+	TArray<uint8> Bytes;
+	SerializeBakedOrthoGrid(SourceGrid, Bytes);
+
+	FHVPTBakedOrthoGrid BakedGrid;
+	if (!TestTrue(TEXT("Serialized grid parses"), ParseBakedOrthoGrid(Bytes, BakedGrid)))
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("Bounds"), BakedGrid.TopLevelGridWorldBoundsMin == SourceGrid.TopLevelGridWorldBoundsMin && BakedGrid.TopLevelGridWorldBoundsMax == SourceGrid.TopLevelGridWorldBoundsMax);
+	TestTrue(TEXT("Resolution"), BakedGrid.TopLevelGridResolution == SourceGrid.TopLevelGridResolution);
+	TestTrue(TEXT("Formats"), BakedGrid.GridDataFormats == SourceGrid.GridDataFormats);
+	TestEqual(TEXT("Slab size"), BakedGrid.VoxelsPerBrick, SourceGrid.VoxelsPerBrick);
+	TestEqual(TEXT("Majorant mip count"), BakedGrid.MajorantMipCount, SourceGrid.MajorantMipCount);
+	TestEqual(TEXT("Sub-bricks per brick"), BakedGrid.SubBricksPerBrick, SourceGrid.SubBricksPerBrick);
+	TestEqual(TEXT("Only the slabs in use are kept"), BakedGrid.BrickCount, 4);
+	TestTrue(TEXT("Majorants"), BakedGrid.Majorants == SourceGrid.Majorants);
+	TestTrue(TEXT("Sub-brick majorants"), BakedGrid.SubBrickMajorants == SourceGrid.SubBrickMajorants);
+
+	// Each cell must keep its resolution, and its brick must hold the same bytes as before
+	for (int32 CellIndex = 0; CellIndex < TopLevelCellCount; ++CellIndex)
+	{
+		const uint32 SourceCell = SourceGrid.TopLevelGrid[CellIndex];
+		const uint32 BakedCell = BakedGrid.TopLevelGrid[CellIndex];
+		if (!TestTrue(FString::Printf(TEXT("Cell %d keeps its resolution and allocation"), CellIndex),
+			(SourceCell & 0x7) == (BakedCell & 0x7) && IsBottomLevelAllocated(SourceCell) == IsBottomLevelAllocated(BakedCell)))
+		{
+			continue;
+		}
+		if (!IsBottomLevelAllocated(SourceCell))
+		{
+			continue;
+		}
+
+		const int32 VoxelResolution = SourceCell & 0x7;
+		const int32 VoxelCount = VoxelResolution * VoxelResolution * VoxelResolution;
+		const int32 SourceVoxel = GetBottomLevelIndex(SourceCell);
+		const int32 BakedVoxel = GetBottomLevelIndex(BakedCell);
+		TestEqual(FString::Printf(TEXT("Cell %d keeps its offset in its slab"), CellIndex), BakedVoxel % VoxelsPerBrick, SourceVoxel % VoxelsPerBrick);
+		for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+		{
+			const int32 BytesPerVoxel = CalcGridDataBytesPerVoxel(GetGridDataFormat(GridDataFormats, Channel));
+			TestTrue(FString::Printf(TEXT("Cell %d keeps its voxels in channel %d"), CellIndex, Channel), FMemory::Memcmp(
+				SourceGrid.ChannelData[Channel].GetData() + SourceVoxel * BytesPerVoxel,
+				BakedGrid.ChannelData[Channel].GetData() + BakedVoxel * BytesPerVoxel,
+				VoxelCount * BytesPerVoxel
+			) == 0);
+		}
+	}
+
+	TestTrue(TEXT("Bricks sharing a slab move together"), GetBottomLevelIndex(BakedGrid.TopLevelGrid[3]) / VoxelsPerBrick == GetBottomLevelIndex(BakedGrid.TopLevelGrid[10]) / VoxelsPerBrick);
+
+	// Truncated files must be rejected rather than read out of bounds
+	FHVPTBakedOrthoGrid TruncatedGrid;
+	TestFalse(TEXT("Truncated grid is rejected"), ParseBakedOrthoGrid(TConstArrayView<uint8>(Bytes).LeftChop(16), TruncatedGrid));
+
+	// As is an index that points past the end of the pool
+	TArray<uint8> CorruptBytes(Bytes);
+	FHVPTBakedOrthoGrid CorruptGrid;
+	if (ParseBakedOrthoGrid(CorruptBytes, CorruptGrid))
+	{
+		uint32* CorruptCell = const_cast<uint32*>(&CorruptGrid.TopLevelGrid[7]);
+		*CorruptCell = ((CorruptGrid.BrickCount * VoxelsPerBrick - 8) << 3) | 4;
+		TestFalse(TEXT("Brick past the end of the pool is rejected"), ParseBakedOrthoGrid(CorruptBytes, CorruptGrid));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
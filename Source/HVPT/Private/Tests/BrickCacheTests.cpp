@@ -0,0 +1,119 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/BrickPool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+// Key of a volume covering SlotCount cells in a row, showing the given frame of its animation
+FHVPTBrickCacheKey MakeKey(int32 Frame, int32 SlotCount)
+{
+	FHVPTBrickCacheKey Key;
+	Key.Frame.MipLevel = Frame;
+	Key.CellMax = FIntVector(SlotCount - 1, 0, 0);
+	return Key;
+}
+
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTBrickCacheAllocatorTest, "HVPT.BrickCache.Allocator", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTBrickCacheAllocatorTest::RunTest(const FString& Parameters)
+{
+	FHVPTBrickCacheAllocator Allocator;
+	Allocator.Initialize(10);
+	bool bCreatedThisBuild;
+
+	// Frames 1 to 3 of a looping animation, one per build
+	Allocator.BeginBuild();
+	TestEqual(TEXT("Frame 1 starts the cache"), Allocator.Allocate(MakeKey(1, 4)), 0);
+	Allocator.BeginBuild();
+	TestEqual(TEXT("Frame 2 follows frame 1"), Allocator.Allocate(MakeKey(2, 4)), 4);
+	Allocator.BeginBuild();
+	TestEqual(TEXT("Frame 1 is found again"), Allocator.Find(MakeKey(1, 4), bCreatedThisBuild), 0);
+	TestFalse(TEXT("Frame 1 was filled by an earlier build"), bCreatedThisBuild);
+
+	// Frame 3 does not fit, and frame 2 is the least recently used
+	TestEqual(TEXT("Frame 3 replaces frame 2"), Allocator.Allocate(MakeKey(3, 4)), 4);
+	TestEqual(TEXT("Frame 2 is evicted"), Allocator.Find(MakeKey(2, 4), bCreatedThisBuild), int32(INDEX_NONE));
+	TestEqual(TEXT("Frame 3 is found"), Allocator.Find(MakeKey(3, 4), bCreatedThisBuild), 4);
+	TestTrue(TEXT("Frame 3 is not filled yet"), bCreatedThisBuild);
+
+	// Frames 1 and 3 are both used by this build, so there is no room for another
+	TestEqual(TEXT("Entries in use are not evicted"), Allocator.Allocate(MakeKey(4, 4)), int32(INDEX_NONE));
+	TestEqual(TEXT("Entry count"), Allocator.GetEntryCount(), 2);
+	TestEqual(TEXT("Used slot count"), Allocator.GetUsedSlotCount(), 8);
+
+	// Every field of the key must match, not just the frame
+	FHVPTBrickCacheKey OtherBox = MakeKey(1, 4);
+	OtherBox.CellMin.Y = -1;
+	OtherBox.CellMax.Y = -1;
+	TestEqual(TEXT("Same frame in another box of cells is not a match"), Allocator.Find(OtherBox, bCreatedThisBuild), int32(INDEX_NONE));
+
+	FHVPTBrickCacheKey OtherOffset = MakeKey(1, 4);
+	OtherOffset.QuantizedOffsetInCell.Z = 512;
+	TestEqual(TEXT("Same frame at another offset in its cell is not a match"), Allocator.Find(OtherOffset, bCreatedThisBuild), int32(INDEX_NONE));
+
+	FHVPTBrickCacheKey OtherScale = MakeKey(1, 4);
+	OtherScale.InstanceAxisX = FVector(2.0, 0.0, 0.0);
+	TestEqual(TEXT("Same frame at another scale is not a match"), Allocator.Find(OtherScale, bCreatedThisBuild), int32(INDEX_NONE));
+
+	FHVPTBrickCacheKey OtherParameters = MakeKey(1, 4);
+	OtherParameters.Frame.ParameterHash = 1;
+	TestEqual(TEXT("Same frame with other material parameters is not a match"), Allocator.Find(OtherParameters, bCreatedThisBuild), int32(INDEX_NONE));
+
+	FHVPTBrickCacheKey OtherRevision = MakeKey(1, 4);
+	OtherRevision.Frame.ContentRevision = 1;
+	TestEqual(TEXT("Same frame after the volume data was marked dirty is not a match"), Allocator.Find(OtherRevision, bCreatedThisBuild), int32(INDEX_NONE));
+
+	// Evicting both entries makes room for one larger than either
+	Allocator.BeginBuild();
+	TestEqual(TEXT("Larger entry evicts both"), Allocator.Allocate(MakeKey(5, 9)), 0);
+	TestEqual(TEXT("Only the larger entry is left"), Allocator.GetEntryCount(), 1);
+	TestEqual(TEXT("Entry larger than the cache"), Allocator.Allocate(MakeKey(6, 11)), int32(INDEX_NONE));
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTBrickCacheAssignSlotsTest, "HVPT.BrickCache.AssignSlots", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTBrickCacheAssignSlotsTest::RunTest(const FString& Parameters)
+{
+	FHVPTBrickCacheAllocator Allocator;
+	Allocator.Initialize(16);
+
+	// Two instances of frame 1 a whole number of cells apart, and one of frame 2
+	TArray<FHVPTBrickCacheVolume> Volumes;
+	Volumes.AddDefaulted_GetRef().Key = MakeKey(1, 4);
+	Volumes.Last().CellMin = FIntVector(0, 0, 0);
+	Volumes.AddDefaulted_GetRef().Key = MakeKey(1, 4);
+	Volumes.Last().CellMin = FIntVector(8, 0, 0);
+	Volumes.AddDefaulted_GetRef().Key = MakeKey(2, 4);
+	Volumes.Last().CellMin = FIntVector(0, 8, 0);
+
+	HVPT::Private::AssignBrickCacheSlots(Allocator, Volumes);
+	if (!TestEqual(TEXT("Every volume is kept"), Volumes.Num(), 3))
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("The first instance creates the entry"), Volumes[0].bNewEntry && Volumes[0].bCapture && !Volumes[0].bDeferredRestore);
+	TestTrue(TEXT("The second instance is restored from it after capture"), Volumes[1].bDeferredRestore && !Volumes[1].bCapture && !Volumes[1].bRestore);
+	TestEqual(TEXT("The second instance shares the entry"), Volumes[1].FirstSlot, Volumes[0].FirstSlot);
+	TestTrue(TEXT("The second instance is restored from the cells of the first"), Volumes[1].SourceCellMin == Volumes[0].CellMin);
+	TestTrue(TEXT("Another frame creates its own entry"), Volumes[2].bNewEntry && Volumes[2].FirstSlot != Volumes[0].FirstSlot);
+	TestEqual(TEXT("Instances do not take slots of their own"), Allocator.GetUsedSlotCount(), 8);
+
+	// Once captured, every instance is restored before rasterization
+	HVPT::Private::AssignBrickCacheSlots(Allocator, Volumes);
+	TestTrue(TEXT("The first instance is restored on the next build"), Volumes[0].bRestore && !Volumes[0].bNewEntry);
+	TestTrue(TEXT("The second instance is restored on the next build"), Volumes[1].bRestore && !Volumes[1].bDeferredRestore);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,99 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/BrickPool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTBrickPoolAllocatorTest, "HVPT.BrickPool.Allocator", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTBrickPoolAllocatorTest::RunTest(const FString& Parameters)
+{
+	// Four slabs of 4x4x4 voxels, each holding one brick of resolution 4, 8 of resolution 2 or 64 of resolution 1
+	const int32 VoxelsPerBrick = 64;
+	FHVPTBrickPoolAllocator Allocator;
+	Allocator.Initialize(4, VoxelsPerBrick);
+
+	TestEqual(TEXT("Every slab starts in the largest class"), Allocator.GetFreeBrickCount(2), 4);
+	TestEqual(TEXT("No voxels are lost to the free lists"), Allocator.GetFreeVoxelCount(), int64(4 * VoxelsPerBrick));
+	TestEqual(TEXT("An unsplit pool is not fragmented"), Allocator.CalcFragmentation(), 0.0f);
+
+	// The start of the pool is handed out first
+	const int32 LargeBrick = Allocator.Allocate(4);
+	TestEqual(TEXT("First slab"), LargeBrick, 0);
+
+	// Smaller classes are empty until slabs are reserved for them
+	TestEqual(TEXT("Unreserved class"), Allocator.Allocate(1), int32(INDEX_NONE));
+	TestEqual(TEXT("Unreserved class overflows"), Allocator.GetOverflowBrickCount(), 1);
+
+	// Nine voxels of demand take a single slab, rather than nine
+	const int32 SmallDemand[] = { 9, 0, 0 };
+	Allocator.Reserve(SmallDemand);
+	TestEqual(TEXT("One slab split into voxels"), Allocator.GetFreeBrickCount(0), VoxelsPerBrick);
+	TestEqual(TEXT("Slabs left after the split"), Allocator.GetFreeBrickCount(2), 2);
+
+	TArray<int32> SmallBricks;
+	TSet<int32> UniqueSmallBricks;
+	for (int32 Index = 0; Index < 9; ++Index)
+	{
+		const int32 BottomLevelIndex = Allocator.Allocate(1);
+		SmallBricks.Add(BottomLevelIndex);
+		UniqueSmallBricks.Add(BottomLevelIndex);
+		TestTrue(TEXT("Small bricks share the split slab"), BottomLevelIndex >= VoxelsPerBrick && BottomLevelIndex < 2 * VoxelsPerBrick);
+	}
+	TestEqual(TEXT("Small bricks do not overlap"), UniqueSmallBricks.Num(), 9);
+
+	const int32 MediumDemand[] = { 0, 3, 0 };
+	Allocator.Reserve(MediumDemand);
+	TArray<int32> MediumBricks;
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		const int32 BottomLevelIndex = Allocator.Allocate(2);
+		MediumBricks.Add(BottomLevelIndex);
+		TestTrue(TEXT("Medium bricks are aligned to their size"), BottomLevelIndex % 8 == 0 && BottomLevelIndex >= 2 * VoxelsPerBrick && BottomLevelIndex < 3 * VoxelsPerBrick);
+	}
+
+	TestEqual(TEXT("Last slab"), Allocator.Allocate(4), 3 * VoxelsPerBrick);
+	TestEqual(TEXT("Exhausted pool"), Allocator.Allocate(4), int32(INDEX_NONE));
+	TestEqual(TEXT("Exhausted pool overflows"), Allocator.GetOverflowBrickCount(), 2);
+	TestEqual(TEXT("Allocated bricks"), Allocator.GetAllocatedBrickCount(), 2 + 9 + 3);
+	TestEqual(TEXT("Allocated voxels"), Allocator.GetAllocatedVoxelCount(), int64(2 * 64 + 9 * 1 + 3 * 8));
+	TestEqual(TEXT("Free and allocated voxels add up to the pool"), Allocator.GetFreeVoxelCount() + Allocator.GetAllocatedVoxelCount(), int64(4 * VoxelsPerBrick));
+	TestEqual(TEXT("Every free voxel is in a split slab"), Allocator.CalcFragmentation(), 1.0f);
+
+	// Freeing the small bricks leaves their slab split until it is reclaimed
+	for (const int32 BottomLevelIndex : SmallBricks)
+	{
+		Allocator.Free(BottomLevelIndex, 1);
+	}
+	TestEqual(TEXT("Freed bricks return to their class"), Allocator.GetFreeBrickCount(0), VoxelsPerBrick);
+	TestEqual(TEXT("Freed slab is not yet whole"), Allocator.GetFreeBrickCount(2), 0);
+
+	Allocator.Reclaim();
+	TestEqual(TEXT("Reclaim returns the empty slab"), Allocator.GetFreeBrickCount(2), 1);
+	TestEqual(TEXT("Reclaim empties the class of the slab"), Allocator.GetFreeBrickCount(0), 0);
+	TestEqual(TEXT("Reclaim keeps the free bricks of partially used slabs"), Allocator.GetFreeBrickCount(1), 8 - 3);
+	TestEqual(TEXT("Reclaim loses no voxels"), Allocator.GetFreeVoxelCount() + Allocator.GetAllocatedVoxelCount(), int64(4 * VoxelsPerBrick));
+
+	// Once the last medium brick is gone the whole pool is one class again
+	for (const int32 BottomLevelIndex : MediumBricks)
+	{
+		Allocator.Free(BottomLevelIndex, 2);
+	}
+	Allocator.Free(LargeBrick, 4);
+	Allocator.Free(3 * VoxelsPerBrick, 4);
+	Allocator.Reclaim();
+	TestEqual(TEXT("Compacted pool"), Allocator.GetFreeBrickCount(2), 4);
+	TestEqual(TEXT("Compacted pool is not fragmented"), Allocator.CalcFragmentation(), 0.0f);
+	TestEqual(TEXT("Compacted pool hands out its start first"), Allocator.Allocate(4), 0);
+
+	// Demand for the largest class is kept back from the smaller classes
+	Allocator.Initialize(2, VoxelsPerBrick);
+	const int32 MixedDemand[] = { 1000, 0, 1 };
+	Allocator.Reserve(MixedDemand);
+	TestEqual(TEXT("Smaller classes only split spare slabs"), Allocator.GetFreeBrickCount(0), VoxelsPerBrick);
+	TestEqual(TEXT("Slab kept for the largest class"), Allocator.GetFreeBrickCount(2), 1);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,230 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/CpuVoxelGridBuilder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+// Matches the encoding of FHVPT_TopLevelGridData in VoxelGridBuildUtils.ush
+constexpr uint32 EmptyVoxelIndex = 0x1FFFFFFF;
+
+bool IsBottomLevelAllocated(uint32 TopLevelGridData)
+{
+	return (TopLevelGridData >> 3) != EmptyVoxelIndex;
+}
+
+int32 GetBottomLevelVoxelResolution(uint32 TopLevelGridData)
+{
+	return TopLevelGridData & 0x7;
+}
+
+template<typename ElementType>
+bool AreViewsIdentical(TConstArrayView<ElementType> A, TConstArrayView<ElementType> B)
+{
+	return A.Num() == B.Num() && FMemory::Memcmp(A.GetData(), B.GetData(), A.Num() * sizeof(ElementType)) == 0;
+}
+
+bool AreGridsIdentical(const FHVPTBakedOrthoGrid& A, const FHVPTBakedOrthoGrid& B)
+{
+	bool bIdentical = AreViewsIdentical(A.TopLevelGrid, B.TopLevelGrid)
+		&& AreViewsIdentical(A.Majorants, B.Majorants)
+		&& AreViewsIdentical(A.SubBrickMajorants, B.SubBrickMajorants);
+	for (int32 Channel = 0; Channel < HVPT_GRID_DATA_CHANNEL_COUNT; ++Channel)
+	{
+		bIdentical &= AreViewsIdentical(A.ChannelData[Channel], B.ChannelData[Channel]);
+	}
+	return bIdentical;
+}
+
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTCpuOrthoGridBuilderTest, "HVPT.CpuOrthoGridBuilder.Build", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTCpuOrthoGridBuilderTest::RunTest(const FString& Parameters)
+{
+	FHVPTCpuOrthoGridBuildSettings BuildSettings;
+	TArray<FHVPTCpuVolume> Volumes;
+	HVPT::Private::MakeSyntheticOrthoGridScene(8, BuildSettings, Volumes);
+
+	FHVPTCpuOrthoGridBuilder MultithreadedBuilder;
+	BuildSettings.bMultithreaded = true;
+	MultithreadedBuilder.Build(BuildSettings, Volumes);
+
+	FHVPTCpuOrthoGridBuilder SingleThreadedBuilder;
+	BuildSettings.bMultithreaded = false;
+	SingleThreadedBuilder.Build(BuildSettings, Volumes);
+
+	TestTrue(TEXT("Bricks are allocated"), MultithreadedBuilder.GetAllocatedBrickCount() > 0);
+	TestTrue(TEXT("Grid is valid"), MultithreadedBuilder.ValidateGrid());
+	TestTrue(TEXT("Single and multithreaded builds are identical"), AreGridsIdentical(MultithreadedBuilder.GetGrid(), SingleThreadedBuilder.GetGrid()));
+
+	// The box is limited to resolution 1 while the sphere is at 4, so both ends of the pool's size classes are used
+	const FHVPTBrickPoolAllocator& BrickAllocator = MultithreadedBuilder.GetBrickAllocator();
+	TestTrue(TEXT("Bricks of different sizes share the pool"), BrickAllocator.GetAllocatedVoxelCount() < static_cast<int64>(BrickAllocator.GetAllocatedBrickCount()) * BrickAllocator.GetVoxelsPerBrick());
+
+	// Majorants of a filtered grid must also bound the neighbouring voxels, including those of cells with a different resolution
+	FHVPTCpuOrthoGridBuilder FilteredBuilder;
+	BuildSettings.bTrilinearFiltering = true;
+	FilteredBuilder.Build(BuildSettings, Volumes);
+	TestTrue(TEXT("Filtered grid is valid"), FilteredBuilder.ValidateGrid());
+	BuildSettings.bTrilinearFiltering = false;
+
+	// Running out of slabs must leave cells empty rather than overrun the pool
+	FHVPTCpuOrthoGridBuilder ExhaustedBuilder;
+	BuildSettings.BrickCapacity = FMath::Max(static_cast<int32>(BrickAllocator.GetAllocatedVoxelCount() / BrickAllocator.GetVoxelsPerBrick() / 2), 1);
+	ExhaustedBuilder.Build(BuildSettings, Volumes);
+	const FHVPTBrickPoolAllocator& ExhaustedAllocator = ExhaustedBuilder.GetBrickAllocator();
+	TestTrue(TEXT("Exhausted pool overflows"), ExhaustedAllocator.GetOverflowBrickCount() > 0);
+	TestTrue(TEXT("Exhausted pool is not overrun"), ExhaustedAllocator.GetAllocatedVoxelCount() <= static_cast<int64>(BuildSettings.BrickCapacity) * ExhaustedAllocator.GetVoxelsPerBrick());
+	TestTrue(TEXT("Exhausted grid is valid"), ExhaustedBuilder.ValidateGrid());
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTCpuOrthoGridBuilderDegradationTest, "HVPT.CpuOrthoGridBuilder.Degradation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTCpuOrthoGridBuilderDegradationTest::RunTest(const FString& Parameters)
+{
+	FHVPTCpuOrthoGridBuildSettings BuildSettings;
+	TArray<FHVPTCpuVolume> Volumes;
+	HVPT::Private::MakeSyntheticOrthoGridScene(8, BuildSettings, Volumes);
+	BuildSettings.MaxDegradationLevel = 2;
+
+	// Fog asking for resolution 2, ranked between the box at resolution 1 and the sphere at 4
+	const float CellSize = BuildSettings.TopLevelGridWorldBounds.GetSize().X / BuildSettings.TopLevelGridResolution.X;
+	FHVPTCpuVolume& Fog = Volumes.AddDefaulted_GetRef();
+	Fog.WorldBounds = FBox(FVector(0.0f, CellSize * 6.0f, CellSize * 6.0f), FVector(CellSize * 4.0f, CellSize * 8.0f, CellSize * 8.0f));
+	Fog.MinimumVoxelSize = CellSize / 2.0f;
+	Fog.Sample = [](const FVector3f& WorldPosition)
+	{
+		FHVPTCpuVolumeSample Sample;
+		Sample.Extinction = FVector3f(0.002f);
+		Sample.Albedo = FVector3f(0.8f);
+		return Sample;
+	};
+
+	FHVPTCpuOrthoGridBuilder FullBuilder;
+	FullBuilder.Build(BuildSettings, Volumes);
+	const FHVPTCpuOrthoGridBuilder::FDegradationStats& FullStats = FullBuilder.GetDegradationStats();
+	TestEqual(TEXT("A pool that fits the demand lowers no cells"), FullStats.DegradedCellCount, 0);
+	TestEqual(TEXT("A pool that fits the demand is not degraded"), FullStats.Level, 0);
+
+	const TConstArrayView<uint32> FullGrid = FullBuilder.GetGrid().TopLevelGrid;
+	const TConstArrayView<uint8> Priorities = FullBuilder.GetCellPriorities();
+
+	// One slab short only needs the lowest bucket with cells above resolution 1, and at most every cell at resolution 1 at the last level
+	for (const int32 BrickCapacity : { FullStats.DemandSlabCount - 1, FullStats.DemandSlabCount / 8 })
+	{
+		FHVPTCpuOrthoGridBuilder Builder;
+		BuildSettings.BrickCapacity = BrickCapacity;
+		Builder.Build(BuildSettings, Volumes);
+
+		const FHVPTCpuOrthoGridBuilder::FDegradationStats& Stats = Builder.GetDegradationStats();
+		const FString Context = FString::Printf(TEXT("%d of %d slabs"), BrickCapacity, FullStats.DemandSlabCount);
+		TestTrue(FString::Printf(TEXT("Undersized pool lowers cells (%s)"), *Context), Stats.DegradedCellCount > 0);
+		TestEqual(FString::Printf(TEXT("Degraded demand fits (%s)"), *Context), Stats.MissingSlabCount, 0);
+		TestEqual(FString::Printf(TEXT("Degraded pool does not overflow (%s)"), *Context), Builder.GetBrickAllocator().GetOverflowBrickCount(), 0);
+		TestTrue(FString::Printf(TEXT("Degraded grid is valid (%s)"), *Context), Builder.ValidateGrid());
+
+		// Halvings of each cell with a brick in both builds, ranked by priority
+		const TConstArrayView<uint32> Grid = Builder.GetGrid().TopLevelGrid;
+		int32 LeastHalvings[HVPT_BRICK_PRIORITY_BUCKET_COUNT];
+		int32 MostHalvings[HVPT_BRICK_PRIORITY_BUCKET_COUNT];
+		for (int32 Bucket = 0; Bucket < HVPT_BRICK_PRIORITY_BUCKET_COUNT; ++Bucket)
+		{
+			LeastHalvings[Bucket] = MAX_int32;
+			MostHalvings[Bucket] = INDEX_NONE;
+		}
+
+		int32 EmptiedCellCount = 0;
+		for (int32 LinearIndex = 0; LinearIndex < FullGrid.Num(); ++LinearIndex)
+		{
+			if (!IsBottomLevelAllocated(FullGrid[LinearIndex]))
+			{
+				continue;
+			}
+			if (!IsBottomLevelAllocated(Grid[LinearIndex]))
+			{
+				EmptiedCellCount++;
+				continue;
+			}
+
+			const int32 VoxelResolution = GetBottomLevelVoxelResolution(Grid[LinearIndex]);
+			const int32 Halvings = FMath::FloorLog2(GetBottomLevelVoxelResolution(FullGrid[LinearIndex])) - FMath::FloorLog2(VoxelResolution);
+			MostHalvings[Priorities[LinearIndex]] = FMath::Max(MostHalvings[Priorities[LinearIndex]], Halvings);
+			// Cells already at resolution 1 cannot follow the rest of their bucket down
+			if (VoxelResolution > 1)
+			{
+				LeastHalvings[Priorities[LinearIndex]] = FMath::Min(LeastHalvings[Priorities[LinearIndex]], Halvings);
+			}
+		}
+		TestEqual(FString::Printf(TEXT("No cell is left empty while levels remain (%s)"), *Context), EmptiedCellCount, 0);
+
+		// Every cell that could still be lowered must have been halved at least as often as any cell of a higher bucket
+		int32 HigherMostHalvings = INDEX_NONE;
+		for (int32 Bucket = HVPT_BRICK_PRIORITY_BUCKET_COUNT - 1; Bucket >= 0; --Bucket)
+		{
+			if (LeastHalvings[Bucket] != MAX_int32 && HigherMostHalvings != INDEX_NONE)
+			{
+				TestTrue(FString::Printf(TEXT("Bucket %d is lowered before the buckets above it (%s)"), Bucket, *Context), LeastHalvings[Bucket] >= HigherMostHalvings);
+			}
+			HigherMostHalvings = FMath::Max(HigherMostHalvings, MostHalvings[Bucket]);
+		}
+	}
+
+	// One slab short is made up by the fog alone, without touching the sphere
+	{
+		FHVPTCpuOrthoGridBuilder Builder;
+		BuildSettings.BrickCapacity = FullStats.DemandSlabCount - 1;
+		Builder.Build(BuildSettings, Volumes);
+
+		const TConstArrayView<uint32> Grid = Builder.GetGrid().TopLevelGrid;
+		bool bSphereKept = true;
+		for (int32 LinearIndex = 0; LinearIndex < FullGrid.Num(); ++LinearIndex)
+		{
+			if (IsBottomLevelAllocated(FullGrid[LinearIndex]) && GetBottomLevelVoxelResolution(FullGrid[LinearIndex]) == BuildSettings.BottomLevelGridResolution)
+			{
+				bSphereKept &= GetBottomLevelVoxelResolution(Grid[LinearIndex]) == BuildSettings.BottomLevelGridResolution;
+			}
+		}
+		TestTrue(TEXT("The highest bucket keeps its resolution when the lower buckets are enough"), bSphereKept);
+		TestEqual(TEXT("One halving is enough for one slab"), Builder.GetDegradationStats().Level, 1);
+	}
+
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTCpuOrthoGridBuilderBenchmark, "HVPT.CpuOrthoGridBuilder.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FHVPTCpuOrthoGridBuilderBenchmark::RunTest(const FString& Parameters)
+{
+	// Same scene as r.HVPT.OrthoGrid.BenchmarkCpuBuilder with its default arguments
+	const int32 TopLevelGridResolution = 32;
+	const int32 Iterations = 4;
+
+	for (const bool bMultithreaded : { false, true })
+	{
+		int32 AllocatedBrickCount = 0;
+		const FHVPTCpuOrthoGridBuilder::FTimings Timings = HVPT::Private::BenchmarkCpuOrthoGridBuilder(TopLevelGridResolution, Iterations, bMultithreaded, AllocatedBrickCount);
+
+		AddInfo(FString::Printf(TEXT("%s, %d^3 cells, %d bricks: voxel size %.2f ms, allocate %.2f ms, rasterize %.2f ms, majorants %.2f ms, total %.2f ms"),
+			bMultithreaded ? TEXT("Multithreaded") : TEXT("Single threaded"),
+			TopLevelGridResolution,
+			AllocatedBrickCount,
+			Timings.CalculateVoxelSizeSeconds * 1000.0,
+			Timings.AllocateBottomLevelGridSeconds * 1000.0,
+			Timings.RasterizeSeconds * 1000.0,
+			Timings.BuildMajorantsSeconds * 1000.0,
+			Timings.GetTotalSeconds() * 1000.0
+		));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
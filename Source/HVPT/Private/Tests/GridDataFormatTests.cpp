@@ -0,0 +1,47 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/GridDataFormat.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTGridDataFormatsTest, "HVPT.GridDataFormat.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTGridDataFormatsTest::RunTest(const FString& Parameters)
+{
+	// Components with very different magnitudes, as extinction of coloured media often has
+	const FVector3f Ratios[] = {
+		FVector3f(1.0f, 1.0f, 1.0f),
+		FVector3f(1.0f, 0.5f, 0.25f),
+		FVector3f(0.01f, 1.0f, 0.3f),
+		FVector3f(0.0f, 0.0f, 1.0f),
+		FVector3f(0.999f, 0.001f, 0.0f),
+	};
+
+	for (uint32 Format = 0; Format < HVPT_GRID_DATA_FORMAT_COUNT; ++Format)
+	{
+		TestTrue(FString::Printf(TEXT("Grid data format %u encodes zero"), Format), HVPT::Private::ValidateGridDataRoundTrip(Format, FVector3f::ZeroVector));
+
+		// Values spanning the range of the format
+		const float MaxValue = FMath::Min(HVPT::Private::GetGridDataMaxValue(Format), 60000.0f);
+		for (float Scale = 1e-4f; Scale <= MaxValue; Scale *= 1.37f)
+		{
+			for (const FVector3f& Ratio : Ratios)
+			{
+				// Monochrome formats can only hold grey values
+				if (Format == HVPT_GRID_DATA_FORMAT_MONOCHROME16 && !Ratio.AllComponentsEqual())
+				{
+					continue;
+				}
+
+				if (!HVPT::Private::ValidateGridDataRoundTrip(Format, Ratio * Scale))
+				{
+					AddError(FString::Printf(TEXT("Grid data format %u exceeded its error bound encoding %s"), Format, *(Ratio * Scale).ToString()));
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
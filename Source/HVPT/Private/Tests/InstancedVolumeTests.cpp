@@ -0,0 +1,55 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/VoxelGrid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTInstancedAssetGridResolutionTest, "HVPT.InstancedVolumes.AssetGridResolution", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTInstancedAssetGridResolutionTest::RunTest(const FString& Parameters)
+{
+	using namespace HVPT::Private;
+
+	const FBox LocalBounds(FVector(-50.0, -25.0, 0.0), FVector(50.0, 25.0, 10.0));
+	const FVector TopLevelVoxelSize(10.0);
+
+	// As many cells as top-level cells fit in the bounds, rounded up
+	TestEqual(TEXT("Unscaled resolution"), CalcInstancedAssetGridResolution(LocalBounds, FVector(1.0), TopLevelVoxelSize), FIntVector(10, 5, 1));
+
+	// An instance scaled up needs finer cells to match the top-level cells around it
+	TestEqual(TEXT("Scaled resolution"), CalcInstancedAssetGridResolution(LocalBounds, FVector(2.0, 1.0, 1.5), TopLevelVoxelSize), FIntVector(20, 5, 2));
+
+	// Never empty, and never beyond the largest local grid
+	TestEqual(TEXT("Flat bounds"), CalcInstancedAssetGridResolution(FBox(FVector(0.0), FVector(100.0, 100.0, 0.0)), FVector(1.0), TopLevelVoxelSize).Z, 1);
+	TestEqual(TEXT("Clamped resolution"), CalcInstancedAssetGridResolution(LocalBounds, FVector(100.0), TopLevelVoxelSize), FIntVector(HVPT_MAX_INSTANCED_ASSET_GRID_RESOLUTION));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTInstancedVolumeWorldToLocalVoxelTest, "HVPT.InstancedVolumes.WorldToLocalVoxel", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTInstancedVolumeWorldToLocalVoxelTest::RunTest(const FString& Parameters)
+{
+	using namespace HVPT::Private;
+
+	const FBox LocalBounds(FVector(-50.0, -25.0, 0.0), FVector(50.0, 25.0, 10.0));
+	const FIntVector LocalGridResolution(8, 4, 2);
+
+	const FMatrix InstanceToWorldA = FScaleRotationTranslationMatrix(FVector(1.0), FRotator(0.0, 0.0, 0.0), FVector(1000.0, 0.0, 0.0));
+	const FMatrix InstanceToWorldB = FScaleRotationTranslationMatrix(FVector(2.0, 0.5, 3.0), FRotator(10.0, 45.0, -30.0), FVector(-200.0, 500.0, 75.0));
+
+	for (const FMatrix& InstanceToWorld : { InstanceToWorldA, InstanceToWorldB })
+	{
+		const FMatrix WorldToLocalVoxel = CalcInstancedVolumeWorldToLocalVoxel(InstanceToWorld, LocalBounds, LocalGridResolution);
+
+		// The corners of the bounds span the whole local grid
+		TestTrue(TEXT("Min corner"), WorldToLocalVoxel.TransformPosition(InstanceToWorld.TransformPosition(LocalBounds.Min)).Equals(FVector::ZeroVector, 1.0e-3));
+		TestTrue(TEXT("Max corner"), WorldToLocalVoxel.TransformPosition(InstanceToWorld.TransformPosition(LocalBounds.Max)).Equals(FVector(LocalGridResolution), 1.0e-3));
+
+		// Every instance finds the same voxel for the same point in instance space, which is what lets them share one local grid
+		const FVector InstancePosition(12.5, -20.0, 7.5);
+		TestTrue(TEXT("Shared voxel"), WorldToLocalVoxel.TransformPosition(InstanceToWorld.TransformPosition(InstancePosition)).Equals(FVector(5.0, 0.4, 1.5), 1.0e-3));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "Misc/AutomationTest.h"
+
+#include "HVPTDefinitions.h"
+#include "Rendering/MajorantPyramid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+// Checks that every non-empty cell visited by the flat traversal is covered by the hierarchical traversal,
+// with a majorant bounding its own, and that both traversals cover the same distance along the ray
+bool ValidateTraversal(const FHVPTMajorantPyramid& Pyramid, const FVector3f& Begin, const FVector3f& End, float LeapThreshold, int32& OutHierarchicalSegmentCount)
+{
+	TArray<FHVPTMajorantPyramid::FSegment> FlatSegments;
+	TArray<FHVPTMajorantPyramid::FSegment> HierarchicalSegments;
+	Pyramid.TraceFlat(Begin, End, FlatSegments);
+	Pyramid.TraceHierarchical(Begin, End, LeapThreshold, HierarchicalSegments);
+	OutHierarchicalSegmentCount = HierarchicalSegments.Num();
+
+	if (FlatSegments.IsEmpty() || HierarchicalSegments.IsEmpty())
+	{
+		return FlatSegments.IsEmpty() == HierarchicalSegments.IsEmpty();
+	}
+	if (!FMath::IsNearlyEqual(FlatSegments.Last().TMax, HierarchicalSegments.Last().TMax, 1e-3f))
+	{
+		return false;
+	}
+
+	int32 HierarchicalIndex = 0;
+	for (const FHVPTMajorantPyramid::FSegment& FlatSegment : FlatSegments)
+	{
+		if (FlatSegment.Majorant <= 0.0f)
+		{
+			continue;
+		}
+
+		// Find the hierarchical step containing the middle of this cell
+		const float MidT = 0.5f * (FlatSegment.TMin + FlatSegment.TMax);
+		while (HierarchicalIndex < HierarchicalSegments.Num() - 1 && HierarchicalSegments[HierarchicalIndex].TMax <= MidT)
+		{
+			HierarchicalIndex++;
+		}
+
+		const FHVPTMajorantPyramid::FSegment& HierarchicalSegment = HierarchicalSegments[HierarchicalIndex];
+		const int32 Level = HierarchicalSegment.MipLevel;
+		const FIntVector CoveringCell(FlatSegment.MipCell.X >> Level, FlatSegment.MipCell.Y >> Level, FlatSegment.MipCell.Z >> Level);
+
+		if (CoveringCell != HierarchicalSegment.MipCell || HierarchicalSegment.Majorant < FlatSegment.Majorant)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTMajorantPyramidTraversalTest, "HVPT.MajorantPyramid.Traversal", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTMajorantPyramidTraversalTest::RunTest(const FString& Parameters)
+{
+	// Not a power of two on any axis, so that the coarser levels have partial cells at the far edges
+	const FIntVector Resolution(13, 9, 6);
+
+	// Mostly empty, with a dense blob and a thin sheet of low density
+	TArray<float> TopLevelMajorants;
+	TopLevelMajorants.SetNumZeroed(Resolution.X * Resolution.Y * Resolution.Z);
+	for (int32 Z = 0; Z < Resolution.Z; ++Z)
+	for (int32 Y = 0; Y < Resolution.Y; ++Y)
+	for (int32 X = 0; X < Resolution.X; ++X)
+	{
+		float& Majorant = TopLevelMajorants[X + Resolution.X * (Y + Resolution.Y * Z)];
+		if (FVector3f::DistSquared(FVector3f(X, Y, Z), FVector3f(3.0f, 4.0f, 2.0f)) < 5.0f)
+		{
+			Majorant = 2.0f + X;
+		}
+		else if (X == 10)
+		{
+			Majorant = 0.25f;
+		}
+	}
+
+	FHVPTMajorantPyramid Pyramid;
+	Pyramid.Build(Resolution, TopLevelMajorants, HVPT_MAX_MAJORANT_MIP_COUNT);
+	TestEqual(TEXT("Levels down to a single cell"), Pyramid.GetMipCount(), HVPT::Private::CalcMajorantMipCount(Resolution, HVPT_MAX_MAJORANT_MIP_COUNT));
+
+	// Every level must bound the level below it
+	for (int32 MipLevel = 1; MipLevel < Pyramid.GetMipCount(); ++MipLevel)
+	{
+		const FIntVector SrcResolution = HVPT::Private::CalcMajorantMipResolution(Resolution, MipLevel - 1);
+		for (int32 Z = 0; Z < SrcResolution.Z; ++Z)
+		for (int32 Y = 0; Y < SrcResolution.Y; ++Y)
+		for (int32 X = 0; X < SrcResolution.X; ++X)
+		{
+			const FIntVector SrcCell(X, Y, Z);
+			if (Pyramid.GetMajorant(MipLevel, SrcCell / 2) < Pyramid.GetMajorant(MipLevel - 1, SrcCell))
+			{
+				AddError(FString::Printf(TEXT("Level %d does not bound cell %s of the level below"), MipLevel, *SrcCell.ToString()));
+			}
+		}
+	}
+
+	const FVector3f GridMax(Resolution);
+	FRandomStream RandomStream(0x4856);
+
+	for (const float LeapThreshold : { 0.0f, 0.5f })
+	{
+		int32 FlatSegmentCount = 0;
+		int32 HierarchicalSegmentCount = 0;
+		for (int32 RayIndex = 0; RayIndex < 256; ++RayIndex)
+		{
+			// Axis aligned and diagonal rays, as well as random ones
+			FVector3f Begin(RandomStream.FRand(), RandomStream.FRand(), RandomStream.FRand());
+			FVector3f End(RandomStream.FRand(), RandomStream.FRand(), RandomStream.FRand());
+			if (RayIndex % 4 == 0)
+			{
+				End = FVector3f(1.0f - Begin.X, Begin.Y, Begin.Z);
+			}
+			else if (RayIndex % 4 == 1)
+			{
+				End = FVector3f(1.0f) - Begin;
+			}
+			Begin *= GridMax;
+			End *= GridMax;
+
+			int32 RaySegmentCount = 0;
+			if (!ValidateTraversal(Pyramid, Begin, End, LeapThreshold, RaySegmentCount))
+			{
+				AddError(FString::Printf(TEXT("Hierarchical traversal from %s to %s with threshold %.2f does not cover the flat traversal"), *Begin.ToString(), *End.ToString(), LeapThreshold));
+			}
+			HierarchicalSegmentCount += RaySegmentCount;
+
+			TArray<FHVPTMajorantPyramid::FSegment> FlatSegments;
+			Pyramid.TraceFlat(Begin, End, FlatSegments);
+			FlatSegmentCount += FlatSegments.Num();
+		}
+
+		// Empty space must actually be skipped
+		TestTrue(FString::Printf(TEXT("Hierarchical traversal with threshold %.2f takes fewer steps"), LeapThreshold), HierarchicalSegmentCount < FlatSegmentCount);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
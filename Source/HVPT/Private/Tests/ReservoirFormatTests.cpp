@@ -0,0 +1,68 @@
+#include "Misc/AutomationTest.h"
+
+#include "Rendering/ReservoirFormat.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+
+FHVPT_Reservoir MakeReservoir(float RunningSum, float M, float P_y, const FVector2f& LightSample)
+{
+	FHVPT_Reservoir Reservoir;
+	Reservoir.RunningSum = RunningSum;
+	Reservoir.M = M;
+	Reservoir.P_y = P_y;
+	Reservoir.PackedData = FUintVector2(0xDEADBEEF, 0x1234ABCD);
+	Reservoir.LightSample = LightSample;
+	return Reservoir;
+}
+
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHVPTCompactReservoirFormatTest, "HVPT.ReservoirFormat.CompactRoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FHVPTCompactReservoirFormatTest::RunTest(const FString& Parameters)
+{
+	using namespace HVPT::Private;
+
+	// Cleared reservoirs must stay empty
+	TestTrue(TEXT("Compact reservoir encodes an empty reservoir"), ValidateCompactReservoirRoundTrip(MakeReservoir(0.0f, 0.0f, 0.0f, FVector2f::ZeroVector)));
+
+	// Weights far outside the range of half floats, as produced by bright lights and low probability paths
+	for (float Weight = 1e-20f; Weight <= 1e20f; Weight *= 1.37f)
+	{
+		if (!ValidateCompactReservoirRoundTrip(MakeReservoir(Weight, 1.0f, Weight * 0.29f, FVector2f(0.5f, 0.5f))))
+		{
+			AddError(FString::Printf(TEXT("Compact reservoir exceeded its error bound encoding weight %g"), Weight));
+		}
+	}
+
+	// Sample counts are integers after candidate generation, and fractional once clamped by the temporal history threshold
+	for (float M = 1.0f; M <= 4096.0f; M *= 1.13f)
+	{
+		for (const float CandidateM : { FMath::RoundToFloat(M), M })
+		{
+			if (!ValidateCompactReservoirRoundTrip(MakeReservoir(1.0f, CandidateM, 1.0f, FVector2f(0.5f, 0.5f))))
+			{
+				AddError(FString::Printf(TEXT("Compact reservoir exceeded its error bound encoding M %g"), CandidateM));
+			}
+		}
+	}
+
+	// Light samples across the whole unit square, including both ends
+	const int32 LightSampleSteps = 1000;
+	for (int32 Step = 0; Step <= LightSampleSteps; ++Step)
+	{
+		const float Value = FMath::Min(static_cast<float>(Step) / LightSampleSteps, 1.0f - UE_KINDA_SMALL_NUMBER);
+		if (!ValidateCompactReservoirRoundTrip(MakeReservoir(1.0f, 1.0f, 1.0f, FVector2f(Value, 1.0f - Value))))
+		{
+			AddError(FString::Printf(TEXT("Compact reservoir exceeded its error bound encoding light sample %g"), Value));
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
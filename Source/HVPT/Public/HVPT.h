@@ -63,11 +63,18 @@ namespace HVPT
 	// Voxel grid build
 	HVPT_API bool GetRebuildEveryFrame();
 	HVPT_API bool GetShouldJitter();
+	HVPT_API bool UseAsyncComputeForGridBuild();
+	HVPT_API bool UseOneFrameLatencyForGridBuild();
 	HVPT_API float GetMinimumVoxelSizeInsideFrustum();
 	HVPT_API float GetMinimumVoxelSizeOutsideFrustum();
 	HVPT_API int32 GetBottomLevelGridResolution();
 	HVPT_API float GetInsideFrustumShadingRate();
 	HVPT_API float GetOutsideFrustumShadingRate();
+	HVPT_API int32 GetGridDataFormatForExtinction();
+	HVPT_API int32 GetGridDataFormatForEmission();
+	HVPT_API int32 GetGridDataFormatForScattering();
+	HVPT_API bool UseMonochromeExtinction();
+	HVPT_API bool UseInterleavedShadingData();
 
 	enum class EFogCompositionMode
 	{
@@ -83,9 +90,31 @@ namespace HVPT
 	HVPT_API float GetFarPlaneDistanceForFrustumGrid();
 	HVPT_API int32 GetDepthSliceCountForFrustumGrid();
 	HVPT_API int32 GetMaxBottomLevelMemoryInMegabytesForFrustumGrid();
+	HVPT_API bool UseAdaptiveDepthSlicesForFrustumGrid();
+	HVPT_API float GetEmptyDepthSliceWeightForFrustumGrid();
+	HVPT_API int32 GetRebuildIntervalForFrustumGrid();
+	HVPT_API float GetRebuildBudgetMillisecondsForFrustumGrid();
+	HVPT_API int32 GetMaxRebuildIntervalForFrustumGrid();
 
 	HVPT_API bool EnableOrthoGrid();
 	HVPT_API int32 GetMaxBottomLevelMemoryInMegabytesForOrthoGrid();
+	HVPT_API int32 GetMaxDegradationLevelForOrthoGrid();
+	HVPT_API bool EnableIncrementalRebuildForOrthoGrid();
+	HVPT_API int32 GetFullRebuildIntervalForOrthoGrid();
+	HVPT_API int32 GetMajorantMipCountForOrthoGrid();
+	HVPT_API float GetMajorantLeapThresholdForOrthoGrid();
+	HVPT_API bool UseSubBrickMajorantsForOrthoGrid();
+	HVPT_API bool UseTrilinearFilteringForOrthoGrid();
+	HVPT_API FString GetBakedGridForOrthoGrid();
+	// Returns the filename given to r.HVPT.OrthoGrid.Bake, if a bake has been requested since the last call
+	HVPT_API bool ConsumeBakeRequestForOrthoGrid(FString& OutFilename);
+	HVPT_API bool EnableStatsForOrthoGrid();
+	// Returns true if r.HVPT.OrthoGrid.DumpStats has been run since the last call
+	HVPT_API bool ConsumeDumpStatsRequestForOrthoGrid();
+	HVPT_API bool EnableDirectVolumesForOrthoGrid();
+	HVPT_API bool EnableInstancedVolumesForOrthoGrid();
+	HVPT_API bool EnableBrickCacheForOrthoGrid();
+	HVPT_API int32 GetBrickCacheMemoryInMegabytesForOrthoGrid();
 
 	// Debug tools
 	HVPT_API bool GetFreezeTemporalSeed();
@@ -4,10 +4,18 @@
 #include "Components/MeshComponent.h"
 #include "GameFramework/Info.h"
 
+#include "HeterogeneousVolumeExInterface.h"
+
 #include "HeterogeneousVolumeExComponent.generated.h"
 
 
 class USparseVolumeTexture;
+class USparseVolumeTextureFrame;
+
+namespace UE::SVT
+{
+	class FTextureRenderResources;
+}
 
 /**
  *	A component that represents a heterogeneous volume, with extended interface to the renderer allowing higher quality rendering
@@ -53,6 +61,47 @@ public:
 	UPROPERTY(EditAnywhere, Category = Volume)
 	uint32 bPivotAtCentroid : 1;
 
+	// The material only ever outputs grey extinction, so it can be stored and tracked as a single channel
+	UPROPERTY(EditAnywhere, Category = Volume)
+	uint32 bMonochromeExtinction : 1;
+
+	// Coarsest bottom-level resolution the cells of the ortho grid covering this volume are given, however far away they are
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD, meta = (ClampMin = "1", ClampMax = "8"))
+	int32 MinBrickResolution;
+
+	// Finest bottom-level resolution the cells of the ortho grid covering this volume are given. 0 uses r.HVPT.BottomLevelGridResolution
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD, meta = (ClampMin = "0", ClampMax = "8"))
+	int32 MaxBrickResolution;
+
+	// Scales the projected pixel size that voxels in view follow by 2^LODDistanceBias
+	// Positive values make the volume coarsen closer to the camera, negative values keep it fine further away
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD, meta = (UIMin = "-4.0", UIMax = "4.0"))
+	float LODDistanceBias;
+
+	// Relative share of grid memory the volume should get at the same distance
+	// Voxel size in view is divided by the cube root, so a volume with importance 8 gets voxels half the size
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = LOD, meta = (ClampMin = "0.01", UIMax = "64.0"))
+	float LODImportance;
+
+	// Trace the sparse volume texture directly from the ortho grid instead of rasterizing the material into bricks
+	// The material is bypassed: extinction is the alpha channel of attribute A and emission the rgb channels of attribute B
+	// Only applies while the volume shares no ortho grid cells with another volume, see r.HVPT.OrthoGrid.DirectVolumes
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = DirectSampling)
+	uint32 bSampleSparseVolumeTextureDirectly : 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = DirectSampling, meta = (ClampMin = "0.0", EditCondition = "bSampleSparseVolumeTextureDirectly"))
+	float DirectExtinctionScale;
+
+	// Density is clamped to this before scaling, which also bounds the majorant of the cells covering the volume
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = DirectSampling, meta = (ClampMin = "0.0", EditCondition = "bSampleSparseVolumeTextureDirectly"))
+	float DirectMaxDensity;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = DirectSampling, meta = (EditCondition = "bSampleSparseVolumeTextureDirectly"))
+	FLinearColor DirectAlbedo;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = DirectSampling, meta = (ClampMin = "0.0", EditCondition = "bSampleSparseVolumeTextureDirectly"))
+	float DirectEmissionScale;
+
 	UPROPERTY(EditAnywhere, Category = Lighting)
 	float StepFactor;
 
@@ -95,12 +144,26 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SparseVolumeTextureStreaming")
 	HVPT_API void SetStreamingMipBias(int32 NewValue);
 
+	UFUNCTION(BlueprintCallable, Category = "LOD")
+	HVPT_API void SetLODPolicy(int32 NewMinBrickResolution, int32 NewMaxBrickResolution, float NewLODDistanceBias, float NewLODImportance);
+
+	// Notifies the renderer that the contents of the volume have changed (e.g. after changing material parameters on the MID)
+	UFUNCTION(BlueprintCallable, Category = "Volume")
+	HVPT_API void MarkVolumeDataDirty();
+
+	uint32 GetDataRevision() const { return DataRevision; }
+	const FHeterogeneousVolumeExFrameKey& GetFrameCacheKey() const { return FrameCacheKey; }
+
+	// Render resources of the current frame, when it is sampled directly
+	const UE::SVT::FTextureRenderResources* GetDirectSparseVolumeTexture() const;
+
 	~UHeterogeneousVolumeExComponent() {}
 
 public:
 	//~ Begin USceneComponent Interface.
 	virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void SendRenderDynamicData_Concurrent() override;
 
 	virtual void PostLoad() override;
 	virtual void PostInitProperties() override;
@@ -125,10 +188,24 @@ public:
 
 private:
 	const USparseVolumeTexture* PreviousSVT;
+	const USparseVolumeTextureFrame* PreviousSVTFrame;
+
+	// Incremented whenever the volume data changes without the scene proxy being recreated
+	uint32 DataRevision;
+
+	// See IHeterogeneousVolumeExInterface::GetFrameCacheKey
+	FHeterogeneousVolumeExFrameKey FrameCacheKey;
+	// Incremented by MarkVolumeDataDirty only, as the frame key cannot tell what else has changed
+	uint32 ContentRevision;
+	// The parameters of the frame key are hashed again after MarkVolumeDataDirty, or when the MID is replaced
+	const UMaterialInstanceDynamic* FrameCacheKeyMaterialInstance;
+	bool bFrameCacheKeyParametersDirty;
 
 	static USparseVolumeTexture* GetSparseVolumeTexture(UMaterialInterface* MaterialInterface, int32 ParameterIndex, FName* OutParamName = nullptr);
 	static UMaterialInstanceDynamic* CreateOrCastToMID(UMaterialInterface* MaterialInterface);
 	void OnSparseVolumeTextureChanged(const USparseVolumeTexture* SparseVolumeTexture);
+	void CalcFrameCacheKeyParameters(FName SVTParameterName, FHeterogeneousVolumeExFrameKey& FrameKey) const;
+	void SetFrameCacheKey(const FHeterogeneousVolumeExFrameKey& NewFrameCacheKey);
 	UMaterialInterface* GetHeterogeneousVolumeMaterial() const; // Gets the UMaterialInterface* returned by GetMaterial(0), but returns nullptr if the material is incompatible with HeterogeneousVolumes.
 };
 
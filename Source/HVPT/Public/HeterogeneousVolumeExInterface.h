@@ -1,6 +1,40 @@
 #pragma once
 
 #include "HeterogeneousVolumeInterface.h"
+#include "UObject/ObjectKey.h"
+
+namespace UE::SVT
+{
+	class FTextureRenderResources;
+}
+
+
+// Identifies what the material of a volume produces for an animation frame, regardless of where the volume is placed
+struct FHeterogeneousVolumeExFrameKey
+{
+	// Null if the frame is unknown, in which case the key is not valid
+	FObjectKey SparseVolumeTextureFrame;
+	int32 MipLevel = 0;
+
+	// Base material, and a hash of every parameter set along the chain of material instances down to the volume's own
+	FObjectKey Material;
+	uint64 ParameterHash = 0;
+
+	// Incremented by UHeterogeneousVolumeExComponent::MarkVolumeDataDirty, for changes that the parameters do not show
+	uint32 ContentRevision = 0;
+
+	bool IsValid() const { return SparseVolumeTextureFrame != FObjectKey(); }
+
+	bool operator==(const FHeterogeneousVolumeExFrameKey& Other) const
+	{
+		return SparseVolumeTextureFrame == Other.SparseVolumeTextureFrame
+			&& MipLevel == Other.MipLevel
+			&& Material == Other.Material
+			&& ParameterHash == Other.ParameterHash
+			&& ContentRevision == Other.ContentRevision;
+	}
+	bool operator!=(const FHeterogeneousVolumeExFrameKey& Other) const { return !(*this == Other); }
+};
 
 
 // Heterogeneous volume extended interface (for HVPT)
@@ -11,6 +45,30 @@ public:
 
 	// Animation
 	virtual bool IsPlayingAnimation() const = 0;
+
+	// Incremented whenever the contents of the volume may have changed without the proxy being recreated (e.g. a new animation frame)
+	virtual uint32 GetDataRevision() const = 0;
+
+	// Identifies what the material will produce for the current animation frame, regardless of where the volume is placed,
+	// so that the ortho grid can reuse bricks rasterized for the same frame earlier or by another instance
+	virtual const FHeterogeneousVolumeExFrameKey& GetFrameCacheKey() const = 0;
+
+	// Extinction is the same in every channel, so the volume may be stored with HVPT_GRID_DATA_FORMAT_MONOCHROME16
+	virtual bool HasMonochromeExtinction() const = 0;
+
+	// Level of detail of the volume in the ortho grid, see UHeterogeneousVolumeExComponent
+	virtual int32 GetMinBrickResolution() const = 0;
+	virtual int32 GetMaxBrickResolution() const = 0;
+	virtual float GetLODDistanceBias() const = 0;
+	virtual float GetLODImportance() const = 0;
+
+	// Sparse volume texture traced directly by the ortho grid instead of being rasterized into bricks, or null to rasterize the volume
+	// Extinction is read from the alpha channel of attribute A and emission from the rgb channels of attribute B
+	virtual const UE::SVT::FTextureRenderResources* GetDirectSparseVolumeTexture() const = 0;
+	virtual float GetDirectExtinctionScale() const = 0;
+	virtual float GetDirectMaxDensity() const = 0;
+	virtual FLinearColor GetDirectAlbedo() const = 0;
+	virtual float GetDirectEmissionScale() const = 0;
 };
 
 
@@ -30,6 +88,17 @@ public:
 		, bPivotAtCentroid(false)
 		, bHoldout(false)
 		, bIsPlayingAnimation(false)
+		, DataRevision(0)
+		, bMonochromeExtinction(false)
+		, MinBrickResolution(1)
+		, MaxBrickResolution(0)
+		, LODDistanceBias(0.0)
+		, LODImportance(1.0)
+		, DirectSparseVolumeTexture(nullptr)
+		, DirectExtinctionScale(1.0)
+		, DirectMaxDensity(1.0)
+		, DirectAlbedo(FLinearColor::White)
+		, DirectEmissionScale(0.0)
 	{
 	}
 
@@ -49,6 +118,17 @@ public:
 		, ReadableName(Name)
 #endif // ACTOR_HAS_LABELS
 		, bIsPlayingAnimation(false)
+		, DataRevision(0)
+		, bMonochromeExtinction(false)
+		, MinBrickResolution(1)
+		, MaxBrickResolution(0)
+		, LODDistanceBias(0.0)
+		, LODImportance(1.0)
+		, DirectSparseVolumeTexture(nullptr)
+		, DirectExtinctionScale(1.0)
+		, DirectMaxDensity(1.0)
+		, DirectAlbedo(FLinearColor::White)
+		, DirectEmissionScale(0.0)
 	{
 	}
 	virtual ~FHeterogeneousVolumeExData() {}
@@ -79,6 +159,18 @@ public:
 
 	// IHeterogeneousVolumeExInterface
 	virtual bool IsPlayingAnimation() const override { return bIsPlayingAnimation; }
+	virtual uint32 GetDataRevision() const override { return DataRevision; }
+	virtual const FHeterogeneousVolumeExFrameKey& GetFrameCacheKey() const override { return FrameCacheKey; }
+	virtual bool HasMonochromeExtinction() const override { return bMonochromeExtinction; }
+	virtual int32 GetMinBrickResolution() const override { return MinBrickResolution; }
+	virtual int32 GetMaxBrickResolution() const override { return MaxBrickResolution; }
+	virtual float GetLODDistanceBias() const override { return LODDistanceBias; }
+	virtual float GetLODImportance() const override { return LODImportance; }
+	virtual const UE::SVT::FTextureRenderResources* GetDirectSparseVolumeTexture() const override { return DirectSparseVolumeTexture; }
+	virtual float GetDirectExtinctionScale() const override { return DirectExtinctionScale; }
+	virtual float GetDirectMaxDensity() const override { return DirectMaxDensity; }
+	virtual FLinearColor GetDirectAlbedo() const override { return DirectAlbedo; }
+	virtual float GetDirectEmissionScale() const override { return DirectEmissionScale; }
 
 	const FPrimitiveSceneProxy* PrimitiveSceneProxy;
 	FMatrix InstanceToLocal;
@@ -101,4 +193,16 @@ public:
 
 	// IHeterogeneousVolumeExInterface
 	bool bIsPlayingAnimation;
+	uint32 DataRevision;
+	FHeterogeneousVolumeExFrameKey FrameCacheKey;
+	bool bMonochromeExtinction;
+	int32 MinBrickResolution;
+	int32 MaxBrickResolution;
+	float LODDistanceBias;
+	float LODImportance;
+	const UE::SVT::FTextureRenderResources* DirectSparseVolumeTexture;
+	float DirectExtinctionScale;
+	float DirectMaxDensity;
+	FLinearColor DirectAlbedo;
+	float DirectEmissionScale;
 };